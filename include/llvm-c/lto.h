@@ -40,7 +40,7 @@ typedef bool lto_bool_t;
  * @{
  */
 
-#define LTO_API_VERSION 11
+#define LTO_API_VERSION 12
 
 /**
  * \since prior to LTO_API_VERSION=3
@@ -484,6 +484,32 @@ lto_codegen_compile(lto_code_gen_t cg, size_t* length);
 extern lto_bool_t
 lto_codegen_compile_to_file(lto_code_gen_t cg, const char** name);
 
+/**
+ * Sets the number of native object files \a lto_codegen_compile_to_files()
+ * generates. The default is 1.
+ *
+ * \since LTO_API_VERSION=12
+ */
+extern void
+lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned parallelism);
+
+/**
+ * Generates code for all added modules into several native object files, as
+ * many as set by \a lto_codegen_set_parallelism(). The merged module is split
+ * along function and global variable boundaries, and each part is compiled
+ * on its own thread. The object files must all be added to the link: local
+ * symbols referenced across them become hidden global symbols.
+ *
+ * On success, \c names is set to an array of \c count file names. The array
+ * is owned by the lto_code_gen_t and is valid until lto_codegen_dispose() or
+ * the next call to this function. Returns true on error.
+ *
+ * \since LTO_API_VERSION=12
+ */
+extern lto_bool_t
+lto_codegen_compile_to_files(lto_code_gen_t cg, const char *const **names,
+                             unsigned *count);
+
 
 /**
  * Sets options to help debug codegen bugs.
@@ -176,6 +176,12 @@ void PrintStatistics();
 /// \brief Print statistics to the given output stream.
 void PrintStatistics(raw_ostream &OS);
 
+/// \brief Print statistics to the given output stream as a JSON object on a
+/// single line:
+///   {"statistics": [{"group": ..., "desc": ..., "value": ...}, ...]}
+/// where group is the DEBUG_TYPE of the statistic.
+void PrintStatisticsJSON(raw_ostream &OS);
+
 } // End llvm namespace
 
 #endif
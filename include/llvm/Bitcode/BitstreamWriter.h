@@ -15,6 +15,7 @@
 #ifndef LLVM_BITCODE_BITSTREAMWRITER_H
 #define LLVM_BITCODE_BITSTREAMWRITER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Bitcode/BitCodes.h"
@@ -226,6 +227,20 @@ public:
     }
   }
 
+  /// EmitSubblock - Emit a block that was written by another BitstreamWriter.
+  /// \p Contents is what that writer emitted after the block header: the
+  /// block size word, the records and the aligned END_BLOCK. It must have
+  /// been written with the same abbreviations in BLOCKINFO.
+  void EmitSubblock(unsigned BlockID, unsigned CodeLen,
+                    ArrayRef<char> Contents) {
+    EmitCode(bitc::ENTER_SUBBLOCK);
+    EmitVBR(BlockID, bitc::BlockIDWidth);
+    EmitVBR(CodeLen, bitc::CodeLenWidth);
+    FlushToWord();
+    assert(Contents.size() % 4 == 0 && "Block is not 32-bit aligned");
+    Out.append(Contents.begin(), Contents.end());
+  }
+
   void ExitBlock() {
     assert(!BlockScope.empty() && "Block scope imbalance!");
     const Block &B = BlockScope.back();
@@ -0,0 +1,48 @@
+//===-- llvm/CodeGen/ParallelCG.h - Parallel code generation ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares functions that can be used for parallel code generation
+// of a module, e.g. by the LTO code generator and the gold plugin.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PARALLELCG_H
+#define LLVM_CODEGEN_PARALLELCG_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Target/TargetMachine.h"
+#include <string>
+
+namespace llvm {
+
+class Module;
+class raw_ostream;
+
+/// Split \p M into OSs.size() partitions and generate code for partition I
+/// into OSs[I]. Every partition is compiled on its own thread, in its own
+/// LLVMContext, with a TargetMachine configured like \p TM.
+///
+/// Functions and global variables are kept whole and are distributed so that
+/// the partitions hold roughly the same number of instructions. Members of a
+/// comdat and aliases stay together with their base objects. Local symbols
+/// that are referenced from another partition are given external linkage and
+/// hidden visibility: the objects resolve them among themselves, but they are
+/// not exported from the linked image.
+///
+/// With a single output stream \p M is compiled as is by \p TM itself.
+/// Otherwise \p M is modified by the externalization above.
+///
+/// Returns true and sets \p ErrMsg on error.
+bool splitCodeGen(Module &M, ArrayRef<raw_ostream *> OSs, TargetMachine &TM,
+                  TargetMachine::CodeGenFileType FileType,
+                  std::string &ErrMsg);
+
+} // end namespace llvm
+
+#endif
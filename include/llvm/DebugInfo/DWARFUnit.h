@@ -133,6 +133,20 @@ class DWARFUnit {
   };
   std::unique_ptr<DWOHolder> DWO;
 
+  /// SubprogramRange - one address range of the subprogram DIE at
+  /// DieArray[DIEIndex]. MaxHighPC is the largest HighPC of this range and
+  /// all ranges sorted before it.
+  struct SubprogramRange {
+    uint64_t LowPC;
+    uint64_t HighPC;
+    uint64_t MaxHighPC;
+    uint32_t DIEIndex;
+  };
+  /// Address ranges of all subprogram DIEs sorted by LowPC. Built on the first
+  /// address lookup and dropped together with the parsed DIEs.
+  std::vector<SubprogramRange> SubprogramIndex;
+  bool SubprogramIndexBuilt;
+
 protected:
   virtual bool extractImpl(DataExtractor debug_info, uint32_t *offset_ptr);
   /// Size in bytes of the unit header.
@@ -230,6 +244,10 @@ private:
   /// clearDIEs - Clear parsed DIEs to keep memory usage low.
   void clearDIEs(bool KeepCUDie);
 
+  /// buildSubprogramIndex - Collects address ranges of subprogram DIEs into
+  /// SubprogramIndex. Requires that all DIEs are extracted.
+  void buildSubprogramIndex();
+
   /// parseDWO - Parses .dwo file for current compile unit. Returns true if
   /// it was actually constructed.
   bool parseDWO();
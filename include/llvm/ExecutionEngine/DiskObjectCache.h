@@ -0,0 +1,81 @@
+//===- DiskObjectCache.h - On-disk object cache for MCJIT -------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares an ObjectCache that keeps the objects compiled by MCJIT
+// in a directory, so that they can be reused by later runs.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_EXECUTIONENGINE_DISKOBJECTCACHE_H
+#define LLVM_EXECUTIONENGINE_DISKOBJECTCACHE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Target/TargetOptions.h"
+#include <string>
+
+namespace llvm {
+
+/// This is an ObjectCache that stores objects in a directory, one file per
+/// object. The files are named after a hash of the contents of the module and
+/// of the code generation settings, so the cache is shared by all modules and
+/// processes using the same directory and never returns a stale object.
+///
+/// Entries are written to a temporary file and renamed into place, with a
+/// LockFileManager lock keeping concurrent processes from compiling and
+/// writing the same entry twice. If a maximum size is given, the least
+/// recently used entries are removed once the cache grows beyond it.
+///
+/// Modules must be fully materialized; others are not cached. Code generation
+/// changes the module, so an object is only stored for a module whose entry
+/// was looked up with getObject before it was compiled, as MCJIT does.
+class DiskObjectCache : public ObjectCache {
+  DiskObjectCache(const DiskObjectCache &) LLVM_DELETED_FUNCTION;
+  void operator=(const DiskObjectCache &) LLVM_DELETED_FUNCTION;
+
+public:
+  /// Create a cache in \p CacheDir, which is created on demand, for objects
+  /// generated for \p Triple, \p CPU and \p Features at \p OptLevel with the
+  /// relocation model \p RM, the code model \p CM and the target options
+  /// \p Options. An empty \p Triple stands for the triple of each module.
+  /// \p MaxSize is the size limit of the directory in bytes, or 0 for no
+  /// limit.
+  DiskObjectCache(StringRef CacheDir, StringRef Triple, StringRef CPU,
+                  StringRef Features, CodeGenOpt::Level OptLevel,
+                  uint64_t MaxSize = 0, Reloc::Model RM = Reloc::Default,
+                  CodeModel::Model CM = CodeModel::Default,
+                  const TargetOptions &Options = TargetOptions());
+  ~DiskObjectCache() override;
+
+  void notifyObjectCompiled(const Module *M, MemoryBufferRef Obj) override;
+
+  std::unique_ptr<MemoryBuffer> getObject(const Module *M) override;
+
+  /// Compute the path of the cache entry of \p M from its current contents.
+  /// Returns false if \p M cannot be cached.
+  bool getCacheFile(const Module *M, SmallVectorImpl<char> &Path) const;
+
+  /// Remove the least recently used entries until the cache is no larger
+  /// than the size limit.
+  void prune();
+
+private:
+  std::string CacheDir;
+  std::string TargetKey;
+  uint64_t MaxSize;
+  /// The entries of the modules which missed in getObject and are being
+  /// compiled.
+  DenseMap<const Module *, std::string> PendingFiles;
+};
+
+} // end namespace llvm
+
+#endif
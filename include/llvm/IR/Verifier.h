@@ -48,6 +48,17 @@ bool verifyFunction(const Function &F, raw_ostream *OS = nullptr);
 /// returned.
 bool verifyModule(const Module &M, raw_ostream *OS = nullptr);
 
+/// \brief Check a module for errors, verifying function bodies in parallel.
+///
+/// The module-level checks run once on the calling thread, and the function
+/// bodies are verified on up to \p NumThreads threads, or on as many threads
+/// as the hardware supports if \p NumThreads is 0. The messages of each
+/// function are buffered and written to OS in function order, so the result
+/// and the output are the same as those of verifyModule. Without thread
+/// support this is verifyModule.
+bool verifyModuleParallel(const Module &M, raw_ostream *OS = nullptr,
+                          unsigned NumThreads = 0);
+
 /// \brief Create a verifier pass.
 ///
 /// Check a module or function for validity. This is essentially a pass wrapped
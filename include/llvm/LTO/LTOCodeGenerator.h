@@ -74,6 +74,11 @@ struct LTOCodeGenerator {
   void setCpu(const char *mCpu) { MCpu = mCpu; }
   void setAttr(const char *mAttr) { MAttr = mAttr; }
 
+  // Set the number of partitions compile_to_files() splits the merged module
+  // into. Each partition is compiled on its own thread into its own object
+  // file.
+  void setParallelism(unsigned parallelism) { Parallelism = parallelism; }
+
   void addMustPreserveSymbol(const char *sym) { MustPreserveSymbols[sym] = 1; }
 
   // To pass options to the driver and optimization passes. These options are
@@ -117,6 +122,21 @@ struct LTOCodeGenerator {
                       bool disableVectorization,
                       std::string &errMsg);
 
+  // As with compile_to_file(), but the optimized module is split into as many
+  // partitions as set by setParallelism(), and each partition is compiled into
+  // its own object file on its own thread. The paths to the object files are
+  // returned to the caller via argument "names". Return true on success.
+  //
+  // The object files only link together: local symbols referenced across
+  // partitions become hidden global symbols. As with compile_to_file(), it is
+  // up to the linker to remove them.
+  bool compile_to_files(ArrayRef<const char *> &names,
+                        bool disableOpt,
+                        bool disableInline,
+                        bool disableGVNLoadPRE,
+                        bool disableVectorization,
+                        std::string &errMsg);
+
   void setDiagnosticHandler(lto_diagnostic_handler_t, void *);
 
   LLVMContext &getContext() { return Context; }
@@ -124,9 +144,9 @@ struct LTOCodeGenerator {
 private:
   void initializeLTOPasses();
 
-  bool generateObjectFile(raw_ostream &out, bool disableOpt, bool disableInline,
-                          bool disableGVNLoadPRE, bool disableVectorization,
-                          std::string &errMsg);
+  bool generateObjectFiles(ArrayRef<raw_ostream *> outs, bool disableOpt,
+                           bool disableInline, bool disableGVNLoadPRE,
+                           bool disableVectorization, std::string &errMsg);
   void applyScopeRestrictions();
   void applyRestriction(GlobalValue &GV, ArrayRef<StringRef> Libcalls,
                         std::vector<const char *> &MustPreserveList,
@@ -155,6 +175,9 @@ private:
   std::string MCpu;
   std::string MAttr;
   std::string NativeObjectPath;
+  std::vector<std::string> NativeObjectPaths;
+  std::vector<const char *> NativeObjectNames;
+  unsigned Parallelism;
   TargetOptions Options;
   lto_diagnostic_handler_t DiagHandler;
   void *DiagContext;
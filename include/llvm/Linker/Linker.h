@@ -59,6 +59,15 @@ public:
     bool hasType(StructType *Ty);
   };
 
+  enum Flags {
+    None = 0,
+    /// Only link in the globals of the source that the composite needs:
+    /// those resolving a declaration of the composite and, transitively, the
+    /// globals they reference. The bodies of the others are never
+    /// materialized, so this is cheap for lazily loaded libraries.
+    LinkOnlyNeeded = 1 << 0
+  };
+
   Linker(Module *M, DiagnosticHandlerFunction DiagnosticHandler);
   Linker(Module *M);
   ~Linker();
@@ -67,8 +76,9 @@ public:
   void deleteModule();
 
   /// \brief Link \p Src into the composite. The source is destroyed.
+  /// \p Flags is a combination of the Flags above.
   /// Returns true on error.
-  bool linkInModule(Module *Src);
+  bool linkInModule(Module *Src, unsigned Flags = Flags::None);
 
   static bool LinkModules(Module *Dest, Module *Src,
                           DiagnosticHandlerFunction DiagnosticHandler);
@@ -0,0 +1,30 @@
+//===--- JSON.h - Helpers for writing JSON ----------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares helpers for the JSON reports of -time-passes and -stats.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_JSON_H
+#define LLVM_SUPPORT_JSON_H
+
+#include "llvm/ADT/StringRef.h"
+
+namespace llvm {
+
+class raw_ostream;
+
+/// printJSONString - Print \p Str to \p OS as a quoted JSON string. Quotes
+/// and backslashes are escaped, and control characters are printed as
+/// \\u escapes.
+void printJSONString(raw_ostream &OS, StringRef Str);
+
+} // end namespace llvm
+
+#endif
@@ -53,11 +53,13 @@ void initializeOCL20To12Pass(PassRegistry&);
 void initializeOCL20ToSPIRVPass(PassRegistry&);
 void initializeOCL21ToSPIRVPass(PassRegistry&);
 void initializeOCLTypeToSPIRVPass(PassRegistry&);
+void initializeOCLVectorizeWorkItemsPass(PassRegistry&);
 void initializeSPIRVLowerBoolPass(PassRegistry&);
 void initializeSPIRVLowerConstExprPass(PassRegistry&);
 void initializeSPIRVLowerOCLBlocksPass(PassRegistry&);
 void initializeSPIRVLowerMemmovePass(PassRegistry&);
 void initializeSPIRVRegularizeLLVMPass(PassRegistry&);
+void initializeSPIRVTTIPass(PassRegistry&);
 void initializeSPIRVToOCL20Pass(PassRegistry&);
 void initializeTransOCLMDPass(PassRegistry&);
 }
@@ -70,6 +72,12 @@ class SPIRVModule;
 /// \brief Check if a string contains SPIR-V binary.
 bool IsSPIRVBinary(std::string &Img);
 
+/// \brief Run the SPIR-V cleanup passes on a SPIR-V module read from the
+/// stream and write the optimized module.
+/// \returns true if succeeds.
+bool OptimizeSPIRV(std::istream &IS, llvm::raw_ostream &OS,
+    std::string &ErrMsg);
+
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
 /// \brief Convert SPIR-V between binary and internal textual formats.
 /// This function is not thread safe and should not be used in multi-thread
@@ -96,11 +104,26 @@ namespace llvm {
 /// \returns true if succeeds.
 bool WriteSPIRV(llvm::Module *M, llvm::raw_ostream &OS, std::string &ErrMsg);
 
+/// \brief Translate LLVM module to SPIRV and write to ostream. The
+/// random-access index of the SPIR-V binary, which records the offsets of
+/// its sections and functions, is written to \p IndexOS.
+/// \returns true if succeeds.
+bool WriteSPIRV(llvm::Module *M, llvm::raw_ostream &OS,
+    llvm::raw_ostream &IndexOS, std::string &ErrMsg);
+
 /// \brief Load SPIRV from istream and translate to LLVM module.
 /// \returns true if succeeds.
 bool ReadSPIRV(llvm::LLVMContext &C, std::istream &IS, llvm::Module *&M,
     std::string &ErrMsg);
 
+/// \brief Load SPIRV from seekable istream using the random-access index
+/// read from \p IndexIS and translate to LLVM module. Only the bodies of
+/// the functions named in \p FuncNames are decoded, the other functions are
+/// translated to declarations.
+/// \returns true if succeeds.
+bool ReadSPIRV(llvm::LLVMContext &C, std::istream &IS, std::istream &IndexIS,
+    ArrayRef<std::string> FuncNames, llvm::Module *&M, std::string &ErrMsg);
+
 /// \brief Regularize LLVM module by removing entities not representable by
 /// SPIRV.
 bool RegularizeLLVMForSPIRV(llvm::Module *M, std::string &ErrMsg);
@@ -127,6 +150,11 @@ ModulePass *createOCL21ToSPIRV();
 /// Create a pass for adapting OCL types for SPIRV.
 ModulePass *createOCLTypeToSPIRV();
 
+/// Create a pass adding to each OpenCL kernel K a function K.wg, which runs
+/// all the work-items of a work-group on a CPU, \p Width of them at a time
+/// in vector registers.
+ModulePass *createOCLVectorizeWorkItems(unsigned Width = 4);
+
 /// Create a pass for lowering cast instructions of i1 type.
 ModulePass *createSPIRVLowerBool();
 
@@ -136,12 +164,16 @@ ModulePass *createSPIRVLowerConstExpr();
 /// Create a pass for lowering OCL 2.0 blocks to functions calls.
 ModulePass *createSPIRVLowerOCLBlocks();
 
-/// Create a pass for lowering llvm.memmove to llvm.memcpys with a temporary variable.
+/// Create a pass for lowering llvm.memmove to llvm.memcpy or a copy loop.
 ModulePass *createSPIRVLowerMemmove();
 
 /// Create a pass for regularize LLVM module to be translated to SPIR-V.
 ModulePass *createSPIRVRegularizeLLVM();
 
+/// Create a target transform info which keeps LLVM optimizations from
+/// introducing constructs not representable by SPIR-V.
+ImmutablePass *createSPIRVTargetTransformInfo();
+
 /// Create a pass for translating SPIR-V builtin functions to OCL 2.0 builtin
 /// functions.
 ModulePass *createSPIRVToOCL20();
@@ -0,0 +1,217 @@
+//===-- llvm/Support/ThreadPool.h - A ThreadPool implementation -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a crude C++11 based thread pool and the parallel_for,
+// parallel_for_each and parallel_transform_reduce helpers built on top of it.
+//
+// When LLVM is built without thread support the pool has no worker threads:
+// tasks run synchronously in async() and the parallel algorithms run serially
+// on the calling thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_THREADPOOL_H
+#define LLVM_SUPPORT_THREADPOOL_H
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#endif
+
+namespace llvm {
+
+/// A ThreadPool for asynchronous parallel execution on a defined number of
+/// threads.
+///
+/// The pool keeps a vector of threads alive, waiting on a condition variable
+/// for some work to become available. Tasks are run in the order they were
+/// submitted, but may complete in any order.
+class ThreadPool {
+public:
+  typedef std::function<void()> TaskTy;
+
+  /// Construct a pool with one thread per hardware thread.
+  ThreadPool();
+
+  /// Construct a pool of \p ThreadCount threads. A count of zero means one
+  /// thread per hardware thread.
+  explicit ThreadPool(unsigned ThreadCount);
+
+  /// Blocking destructor: the pool waits for all the queued tasks to finish.
+  ~ThreadPool();
+
+  /// Asynchronous submission of a task to the pool. The returned future can
+  /// be used to wait for the task to finish and to retrieve its result.
+  template <typename Function, typename... Args>
+  auto async(Function &&F, Args &&... ArgList)
+      -> std::future<decltype(F(ArgList...))> {
+    typedef decltype(F(ArgList...)) ResultTy;
+    auto Task = std::make_shared<std::packaged_task<ResultTy()>>(
+        std::bind(std::forward<Function>(F), std::forward<Args>(ArgList)...));
+    std::future<ResultTy> Future = Task->get_future();
+    asyncImpl([Task]() { (*Task)(); });
+    return Future;
+  }
+
+  /// Blocking wait for all the tasks submitted so far to complete.
+  void wait();
+
+  /// Returns the number of worker threads, zero if LLVM is built without
+  /// thread support.
+  unsigned getThreadCount() const;
+
+private:
+  ThreadPool(const ThreadPool &) LLVM_DELETED_FUNCTION;
+  void operator=(const ThreadPool &) LLVM_DELETED_FUNCTION;
+
+  /// Enqueue \p Task, or run it right away without thread support.
+  void asyncImpl(TaskTy Task);
+
+#if LLVM_ENABLE_THREADS
+  /// The body of each worker thread.
+  void work();
+
+  /// Threads in flight.
+  std::vector<std::thread> Threads;
+
+  /// Tasks waiting for execution in the pool.
+  std::queue<TaskTy> Tasks;
+
+  /// Locking and signaling for accessing the Tasks queue and ActiveThreads.
+  std::mutex QueueLock;
+  std::condition_variable QueueCondition;
+
+  /// Signaling for job completion.
+  std::condition_variable CompletionCondition;
+
+  /// Keep track of the number of threads actually busy.
+  unsigned ActiveThreads;
+
+  /// Signal for the destruction of the pool, asking threads to exit.
+  bool EnableFlag;
+#endif
+};
+
+/// Returns the process-wide pool used by the parallel algorithms when no
+/// pool is given explicitly.
+ThreadPool &getDefaultThreadPool();
+
+/// Returns how many pool threads to use for a job that should run on
+/// \p NumThreads threads in total, the calling thread included. Zero means
+/// one thread per hardware thread. Returns zero when the job should run
+/// serially on the calling thread.
+unsigned getWorkerThreadCount(unsigned NumThreads);
+
+namespace detail {
+/// Call \p Body on disjoint chunks of [\p Begin, \p End) of at most \p Grain
+/// indices. The calling thread takes part in the work; idle workers steal
+/// half of the remaining indices of a busy one. Returns when all indices
+/// have been processed.
+void parallelForImpl(ThreadPool &Pool, size_t Begin, size_t End, size_t Grain,
+                     std::function<void(size_t, size_t)> Body);
+
+/// Chunk size giving each thread of \p Pool several chunks of [0, \p N).
+size_t getDefaultGrainSize(const ThreadPool &Pool, size_t N);
+} // end namespace detail
+
+/// Call \p Fn(I) for every I in [\p Begin, \p End) using the threads of
+/// \p Pool. The order of the calls is unspecified.
+template <typename IndexTy, typename FuncTy>
+void parallel_for(ThreadPool &Pool, IndexTy Begin, IndexTy End, FuncTy Fn) {
+  if (!(Begin < End))
+    return;
+  size_t N = End - Begin;
+  detail::parallelForImpl(Pool, 0, N, detail::getDefaultGrainSize(Pool, N),
+                          [&](size_t B, size_t E) {
+                            for (size_t I = B; I != E; ++I)
+                              Fn(IndexTy(Begin + I));
+                          });
+}
+
+template <typename IndexTy, typename FuncTy>
+void parallel_for(IndexTy Begin, IndexTy End, FuncTy Fn) {
+  parallel_for(getDefaultThreadPool(), Begin, End, Fn);
+}
+
+/// Call \p Fn on every element of the random access range [\p Begin, \p End)
+/// using the threads of \p Pool. The order of the calls is unspecified.
+template <typename RandomIt, typename FuncTy>
+void parallel_for_each(ThreadPool &Pool, RandomIt Begin, RandomIt End,
+                       FuncTy Fn) {
+  parallel_for(Pool, size_t(0), size_t(std::distance(Begin, End)),
+               [&](size_t I) { Fn(Begin[I]); });
+}
+
+template <typename RandomIt, typename FuncTy>
+void parallel_for_each(RandomIt Begin, RandomIt End, FuncTy Fn) {
+  parallel_for_each(getDefaultThreadPool(), Begin, End, Fn);
+}
+
+/// Reduce \p Transform(X) for every element X of [\p Begin, \p End) with
+/// \p Reduce. \p Init must be an identity of \p Reduce.
+///
+/// The range is cut into chunks whose bounds only depend on its size. Each
+/// chunk is reduced in order and the chunk results are then reduced in
+/// order, so the result does not depend on the number of threads or on
+/// scheduling even if \p Reduce is not associative, e.g. for floating point.
+template <typename RandomIt, typename ResultTy, typename ReduceFuncTy,
+          typename TransformFuncTy>
+ResultTy parallel_transform_reduce(ThreadPool &Pool, RandomIt Begin,
+                                   RandomIt End, ResultTy Init,
+                                   ReduceFuncTy Reduce,
+                                   TransformFuncTy Transform) {
+  const size_t MaxChunks = 1024;
+  size_t N = std::distance(Begin, End);
+  size_t NumChunks = std::min(N, MaxChunks);
+  if (NumChunks == 0)
+    return Init;
+  size_t ChunkSize = (N + NumChunks - 1) / NumChunks;
+  NumChunks = (N + ChunkSize - 1) / ChunkSize;
+
+  std::vector<ResultTy> Results(NumChunks, Init);
+  detail::parallelForImpl(Pool, 0, NumChunks, 1, [&](size_t B, size_t E) {
+    for (size_t C = B; C != E; ++C) {
+      RandomIt I = Begin + C * ChunkSize;
+      RandomIt ChunkEnd = Begin + std::min(N, (C + 1) * ChunkSize);
+      ResultTy R = Init;
+      for (; I != ChunkEnd; ++I)
+        R = Reduce(R, Transform(*I));
+      Results[C] = std::move(R);
+    }
+  });
+
+  ResultTy Result = Init;
+  for (ResultTy &R : Results)
+    Result = Reduce(Result, std::move(R));
+  return Result;
+}
+
+template <typename RandomIt, typename ResultTy, typename ReduceFuncTy,
+          typename TransformFuncTy>
+ResultTy parallel_transform_reduce(RandomIt Begin, RandomIt End,
+                                   ResultTy Init, ReduceFuncTy Reduce,
+                                   TransformFuncTy Transform) {
+  return parallel_transform_reduce(getDefaultThreadPool(), Begin, End, Init,
+                                   Reduce, Transform);
+}
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_THREADPOOL_H
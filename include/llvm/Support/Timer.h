@@ -67,6 +67,10 @@ public:
   /// print - Print the current timer to standard error, and reset the "Started"
   /// flag.
   void print(const TimeRecord &Total, raw_ostream &OS) const;
+
+  /// printJSONValues - Print the times in seconds and the memory used in bytes
+  /// as the members of a JSON object.
+  void printJSONValues(raw_ostream &OS) const;
 };
   
 /// Timer - This class is used to track the amount of time spent between
@@ -174,15 +178,24 @@ public:
 
   /// print - Print any started timers in this group and zero them.
   void print(raw_ostream &OS);
+
+  /// printJSON - Like print, but print the report as a JSON object on a single
+  /// line regardless of -timers-json.
+  void printJSON(raw_ostream &OS);
   
   /// printAll - This static method prints all timers and clears them all out.
   static void printAll(raw_ostream &OS);
+
+  /// printAllJSON - Like printAll, but print one JSON object per group.
+  static void printAllJSON(raw_ostream &OS);
   
 private:
   friend class Timer;
   void addTimer(Timer &T);
   void removeTimer(Timer &T);
+  bool queueStartedTimers();
   void PrintQueuedTimers(raw_ostream &OS);
+  void PrintQueuedTimersJSON(raw_ostream &OS);
 };
 
 } // End llvm namespace
@@ -22,14 +22,21 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/OperandTraits.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/DataStream.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
 
+static cl::opt<unsigned> MaterializeThreads(
+    "bitcode-materialize-threads", cl::init(1), cl::Hidden,
+    cl::desc("Number of threads decoding function bodies when the whole "
+             "module is materialized (0 = one per hardware thread)"));
+
 enum {
   SWITCH_INST_MAGIC = 0x4B5 // May 2012 => 1205 => Hex
 };
@@ -79,7 +86,7 @@ BitcodeReader::BitcodeReader(MemoryBuffer *buffer, LLVMContext &C,
       TheModule(nullptr), Buffer(buffer), LazyStreamer(nullptr),
       NextUnreadBit(0), SeenValueSymbolTable(false), ValueList(C),
       MDValueList(C), SeenFirstFunctionBody(false), UseRelativeIDs(false),
-      WillMaterializeAllForwardRefs(false) {}
+      WillMaterializeAllForwardRefs(false), Replay(nullptr) {}
 
 BitcodeReader::BitcodeReader(DataStreamer *streamer, LLVMContext &C,
                              DiagnosticHandlerFunction DiagnosticHandler)
@@ -87,7 +94,7 @@ BitcodeReader::BitcodeReader(DataStreamer *streamer, LLVMContext &C,
       TheModule(nullptr), Buffer(nullptr), LazyStreamer(streamer),
       NextUnreadBit(0), SeenValueSymbolTable(false), ValueList(C),
       MDValueList(C), SeenFirstFunctionBody(false), UseRelativeIDs(false),
-      WillMaterializeAllForwardRefs(false) {}
+      WillMaterializeAllForwardRefs(false), Replay(nullptr) {}
 
 std::error_code BitcodeReader::materializeForwardReferencedFunctions() {
   if (WillMaterializeAllForwardRefs)
@@ -133,6 +140,7 @@ void BitcodeReader::FreeState() {
   std::vector<BasicBlock*>().swap(FunctionBBs);
   std::vector<Function*>().swap(FunctionsWithBodies);
   DeferredFunctionInfo.clear();
+  DecodedFunctionBodies.clear();
   MDKindMap.clear();
 
   assert(BasicBlockFwdRefs.empty() && "Unresolved blockaddress fwd references");
@@ -1095,7 +1103,7 @@ std::error_code BitcodeReader::ParseTypeTableBody() {
 }
 
 std::error_code BitcodeReader::ParseValueSymbolTable() {
-  if (Stream.EnterSubBlock(bitc::VALUE_SYMTAB_BLOCK_ID))
+  if (EnterSubBlock(bitc::VALUE_SYMTAB_BLOCK_ID))
     return Error("Invalid record");
 
   SmallVector<uint64_t, 64> Record;
@@ -1103,7 +1111,7 @@ std::error_code BitcodeReader::ParseValueSymbolTable() {
   // Read all the records for this value table.
   SmallString<128> ValueName;
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = advanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -1118,7 +1126,7 @@ std::error_code BitcodeReader::ParseValueSymbolTable() {
 
     // Read a record.
     Record.clear();
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    switch (readRecord(Entry.ID, Record)) {
     default:  // Default behavior: unknown type.
       break;
     case bitc::VST_CODE_ENTRY: {  // VST_ENTRY: [valueid, namechar x N]
@@ -1151,14 +1159,14 @@ std::error_code BitcodeReader::ParseValueSymbolTable() {
 std::error_code BitcodeReader::ParseMetadata() {
   unsigned NextMDValueNo = MDValueList.size();
 
-  if (Stream.EnterSubBlock(bitc::METADATA_BLOCK_ID))
+  if (EnterSubBlock(bitc::METADATA_BLOCK_ID))
     return Error("Invalid record");
 
   SmallVector<uint64_t, 64> Record;
 
   // Read all the records.
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = advanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -1174,7 +1182,7 @@ std::error_code BitcodeReader::ParseMetadata() {
 
     // Read a record.
     Record.clear();
-    unsigned Code = Stream.readRecord(Entry.ID, Record);
+    unsigned Code = readRecord(Entry.ID, Record);
     bool IsDistinct = false;
     switch (Code) {
     default:  // Default behavior: ignore.
@@ -1183,10 +1191,10 @@ std::error_code BitcodeReader::ParseMetadata() {
       // Read name of the named metadata.
       SmallString<8> Name(Record.begin(), Record.end());
       Record.clear();
-      Code = Stream.ReadCode();
+      Code = ReadCode();
 
       // METADATA_NAME is always followed by METADATA_NAMED_NODE.
-      unsigned NextBitCode = Stream.readRecord(Code, Record);
+      unsigned NextBitCode = readRecord(Code, Record);
       assert(NextBitCode == bitc::METADATA_NAMED_NODE); (void)NextBitCode;
 
       // Read named metadata elements.
@@ -1405,7 +1413,7 @@ static APInt ReadWideAPInt(ArrayRef<uint64_t> Vals, unsigned TypeBits) {
 }
 
 std::error_code BitcodeReader::ParseConstants() {
-  if (Stream.EnterSubBlock(bitc::CONSTANTS_BLOCK_ID))
+  if (EnterSubBlock(bitc::CONSTANTS_BLOCK_ID))
     return Error("Invalid record");
 
   SmallVector<uint64_t, 64> Record;
@@ -1414,7 +1422,7 @@ std::error_code BitcodeReader::ParseConstants() {
   Type *CurTy = Type::getInt32Ty(Context);
   unsigned NextCstNo = ValueList.size();
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = advanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -1436,7 +1444,7 @@ std::error_code BitcodeReader::ParseConstants() {
     // Read a record.
     Record.clear();
     Value *V = nullptr;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = readRecord(Entry.ID, Record);
     switch (BitCode) {
     default:  // Default behavior: unknown constant
     case bitc::CST_CODE_UNDEF:     // UNDEF
@@ -1854,13 +1862,13 @@ std::error_code BitcodeReader::ParseConstants() {
 }
 
 std::error_code BitcodeReader::ParseUseLists() {
-  if (Stream.EnterSubBlock(bitc::USELIST_BLOCK_ID))
+  if (EnterSubBlock(bitc::USELIST_BLOCK_ID))
     return Error("Invalid record");
 
   // Read all the records.
   SmallVector<uint64_t, 64> Record;
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = advanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -1876,7 +1884,7 @@ std::error_code BitcodeReader::ParseUseLists() {
     // Read a use list record.
     Record.clear();
     bool IsBB = false;
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    switch (readRecord(Entry.ID, Record)) {
     default:  // Default behavior: unknown type.
       break;
     case bitc::USELIST_CODE_BB:
@@ -2469,12 +2477,12 @@ ErrorOr<std::string> BitcodeReader::parseTriple() {
 
 /// ParseMetadataAttachment - Parse metadata attachments.
 std::error_code BitcodeReader::ParseMetadataAttachment() {
-  if (Stream.EnterSubBlock(bitc::METADATA_ATTACHMENT_ID))
+  if (EnterSubBlock(bitc::METADATA_ATTACHMENT_ID))
     return Error("Invalid record");
 
   SmallVector<uint64_t, 64> Record;
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = advanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -2489,7 +2497,7 @@ std::error_code BitcodeReader::ParseMetadataAttachment() {
 
     // Read a metadata attachment record.
     Record.clear();
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    switch (readRecord(Entry.ID, Record)) {
     default:  // Default behavior: ignore.
       break;
     case bitc::METADATA_ATTACHMENT: {
@@ -2518,9 +2526,104 @@ std::error_code BitcodeReader::ParseMetadataAttachment() {
   }
 }
 
+bool DecodedFunctionBody::decode(BitstreamCursor &Cursor, uint64_t Bit) {
+  Cursor.JumpToBit(Bit);
+  if (Cursor.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+    return false;
+  return decodeBlock(Cursor);
+}
+
+bool DecodedFunctionBody::decodeBlock(BitstreamCursor &Cursor) {
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry Entry = Cursor.advance();
+    DecodedEntry D = { Entry.Kind, 0, 0, 0 };
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return false;
+    case BitstreamEntry::EndBlock:
+      Entries.push_back(D);
+      return true;
+
+    case BitstreamEntry::SubBlock: {
+      unsigned Idx = Entries.size();
+      D.ID = Entry.ID;
+      Entries.push_back(D);
+      switch (Entry.ID) {
+      default: // ParseFunctionBody skips unknown blocks too.
+        if (Cursor.SkipBlock())
+          return false;
+        break;
+      case bitc::CONSTANTS_BLOCK_ID:
+      case bitc::VALUE_SYMTAB_BLOCK_ID:
+      case bitc::METADATA_ATTACHMENT_ID:
+      case bitc::METADATA_BLOCK_ID:
+      case bitc::USELIST_BLOCK_ID:
+        if (Cursor.EnterSubBlock(Entry.ID) || !decodeBlock(Cursor))
+          return false;
+        break;
+      }
+      Entries[Idx].End = Entries.size();
+      continue;
+    }
+
+    case BitstreamEntry::Record:
+      Record.clear();
+      D.ID = Cursor.readRecord(Entry.ID, Record);
+      D.Begin = Ops.size();
+      D.End = D.Begin + Record.size();
+      Ops.insert(Ops.end(), Record.begin(), Record.end());
+      Entries.push_back(D);
+      continue;
+    }
+  }
+}
+
+BitstreamEntry DecodedFunctionBody::advance() {
+  if (Next == Entries.size())
+    return BitstreamEntry::getError();
+  const DecodedEntry &D = Entries[Next];
+  switch (D.Kind) {
+  case BitstreamEntry::SubBlock:
+    ++Next;
+    return BitstreamEntry::getSubBlock(D.ID);
+  case BitstreamEntry::EndBlock:
+    ++Next;
+    return BitstreamEntry::getEndBlock();
+  default:
+    // The record itself is consumed by readRecord.
+    return BitstreamEntry::getRecord(0);
+  }
+}
+
+BitstreamEntry DecodedFunctionBody::advanceSkippingSubblocks() {
+  while (1) {
+    BitstreamEntry Entry = advance();
+    if (Entry.Kind != BitstreamEntry::SubBlock)
+      return Entry;
+    SkipBlock();
+  }
+}
+
+unsigned DecodedFunctionBody::readRecord(SmallVectorImpl<uint64_t> &Vals) {
+  assert(Next < Entries.size() && Entries[Next].Kind == BitstreamEntry::Record &&
+         "No record to read");
+  const DecodedEntry &D = Entries[Next++];
+  Vals.append(Ops.begin() + D.Begin, Ops.begin() + D.End);
+  return D.ID;
+}
+
+bool DecodedFunctionBody::SkipBlock() {
+  assert(Next && Entries[Next - 1].Kind == BitstreamEntry::SubBlock &&
+         "Not at the start of a block");
+  Next = Entries[Next - 1].End;
+  return false;
+}
+
 /// ParseFunctionBody - Lazily parse the specified function body block.
 std::error_code BitcodeReader::ParseFunctionBody(Function *F) {
-  if (Stream.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+  if (EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
     return Error("Invalid record");
 
   InstructionList.clear();
@@ -2548,7 +2651,7 @@ std::error_code BitcodeReader::ParseFunctionBody(Function *F) {
   // Read all the records.
   SmallVector<uint64_t, 64> Record;
   while (1) {
-    BitstreamEntry Entry = Stream.advance();
+    BitstreamEntry Entry = advance();
 
     switch (Entry.Kind) {
     case BitstreamEntry::Error:
@@ -2559,7 +2662,7 @@ std::error_code BitcodeReader::ParseFunctionBody(Function *F) {
     case BitstreamEntry::SubBlock:
       switch (Entry.ID) {
       default:  // Skip unknown content.
-        if (Stream.SkipBlock())
+        if (SkipBlock())
           return Error("Invalid record");
         break;
       case bitc::CONSTANTS_BLOCK_ID:
@@ -2594,7 +2697,7 @@ std::error_code BitcodeReader::ParseFunctionBody(Function *F) {
     // Read a record.
     Record.clear();
     Instruction *I = nullptr;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = readRecord(Entry.ID, Record);
     switch (BitCode) {
     default: // Default behavior: reject
       return Error("Invalid value");
@@ -3496,10 +3599,21 @@ std::error_code BitcodeReader::materialize(GlobalValue *GV) {
     if (std::error_code EC = FindFunctionInStream(F, DFII))
       return EC;
 
-  // Move the bit stream to the saved position of the deferred function body.
-  Stream.JumpToBit(DFII->second);
+  // Replay the body if it was decoded ahead of time, otherwise move the bit
+  // stream to the saved position of the deferred function body.
+  std::unique_ptr<DecodedFunctionBody> Decoded;
+  auto DFBI = DecodedFunctionBodies.find(F);
+  if (DFBI != DecodedFunctionBodies.end()) {
+    Decoded = std::move(DFBI->second);
+    DecodedFunctionBodies.erase(DFBI);
+    Replay = Decoded.get();
+  } else {
+    Stream.JumpToBit(DFII->second);
+  }
 
-  if (std::error_code EC = ParseFunctionBody(F))
+  std::error_code EC = ParseFunctionBody(F);
+  Replay = nullptr;
+  if (EC)
     return EC;
   F->setIsMaterializable(false);
 
@@ -3553,6 +3667,9 @@ std::error_code BitcodeReader::MaterializeModule(Module *M) {
   // Promise to materialize all forward references.
   WillMaterializeAllForwardRefs = true;
 
+  if (MaterializeThreads != 1)
+    decodeFunctionBodies();
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Module::iterator F = TheModule->begin(), E = TheModule->end();
@@ -3597,6 +3714,43 @@ std::error_code BitcodeReader::MaterializeModule(Module *M) {
   return std::error_code();
 }
 
+/// Decode the bodies of the functions still to be materialized in parallel,
+/// each thread with its own cursor over the shared bitstream. Building the
+/// IR uniques constants and types in the context and fills ValueList and
+/// MDValueList, so it stays serial and replays the decoded records.
+void BitcodeReader::decodeFunctionBodies() {
+  // A streamed module may not have been read up to the bodies yet.
+  if (LazyStreamer)
+    return;
+
+  std::vector<std::pair<Function *, uint64_t>> Bodies;
+  for (Function &F : *TheModule) {
+    if (!F.isMaterializable() || DecodedFunctionBodies.count(&F))
+      continue;
+    DenseMap<Function *, uint64_t>::iterator DFII =
+        DeferredFunctionInfo.find(&F);
+    if (DFII != DeferredFunctionInfo.end() && DFII->second)
+      Bodies.push_back(std::make_pair(&F, DFII->second));
+  }
+  unsigned NumWorkers = getWorkerThreadCount(MaterializeThreads);
+  if (Bodies.size() < 2 || NumWorkers == 0)
+    return;
+
+  ThreadPool Pool(NumWorkers);
+  std::vector<std::unique_ptr<DecodedFunctionBody>> Decoded(Bodies.size());
+  parallel_for(Pool, size_t(0), Bodies.size(), [&](size_t I) {
+    BitstreamCursor Cursor(*StreamFile);
+    std::unique_ptr<DecodedFunctionBody> Body(new DecodedFunctionBody());
+    // Leave malformed bodies to ParseFunctionBody to diagnose.
+    if (Body->decode(Cursor, Bodies[I].second))
+      Decoded[I] = std::move(Body);
+  });
+
+  for (size_t I = 0, E = Bodies.size(); I != E; ++I)
+    if (Decoded[I])
+      DecodedFunctionBodies[Bodies[I].first] = std::move(Decoded[I]);
+}
+
 std::vector<StructType *> BitcodeReader::getIdentifiedStructTypes() const {
   return IdentifiedStructTypes;
 }
@@ -25,6 +25,7 @@
 #include "llvm/IR/Type.h"
 #include "llvm/IR/ValueHandle.h"
 #include <deque>
+#include <memory>
 #include <system_error>
 #include <vector>
 
@@ -132,6 +133,43 @@ public:
   void tryToResolveCycles();
 };
 
+//===----------------------------------------------------------------------===//
+//                          DecodedFunctionBody Class
+//===----------------------------------------------------------------------===//
+
+/// The records of a function block, decoded ahead of ParseFunctionBody so
+/// that the bit-level decoding of many bodies can run in parallel while the
+/// IR is still built serially. Replaying it mimics the part of the
+/// BitstreamCursor interface used by the function body parsers.
+class DecodedFunctionBody {
+  struct DecodedEntry {
+    /// The BitstreamEntry kind.
+    unsigned Kind;
+    /// The block ID of a sub-block or the code of a record.
+    unsigned ID;
+    /// The operands of a record in Ops. For a sub-block, End is the index of
+    /// the entry following the block.
+    unsigned Begin, End;
+  };
+  std::vector<DecodedEntry> Entries;
+  std::vector<uint64_t> Ops;
+  unsigned Next;
+
+  bool decodeBlock(BitstreamCursor &Cursor);
+
+public:
+  DecodedFunctionBody() : Next(0) {}
+
+  /// Decode the function block whose body starts at \p Bit. Returns false if
+  /// the block is malformed; the serial parser then reports the error.
+  bool decode(BitstreamCursor &Cursor, uint64_t Bit);
+
+  BitstreamEntry advance();
+  BitstreamEntry advanceSkippingSubblocks();
+  unsigned readRecord(SmallVectorImpl<uint64_t> &Vals);
+  bool SkipBlock();
+};
+
 class BitcodeReader : public GVMaterializer {
   LLVMContext &Context;
   DiagnosticHandlerFunction DiagnosticHandler;
@@ -212,6 +250,12 @@ class BitcodeReader : public GVMaterializer {
   /// Functions that have block addresses taken.  This is usually empty.
   SmallPtrSet<const Function *, 4> BlockAddressesTaken;
 
+  /// Function bodies decoded ahead of time by MaterializeModule, and the one
+  /// ParseFunctionBody is replaying instead of reading Stream, if any.
+  DenseMap<Function *, std::unique_ptr<DecodedFunctionBody>>
+      DecodedFunctionBodies;
+  DecodedFunctionBody *Replay;
+
 public:
   std::error_code Error(BitcodeError E, const Twine &Message);
   std::error_code Error(BitcodeError E);
@@ -335,6 +379,29 @@ private:
     return getFnValueByID(ValNo, Ty);
   }
 
+  /// Record access for the parsers reachable from ParseFunctionBody, which
+  /// may replay a pre-decoded function body instead of reading Stream.
+  BitstreamEntry advance() {
+    return Replay ? Replay->advance() : Stream.advance();
+  }
+  BitstreamEntry advanceSkippingSubblocks() {
+    return Replay ? Replay->advanceSkippingSubblocks()
+                  : Stream.advanceSkippingSubblocks();
+  }
+  unsigned readRecord(unsigned AbbrevID, SmallVectorImpl<uint64_t> &Vals) {
+    return Replay ? Replay->readRecord(Vals) : Stream.readRecord(AbbrevID, Vals);
+  }
+  unsigned ReadCode() {
+    return Replay ? 0 : Stream.ReadCode();
+  }
+  bool EnterSubBlock(unsigned BlockID) {
+    // The decoder has already entered the block.
+    return Replay ? false : Stream.EnterSubBlock(BlockID);
+  }
+  bool SkipBlock() {
+    return Replay ? Replay->SkipBlock() : Stream.SkipBlock();
+  }
+
   std::error_code ParseAttrKind(uint64_t Code, Attribute::AttrKind *Kind);
   std::error_code ParseModule(bool Resume);
   std::error_code ParseAttributeBlock();
@@ -346,6 +413,7 @@ private:
   std::error_code ParseConstants();
   std::error_code RememberAndSkipFunctionBody();
   std::error_code ParseFunctionBody(Function *F);
+  void decodeFunctionBodies();
   std::error_code GlobalCleanup();
   std::error_code ResolveGlobalAndAliasInits();
   std::error_code ParseMetadata();
@@ -28,11 +28,18 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cctype>
 #include <map>
+#include <mutex>
 using namespace llvm;
 
+static cl::opt<unsigned> WriteThreads(
+    "bitcode-write-threads", cl::init(1), cl::Hidden,
+    cl::desc("Number of threads writing function blocks "
+             "(0 = one per hardware thread)"));
+
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
 enum {
@@ -1697,10 +1704,10 @@ static void WriteUseListBlock(const Function *F, ValueEnumerator &VE,
   Stream.ExitBlock();
 }
 
-/// WriteFunction - Emit a function body to the module stream.
-static void WriteFunction(const Function &F, ValueEnumerator &VE,
-                          BitstreamWriter &Stream) {
-  Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+/// WriteFunctionBody - Emit the records of a function body into the
+/// FUNCTION_BLOCK the stream is in.
+static void WriteFunctionBody(const Function &F, ValueEnumerator &VE,
+                              BitstreamWriter &Stream) {
   VE.incorporateFunction(F);
 
   SmallVector<unsigned, 64> Vals;
@@ -1769,6 +1776,13 @@ static void WriteFunction(const Function &F, ValueEnumerator &VE,
   if (shouldPreserveBitcodeUseListOrder())
     WriteUseListBlock(&F, VE, Stream);
   VE.purgeFunction();
+}
+
+/// WriteFunction - Emit a function body to the module stream.
+static void WriteFunction(const Function &F, ValueEnumerator &VE,
+                          BitstreamWriter &Stream) {
+  Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+  WriteFunctionBody(F, VE, Stream);
   Stream.ExitBlock();
 }
 
@@ -1933,6 +1947,72 @@ static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
   Stream.ExitBlock();
 }
 
+namespace {
+/// A thread's copy of the module-level enumeration together with the stream
+/// it writes function blocks to. FUNCTION_BLOCK abbreviations come from
+/// BLOCKINFO, so the stream is primed with it before the first block.
+struct FunctionBlockWriter {
+  ValueEnumerator VE;
+  SmallVector<char, 0> Buffer;
+  BitstreamWriter Stream;
+
+  explicit FunctionBlockWriter(const ValueEnumerator &ModuleVE)
+      : VE(ModuleVE), Stream(Buffer) {
+    // Only the abbreviations matter; the BLOCKINFO block itself is dropped.
+    WriteBlockInfo(VE, Stream);
+    Buffer.clear();
+  }
+};
+} // end anonymous namespace
+
+/// WriteFunctionsInParallel - Emit the function bodies of the module on the
+/// threads of \p Pool. Each FunctionBlockWriter incorporates functions into
+/// its own copy of the module-level enumeration and writes whole
+/// FUNCTION_BLOCKs with its own BitstreamWriter. Writers are reused across
+/// functions, so there are at most as many as threads. The blocks are then
+/// spliced into the module stream in order, so the output is identical to
+/// writing them serially.
+static void WriteFunctionsInParallel(const Module *M, const ValueEnumerator &VE,
+                                     BitstreamWriter &Stream,
+                                     ThreadPool &Pool) {
+  std::vector<const Function *> Functions;
+  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+    if (!F->isDeclaration())
+      Functions.push_back(F);
+
+  std::vector<SmallVector<char, 0>> Blocks(Functions.size());
+  std::vector<std::unique_ptr<FunctionBlockWriter>> Writers;
+  std::vector<FunctionBlockWriter *> IdleWriters;
+  std::mutex WritersLock;
+  parallel_for(Pool, size_t(0), Functions.size(), [&](size_t I) {
+    FunctionBlockWriter *W = nullptr;
+    {
+      std::lock_guard<std::mutex> Guard(WritersLock);
+      if (IdleWriters.empty()) {
+        Writers.emplace_back(new FunctionBlockWriter(VE));
+        W = Writers.back().get();
+      } else {
+        W = IdleWriters.back();
+        IdleWriters.pop_back();
+      }
+    }
+
+    W->Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+    // The block size word is the last word of the block header.
+    size_t Begin = W->Buffer.size() - 4;
+    WriteFunctionBody(*Functions[I], W->VE, W->Stream);
+    W->Stream.ExitBlock();
+    Blocks[I].append(W->Buffer.begin() + Begin, W->Buffer.end());
+    W->Buffer.clear();
+
+    std::lock_guard<std::mutex> Guard(WritersLock);
+    IdleWriters.push_back(W);
+  });
+
+  for (auto &Block : Blocks)
+    Stream.EmitSubblock(bitc::FUNCTION_BLOCK_ID, 4, Block);
+}
+
 /// WriteModule - Emit the specified module to the bitstream.
 static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
@@ -1979,10 +2059,17 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   if (shouldPreserveBitcodeUseListOrder())
     WriteUseListBlock(nullptr, VE, Stream);
 
-  // Emit function bodies.
-  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
-      WriteFunction(*F, VE, Stream);
+  // Emit function bodies. Use-list orders are kept on a single stack that
+  // is consumed function by function, so they are only written serially.
+  unsigned NumWorkers = getWorkerThreadCount(WriteThreads);
+  if (NumWorkers && !shouldPreserveBitcodeUseListOrder()) {
+    ThreadPool Pool(NumWorkers);
+    WriteFunctionsInParallel(M, VE, Stream, Pool);
+  } else {
+    for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+      if (!F->isDeclaration())
+        WriteFunction(*F, VE, Stream);
+  }
 
   Stream.ExitBlock();
 }
@@ -282,6 +282,22 @@ static bool isIntOrIntVectorValue(const std::pair<const Value*, unsigned> &V) {
   return V.first->getType()->isIntOrIntVectorTy();
 }
 
+ValueEnumerator::ValueEnumerator(const ValueEnumerator &VE)
+    : TypeMap(VE.TypeMap), Types(VE.Types), ValueMap(VE.ValueMap),
+      Values(VE.Values), Comdats(VE.Comdats), MDs(VE.MDs),
+      FunctionLocalMDs(VE.FunctionLocalMDs), MDValueMap(VE.MDValueMap),
+      HasMDString(VE.HasMDString), HasMDLocation(VE.HasMDLocation),
+      AttributeGroupMap(VE.AttributeGroupMap),
+      AttributeGroups(VE.AttributeGroups), AttributeMap(VE.AttributeMap),
+      Attribute(VE.Attribute), GlobalBasicBlockIDs(VE.GlobalBasicBlockIDs),
+      InstructionMap(VE.InstructionMap), InstructionCount(VE.InstructionCount),
+      BasicBlocks(VE.BasicBlocks), NumModuleValues(VE.NumModuleValues),
+      NumModuleMDs(VE.NumModuleMDs),
+      FirstFuncConstantID(VE.FirstFuncConstantID),
+      FirstInstID(VE.FirstInstID) {
+  assert(VE.UseListOrders.empty() && "Use-list orders cannot be copied");
+}
+
 ValueEnumerator::ValueEnumerator(const Module &M)
     : HasMDString(false), HasMDLocation(false) {
   if (shouldPreserveBitcodeUseListOrder())
@@ -0,0 +1,392 @@
+//===-- ParallelCG.cpp ----------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines functions that can be used for parallel code generation.
+//
+// The module is partitioned in place, the partitioned module is written to
+// bitcode once, and every thread reads its own copy back into a private
+// LLVMContext, since a context cannot be used from several threads. The
+// thread then turns the definitions of the other partitions into declarations
+// and runs the code generator on what is left.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include <algorithm>
+#include <memory>
+
+using namespace llvm;
+
+namespace {
+/// The partition of every function, global variable and alias of a module,
+/// in module order. Declarations and the llvm.used lists have no partition:
+/// every partition keeps them.
+struct ModulePartitioning {
+  static const unsigned NoPartition = ~0U;
+
+  std::vector<unsigned> Functions;
+  std::vector<unsigned> Variables;
+  std::vector<unsigned> Aliases;
+};
+}
+
+typedef DenseMap<const GlobalValue *, unsigned> PartitionMap;
+
+static bool isUsedList(const GlobalValue *GV) {
+  return GV->getName() == "llvm.used" || GV->getName() == "llvm.compiler.used";
+}
+
+/// Add to \p Owners the globals whose definitions refer to \p V, looking
+/// through constant expressions.
+static void findOwners(const Value *V,
+                       SmallPtrSetImpl<const GlobalValue *> &Owners,
+                       SmallPtrSetImpl<const Constant *> &Visited) {
+  for (const User *U : V->users()) {
+    if (auto I = dyn_cast<Instruction>(U))
+      Owners.insert(I->getParent()->getParent());
+    else if (auto GV = dyn_cast<GlobalValue>(U))
+      Owners.insert(GV);
+    else if (auto C = dyn_cast<Constant>(U))
+      if (Visited.insert(C).second)
+        findOwners(C, Owners, Visited);
+  }
+}
+
+static void findOwners(const Value *V,
+                       SmallPtrSetImpl<const GlobalValue *> &Owners) {
+  SmallPtrSet<const Constant *, 8> Visited;
+  findOwners(V, Owners, Visited);
+}
+
+/// The weight of a global when balancing the partitions.
+static uint64_t getSize(const GlobalValue *GV) {
+  uint64_t Size = 1;
+  if (auto F = dyn_cast<Function>(GV))
+    for (const BasicBlock &BB : *F)
+      Size += BB.size();
+  return Size;
+}
+
+/// Assign the definitions of \p M to \p N partitions. Globals that must be
+/// emitted into the same object are grouped first, then the groups are dealt
+/// out largest first, each to the partition with the smallest size so far.
+/// Ties are broken by module order, so the result only depends on \p M.
+static PartitionMap partitionModule(const Module &M, unsigned N) {
+  EquivalenceClasses<const GlobalValue *> Groups;
+  DenseMap<const Comdat *, const GlobalValue *> ComdatLeaders;
+
+  auto addObject = [&](const GlobalObject &GO) {
+    if (GO.isDeclaration() || isUsedList(&GO))
+      return;
+    Groups.insert(&GO);
+    if (const Comdat *C = GO.getComdat()) {
+      auto Inserted = ComdatLeaders.insert(std::make_pair(C, &GO));
+      if (!Inserted.second)
+        Groups.unionSets(&GO, Inserted.first->second);
+    }
+  };
+
+  for (const Function &F : M) {
+    addObject(F);
+    // A block address can only be emitted with the function of the block.
+    for (const BasicBlock &BB : F) {
+      if (!BB.hasAddressTaken())
+        continue;
+      SmallPtrSet<const GlobalValue *, 4> Owners;
+      if (const BlockAddress *BA = BlockAddress::lookup(&BB))
+        findOwners(BA, Owners);
+      for (const GlobalValue *Owner : Owners)
+        if (!isUsedList(Owner))
+          Groups.unionSets(&F, Owner);
+    }
+  }
+  for (const GlobalVariable &GV : M.globals())
+    addObject(GV);
+  for (const GlobalAlias &GA : M.aliases()) {
+    Groups.insert(&GA);
+    const GlobalObject *Base = GA.getBaseObject();
+    if (Base && !Base->isDeclaration())
+      Groups.unionSets(&GA, Base);
+  }
+
+  // Collect the groups in module order with their sizes.
+  std::vector<const GlobalValue *> Leaders;
+  DenseMap<const GlobalValue *, uint64_t> GroupSize;
+  auto addToGroup = [&](const GlobalValue &GV) {
+    if (Groups.findValue(&GV) == Groups.end())
+      return;
+    const GlobalValue *Leader = Groups.getLeaderValue(&GV);
+    auto Inserted = GroupSize.insert(std::make_pair(Leader, 0));
+    if (Inserted.second)
+      Leaders.push_back(Leader);
+    Inserted.first->second += getSize(&GV);
+  };
+  for (const Function &F : M)
+    addToGroup(F);
+  for (const GlobalVariable &GV : M.globals())
+    addToGroup(GV);
+  for (const GlobalAlias &GA : M.aliases())
+    addToGroup(GA);
+
+  std::stable_sort(Leaders.begin(), Leaders.end(),
+                   [&](const GlobalValue *A, const GlobalValue *B) {
+                     return GroupSize[A] > GroupSize[B];
+                   });
+
+  std::vector<uint64_t> PartitionSize(N, 0);
+  PartitionMap LeaderPartition;
+  for (const GlobalValue *Leader : Leaders) {
+    unsigned P = std::min_element(PartitionSize.begin(), PartitionSize.end()) -
+                 PartitionSize.begin();
+    LeaderPartition[Leader] = P;
+    PartitionSize[P] += GroupSize[Leader];
+  }
+
+  PartitionMap Partition;
+  for (auto I = Groups.begin(), E = Groups.end(); I != E; ++I)
+    for (auto MI = Groups.member_begin(I); MI != Groups.member_end(); ++MI)
+      Partition[*MI] = LeaderPartition[Groups.getLeaderValue(*MI)];
+  return Partition;
+}
+
+/// Give external linkage and hidden visibility to the local globals that are
+/// referenced from another partition than their own.
+static void externalizeCrossPartitionLocals(Module &M,
+                                            const PartitionMap &Partition) {
+  auto externalize = [&](GlobalValue &GV) {
+    if (!GV.hasLocalLinkage())
+      return;
+    auto It = Partition.find(&GV);
+    if (It == Partition.end())
+      return;
+    SmallPtrSet<const GlobalValue *, 8> Owners;
+    findOwners(&GV, Owners);
+    for (const GlobalValue *Owner : Owners) {
+      // The llvm.used lists have no partition: each partition filters them.
+      auto OwnerIt = Partition.find(Owner);
+      if (OwnerIt == Partition.end() || OwnerIt->second == It->second)
+        continue;
+      // Unnamed globals would be given a different name by each partition.
+      if (!GV.hasName())
+        GV.setName("__llvmsplit_unnamed");
+      GV.setLinkage(GlobalValue::ExternalLinkage);
+      GV.setVisibility(GlobalValue::HiddenVisibility);
+      return;
+    }
+  };
+
+  for (Function &F : M)
+    externalize(F);
+  for (GlobalVariable &GV : M.globals())
+    externalize(GV);
+  for (GlobalAlias &GA : M.aliases())
+    externalize(GA);
+}
+
+static ModulePartitioning getModulePartitioning(const Module &M,
+                                                const PartitionMap &Partition) {
+  auto getPartition = [&](const GlobalValue &GV) {
+    auto It = Partition.find(&GV);
+    return It == Partition.end() ? ModulePartitioning::NoPartition
+                                 : It->second;
+  };
+
+  ModulePartitioning Parts;
+  for (const Function &F : M)
+    Parts.Functions.push_back(getPartition(F));
+  for (const GlobalVariable &GV : M.globals())
+    Parts.Variables.push_back(getPartition(GV));
+  for (const GlobalAlias &GA : M.aliases())
+    Parts.Aliases.push_back(getPartition(GA));
+  return Parts;
+}
+
+/// Drop from the used list \p Name the globals that are not defined here.
+static void filterUsedList(Module &M, StringRef Name) {
+  GlobalVariable *Used = M.getGlobalVariable(Name);
+  if (!Used || !Used->hasInitializer())
+    return;
+  auto Init = dyn_cast<ConstantArray>(Used->getInitializer());
+  if (!Init)
+    return;
+
+  SmallVector<Constant *, 16> Kept;
+  for (const Use &Op : Init->operands()) {
+    auto C = cast<Constant>(Op);
+    auto GV = dyn_cast<GlobalValue>(C->stripPointerCasts());
+    if (!GV || !GV->isDeclaration())
+      Kept.push_back(C);
+  }
+  if (Kept.size() == Init->getNumOperands())
+    return;
+
+  if (!Kept.empty()) {
+    ArrayType *ATy = ArrayType::get(Init->getType()->getElementType(),
+                                    Kept.size());
+    GlobalVariable *NewUsed = new GlobalVariable(
+        M, ATy, false, GlobalValue::AppendingLinkage,
+        ConstantArray::get(ATy, Kept), "", Used);
+    NewUsed->setSection(Used->getSection());
+    NewUsed->takeName(Used);
+  }
+  Used->eraseFromParent();
+}
+
+/// Turn the definitions of \p M that do not belong to partition \p P into
+/// declarations. \p M must have been read from the bitcode of the module
+/// \p Parts was computed for.
+static void keepPartition(Module &M, const ModulePartitioning &Parts,
+                          unsigned P) {
+  auto isElsewhere = [&](unsigned Part) {
+    return Part != ModulePartitioning::NoPartition && Part != P;
+  };
+
+  unsigned I = 0;
+  for (Function &F : M) {
+    if (!isElsewhere(Parts.Functions[I++]))
+      continue;
+    F.deleteBody();
+    F.setComdat(nullptr);
+  }
+
+  I = 0;
+  for (auto GVI = M.global_begin(), E = M.global_end(); GVI != E;) {
+    GlobalVariable &GV = *GVI++;
+    if (!isElsewhere(Parts.Variables[I++]))
+      continue;
+    if (GV.hasAppendingLinkage() && GV.use_empty()) {
+      GV.eraseFromParent();
+      continue;
+    }
+    GV.setInitializer(nullptr);
+    GV.setLinkage(GlobalValue::ExternalLinkage);
+    GV.setComdat(nullptr);
+  }
+
+  // An alias needs a definition, so the aliases of the other partitions are
+  // replaced with plain declarations. This comes last because it appends to
+  // the lists indexed above.
+  I = 0;
+  for (auto GAI = M.alias_begin(), E = M.alias_end(); GAI != E;) {
+    GlobalAlias &GA = *GAI++;
+    if (!isElsewhere(Parts.Aliases[I++]))
+      continue;
+    PointerType *Ty = GA.getType();
+    GlobalValue *Decl;
+    if (auto FTy = dyn_cast<FunctionType>(Ty->getElementType()))
+      Decl = Function::Create(FTy, GlobalValue::ExternalLinkage, "", &M);
+    else
+      Decl = new GlobalVariable(M, Ty->getElementType(), false,
+                                GlobalValue::ExternalLinkage, nullptr, "",
+                                nullptr, GA.getThreadLocalMode(),
+                                Ty->getAddressSpace());
+    Decl->takeName(&GA);
+    Decl->setVisibility(GA.getVisibility());
+    GA.replaceAllUsesWith(Decl);
+    GA.eraseFromParent();
+  }
+
+  filterUsedList(M, "llvm.used");
+  filterUsedList(M, "llvm.compiler.used");
+}
+
+static bool codegen(Module &M, raw_ostream &OS, TargetMachine &TM,
+                    TargetMachine::CodeGenFileType FileType,
+                    std::string &ErrMsg) {
+  PassManager CodeGenPasses;
+  CodeGenPasses.add(new DataLayoutPass());
+
+  formatted_raw_ostream FOS(OS);
+  if (TM.addPassesToEmitFile(CodeGenPasses, FOS, FileType)) {
+    ErrMsg = "target file type not supported";
+    return true;
+  }
+  CodeGenPasses.run(M);
+  return false;
+}
+
+static bool codegenPartition(StringRef Bitcode,
+                             const ModulePartitioning &Parts, unsigned P,
+                             raw_ostream &OS, const TargetMachine &TM,
+                             TargetMachine::CodeGenFileType FileType,
+                             std::string &ErrMsg) {
+  LLVMContext Context;
+  ErrorOr<Module *> MOrErr =
+      parseBitcodeFile(MemoryBufferRef(Bitcode, "<split-module>"), Context);
+  if (std::error_code EC = MOrErr.getError()) {
+    ErrMsg = EC.message();
+    return true;
+  }
+  std::unique_ptr<Module> M(MOrErr.get());
+  keepPartition(*M, Parts, P);
+
+  std::unique_ptr<TargetMachine> PartTM(TM.getTarget().createTargetMachine(
+      TM.getTargetTriple(), TM.getTargetCPU(), TM.getTargetFeatureString(),
+      TM.Options, TM.getRelocationModel(), TM.getCodeModel(),
+      TM.getOptLevel()));
+  return codegen(*M, OS, *PartTM, FileType, ErrMsg);
+}
+
+bool llvm::splitCodeGen(Module &M, ArrayRef<raw_ostream *> OSs,
+                        TargetMachine &TM,
+                        TargetMachine::CodeGenFileType FileType,
+                        std::string &ErrMsg) {
+  assert(!OSs.empty() && "No output streams");
+  if (OSs.size() == 1)
+    return codegen(M, *OSs[0], TM, FileType, ErrMsg);
+
+  PartitionMap Partition = partitionModule(M, OSs.size());
+  externalizeCrossPartitionLocals(M, Partition);
+  ModulePartitioning Parts = getModulePartitioning(M, Partition);
+
+  SmallVector<char, 0> Bitcode;
+  {
+    raw_svector_ostream BitcodeOS(Bitcode);
+    WriteBitcodeToFile(&M, BitcodeOS);
+  }
+  StringRef BitcodeRef(Bitcode.data(), Bitcode.size());
+
+  std::vector<std::string> Errors(OSs.size());
+  {
+    ThreadPool Pool(OSs.size());
+    for (unsigned P = 0, E = OSs.size(); P != E; ++P)
+      Pool.async([&, P] {
+        codegenPartition(BitcodeRef, Parts, P, *OSs[P], TM, FileType,
+                         Errors[P]);
+      });
+    Pool.wait();
+  }
+
+  for (const std::string &Error : Errors)
+    if (!Error.empty()) {
+      ErrMsg = Error;
+      return true;
+    }
+  return false;
+}
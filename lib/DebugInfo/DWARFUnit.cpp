@@ -12,6 +12,7 @@
 #include "llvm/DebugInfo/DWARFFormValue.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
 #include <cstdio>
 
 using namespace llvm;
@@ -293,6 +294,9 @@ bool DWARFUnit::parseDWO() {
 }
 
 void DWARFUnit::clearDIEs(bool KeepCUDie) {
+  // The subprogram index refers to DIEs by their position in DieArray.
+  std::vector<SubprogramRange>().swap(SubprogramIndex);
+  SubprogramIndexBuilt = false;
   if (DieArray.size() > (unsigned)KeepCUDie) {
     // std::vectors never get any smaller when resized to a smaller size,
     // or when clear() or erase() are called, the size will report that it
@@ -339,16 +343,55 @@ void DWARFUnit::collectAddressRanges(DWARFAddressRangesVector &CURanges) {
     clearDIEs(true);
 }
 
+void DWARFUnit::buildSubprogramIndex() {
+  SubprogramIndex.clear();
+  for (uint32_t I = 0, E = DieArray.size(); I != E; ++I) {
+    const DWARFDebugInfoEntryMinimal &DIE = DieArray[I];
+    if (!DIE.isSubprogramDIE())
+      continue;
+    for (const auto &R : DIE.getAddressRanges(this)) {
+      if (R.first < R.second)
+        SubprogramIndex.push_back({R.first, R.second, 0, I});
+    }
+  }
+  std::sort(SubprogramIndex.begin(), SubprogramIndex.end(),
+            [](const SubprogramRange &LHS, const SubprogramRange &RHS) {
+    if (LHS.LowPC != RHS.LowPC)
+      return LHS.LowPC < RHS.LowPC;
+    return LHS.DIEIndex < RHS.DIEIndex;
+  });
+  uint64_t MaxHighPC = 0;
+  for (SubprogramRange &R : SubprogramIndex) {
+    MaxHighPC = std::max(MaxHighPC, R.HighPC);
+    R.MaxHighPC = MaxHighPC;
+  }
+  SubprogramIndexBuilt = true;
+}
+
 const DWARFDebugInfoEntryMinimal *
 DWARFUnit::getSubprogramForAddress(uint64_t Address) {
   extractDIEsIfNeeded(false);
-  for (const DWARFDebugInfoEntryMinimal &DIE : DieArray) {
-    if (DIE.isSubprogramDIE() &&
-        DIE.addressRangeContainsAddress(this, Address)) {
-      return &DIE;
-    }
+  if (!SubprogramIndexBuilt)
+    buildSubprogramIndex();
+  // Walk back from the last range starting at or before Address for as long
+  // as an earlier range may still contain it. Ranges of different subprograms
+  // normally don't overlap, so this stops after a step or two. If they do,
+  // pick the subprogram that comes first in the unit, as a scan over the DIEs
+  // would.
+  auto It = std::upper_bound(
+      SubprogramIndex.begin(), SubprogramIndex.end(), Address,
+      [](uint64_t Addr, const SubprogramRange &R) { return Addr < R.LowPC; });
+  uint32_t Found = -1U;
+  while (It != SubprogramIndex.begin()) {
+    --It;
+    if (It->MaxHighPC <= Address)
+      break;
+    if (Address < It->HighPC)
+      Found = std::min(Found, It->DIEIndex);
   }
-  return nullptr;
+  if (Found == -1U)
+    return nullptr;
+  return &DieArray[Found];
 }
 
 DWARFDebugInfoEntryInlinedChain
@@ -13,11 +13,13 @@
 
 #include "Interpreter.h"
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/IntrinsicLowering.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
@@ -39,7 +41,7 @@ static cl::opt<bool> PrintVolatile("interpreter-print-volatile", cl::Hidden,
 //===----------------------------------------------------------------------===//
 
 static void SetValue(Value *V, GenericValue Val, ExecutionContext &SF) {
-  SF.Values[V] = Val;
+  SF.Regs[SF.Code->getSlot(V)] = Val;
 }
 
 //===----------------------------------------------------------------------===//
@@ -928,15 +930,16 @@ void Interpreter::visitIndirectBrInst(IndirectBrInst &I) {
 //
 void Interpreter::SwitchToNewBasicBlock(BasicBlock *Dest, ExecutionContext &SF){
   BasicBlock *PrevBB = SF.CurBB;      // Remember where we came from...
-  SF.CurBB   = Dest;                  // Update CurBB to branch destination
-  SF.CurInst = SF.CurBB->begin();     // Update new instruction ptr...
+  SF.CurBB = Dest;                    // Update CurBB to branch destination
+  SF.PC = SF.Code->getBlockStart(Dest); // The PHI nodes are not decoded
 
-  if (!isa<PHINode>(SF.CurInst)) return;  // Nothing fancy to do
+  BasicBlock::iterator CurInst = Dest->begin();
+  if (!isa<PHINode>(CurInst)) return;  // Nothing fancy to do
 
   // Loop over all of the PHI nodes in the current block, reading their inputs.
   std::vector<GenericValue> ResultValues;
 
-  for (; PHINode *PN = dyn_cast<PHINode>(SF.CurInst); ++SF.CurInst) {
+  for (; PHINode *PN = dyn_cast<PHINode>(CurInst); ++CurInst) {
     // Search for the value corresponding to this previous bb...
     int i = PN->getBasicBlockIndex(PrevBB);
     assert(i != -1 && "PHINode doesn't contain entry for predecessor??");
@@ -947,9 +950,9 @@ void Interpreter::SwitchToNewBasicBlock(BasicBlock *Dest, ExecutionContext &SF){
   }
 
   // Now loop over all of the PHI nodes setting their values...
-  SF.CurInst = SF.CurBB->begin();
-  for (unsigned i = 0; isa<PHINode>(SF.CurInst); ++SF.CurInst, ++i) {
-    PHINode *PN = cast<PHINode>(SF.CurInst);
+  CurInst = Dest->begin();
+  for (unsigned i = 0; isa<PHINode>(CurInst); ++CurInst, ++i) {
+    PHINode *PN = cast<PHINode>(CurInst);
     SetValue(PN, ResultValues[i], SF);
   }
 }
@@ -1082,24 +1085,9 @@ void Interpreter::visitCallSite(CallSite CS) {
       SetValue(CS.getInstruction(), getOperandValue(*CS.arg_begin(), SF), SF);
       return;
     default:
-      // If it is an unknown intrinsic function, use the intrinsic lowering
-      // class to transform it into hopefully tasty LLVM code.
-      //
-      BasicBlock::iterator me(CS.getInstruction());
-      BasicBlock *Parent = CS.getInstruction()->getParent();
-      bool atBegin(Parent->begin() == me);
-      if (!atBegin)
-        --me;
-      IL->LowerIntrinsicCall(cast<CallInst>(CS.getInstruction()));
-
-      // Restore the CurInst pointer to the first instruction newly inserted, if
-      // any.
-      if (atBegin) {
-        SF.CurInst = Parent->begin();
-      } else {
-        SF.CurInst = me;
-        ++SF.CurInst;
-      }
+      // Lower the intrinsic as the code generator would, and continue with
+      // the instructions it was lowered to.
+      lowerIntrinsicCall(cast<CallInst>(CS.getInstruction()), SF);
       return;
     }
 
@@ -2061,8 +2049,366 @@ GenericValue Interpreter::getOperandValue(Value *V, ExecutionContext &SF) {
   } else if (GlobalValue *GV = dyn_cast<GlobalValue>(V)) {
     return PTOGV(getPointerToGlobal(GV));
   } else {
-    return SF.Values[V];
+    return SF.Regs[SF.Code->getSlot(V)];
+  }
+}
+
+//===----------------------------------------------------------------------===//
+//                        Function Decoding
+//===----------------------------------------------------------------------===//
+//
+// A function is decoded the first time it is called.  Decoding gives every
+// value a slot in the register file of the stack frame, evaluates the
+// constants once, turns PHI nodes into copies on the incoming edges and gives
+// the common scalar operations their own opcode, so that run() neither looks
+// values up by pointer nor goes through the InstVisitor for them.
+//
+
+const DecodedFunction &Interpreter::getDecodedFunction(Function *F) {
+  DecodedFunction *&DF = DecodedFunctions[F];
+  if (!DF) {
+    DF = new DecodedFunction();
+    decodeFunction(F, *DF);
+  }
+  return *DF;
+}
+
+// getDecodedOperand - Return the slot holding V, giving constants a slot the
+// first time they are used.
+//
+unsigned Interpreter::getDecodedOperand(Value *V, DecodedFunction &DF) {
+  DenseMap<const Value *, unsigned>::iterator I = DF.Slots.find(V);
+  if (I != DF.Slots.end())
+    return I->second;
+
+  // Arguments and instructions got their slots up front, so this is a
+  // constant, and its value does not depend on the stack frame.
+  assert(isa<Constant>(V) && "Operand has no slot!");
+  ExecutionContext NoFrame;
+  unsigned Slot = DF.InitialRegs.size();
+  DF.InitialRegs.push_back(getOperandValue(V, NoFrame));
+  DF.Slots[V] = Slot;
+  return Slot;
+}
+
+// getDecodedEdge - Add the edge From -> To, with a copy for each PHI node in
+// To, and return its index.
+//
+unsigned Interpreter::getDecodedEdge(BasicBlock *From, BasicBlock *To,
+                                     DecodedFunction &DF) {
+  DecodedEdge E;
+  E.Target = 0;    // Filled in once every block has been decoded.
+  E.BB = To;
+  E.CopyBegin = DF.Copies.size();
+  for (BasicBlock::iterator I = To->begin(); PHINode *PN = dyn_cast<PHINode>(I);
+       ++I) {
+    unsigned Src = getDecodedOperand(PN->getIncomingValueForBlock(From), DF);
+    DF.Copies.push_back(std::make_pair(DF.getSlot(PN), Src));
+  }
+  E.CopyEnd = DF.Copies.size();
+
+  // All the PHI nodes read their inputs before any of them is written.  That
+  // only needs a temporary if one of the copies reads another one's result.
+  E.Overlapping = false;
+  for (unsigned i = E.CopyBegin; i != E.CopyEnd; ++i)
+    for (unsigned j = E.CopyBegin; j != E.CopyEnd; ++j)
+      if (i != j && DF.Copies[i].second == DF.Copies[j].first)
+        E.Overlapping = true;
+
+  DF.Edges.push_back(E);
+  return DF.Edges.size() - 1;
+}
+
+// getGEPIndex - Sign extend a getelementptr index the way
+// executeGEPOperation does.
+//
+static int64_t getGEPIndex(const APInt &Idx, unsigned BitWidth) {
+  if (BitWidth == 32)
+    return (int64_t)(int32_t)Idx.getZExtValue();
+  return (int64_t)Idx.getZExtValue();
+}
+
+// decodeGEP - Fold the constant indices of I into a single offset.  Returns
+// false if I has to go through executeGEPOperation instead.
+//
+bool Interpreter::decodeGEP(GetElementPtrInst &I, DecodedInst &D,
+                            DecodedFunction &DF) {
+  if (I.getType()->isVectorTy())
+    return false;
+
+  DecodedGEP G;
+  G.Offset = 0;
+  G.IndexBegin = DF.GEPIndices.size();
+  for (gep_type_iterator GTI = gep_type_begin(I), E = gep_type_end(I);
+       GTI != E; ++GTI) {
+    if (StructType *STy = dyn_cast<StructType>(*GTI)) {
+      const ConstantInt *CPU = cast<ConstantInt>(GTI.getOperand());
+      unsigned Index = unsigned(CPU->getZExtValue());
+      G.Offset += TD.getStructLayout(STy)->getElementOffset(Index);
+      continue;
+    }
+
+    uint64_t Scale =
+        TD.getTypeAllocSize(cast<SequentialType>(*GTI)->getElementType());
+    unsigned BitWidth =
+        cast<IntegerType>(GTI.getOperand()->getType())->getBitWidth();
+    if (BitWidth != 32 && BitWidth != 64) {
+      DF.GEPIndices.resize(G.IndexBegin);
+      return false;
+    }
+    if (ConstantInt *CI = dyn_cast<ConstantInt>(GTI.getOperand())) {
+      G.Offset += Scale * getGEPIndex(CI->getValue(), BitWidth);
+      continue;
+    }
+    DecodedGEP::Index Idx;
+    Idx.Slot = getDecodedOperand(GTI.getOperand(), DF);
+    Idx.BitWidth = BitWidth;
+    Idx.Scale = Scale;
+    DF.GEPIndices.push_back(Idx);
+  }
+  G.IndexEnd = DF.GEPIndices.size();
+
+  D.Ops[0] = getDecodedOperand(I.getPointerOperand(), DF);
+  D.Aux = DF.GEPs.size();
+  DF.GEPs.push_back(G);
+  return true;
+}
+
+// getDecodedOpcode - Pick the opcode I is decoded to.  Vector operations and
+// anything uncommon stay Generic.
+//
+static unsigned getDecodedOpcode(Instruction &I) {
+  Type *Ty = I.getType();
+  if (isa<BinaryOperator>(I)) {
+    if (Ty->isIntegerTy())
+      switch (I.getOpcode()) {
+      case Instruction::Add:  return DecodedInst::Add;
+      case Instruction::Sub:  return DecodedInst::Sub;
+      case Instruction::Mul:  return DecodedInst::Mul;
+      case Instruction::UDiv: return DecodedInst::UDiv;
+      case Instruction::SDiv: return DecodedInst::SDiv;
+      case Instruction::URem: return DecodedInst::URem;
+      case Instruction::SRem: return DecodedInst::SRem;
+      case Instruction::And:  return DecodedInst::And;
+      case Instruction::Or:   return DecodedInst::Or;
+      case Instruction::Xor:  return DecodedInst::Xor;
+      case Instruction::Shl:  return DecodedInst::Shl;
+      case Instruction::LShr: return DecodedInst::LShr;
+      case Instruction::AShr: return DecodedInst::AShr;
+      default: break;
+      }
+    if (Ty->isFloatTy())
+      switch (I.getOpcode()) {
+      case Instruction::FAdd: return DecodedInst::FAddFloat;
+      case Instruction::FSub: return DecodedInst::FSubFloat;
+      case Instruction::FMul: return DecodedInst::FMulFloat;
+      case Instruction::FDiv: return DecodedInst::FDivFloat;
+      default: break;
+      }
+    if (Ty->isDoubleTy())
+      switch (I.getOpcode()) {
+      case Instruction::FAdd: return DecodedInst::FAddDouble;
+      case Instruction::FSub: return DecodedInst::FSubDouble;
+      case Instruction::FMul: return DecodedInst::FMulDouble;
+      case Instruction::FDiv: return DecodedInst::FDivDouble;
+      default: break;
+      }
+    return DecodedInst::Generic;
+  }
+
+  switch (I.getOpcode()) {
+  case Instruction::ICmp:
+    if (I.getOperand(0)->getType()->isIntegerTy())
+      return DecodedInst::ICmp;
+    // FALL THROUGH
+  case Instruction::FCmp:
+    return Ty->isVectorTy() ? DecodedInst::Generic : DecodedInst::Cmp;
+  case Instruction::Select:
+    return I.getOperand(0)->getType()->isVectorTy() ? DecodedInst::Generic
+                                                    : DecodedInst::Select;
+  case Instruction::Trunc:
+    return Ty->isIntegerTy() ? DecodedInst::Trunc : DecodedInst::Generic;
+  case Instruction::ZExt:
+    return Ty->isIntegerTy() ? DecodedInst::ZExt : DecodedInst::Generic;
+  case Instruction::SExt:
+    return Ty->isIntegerTy() ? DecodedInst::SExt : DecodedInst::Generic;
+  case Instruction::Load:
+    if (cast<LoadInst>(I).isVolatile() && PrintVolatile)
+      return DecodedInst::Generic;
+    return DecodedInst::Load;
+  case Instruction::Store:
+    if (cast<StoreInst>(I).isVolatile() && PrintVolatile)
+      return DecodedInst::Generic;
+    return DecodedInst::Store;
+  case Instruction::GetElementPtr:
+    return DecodedInst::GEP;
+  case Instruction::Br:
+    return cast<BranchInst>(I).isConditional() ? DecodedInst::CondBr
+                                               : DecodedInst::Br;
+  case Instruction::Ret:
+    return DecodedInst::Ret;
+  case Instruction::Call: {
+    // Intrinsics and inline asm need visitCallSite.
+    CallInst &CI = cast<CallInst>(I);
+    if (CI.isInlineAsm())
+      return DecodedInst::Generic;
+    Function *F = CI.getCalledFunction();
+    if (F && F->getIntrinsicID() != Intrinsic::not_intrinsic)
+      return DecodedInst::Generic;
+    return DecodedInst::Call;
+  }
+  default:
+    return DecodedInst::Generic;
+  }
+}
+
+void Interpreter::decodeFunction(Function *F, DecodedFunction &DF) {
+  // Number the arguments, then every instruction that produces a value.  When
+  // the function is decoded again after an intrinsic was lowered, the values
+  // keep the slots the running frames use, and the new instructions get slots
+  // after the constants.
+  unsigned NumSlots = DF.InitialRegs.size();
+  for (Function::arg_iterator AI = F->arg_begin(), E = F->arg_end(); AI != E;
+       ++AI)
+    if (DF.Slots.insert(std::make_pair(AI, NumSlots)).second)
+      ++NumSlots;
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+    if (!I->getType()->isVoidTy() &&
+        DF.Slots.insert(std::make_pair(&*I, NumSlots)).second)
+      ++NumSlots;
+  DF.InitialRegs.resize(NumSlots);
+  DF.Insts.clear();
+  DF.Edges.clear();
+  DF.Copies.clear();
+  DF.GEPs.clear();
+  DF.GEPIndices.clear();
+  DF.CallArgs.clear();
+  DF.BlockStarts.clear();
+
+  for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB) {
+    DF.BlockStarts[BB] = DF.Insts.size();
+    for (BasicBlock::iterator I = BB->getFirstNonPHI(), E = BB->end(); I != E;
+         ++I) {
+      DecodedInst D;
+      D.Op = getDecodedOpcode(*I);
+      D.Dest = I->getType()->isVoidTy() ? 0 : DF.getSlot(I);
+      D.Ops[0] = D.Ops[1] = D.Ops[2] = 0;
+      D.Aux = 0;
+      D.Ty = I->getType();
+      D.I = I;
+
+      switch (D.Op) {
+      case DecodedInst::Generic:
+        break;
+      case DecodedInst::GEP:
+        if (!decodeGEP(cast<GetElementPtrInst>(*I), D, DF))
+          D.Op = DecodedInst::Generic;
+        break;
+      case DecodedInst::Br:
+        D.Aux = getDecodedEdge(BB, cast<BranchInst>(I)->getSuccessor(0), DF);
+        break;
+      case DecodedInst::CondBr: {
+        // The false edge is always at Aux + 1.
+        BranchInst *BI = cast<BranchInst>(I);
+        D.Ops[0] = getDecodedOperand(BI->getCondition(), DF);
+        D.Aux = getDecodedEdge(BB, BI->getSuccessor(0), DF);
+        getDecodedEdge(BB, BI->getSuccessor(1), DF);
+        break;
+      }
+      case DecodedInst::Ret:
+        if (Value *RV = cast<ReturnInst>(I)->getReturnValue()) {
+          D.Ops[0] = getDecodedOperand(RV, DF);
+          D.Ty = RV->getType();
+        }
+        break;
+      case DecodedInst::Call: {
+        CallSite CS(I);
+        D.Ops[0] = getDecodedOperand(CS.getCalledValue(), DF);
+        D.Aux = DF.CallArgs.size();
+        for (CallSite::arg_iterator AI = CS.arg_begin(), AE = CS.arg_end();
+             AI != AE; ++AI) {
+          unsigned Slot = getDecodedOperand(*AI, DF);
+          DF.CallArgs.push_back(Slot);
+        }
+        D.Ops[1] = DF.CallArgs.size();
+        break;
+      }
+      case DecodedInst::ICmp:
+      case DecodedInst::Cmp:
+        D.Aux = cast<CmpInst>(I)->getPredicate();
+        D.Ty = I->getOperand(0)->getType();
+        goto DecodeOperands;
+      case DecodedInst::Trunc:
+      case DecodedInst::ZExt:
+      case DecodedInst::SExt:
+        D.Aux = cast<IntegerType>(I->getType())->getBitWidth();
+        goto DecodeOperands;
+      case DecodedInst::Store:
+        D.Ty = I->getOperand(0)->getType();
+        goto DecodeOperands;
+      default:
+      DecodeOperands:
+        assert(I->getNumOperands() <= 3 && "Too many operands to decode!");
+        for (unsigned i = 0, e = I->getNumOperands(); i != e; ++i)
+          D.Ops[i] = getDecodedOperand(I->getOperand(i), DF);
+        break;
+      }
+      DF.Insts.push_back(D);
+    }
   }
+
+  for (unsigned i = 0, e = DF.Edges.size(); i != e; ++i)
+    DF.Edges[i].Target = DF.getBlockStart(DF.Edges[i].BB);
+}
+
+// lowerIntrinsicCall - Lower CI, a call to an intrinsic the interpreter does
+// not implement, when it is about to run in the frame SF, and decode its
+// function again.  Intrinsics are only lowered once they run, so code that
+// never runs may call intrinsics IntrinsicLowering does not support.
+//
+void Interpreter::lowerIntrinsicCall(CallInst *CI, ExecutionContext &SF) {
+  DecodedFunction &DF = *DecodedFunctions[SF.CurFunction];
+  BasicBlock *BB = CI->getParent();
+  Instruction *Prev = CI == BB->getFirstNonPHI() ? nullptr : CI->getPrevNode();
+
+  // The other frames running the function resume after a call.  Remember the
+  // instruction, since its index changes.  Frames resuming at CI itself are
+  // remembered with a null instruction, since CI is deleted.
+  std::vector<std::pair<ExecutionContext *, Instruction *> > Frames;
+  for (ExecutionContext &Frame : ECStack)
+    if (Frame.Code == &DF && &Frame != &SF) {
+      Instruction *Resume = DF.Insts[Frame.PC].I;
+      Frames.push_back(std::make_pair(&Frame, Resume == CI ? nullptr : Resume));
+    }
+
+  DF.Slots.erase(CI);
+  IL->LowerIntrinsicCall(CI);
+  decodeFunction(SF.CurFunction, DF);
+
+  DenseMap<const Instruction *, unsigned> Index;
+  for (unsigned i = 0, e = DF.Insts.size(); i != e; ++i)
+    Index[DF.Insts[i].I] = i;
+  auto GetPC = [&](const Instruction *I) {
+    DenseMap<const Instruction *, unsigned>::const_iterator It = Index.find(I);
+    assert(It != Index.end() && "Resume point was not decoded!");
+    return It->second;
+  };
+  // Frames resuming at CI continue with the first instruction CI was lowered
+  // to, if any.
+  Instruction *Lowered = Prev ? Prev->getNextNode() : BB->getFirstNonPHI();
+  for (unsigned i = 0, e = Frames.size(); i != e; ++i)
+    Frames[i].first->PC =
+        GetPC(Frames[i].second ? Frames[i].second : Lowered);
+  SF.PC = GetPC(Lowered);
+
+  // Give the frames the slots of the new instructions and constants.
+  for (ExecutionContext &Frame : ECStack)
+    if (Frame.Code == &DF) {
+      size_t OldSize = Frame.Regs.size();
+      Frame.Regs.resize(DF.InitialRegs.size());
+      std::copy(DF.InitialRegs.begin() + OldSize, DF.InitialRegs.end(),
+                Frame.Regs.begin() + OldSize);
+    }
 }
 
 //===----------------------------------------------------------------------===//
@@ -2090,58 +2436,287 @@ void Interpreter::callFunction(Function *F,
     return;
   }
 
-  // Get pointers to first LLVM BB & Instruction in function.
-  StackFrame.CurBB     = F->begin();
-  StackFrame.CurInst   = StackFrame.CurBB->begin();
+  // Start at the first instruction of the decoded function, with the
+  // constants it uses already in their slots.
+  const DecodedFunction &Code = getDecodedFunction(F);
+  StackFrame.Code = &Code;
+  StackFrame.CurBB = F->begin();
+  StackFrame.PC = 0;
+  StackFrame.Regs = Code.InitialRegs;
 
   // Run through the function arguments and initialize their values...
   assert((ArgVals.size() == F->arg_size() ||
          (ArgVals.size() > F->arg_size() && F->getFunctionType()->isVarArg()))&&
          "Invalid number of values passed to function invocation!");
 
-  // Handle non-varargs arguments...
+  // Handle non-varargs arguments, which have the first slots...
   unsigned i = 0;
-  for (Function::arg_iterator AI = F->arg_begin(), E = F->arg_end(); 
-       AI != E; ++AI, ++i)
-    SetValue(AI, ArgVals[i], StackFrame);
+  for (unsigned e = F->arg_size(); i != e; ++i)
+    StackFrame.Regs[i] = ArgVals[i];
 
   // Handle varargs arguments...
   StackFrame.VarArgs.assign(ArgVals.begin()+i, ArgVals.end());
 }
 
+// takeEdge - Perform the PHI node copies of E in SF and return the first
+// instruction of its destination.
+//
+static const DecodedInst *takeEdge(const DecodedEdge &E,
+                                   const DecodedFunction &Code,
+                                   ExecutionContext &SF) {
+  GenericValue *Regs = SF.Regs.data();
+  if (!E.Overlapping) {
+    for (unsigned i = E.CopyBegin; i != E.CopyEnd; ++i)
+      Regs[Code.Copies[i].first] = Regs[Code.Copies[i].second];
+  } else {
+    SmallVector<GenericValue, 8> Values;
+    for (unsigned i = E.CopyBegin; i != E.CopyEnd; ++i)
+      Values.push_back(Regs[Code.Copies[i].second]);
+    for (unsigned i = E.CopyBegin; i != E.CopyEnd; ++i)
+      Regs[Code.Copies[i].first] = Values[i - E.CopyBegin];
+  }
+  SF.CurBB = E.BB;
+  return Code.Insts.data() + E.Target;
+}
+
+// With GCC compatible compilers every handler jumps straight to the next one
+// through a table of label addresses.  Elsewhere, or when the build defines
+// INTERPRETER_THREADED_DISPATCH to 0, they go back to a switch.
+#ifndef INTERPRETER_THREADED_DISPATCH
+#if defined(__GNUC__)
+#define INTERPRETER_THREADED_DISPATCH 1
+#else
+#define INTERPRETER_THREADED_DISPATCH 0
+#endif
+#endif
 
+// run - Execute the decoded instructions of the top stack frame until the
+// stack is empty.  Generic instructions, calls and returns may push or pop
+// frames, so they save the PC and reload the state of the top frame after
+// they are done.
+//
 void Interpreter::run() {
-  while (!ECStack.empty()) {
-    // Interpret a single instruction & increment the "PC".
-    ExecutionContext &SF = ECStack.back();  // Current stack frame
-    Instruction &I = *SF.CurInst++;         // Increment before execute
-
-    // Track the number of dynamic instructions executed.
-    ++NumDynamicInsts;
-
-    DEBUG(dbgs() << "About to interpret: " << I);
-    visit(I);   // Dispatch to one of the visit* methods...
-#if 0
-    // This is not safe, as visiting the instruction could lower it and free I.
-DEBUG(
-    if (!isa<CallInst>(I) && !isa<InvokeInst>(I) && 
-        I.getType() != Type::VoidTy) {
-      dbgs() << "  --> ";
-      const GenericValue &Val = SF.Values[&I];
-      switch (I.getType()->getTypeID()) {
-      default: llvm_unreachable("Invalid GenericValue Type");
-      case Type::VoidTyID:    dbgs() << "void"; break;
-      case Type::FloatTyID:   dbgs() << "float " << Val.FloatVal; break;
-      case Type::DoubleTyID:  dbgs() << "double " << Val.DoubleVal; break;
-      case Type::PointerTyID: dbgs() << "void* " << intptr_t(Val.PointerVal);
-        break;
-      case Type::IntegerTyID: 
-        dbgs() << "i" << Val.IntVal.getBitWidth() << " "
-               << Val.IntVal.toStringUnsigned(10)
-               << " (0x" << Val.IntVal.toStringUnsigned(16) << ")\n";
-        break;
-      }
-    });
+  ExecutionContext *SF;
+  const DecodedFunction *Code;
+  const DecodedInst *Inst;
+  GenericValue *Regs;
+  unsigned Executed = 0;
+
+#if INTERPRETER_THREADED_DISPATCH
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+  static void *const Handlers[] = {
+    &&Op_Generic,
+    &&Op_Add, &&Op_Sub, &&Op_Mul, &&Op_UDiv, &&Op_SDiv, &&Op_URem, &&Op_SRem,
+    &&Op_And, &&Op_Or, &&Op_Xor, &&Op_Shl, &&Op_LShr, &&Op_AShr,
+    &&Op_FAddFloat, &&Op_FSubFloat, &&Op_FMulFloat, &&Op_FDivFloat,
+    &&Op_FAddDouble, &&Op_FSubDouble, &&Op_FMulDouble, &&Op_FDivDouble,
+    &&Op_ICmp, &&Op_Cmp, &&Op_Select, &&Op_Trunc, &&Op_ZExt, &&Op_SExt,
+    &&Op_Load, &&Op_Store, &&Op_GEP, &&Op_Br, &&Op_CondBr, &&Op_Ret, &&Op_Call
+  };
+  static_assert(sizeof(Handlers) / sizeof(Handlers[0]) ==
+                    DecodedInst::NumOpcodes,
+                "Handler table does not match DecodedInst::Opcode");
+#define HANDLE(X) Op_##X:
+#define DISPATCH()                                                             \
+  do {                                                                         \
+    ++Executed;                                                                \
+    DEBUG(dbgs() << "About to interpret: " << *Inst->I);                       \
+    goto *Handlers[Inst->Op];                                                  \
+  } while (0)
+#define NEXT()                                                                 \
+  do {                                                                         \
+    ++Inst;                                                                    \
+    DISPATCH();                                                                \
+  } while (0)
+#else
+#define HANDLE(X) case DecodedInst::X:
+#define DISPATCH() continue
+// A do-while loop would take the continue and fall into the next case.
+#define NEXT()                                                                 \
+  {                                                                            \
+    ++Inst;                                                                    \
+    continue;                                                                  \
+  }
 #endif
+#define INT_BINOP(X, EXPR)                                                     \
+  HANDLE(X) {                                                                  \
+    const APInt &A = Regs[Inst->Ops[0]].IntVal;                                \
+    const APInt &B = Regs[Inst->Ops[1]].IntVal;                                \
+    Regs[Inst->Dest].IntVal = EXPR;                                            \
+    NEXT();                                                                    \
+  }
+#define FP_BINOP(X, FIELD, OP)                                                 \
+  HANDLE(X) {                                                                  \
+    Regs[Inst->Dest].FIELD =                                                   \
+        Regs[Inst->Ops[0]].FIELD OP Regs[Inst->Ops[1]].FIELD;                  \
+    NEXT();                                                                    \
+  }
+
+Reload:
+  NumDynamicInsts += Executed;
+  Executed = 0;
+  if (ECStack.empty())
+    return;
+  SF = &ECStack.back();
+  Code = SF->Code;
+  Regs = SF->Regs.data();
+  Inst = Code->Insts.data() + SF->PC;
+
+#if INTERPRETER_THREADED_DISPATCH
+  DISPATCH();
+#else
+  for (;;) {
+    ++Executed;
+    DEBUG(dbgs() << "About to interpret: " << *Inst->I);
+    switch (Inst->Op) {
+    default:
+      llvm_unreachable("Unknown decoded opcode!");
+#endif
+
+  HANDLE(Generic) {
+    SF->PC = unsigned(Inst - Code->Insts.data()) + 1;
+    visit(*Inst->I);   // Dispatch to one of the visit* methods...
+    goto Reload;
+  }
+
+  INT_BINOP(Add, A + B)
+  INT_BINOP(Sub, A - B)
+  INT_BINOP(Mul, A * B)
+  INT_BINOP(UDiv, A.udiv(B))
+  INT_BINOP(SDiv, A.sdiv(B))
+  INT_BINOP(URem, A.urem(B))
+  INT_BINOP(SRem, A.srem(B))
+  INT_BINOP(And, A & B)
+  INT_BINOP(Or, A | B)
+  INT_BINOP(Xor, A ^ B)
+  INT_BINOP(Shl, A.shl(getShiftAmount(B.getZExtValue(), A)))
+  INT_BINOP(LShr, A.lshr(getShiftAmount(B.getZExtValue(), A)))
+  INT_BINOP(AShr, A.ashr(getShiftAmount(B.getZExtValue(), A)))
+
+  FP_BINOP(FAddFloat, FloatVal, +)
+  FP_BINOP(FSubFloat, FloatVal, -)
+  FP_BINOP(FMulFloat, FloatVal, *)
+  FP_BINOP(FDivFloat, FloatVal, /)
+  FP_BINOP(FAddDouble, DoubleVal, +)
+  FP_BINOP(FSubDouble, DoubleVal, -)
+  FP_BINOP(FMulDouble, DoubleVal, *)
+  FP_BINOP(FDivDouble, DoubleVal, /)
+
+  HANDLE(ICmp) {
+    const APInt &A = Regs[Inst->Ops[0]].IntVal;
+    const APInt &B = Regs[Inst->Ops[1]].IntVal;
+    bool R;
+    switch (Inst->Aux) {
+    default: llvm_unreachable("Invalid integer predicate!");
+    case ICmpInst::ICMP_EQ:  R = A.eq(B);  break;
+    case ICmpInst::ICMP_NE:  R = A.ne(B);  break;
+    case ICmpInst::ICMP_UGT: R = A.ugt(B); break;
+    case ICmpInst::ICMP_SGT: R = A.sgt(B); break;
+    case ICmpInst::ICMP_ULT: R = A.ult(B); break;
+    case ICmpInst::ICMP_SLT: R = A.slt(B); break;
+    case ICmpInst::ICMP_UGE: R = A.uge(B); break;
+    case ICmpInst::ICMP_SGE: R = A.sge(B); break;
+    case ICmpInst::ICMP_ULE: R = A.ule(B); break;
+    case ICmpInst::ICMP_SLE: R = A.sle(B); break;
+    }
+    Regs[Inst->Dest].IntVal = APInt(1, R);
+    NEXT();
+  }
+
+  HANDLE(Cmp) {
+    Regs[Inst->Dest] = executeCmpInst(Inst->Aux, Regs[Inst->Ops[0]],
+                                      Regs[Inst->Ops[1]], Inst->Ty);
+    NEXT();
+  }
+
+  HANDLE(Select) {
+    Regs[Inst->Dest] = Regs[Inst->Ops[0]].IntVal == 0 ? Regs[Inst->Ops[2]]
+                                                      : Regs[Inst->Ops[1]];
+    NEXT();
+  }
+
+  HANDLE(Trunc) {
+    Regs[Inst->Dest].IntVal = Regs[Inst->Ops[0]].IntVal.trunc(Inst->Aux);
+    NEXT();
+  }
+
+  HANDLE(ZExt) {
+    Regs[Inst->Dest].IntVal = Regs[Inst->Ops[0]].IntVal.zext(Inst->Aux);
+    NEXT();
+  }
+
+  HANDLE(SExt) {
+    Regs[Inst->Dest].IntVal = Regs[Inst->Ops[0]].IntVal.sext(Inst->Aux);
+    NEXT();
+  }
+
+  HANDLE(Load) {
+    LoadValueFromMemory(Regs[Inst->Dest],
+                        (GenericValue *)GVTOP(Regs[Inst->Ops[0]]), Inst->Ty);
+    NEXT();
+  }
+
+  HANDLE(Store) {
+    StoreValueToMemory(Regs[Inst->Ops[0]],
+                       (GenericValue *)GVTOP(Regs[Inst->Ops[1]]), Inst->Ty);
+    NEXT();
+  }
+
+  HANDLE(GEP) {
+    const DecodedGEP &G = Code->GEPs[Inst->Aux];
+    uint64_t Total = G.Offset;
+    for (unsigned i = G.IndexBegin; i != G.IndexEnd; ++i) {
+      const DecodedGEP::Index &Idx = Code->GEPIndices[i];
+      Total += Idx.Scale * getGEPIndex(Regs[Idx.Slot].IntVal, Idx.BitWidth);
+    }
+    Regs[Inst->Dest].PointerVal = (char *)Regs[Inst->Ops[0]].PointerVal + Total;
+    NEXT();
   }
+
+  HANDLE(Br) {
+    Inst = takeEdge(Code->Edges[Inst->Aux], *Code, *SF);
+    DISPATCH();
+  }
+
+  HANDLE(CondBr) {
+    unsigned Edge = Inst->Aux + (Regs[Inst->Ops[0]].IntVal == 0);
+    Inst = takeEdge(Code->Edges[Edge], *Code, *SF);
+    DISPATCH();
+  }
+
+  HANDLE(Ret) {
+    GenericValue Result;
+    if (!Inst->Ty->isVoidTy())
+      Result = Regs[Inst->Ops[0]];
+    popStackAndReturnValueToCaller(Inst->Ty, Result);
+    goto Reload;
+  }
+
+  HANDLE(Call) {
+    std::vector<GenericValue> ArgVals;
+    ArgVals.reserve(Inst->Ops[1] - Inst->Aux);
+    for (unsigned i = Inst->Aux, e = Inst->Ops[1]; i != e; ++i)
+      ArgVals.push_back(Regs[Code->CallArgs[i]]);
+
+    // To handle indirect calls, we must get the pointer value from the
+    // argument and treat it as a function pointer.
+    Function *F = (Function *)GVTOP(Regs[Inst->Ops[0]]);
+    SF->PC = unsigned(Inst - Code->Insts.data()) + 1;
+    SF->Caller = CallSite(Inst->I);
+    callFunction(F, ArgVals);
+    goto Reload;
+  }
+
+#if INTERPRETER_THREADED_DISPATCH
+#pragma GCC diagnostic pop
+#else
+    }
+  }
+#endif
+#undef FP_BINOP
+#undef INT_BINOP
+#undef NEXT
+#undef DISPATCH
+#undef HANDLE
 }
@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "Interpreter.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/CodeGen/IntrinsicLowering.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Module.h"
@@ -62,6 +63,7 @@ Interpreter::Interpreter(std::unique_ptr<Module> M)
 }
 
 Interpreter::~Interpreter() {
+  DeleteContainerSeconds(DecodedFunctions);
   delete IL;
 }
 
@@ -14,6 +14,7 @@
 #ifndef LLVM_LIB_EXECUTIONENGINE_INTERPRETER_INTERPRETER_H
 #define LLVM_LIB_EXECUTIONENGINE_INTERPRETER_INTERPRETER_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/IR/CallSite.h"
@@ -59,32 +60,117 @@ public:
 
 typedef std::vector<GenericValue> ValuePlaneTy;
 
+// DecodedInst - One instruction of a function's pre-decoded form.  Operands
+// and results are indices into the register file of the stack frame.  The
+// common scalar operations get their own opcode; everything else is Generic
+// and goes through the InstVisitor.
+//
+struct DecodedInst {
+  enum Opcode {
+    Generic,
+    Add, Sub, Mul, UDiv, SDiv, URem, SRem, And, Or, Xor, Shl, LShr, AShr,
+    FAddFloat, FSubFloat, FMulFloat, FDivFloat,
+    FAddDouble, FSubDouble, FMulDouble, FDivDouble,
+    ICmp, Cmp, Select, Trunc, ZExt, SExt,
+    Load, Store, GEP, Br, CondBr, Ret, Call,
+    NumOpcodes
+  };
+
+  unsigned Op;         // The Opcode to dispatch on
+  unsigned Dest;       // Slot of the result, if any
+  unsigned Ops[3];     // Slots of the operands
+  unsigned Aux;        // Predicate, bit width, or index of an edge, GEP or
+                       // argument list, depending on Op
+  Type *Ty;            // Type the operation works on
+  Instruction *I;      // The instruction this was decoded from
+};
+
+// DecodedEdge - A CFG edge taken by a decoded branch, with the PHI nodes of
+// the destination lowered into copies between slots.
+//
+struct DecodedEdge {
+  unsigned Target;           // Index of the first non-PHI instruction
+  BasicBlock *BB;            // The destination block
+  unsigned CopyBegin, CopyEnd;
+  bool Overlapping;          // Some copy reads a slot another one writes
+};
+
+// DecodedGEP - A getelementptr with its constant indices folded into Offset.
+// Only the variable indices are left to be scaled at run time.
+//
+struct DecodedGEP {
+  struct Index {
+    unsigned Slot;
+    unsigned BitWidth;
+    uint64_t Scale;
+  };
+  uint64_t Offset;
+  unsigned IndexBegin, IndexEnd;
+};
+
+// DecodedFunction - A function lowered once into a flat instruction stream
+// over numbered slots.  Arguments come first, then every instruction that
+// produces a value, then the constants the function uses.  Constants are
+// evaluated at decode time and live in InitialRegs, which every new frame
+// copies as its register file.  Lowering an intrinsic call changes the
+// function, which is then decoded again with the slots of the instructions
+// it added after the existing ones.
+//
+struct DecodedFunction {
+  std::vector<DecodedInst> Insts;
+  std::vector<GenericValue> InitialRegs;
+  std::vector<DecodedEdge> Edges;
+  std::vector<std::pair<unsigned, unsigned> > Copies; // (Dest, Src) slots
+  std::vector<DecodedGEP> GEPs;
+  std::vector<DecodedGEP::Index> GEPIndices;
+  std::vector<unsigned> CallArgs;
+  DenseMap<const Value *, unsigned> Slots;
+  DenseMap<const BasicBlock *, unsigned> BlockStarts;
+
+  unsigned getSlot(const Value *V) const {
+    DenseMap<const Value *, unsigned>::const_iterator I = Slots.find(V);
+    assert(I != Slots.end() && "Value has no slot in this function!");
+    return I->second;
+  }
+
+  unsigned getBlockStart(const BasicBlock *BB) const {
+    DenseMap<const BasicBlock *, unsigned>::const_iterator I =
+        BlockStarts.find(BB);
+    assert(I != BlockStarts.end() && "Block is not in this function!");
+    return I->second;
+  }
+};
+
 // ExecutionContext struct - This struct represents one stack frame currently
 // executing.
 //
 struct ExecutionContext {
   Function             *CurFunction;// The currently executing function
+  const DecodedFunction *Code;     // The decoded form of CurFunction
   BasicBlock           *CurBB;      // The currently executing BB
-  BasicBlock::iterator  CurInst;    // The next instruction to execute
+  unsigned              PC;         // Index of the next instruction in Code
   CallSite             Caller;     // Holds the call that called subframes.
                                    // NULL if main func or debugger invoked fn
-  std::map<Value *, GenericValue> Values; // LLVM values used in this invocation
+  ValuePlaneTy         Regs;       // LLVM values used in this invocation,
+                                   // indexed by slot
   std::vector<GenericValue>  VarArgs; // Values passed through an ellipsis
   AllocaHolder Allocas;            // Track memory allocated by alloca
 
-  ExecutionContext() : CurFunction(nullptr), CurBB(nullptr), CurInst(nullptr) {}
+  ExecutionContext()
+      : CurFunction(nullptr), Code(nullptr), CurBB(nullptr), PC(0) {}
 
   ExecutionContext(ExecutionContext &&O)
-      : CurFunction(O.CurFunction), CurBB(O.CurBB), CurInst(O.CurInst),
-        Caller(O.Caller), Values(std::move(O.Values)),
+      : CurFunction(O.CurFunction), Code(O.Code), CurBB(O.CurBB), PC(O.PC),
+        Caller(O.Caller), Regs(std::move(O.Regs)),
         VarArgs(std::move(O.VarArgs)), Allocas(std::move(O.Allocas)) {}
 
   ExecutionContext &operator=(ExecutionContext &&O) {
     CurFunction = O.CurFunction;
+    Code = O.Code;
     CurBB = O.CurBB;
-    CurInst = O.CurInst;
+    PC = O.PC;
     Caller = O.Caller;
-    Values = std::move(O.Values);
+    Regs = std::move(O.Regs);
     VarArgs = std::move(O.VarArgs);
     Allocas = std::move(O.Allocas);
     return *this;
@@ -106,6 +192,9 @@ class Interpreter : public ExecutionEngine, public InstVisitor<Interpreter> {
   // registered with the atexit() library function.
   std::vector<Function*> AtExitHandlers;
 
+  // DecodedFunctions - The decoded form of every function called so far.
+  DenseMap<Function *, DecodedFunction *> DecodedFunctions;
+
 public:
   explicit Interpreter(std::unique_ptr<Module> M);
   ~Interpreter();
@@ -215,6 +304,16 @@ private:  // Helper functions
   //
   void SwitchToNewBasicBlock(BasicBlock *Dest, ExecutionContext &SF);
 
+  // getDecodedFunction - Return the decoded form of F, decoding it on first
+  // use.
+  const DecodedFunction &getDecodedFunction(Function *F);
+  void decodeFunction(Function *F, DecodedFunction &DF);
+  unsigned getDecodedOperand(Value *V, DecodedFunction &DF);
+  unsigned getDecodedEdge(BasicBlock *From, BasicBlock *To,
+                          DecodedFunction &DF);
+  bool decodeGEP(GetElementPtrInst &I, DecodedInst &D, DecodedFunction &DF);
+  void lowerIntrinsicCall(CallInst *CI, ExecutionContext &SF);
+
   void *getPointerToFunction(Function *F) override { return (void*)F; }
 
   void initializeExecutionEngine() { }
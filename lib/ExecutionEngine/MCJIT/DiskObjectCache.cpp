@@ -0,0 +1,200 @@
+//===- DiskObjectCache.cpp - On-disk object cache for MCJIT ---------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the content-addressed on-disk ObjectCache.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/DiskObjectCache.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace llvm;
+
+namespace {
+/// A cache entry found while pruning.
+struct CacheEntry {
+  std::string Path;
+  uint64_t Size;
+  sys::TimeValue LastUsed;
+};
+}
+
+DiskObjectCache::DiskObjectCache(StringRef CacheDir, StringRef Triple,
+                                 StringRef CPU, StringRef Features,
+                                 CodeGenOpt::Level OptLevel, uint64_t MaxSize,
+                                 Reloc::Model RM, CodeModel::Model CM,
+                                 const TargetOptions &Options)
+    : CacheDir(CacheDir), MaxSize(MaxSize) {
+  raw_string_ostream OS(TargetKey);
+  OS << Triple << '\0' << CPU << '\0' << Features << '\0' << OptLevel << '\0'
+     << RM << '\0' << CM << '\0';
+
+  // The options that can change the generated object.
+  OS << Options.NoFramePointerElim << Options.LessPreciseFPMADOption
+     << Options.UnsafeFPMath << Options.NoInfsFPMath << Options.NoNaNsFPMath
+     << Options.HonorSignDependentRoundingFPMathOption << Options.UseSoftFloat
+     << Options.NoZerosInBSS << Options.JITEmitDebugInfo
+     << Options.GuaranteedTailCallOpt << Options.DisableTailCalls
+     << Options.EnableFastISel << Options.PositionIndependentExecutable
+     << Options.UseInitArray << Options.CompressDebugSections
+     << Options.FunctionSections << Options.DataSections
+     << Options.TrapUnreachable << Options.FCFI << Options.CFIEnforcing << '\0'
+     << Options.StackAlignmentOverride << '\0' << Options.TrapFuncName << '\0'
+     << Options.FloatABIType << '\0' << Options.AllowFPOpFusion << '\0'
+     << Options.JTType << '\0' << Options.ThreadModel << '\0'
+     << unsigned(Options.CFIType) << '\0' << Options.CFIFuncName << '\0';
+  const MCTargetOptions &MCOptions = Options.MCOptions;
+  OS << MCOptions.SanitizeAddress << MCOptions.MCRelaxAll
+     << MCOptions.MCNoExecStack << MCOptions.MCSaveTempLabels
+     << MCOptions.MCUseDwarfDirectory << '\0' << MCOptions.DwarfVersion << '\0'
+     << MCOptions.ABIName;
+}
+
+DiskObjectCache::~DiskObjectCache() {}
+
+bool DiskObjectCache::getCacheFile(const Module *M,
+                                   SmallVectorImpl<char> &Path) const {
+  // Unmaterialized functions would print as declarations.
+  for (const Function &F : *M)
+    if (F.isMaterializable())
+      return false;
+
+  std::string Text;
+  raw_string_ostream OS(Text);
+  M->print(OS, nullptr);
+  OS.flush();
+
+  // The module identifier is usually a file name, which must not matter.
+  StringRef Contents(Text);
+  if (Contents.startswith("; ModuleID = "))
+    Contents = Contents.substr(Contents.find('\n') + 1);
+
+  MD5 Hash;
+  Hash.update(TargetKey);
+  Hash.update(StringRef("\0", 1));
+  Hash.update(M->getTargetTriple());
+  Hash.update(StringRef("\0", 1));
+  Hash.update(Contents);
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Name;
+  MD5::stringifyResult(Result, Name);
+
+  Path.clear();
+  Path.append(CacheDir.begin(), CacheDir.end());
+  sys::path::append(Path, Name + ".o");
+  return true;
+}
+
+std::unique_ptr<MemoryBuffer> DiskObjectCache::getObject(const Module *M) {
+  PendingFiles.erase(M);
+  SmallString<128> Path;
+  if (!getCacheFile(M, Path))
+    return nullptr;
+
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+      MemoryBuffer::getFile(Path.str(), -1, false);
+  if (!Buffer) {
+    // The module is about to be compiled, which changes it, so its key has to
+    // be computed now.
+    PendingFiles[M] = Path.str();
+    return nullptr;
+  }
+
+  // Remember the use for pruning.
+  int FD;
+  if (!sys::fs::openFileForRead(Path.str(), FD)) {
+    sys::fs::setLastModificationAndAccessTime(FD, sys::TimeValue::now());
+    sys::Process::SafelyCloseFileDescriptor(FD);
+  }
+
+  // MCJIT may write into the buffer, so don't hand out the mapped file.
+  return MemoryBuffer::getMemBufferCopy(Buffer.get()->getBuffer(),
+                                        Buffer.get()->getBufferIdentifier());
+}
+
+void DiskObjectCache::notifyObjectCompiled(const Module *M,
+                                           MemoryBufferRef Obj) {
+  auto I = PendingFiles.find(M);
+  if (I == PendingFiles.end())
+    return;
+  std::string Path = std::move(I->second);
+  PendingFiles.erase(I);
+  if (sys::fs::create_directories(CacheDir))
+    return;
+
+  // If someone else is writing this entry, it will have the same contents.
+  LockFileManager Lock(Path);
+  if (Lock.getState() != LockFileManager::LFS_Owned)
+    return;
+
+  // Write to a temporary file first, so that readers never see a partial
+  // object.
+  int FD;
+  SmallString<128> TempPath;
+  if (sys::fs::createUniqueFile(Path + "-%%%%%%%%.tmp", FD, TempPath))
+    return;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS.write(Obj.getBufferStart(), Obj.getBufferSize());
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath.str());
+      return;
+    }
+  }
+  if (sys::fs::rename(TempPath.str(), Path)) {
+    sys::fs::remove(TempPath.str());
+    return;
+  }
+
+  if (MaxSize)
+    prune();
+}
+
+void DiskObjectCache::prune() {
+  std::vector<CacheEntry> Entries;
+  uint64_t TotalSize = 0;
+  std::error_code EC;
+  for (sys::fs::directory_iterator I(CacheDir, EC), E; I != E && !EC;
+       I.increment(EC)) {
+    if (sys::path::extension(I->path()) != ".o")
+      continue;
+    sys::fs::file_status Status;
+    if (I->status(Status) || !sys::fs::is_regular_file(Status))
+      continue;
+    CacheEntry Entry = {I->path(), Status.getSize(),
+                        Status.getLastModificationTime()};
+    Entries.push_back(Entry);
+    TotalSize += Entry.Size;
+  }
+  if (TotalSize <= MaxSize)
+    return;
+
+  std::sort(Entries.begin(), Entries.end(),
+            [](const CacheEntry &LHS, const CacheEntry &RHS) {
+    return LHS.LastUsed < RHS.LastUsed;
+  });
+  for (const CacheEntry &Entry : Entries) {
+    if (TotalSize <= MaxSize)
+      break;
+    if (!sys::fs::remove(Entry.Path))
+      TotalSize -= Entry.Size;
+  }
+}
@@ -51,6 +51,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/CallingConv.h"
@@ -69,10 +70,12 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Statepoint.h"
+#include "llvm/IR/TypeFinder.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdarg>
@@ -2875,6 +2878,90 @@ bool llvm::verifyModule(const Module &M, raw_ostream *OS) {
   return !V.verify(M) || !DIV.verify(M) || Broken;
 }
 
+/// Checking intrinsic prototypes may create new types in the context, which
+/// is not safe to do concurrently, so such functions are verified serially.
+/// \p MaxArgs is raised to the number of arguments of \p F and of the calls
+/// in \p F.
+static bool callsIntrinsic(const Function &F, unsigned &MaxArgs) {
+  bool Result = false;
+  MaxArgs = std::max<unsigned>(MaxArgs, F.arg_size());
+  for (const_inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+    if (ImmutableCallSite CS = ImmutableCallSite(&*I)) {
+      MaxArgs = std::max<unsigned>(MaxArgs, CS.arg_size());
+      if (const Function *Callee = CS.getCalledFunction())
+        Result |= Callee->isIntrinsic();
+    }
+  return Result;
+}
+
+bool llvm::verifyModuleParallel(const Module &M, raw_ostream *OS,
+                                unsigned NumThreads) {
+  std::vector<const Function *> Funcs;
+  for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+    if (!I->isDeclaration() && !I->isMaterializable())
+      Funcs.push_back(I);
+
+  unsigned NumWorkers = getWorkerThreadCount(NumThreads);
+  if (NumWorkers == 0 || Funcs.size() < 2)
+    return verifyModule(M, OS);
+
+  // Each function is verified by its own Verifier into its own buffer, so
+  // the output does not depend on which thread verified which function.
+  std::vector<std::string> Diags(Funcs.size());
+  std::vector<char> FuncBroken(Funcs.size());
+  std::vector<char> Serial(Funcs.size());
+  unsigned MaxArgs = 0;
+  for (size_t I = 0, E = Funcs.size(); I != E; ++I)
+    Serial[I] = callsIntrinsic(*Funcs[I], MaxArgs);
+
+  // Checking parameter attributes asks AttributeFuncs::typeIncompatible for
+  // an attribute set, which is uniqued in the context and so created on first
+  // use. The set depends only on the index and on whether the type is an
+  // integer or a pointer, so create all of them here. The workers then only
+  // look up existing sets, which is safe to do concurrently.
+  LLVMContext &Context = M.getContext();
+  Type *AttrTys[] = {Type::getInt8Ty(Context), Type::getInt8PtrTy(Context),
+                     Type::getVoidTy(Context)};
+  for (unsigned Idx = 0; Idx <= MaxArgs; ++Idx)
+    for (Type *Ty : AttrTys)
+      AttributeFuncs::typeIncompatible(Ty, Idx);
+
+  // StructType::isSized caches its answer in the type, which is shared by all
+  // workers, so compute it for every struct type the module uses up front.
+  TypeFinder StructTypes;
+  StructTypes.run(M, false);
+  for (StructType *STy : StructTypes)
+    STy->isSized();
+
+  auto VerifyFunction = [&](size_t I) {
+    raw_string_ostream DiagOS(Diags[I]);
+    Verifier V(DiagOS);
+    FuncBroken[I] = !V.verify(*Funcs[I]);
+  };
+  {
+    ThreadPool Pool(std::min<size_t>(NumWorkers, Funcs.size() - 1));
+    parallel_for(Pool, size_t(0), Funcs.size(), [&](size_t I) {
+      if (!Serial[I])
+        VerifyFunction(I);
+    });
+  }
+  for (size_t I = 0, E = Funcs.size(); I != E; ++I)
+    if (Serial[I])
+      VerifyFunction(I);
+
+  bool Broken = false;
+  for (size_t I = 0, E = Funcs.size(); I != E; ++I) {
+    if (OS)
+      *OS << Diags[I];
+    Broken |= FuncBroken[I];
+  }
+
+  raw_null_ostream NullStr;
+  Verifier V(OS ? *OS : NullStr);
+  DebugInfoVerifier DIV(OS ? *OS : NullStr);
+  return !V.verify(M) || !DIV.verify(M) || Broken;
+}
+
 namespace {
 struct VerifierLegacyPass : public FunctionPass {
   static char ID;
@@ -16,6 +16,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Analysis/Passes.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/CodeGen/RuntimeLibcalls.h"
 #include "llvm/Config/config.h"
 #include "llvm/IR/Constants.h"
@@ -79,6 +80,7 @@ void LTOCodeGenerator::initialize() {
   EmitDwarfDebugInfo = false;
   ScopeRestrictionsDone = false;
   CodeModel = LTO_CODEGEN_PIC_MODEL_DEFAULT;
+  Parallelism = 1;
   DiagHandler = nullptr;
   DiagContext = nullptr;
 
@@ -220,9 +222,10 @@ bool LTOCodeGenerator::compile_to_file(const char** name,
   // generate object file
   tool_output_file objFile(Filename.c_str(), FD);
 
+  raw_ostream *OS = &objFile.os();
   bool genResult =
-      generateObjectFile(objFile.os(), disableOpt, disableInline,
-                         disableGVNLoadPRE, disableVectorization, errMsg);
+      generateObjectFiles(OS, disableOpt, disableInline, disableGVNLoadPRE,
+                          disableVectorization, errMsg);
   objFile.os().close();
   if (objFile.os().has_error()) {
     objFile.os().clear_error();
@@ -241,6 +244,55 @@ bool LTOCodeGenerator::compile_to_file(const char** name,
   return true;
 }
 
+bool LTOCodeGenerator::compile_to_files(ArrayRef<const char *> &names,
+                                        bool disableOpt,
+                                        bool disableInline,
+                                        bool disableGVNLoadPRE,
+                                        bool disableVectorization,
+                                        std::string &errMsg) {
+  NativeObjectPaths.clear();
+  NativeObjectNames.clear();
+
+  // make unique temp .o files to put the generated object files
+  std::vector<std::unique_ptr<tool_output_file>> objFiles;
+  std::vector<raw_ostream *> OSs;
+  for (unsigned I = 0; I != std::max(Parallelism, 1U); ++I) {
+    SmallString<128> Filename;
+    int FD;
+    std::error_code EC =
+        sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
+    if (EC) {
+      errMsg = EC.message();
+      return false;
+    }
+    objFiles.emplace_back(new tool_output_file(Filename.c_str(), FD));
+    OSs.push_back(&objFiles.back()->os());
+    NativeObjectPaths.push_back(Filename.str());
+  }
+
+  bool genResult =
+      generateObjectFiles(OSs, disableOpt, disableInline, disableGVNLoadPRE,
+                          disableVectorization, errMsg);
+  bool writeError = false;
+  for (std::unique_ptr<tool_output_file> &objFile : objFiles) {
+    objFile->os().close();
+    if (objFile->os().has_error()) {
+      objFile->os().clear_error();
+      writeError = true;
+    }
+  }
+  // Unkept tool_output_files remove their files when they are destroyed.
+  if (!genResult || writeError)
+    return false;
+
+  for (unsigned I = 0, E = objFiles.size(); I != E; ++I) {
+    objFiles[I]->keep();
+    NativeObjectNames.push_back(NativeObjectPaths[I].c_str());
+  }
+  names = NativeObjectNames;
+  return true;
+}
+
 const void* LTOCodeGenerator::compile(size_t* length,
                                       bool disableOpt,
                                       bool disableInline,
@@ -456,13 +508,14 @@ void LTOCodeGenerator::applyScopeRestrictions() {
   ScopeRestrictionsDone = true;
 }
 
-/// Optimize merged modules using various IPO passes
-bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
-                                          bool DisableOpt,
-                                          bool DisableInline,
-                                          bool DisableGVNLoadPRE,
-                                          bool DisableVectorization,
-                                          std::string &errMsg) {
+/// Optimize merged modules using various IPO passes, then generate code for
+/// them into one object file per output stream.
+bool LTOCodeGenerator::generateObjectFiles(ArrayRef<raw_ostream *> outs,
+                                           bool DisableOpt,
+                                           bool DisableInline,
+                                           bool DisableGVNLoadPRE,
+                                           bool DisableVectorization,
+                                           std::string &errMsg) {
   if (!this->determineTarget(errMsg))
     return false;
 
@@ -492,29 +545,17 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
 
   PMB.populateLTOPassManager(passes, TargetMach);
 
-  PassManager codeGenPasses;
-
-  codeGenPasses.add(new DataLayoutPass());
-
-  formatted_raw_ostream Out(out);
-
   // If the bitcode files contain ARC code and were compiled with optimization,
-  // the ObjCARCContractPass must be run, so do it unconditionally here.
-  codeGenPasses.add(createObjCARCContractPass());
-
-  if (TargetMach->addPassesToEmitFile(codeGenPasses, Out,
-                                      TargetMachine::CGFT_ObjectFile)) {
-    errMsg = "target file type not supported";
-    return false;
-  }
+  // the ObjCARCContractPass must be run, so do it unconditionally here. It
+  // runs last, right before the module is split for code generation.
+  passes.add(createObjCARCContractPass());
 
   // Run our queue of passes all at once now, efficiently.
   passes.run(*mergedModule);
 
-  // Run the code generator, and write assembly file
-  codeGenPasses.run(*mergedModule);
-
-  return true;
+  // Run the code generator, and write the object files
+  return !splitCodeGen(*mergedModule, outs, *TargetMach,
+                       TargetMachine::CGFT_ObjectFile, errMsg);
 }
 
 /// setCodeGenDebugOptions - Set codegen debugging options to aid in debugging
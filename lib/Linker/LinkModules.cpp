@@ -422,16 +422,21 @@ class ModuleLinker {
 
   DiagnosticHandlerFunction DiagnosticHandler;
 
+  /// Linker::Flags controlling this link.
+  unsigned Flags;
+
 public:
   ModuleLinker(Module *dstM, Linker::IdentifiedStructTypeSet &Set, Module *srcM,
-               DiagnosticHandlerFunction DiagnosticHandler)
+               DiagnosticHandlerFunction DiagnosticHandler, unsigned Flags)
       : DstM(dstM), SrcM(srcM), TypeMap(Set),
         ValMaterializer(TypeMap, DstM, LazilyLinkGlobalValues),
-        DiagnosticHandler(DiagnosticHandler) {}
+        DiagnosticHandler(DiagnosticHandler), Flags(Flags) {}
 
   bool run();
 
 private:
+  bool shouldLinkOnlyNeeded() const { return Flags & Linker::LinkOnlyNeeded; }
+
   bool shouldLinkFromSource(bool &LinkFromSrc, const GlobalValue &Dest,
                             const GlobalValue &Src);
 
@@ -599,6 +604,10 @@ Value *ValueMaterializerTy::materializeValueFor(Value *V) {
 
   GlobalValue *DGV = copyGlobalValueProto(TypeMap, *DstM, SGV);
 
+  // When only linking what is needed, declarations are created on use too.
+  if (SGV->isDeclaration())
+    return DGV;
+
   if (Comdat *SC = SGV->getComdat()) {
     if (auto *DGO = dyn_cast<GlobalObject>(DGV)) {
       Comdat *DC = DstM->getOrInsertComdat(SC->getName());
@@ -1076,7 +1085,11 @@ bool ModuleLinker::linkGlobalValueProto(GlobalValue *SGV) {
   } else {
     // If the GV is to be lazily linked, don't create it just yet.
     // The ValueMaterializerTy will deal with creating it if it's used.
-    if (!DGV && (SGV->hasLocalLinkage() || SGV->hasLinkOnceLinkage() ||
+    // When only linking what is needed, that is the case of every global
+    // that does not resolve something in the destination, except for
+    // appending variables like llvm.global_ctors.
+    if (!DGV && ((shouldLinkOnlyNeeded() && !SGV->hasAppendingLinkage()) ||
+                 SGV->hasLocalLinkage() || SGV->hasLinkOnceLinkage() ||
                  SGV->hasAvailableExternallyLinkage())) {
       DoNotLinkFromSource.insert(SGV);
       return false;
@@ -1718,9 +1731,9 @@ void Linker::deleteModule() {
   Composite = nullptr;
 }
 
-bool Linker::linkInModule(Module *Src) {
+bool Linker::linkInModule(Module *Src, unsigned Flags) {
   ModuleLinker TheLinker(Composite, IdentifiedStructTypes, Src,
-                         DiagnosticHandler);
+                         DiagnosticHandler, Flags);
   return TheLinker.run();
 }
 
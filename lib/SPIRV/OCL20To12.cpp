@@ -73,6 +73,7 @@ public:
 private:
   Module *M;
   LLVMContext *Ctx;
+  BuiltinCalleeCache Callees;
 };
 
 char OCL20To12::ID = 0;
@@ -80,6 +81,7 @@ char OCL20To12::ID = 0;
 bool
 OCL20To12::runOnModule(Module& Module) {
   M = &Module;
+  Callees.reset(M);
   if (getOCLVersion(M) >= kOCLVer::CL20)
     return false;
 
@@ -123,7 +125,7 @@ void OCL20To12::visitCallAtomicWorkItemFence(CallInst* CI) {
         false);
 
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstOCL(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstOCL(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     Args.resize(1);
     Args[0] = getInt32(M, std::get<0>(Lit));
     return kOCLBuiltinName::MemFence;
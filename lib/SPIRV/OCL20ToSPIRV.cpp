@@ -276,6 +276,7 @@ public:
 private:
   Module *M;
   LLVMContext *Ctx;
+  BuiltinCalleeCache Callees;       /// Callees of mutated calls
   unsigned CLVer;                   /// OpenCL version as major*10+minor
   std::set<Value *> ValuesToDelete;
 
@@ -335,6 +336,7 @@ char OCL20ToSPIRV::ID = 0;
 bool
 OCL20ToSPIRV::runOnModule(Module& Module) {
   M = &Module;
+  Callees.reset(M);
   Ctx = &M->getContext();
   auto Src = getSPIRVSource(&Module);
   if (std::get<0>(Src) != spv::SourceLanguageOpenCL_C)
@@ -543,7 +545,7 @@ OCL20ToSPIRV::visitCallNDRange(CallInst *CI,
   //   local work size
   // The arguments need to add missing members.
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstSPIRV(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstSPIRV(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     for (size_t I = 1, E = Args.size(); I != E; ++I)
       Args[I] = getScalarOrArray(Args[I], Len, CI);
     switch (Args.size()) {
@@ -582,7 +584,7 @@ void
 OCL20ToSPIRV::visitCallAsyncWorkGroupCopy(CallInst* CI,
     const std::string &DemangledName) {
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstSPIRV(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstSPIRV(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     if (DemangledName == OCLUtil::kOCLBuiltinName::AsyncWorkGroupCopy) {
       Args.insert(Args.begin()+3, addSizet(1));
     }
@@ -597,7 +599,7 @@ OCL20ToSPIRV::visitCallAtomicCmpXchg(CallInst* CI,
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
   Value *Expected = nullptr;
   CallInst *NewCI = nullptr;
-  mutateCallInstOCL(M, CI, [&](CallInst * CI, std::vector<Value *> &Args,
+  mutateCallInstOCL(Callees, CI, [&](CallInst * CI, std::vector<Value *> &Args,
       Type *&RetTy){
     Expected = Args[1]; // temporary save second argument.
     Args[1] = new LoadInst(Args[1], "exp", false, CI);
@@ -646,7 +648,7 @@ OCL20ToSPIRV::visitCallAllAny(spv::Op OC, CallInst* CI) {
     CI->eraseFromParent();
   } else {
     mutateCallInstSPIRV(
-        M, CI,
+        Callees, CI,
         [&](CallInst *, std::vector<Value *> &Args, Type *&Ret) {
           Args[0] = Cmp;
           Ret = Type::getInt1Ty(*Ctx);
@@ -677,7 +679,7 @@ OCL20ToSPIRV::visitCallMemFence(CallInst* CI) {
 void OCL20ToSPIRV::transMemoryBarrier(CallInst* CI,
     AtomicWorkItemFenceLiterals Lit) {
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstSPIRV(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstSPIRV(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     Args.resize(2);
     Args[0] = addInt32(map<Scope>(std::get<2>(Lit)));
     Args[1] = addInt32(mapOCLMemSemanticToSPIRV(std::get<0>(Lit),
@@ -796,7 +798,7 @@ void
 OCL20ToSPIRV::transAtomicBuiltin(CallInst* CI,
     OCLBuiltinTransInfo& Info) {
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstSPIRV(M, CI, [=](CallInst * CI, std::vector<Value *> &Args){
+  mutateCallInstSPIRV(Callees, CI, [=](CallInst * CI, std::vector<Value *> &Args){
     Info.PostProc(Args);
     // Order of args in OCL20:
     // object, 0-2 other args, 1-2 order, scope
@@ -831,7 +833,7 @@ void
 OCL20ToSPIRV::visitCallBarrier(CallInst* CI) {
   auto Lit = getBarrierLiterals(CI);
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstSPIRV(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstSPIRV(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     Args.resize(3);
     Args[0] = addInt32(map<Scope>(std::get<2>(Lit)));
     Args[1] = addInt32(map<Scope>(std::get<1>(Lit)));
@@ -886,7 +888,7 @@ void OCL20ToSPIRV::visitCallConvert(CallInst* CI,
     Rounding = DemangledName.substr(Loc, 4);
   }
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstSPIRV(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstSPIRV(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     return getSPIRVFuncName(OC, TargetTyName + Sat + Rounding);
   }, &Attrs);
 }
@@ -981,7 +983,7 @@ OCL20ToSPIRV::transBuiltin(CallInst* CI,
   else
     return;
   if (!Info.RetTy)
-    mutateCallInstSPIRV(M, CI,
+    mutateCallInstSPIRV(Callees, CI,
                         [=](CallInst *, std::vector<Value *> &Args) {
                           Info.PostProc(Args);
                           return Info.UniqName + Info.Postfix;
@@ -989,7 +991,7 @@ OCL20ToSPIRV::transBuiltin(CallInst* CI,
                         &Attrs);
   else
     mutateCallInstSPIRV(
-        M, CI,
+        Callees, CI,
         [=](CallInst *, std::vector<Value *> &Args, Type *&RetTy) {
           Info.PostProc(Args);
           RetTy = Info.RetTy;
@@ -1026,7 +1028,7 @@ void OCL20ToSPIRV::visitCallReadImageMSAA(CallInst *CI, StringRef MangledName,
   assert(MangledName.find("msaa") != StringRef::npos);
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
   mutateCallInstSPIRV(
-      M, CI,
+      Callees, CI,
       [=](CallInst *, std::vector<Value *> &Args) {
         Args.insert(Args.begin() + 2, getInt32(M, ImageOperandsSampleMask));
         return getSPIRVFuncName(OpImageRead,
@@ -1042,7 +1044,7 @@ void OCL20ToSPIRV::visitCallReadImageWithSampler(
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
   bool isRetScalar = !CI->getType()->isVectorTy();
   mutateCallInstSPIRV(
-      M, CI,
+      Callees, CI,
       [=](CallInst *, std::vector<Value *> &Args, Type *&Ret) {
         auto ImageTy = getAnalysis<OCLTypeToSPIRV>().getAdaptedType(Args[0]);
         if (isOCLImageType(ImageTy))
@@ -1104,7 +1106,7 @@ OCL20ToSPIRV::visitCallGetImageSize(CallInst* CI,
   auto Desc = map<SPIRVTypeImageDescriptor>(ImageTyName);
   unsigned Dim = getImageDimension(Desc.Dim) + Desc.Arrayed;
   assert(Dim > 0 && "Invalid image dimension.");
-  mutateCallInstSPIRV(M, CI,
+  mutateCallInstSPIRV(Callees, CI,
     [&](CallInst *, std::vector<Value *> &Args, Type *&Ret){
       assert(Args.size() == 1);
       Ret = CI->getType()->isIntegerTy(64) ? Type::getInt64Ty(*Ctx)
@@ -1292,7 +1294,7 @@ void OCL20ToSPIRV::visitCallRelational(CallInst *CI,
   OCLSPIRVBuiltinMap::find(DemangledName, &OC);
   std::string SPIRVName = getSPIRVFuncName(OC);
   mutateCallInstSPIRV(
-      M, CI,
+      Callees, CI,
       [=](CallInst *, std::vector<Value *> &Args, Type *&Ret) {
         Ret = Type::getInt1Ty(*Ctx);
         if (CI->getOperand(0)->getType()->isVectorTy())
@@ -1374,7 +1376,7 @@ void OCL20ToSPIRV::visitCallGetFence(CallInst *CI, StringRef MangledName,
   Op OC = OpNop;
   OCLSPIRVBuiltinMap::find(DemangledName, &OC);
   std::string SPIRVName = getSPIRVFuncName(OC);
-  mutateCallInstSPIRV(M, CI, [=](CallInst *, std::vector<Value *> &Args,
+  mutateCallInstSPIRV(Callees, CI, [=](CallInst *, std::vector<Value *> &Args,
                                  Type *&Ret) { return SPIRVName; },
             [=](CallInst *NewCI) -> Instruction * {
               return BinaryOperator::CreateLShr(NewCI, getInt32(M, 8), "", CI);
@@ -1430,7 +1432,7 @@ void OCL20ToSPIRV::visitCallScalToVec(CallInst *CI, StringRef MangledName,
 
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
   mutateCallInstSPIRV(
-      M, CI,
+      Callees, CI,
       [=](CallInst *, std::vector<Value *> &Args) {
         Args.resize(VecPos.size() + ScalarPos.size());
         for (auto I : VecPos) {
@@ -1461,7 +1463,7 @@ void OCL20ToSPIRV::visitCallGetImageChannel(CallInst *CI, StringRef MangledName,
   Op OC = OpNop;
   OCLSPIRVBuiltinMap::find(DemangledName, &OC);
   std::string SPIRVName = getSPIRVFuncName(OC);
-  mutateCallInstSPIRV(M, CI, [=](CallInst *, std::vector<Value *> &Args,
+  mutateCallInstSPIRV(Callees, CI, [=](CallInst *, std::vector<Value *> &Args,
                                  Type *&Ret) { return SPIRVName; },
                       [=](CallInst *NewCI) -> Instruction * {
                         return BinaryOperator::CreateAdd(
@@ -1494,7 +1496,7 @@ void OCL20ToSPIRV::visitSubgroupBlockReadINTEL(CallInst *CI, StringRef MangledNa
   else
     Info.Postfix += "_ui";
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstSPIRV(M, CI,
+  mutateCallInstSPIRV(Callees, CI,
                       [=](CallInst *, std::vector<Value *> &Args) {
                           Info.PostProc(Args);
                           return Info.UniqName + Info.Postfix;
@@ -1524,7 +1526,7 @@ void OCL20ToSPIRV::visitSubgroupBlockWriteINTEL(CallInst *CI, StringRef MangledN
     }
   }
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstSPIRV(M, CI,
+  mutateCallInstSPIRV(Callees, CI,
                       [=](CallInst *, std::vector<Value *> &Args) {
                           Info.PostProc(Args);
                           return Info.UniqName + Info.Postfix;
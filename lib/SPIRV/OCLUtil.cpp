@@ -511,6 +511,10 @@ public:
     addSamplerArg(1);
   }
 }
+// The mangling of some builtins depends on the parameters of F.
+Value *getCacheKey() const {
+  return F;
+}
 // Auxiliarry information, it is expected what it is relevant at the moment
 // the init method is called.
 Function * F; // SPIRV decorated function
@@ -534,6 +538,26 @@ mutateCallInstOCL(Module *M, CallInst *CI,
   return mutateCallInst(M, CI, ArgMutate, RetMutate, &BtnInfo, Attrs);
 }
 
+CallInst *
+mutateCallInstOCL(BuiltinCalleeCache &Callees, CallInst *CI,
+    std::function<std::string (CallInst *, std::vector<Value *> &)>ArgMutate,
+    AttributeSet *Attrs) {
+  OCLBuiltinFuncMangleInfo BtnInfo(CI->getCalledFunction());
+  return mutateCallInst(Callees.getModule(), CI, ArgMutate, &BtnInfo, Attrs,
+      false, &Callees);
+}
+
+Instruction *
+mutateCallInstOCL(BuiltinCalleeCache &Callees, CallInst *CI,
+    std::function<std::string (CallInst *, std::vector<Value *> &,
+        Type *&RetTy)> ArgMutate,
+    std::function<Instruction *(CallInst *)> RetMutate,
+    AttributeSet *Attrs) {
+  OCLBuiltinFuncMangleInfo BtnInfo(CI->getCalledFunction());
+  return mutateCallInst(Callees.getModule(), CI, ArgMutate, RetMutate,
+      &BtnInfo, Attrs, false, &Callees);
+}
+
 void
 mutateFunctionOCL(Function *F,
     std::function<std::string (CallInst *, std::vector<Value *> &)>ArgMutate,
@@ -351,6 +351,22 @@ mutateCallInstOCL(Module *M, CallInst *CI,
     std::function<Instruction *(CallInst *)> RetMutate,
     AttributeSet *Attrs = nullptr);
 
+/// Mutate call instruction to call OpenCL builtin function, looking up the
+/// callee in \p Callees.
+CallInst *
+mutateCallInstOCL(BuiltinCalleeCache &Callees, CallInst *CI,
+    std::function<std::string (CallInst *, std::vector<Value *> &)>ArgMutate,
+    AttributeSet *Attrs = nullptr);
+
+/// Mutate call instruction to call OpenCL builtin function, looking up the
+/// callee in \p Callees.
+Instruction *
+mutateCallInstOCL(BuiltinCalleeCache &Callees, CallInst *CI,
+    std::function<std::string (CallInst *, std::vector<Value *> &,
+        Type *&RetTy)> ArgMutate,
+    std::function<Instruction *(CallInst *)> RetMutate,
+    AttributeSet *Attrs = nullptr);
+
 /// Mutate a function to OpenCL builtin function.
 void
 mutateFunctionOCL(Function *F,
@@ -0,0 +1,1317 @@
+//===- OCLVectorizeWorkItems.cpp - Vectorize kernels across work-items ----===//
+//
+//                     The LLVM/SPIRV Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2014 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements whole-function vectorization of OpenCL kernels across
+// work-items for execution on a CPU.
+//
+// For every kernel K a work-group function K.wg is added, which takes the
+// kernel arguments and runs all the work-items of the current work-group by
+// looping over the local ids. It calls
+//
+//   K.wi.v<N>(args..., lid.x, lid.y, lid.z)
+//
+// for N work-items with consecutive local ids lid.x .. lid.x + N - 1 at a
+// time, and
+//
+//   K.wi(args..., lid.x, lid.y, lid.z)
+//
+// for the remaining work-items of each row. Inside these functions
+// get_local_id and get_global_id are computed from the explicit local ids,
+// so the runtime only has to call K.wg once per work-group.
+//
+// K.wi.v<N> is built by classifying every value of K as uniform (equal in all
+// work-items), consecutive (the value of the first work-item plus the
+// work-item's lane number) or varying. Uniform values are computed once,
+// consecutive values are computed for the first lane and turn loads and
+// stores into vector loads and stores, and varying values are kept in
+// vectors of N elements. Control flow which depends on varying values is
+// linearized: every block is executed under a mask of the work-items which
+// reach it, phis become selects, and memory accesses and calls are only
+// performed for the active work-items.
+//
+// Kernels which synchronize the work-group (barriers, work-group and
+// sub-group functions) get no work-group function. Neither do kernels which
+// call functions that query the id of the work-item, since only the queries
+// in the kernel itself are replaced; nothing reports this, such kernels are
+// simply left to be run one work-item at a time. Kernels whose vector form
+// is not supported, e.g. because they use private arrays or branch on
+// varying values inside loops, get a work-group function which only uses
+// K.wi.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "oclvecwi"
+
+#include "SPIRVInternal.h"
+#include "OCLUtil.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/PassSupport.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+#include <functional>
+
+using namespace llvm;
+using namespace SPIRV;
+using namespace OCLUtil;
+
+namespace SPIRV {
+
+static const char *const DimNames[] = {"x", "y", "z"};
+
+/// How a value changes across the work-items executed together.
+enum WorkItemShape {
+  WIUniform,     // Same value in all work-items.
+  WIConsecutive, // Value of the first work-item plus the lane number. For
+                 // pointers the lane number is counted in pointee elements.
+  WIVarying      // Any other value.
+};
+
+/// \returns the demangled name of the OpenCL builtin function called by
+/// \p CI or an empty string.
+static std::string
+getCalledBuiltin(CallInst *CI) {
+  auto F = CI->getCalledFunction();
+  std::string DemangledName;
+  if (!F || !F->isDeclaration() || !oclIsBuiltin(F->getName(), &DemangledName))
+    return "";
+  return DemangledName;
+}
+
+static bool
+isWorkItemIdQuery(StringRef Name) {
+  return Name == "get_global_id" || Name == "get_local_id";
+}
+
+/// \returns true for the builtin functions returning the same value in all
+/// the work-items of a work-group.
+static bool
+isWorkGroupUniformBuiltin(StringRef Name) {
+  return Name == "get_work_dim" ||
+         Name == "get_global_size" ||
+         Name == "get_local_size" ||
+         Name == "get_enqueued_local_size" ||
+         Name == "get_num_groups" ||
+         Name == "get_group_id" ||
+         Name == "get_global_offset";
+}
+
+/// \returns true for the builtin functions which need the work-items of a
+/// work-group to run as separate threads.
+static bool
+isWorkGroupCollectiveBuiltin(StringRef Name) {
+  return Name == kOCLBuiltinName::Barrier ||
+         Name.startswith(kOCLBuiltinName::WorkGroupPrefix) ||
+         Name.find("sub_group") != StringRef::npos ||
+         Name == kOCLBuiltinName::AsyncWorkGroupCopy ||
+         Name == kOCLBuiltinName::AsyncWorkGroupStridedCopy ||
+         Name == kOCLBuiltinName::WaitGroupEvent ||
+         Name == "get_local_linear_id" ||
+         Name == "get_global_linear_id";
+}
+
+/// \returns true if \p F, or a function called by it, synchronizes the
+/// work-group or queries the id of the work-item.
+static bool
+usesWorkItemState(Function *F, SmallPtrSet<Function *, 8> &Visited) {
+  if (!Visited.insert(F).second)
+    return false;
+  for (auto I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    auto CI = dyn_cast<CallInst>(&*I);
+    if (!CI || isa<IntrinsicInst>(CI))
+      continue;
+    auto Callee = CI->getCalledFunction();
+    if (!Callee)
+      return true;
+    if (!Callee->isDeclaration()) {
+      if (usesWorkItemState(Callee, Visited))
+        return true;
+      continue;
+    }
+    auto Name = getCalledBuiltin(CI);
+    if (isWorkItemIdQuery(Name) || isWorkGroupCollectiveBuiltin(Name))
+      return true;
+  }
+  return false;
+}
+
+/// \returns true if the work-items of kernel \p F can be executed one after
+/// another by a work-group function.
+static bool
+canExecuteWorkItemsInSequence(Function *F) {
+  SmallPtrSet<Function *, 8> Visited;
+  Visited.insert(F);
+  for (auto I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    auto CI = dyn_cast<CallInst>(&*I);
+    if (!CI || isa<IntrinsicInst>(CI))
+      continue;
+    auto Callee = CI->getCalledFunction();
+    if (!Callee) {
+      DEBUG(dbgs() << "[oclvecwi] indirect call in " << F->getName() << '\n');
+      return false;
+    }
+    if (!Callee->isDeclaration()) {
+      if (usesWorkItemState(Callee, Visited)) {
+        DEBUG(dbgs() << "[oclvecwi] " << Callee->getName() <<
+            " uses work-item state\n");
+        return false;
+      }
+      continue;
+    }
+    auto Name = getCalledBuiltin(CI);
+    if (isWorkGroupCollectiveBuiltin(Name) ||
+        (isWorkItemIdQuery(Name) && !isa<ConstantInt>(CI->getArgOperand(0)))) {
+      DEBUG(dbgs() << "[oclvecwi] unsupported call " << *CI << '\n');
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Get or declare the OpenCL builtin function \p Name taking the dimension
+/// index and returning size_t.
+static Function *
+getWorkItemBuiltin(Module *M, const std::string &Name) {
+  auto Int32Ty = Type::getInt32Ty(M->getContext());
+  std::string MangledName;
+  MangleOpenCLBuiltin(Name, Int32Ty, MangledName);
+  Function *F = M->getFunction(MangledName);
+  if (!F) {
+    FunctionType *FT = FunctionType::get(getSizetType(M), Int32Ty, false);
+    F = Function::Create(FT, GlobalValue::ExternalLinkage, MangledName, M);
+    F->setCallingConv(CallingConv::SPIR_FUNC);
+    F->addFnAttr(Attribute::NoUnwind);
+    F->addFnAttr(Attribute::ReadNone);
+  }
+  return F;
+}
+
+static Value *
+emitWorkItemBuiltinCall(IRBuilder<> &Builder, Module *M,
+    const std::string &Name, unsigned Dim) {
+  auto F = getWorkItemBuiltin(M, Name);
+  auto CI = Builder.CreateCall(F, Builder.getInt32(Dim));
+  CI->setCallingConv(F->getCallingConv());
+  return Builder.CreateZExtOrTrunc(CI, getSizetType(M));
+}
+
+/// Emit get_group_id(Dim) * get_local_size(Dim) + get_global_offset(Dim),
+/// which is get_global_id(Dim) - get_local_id(Dim) for uniform work-groups.
+static Value *
+emitGlobalIdOffset(IRBuilder<> &Builder, Module *M, unsigned Dim) {
+  auto Group = emitWorkItemBuiltinCall(Builder, M, "get_group_id", Dim);
+  auto Size = emitWorkItemBuiltinCall(Builder, M, "get_local_size", Dim);
+  auto Offset = emitWorkItemBuiltinCall(Builder, M, "get_global_offset", Dim);
+  return Builder.CreateAdd(Builder.CreateMul(Group, Size), Offset);
+}
+
+/// Replace get_local_id and get_global_id in the work-item function \p F,
+/// whose last three arguments are the local ids.
+static void
+replaceWorkItemIdQueries(Function *F) {
+  Module *M = F->getParent();
+  Value *LocalIds[3];
+  auto Arg = F->arg_end();
+  for (int Dim = 2; Dim >= 0; --Dim)
+    LocalIds[Dim] = --Arg;
+  std::vector<CallInst *> Queries;
+  for (auto I = inst_begin(F), E = inst_end(F); I != E; ++I)
+    if (auto CI = dyn_cast<CallInst>(&*I))
+      if (isWorkItemIdQuery(getCalledBuiltin(CI)))
+        Queries.push_back(CI);
+  for (auto CI : Queries) {
+    unsigned Dim = cast<ConstantInt>(CI->getArgOperand(0))->getZExtValue();
+    IRBuilder<> Builder(CI);
+    Value *Id = getSizet(M, 0);
+    if (Dim < 3) {
+      Id = LocalIds[Dim];
+      if (getCalledBuiltin(CI) == "get_global_id")
+        Id = Builder.CreateAdd(emitGlobalIdOffset(Builder, M, Dim), Id);
+    }
+    Id = Builder.CreateZExtOrTrunc(Id, CI->getType());
+    if (isa<Instruction>(Id))
+      Id->takeName(CI);
+    CI->replaceAllUsesWith(Id);
+    CI->eraseFromParent();
+  }
+}
+
+/// Builds the function executing a kernel for Width work-items with
+/// consecutive local ids in the first dimension.
+class WorkItemVectorizer {
+public:
+  WorkItemVectorizer(Function *F, unsigned Width):M(F->getParent()), F(F),
+      Width(Width), Divergent(false), VF(nullptr), Builder(F->getContext()),
+      Prologue(F->getContext()), AllTrue(nullptr), KnownAnyMask(nullptr) {}
+
+  /// \returns the vectorized function of type \p FT named \p Name, or
+  /// nullptr if the kernel cannot be vectorized.
+  Function *run(FunctionType *FT, const Twine &Name);
+
+private:
+  Module *M;
+  Function *F;
+  unsigned Width;
+
+  // Analysis of the kernel.
+  DominatorTree DT;
+  LoopInfoBase<BasicBlock, Loop> LI;
+  std::vector<BasicBlock *> RPO;
+  DenseMap<BasicBlock *, unsigned> RPONum;
+  DenseMap<Value *, WorkItemShape> Shapes;
+  DenseSet<BasicBlock *> VaryingMaskBlocks;
+  bool Divergent;
+
+  // State of the vectorized function.
+  Function *VF;
+  IRBuilder<> Builder;
+  IRBuilder<> Prologue;
+  Value *LocalIds[3];
+  Value *GlobalIds[3];
+  Value *AllTrue;
+  Value *KnownAnyMask;
+  DenseMap<Value *, Value *> Scalars;
+  DenseMap<Value *, Value *> Vectors;
+  DenseMap<BasicBlock *, BasicBlock *> NewBlocks;
+  DenseMap<BasicBlock *, BasicBlock *> EndBlocks;
+  DenseMap<std::pair<BasicBlock *, BasicBlock *>, Value *> EdgeMasks;
+  DenseMap<std::pair<Value *, unsigned>, Value *> ReducedMasks;
+
+  WorkItemShape getShape(Value *V) const {
+    auto Loc = Shapes.find(V);
+    return Loc == Shapes.end() ? WIUniform : Loc->second;
+  }
+  bool isBackEdge(BasicBlock *From, BasicBlock *To) const {
+    auto L = LI.getLoopFor(To);
+    return L && L->getHeader() == To && L->contains(From);
+  }
+  bool isDivergent(TerminatorInst *T) const {
+    if (auto BI = dyn_cast<BranchInst>(T))
+      return BI->isConditional() && getShape(BI->getCondition()) != WIUniform;
+    if (auto SI = dyn_cast<SwitchInst>(T))
+      return getShape(SI->getCondition()) != WIUniform;
+    return false;
+  }
+  bool isAllTrue(Value *Mask) const {
+    return Mask == AllTrue;
+  }
+
+  bool analyze();
+  WorkItemShape computeShape(Instruction *I);
+  WorkItemShape computePhiShape(PHINode *Phi);
+  bool hasVaryingMask(BasicBlock *BB);
+  bool isSupported();
+
+  Value *getScalar(Value *V);
+  Value *getVector(Value *V);
+  Value *getLane(Value *V, unsigned Lane);
+  Value *getPhiOperand(PHINode *Phi, Value *V);
+  Value *emitReduceMask(Value *Mask, bool All);
+  Value *emitIf(Value *Cond, std::function<Value *()> Then,
+      std::function<Value *()> Else, const Twine &Name);
+  Value *emitLinearPhi(PHINode *Phi, bool FromOutside);
+  void emitRegion(ArrayRef<BasicBlock *> Blocks, Value *Mask, BasicBlock *Exit,
+      BasicBlock *Pre, const DenseMap<PHINode *, Value *> &Entries);
+  void emitLinearized();
+  void eraseDeadMasks();
+  void emitLinearBlock(BasicBlock *BB);
+  void emitLinearLoop(Loop *L);
+  void addEdgeMask(BasicBlock *From, BasicBlock *To, Value *Mask);
+  void emitInstruction(Instruction *I, Value *Mask);
+  bool emitWorkItemIdQuery(CallInst *CI);
+  void emitScalar(Instruction *I, Value *Mask);
+  void emitVarying(Instruction *I, Value *Mask);
+  Value *emitPerLane(Instruction *I, Value *Mask);
+};
+
+bool
+WorkItemVectorizer::analyze() {
+  DT.recalculate(*F);
+  LI.Analyze(DT);
+  ReversePostOrderTraversal<Function *> RPOT(F);
+  for (auto BB : RPOT) {
+    RPONum[BB] = RPO.size();
+    RPO.push_back(BB);
+  }
+
+  // Shapes only move from uniform towards varying, so this terminates.
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (auto BB : RPO) {
+      if (!VaryingMaskBlocks.count(BB) && hasVaryingMask(BB)) {
+        VaryingMaskBlocks.insert(BB);
+        Changed = true;
+      }
+      for (auto &I : *BB) {
+        auto S = computeShape(&I);
+        if (S > getShape(&I)) {
+          Shapes[&I] = S;
+          Changed = true;
+        }
+      }
+    }
+  }
+
+  for (auto BB : RPO)
+    if (isDivergent(BB->getTerminator()))
+      Divergent = true;
+  return isSupported();
+}
+
+bool
+WorkItemVectorizer::hasVaryingMask(BasicBlock *BB) {
+  for (auto PI = pred_begin(BB), PE = pred_end(BB); PI != PE; ++PI) {
+    auto P = *PI;
+    if (!RPONum.count(P) || isBackEdge(P, BB))
+      continue;
+    if (VaryingMaskBlocks.count(P) || isDivergent(P->getTerminator()))
+      return true;
+  }
+  return false;
+}
+
+WorkItemShape
+WorkItemVectorizer::computePhiShape(PHINode *Phi) {
+  WorkItemShape S = WIUniform;
+  bool First = true;
+  Value *Entry = nullptr;
+  bool DifferentEntries = false;
+  for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I) {
+    auto P = Phi->getIncomingBlock(I);
+    if (!RPONum.count(P))
+      continue;
+    auto V = Phi->getIncomingValue(I);
+    auto VS = getShape(V);
+    if (First)
+      S = VS;
+    else if (VS != S)
+      S = WIVarying;
+    First = false;
+    if (isBackEdge(P, Phi->getParent()))
+      continue;
+    if (Entry && Entry != V)
+      DifferentEntries = true;
+    Entry = V;
+  }
+  // Work-items reaching the block through different edges get different
+  // values.
+  if (DifferentEntries && VaryingMaskBlocks.count(Phi->getParent()))
+    return WIVarying;
+  return S;
+}
+
+WorkItemShape
+WorkItemVectorizer::computeShape(Instruction *I) {
+  if (isa<DbgInfoIntrinsic>(I))
+    return WIUniform;
+  if (auto Phi = dyn_cast<PHINode>(I))
+    return computePhiShape(Phi);
+  if (auto CI = dyn_cast<CallInst>(I)) {
+    auto Name = getCalledBuiltin(CI);
+    if (isWorkItemIdQuery(Name))
+      return cast<ConstantInt>(CI->getArgOperand(0))->isZero() ?
+          WIConsecutive : WIUniform;
+    if (isWorkGroupUniformBuiltin(Name))
+      return WIUniform;
+    // Calls with side effects are made by every work-item.
+    if (!CI->doesNotAccessMemory())
+      return WIVarying;
+  }
+
+  SmallVector<WorkItemShape, 4> Ops;
+  bool AllUniform = true;
+  for (auto &Op : I->operands()) {
+    auto S = getShape(Op);
+    if (S == WIVarying)
+      return WIVarying;
+    AllUniform &= S == WIUniform;
+    Ops.push_back(S);
+  }
+  if (AllUniform) {
+    if (auto LD = dyn_cast<LoadInst>(I))
+      return LD->isSimple() ? WIUniform : WIVarying;
+    if (auto ST = dyn_cast<StoreInst>(I))
+      return ST->isSimple() ? WIUniform : WIVarying;
+    if (isa<AtomicRMWInst>(I) || isa<AtomicCmpXchgInst>(I) || isa<VAArgInst>(I))
+      return WIVarying;
+    return WIUniform;
+  }
+
+  switch (I->getOpcode()) {
+  case Instruction::Add:
+    // The index arithmetic is assumed not to wrap between the work-items
+    // executed together, here and for the extensions below.
+    if (Ops[0] == WIUniform || Ops[1] == WIUniform)
+      return WIConsecutive;
+    return WIVarying;
+  case Instruction::Sub:
+    return Ops[1] == WIUniform ? WIConsecutive : WIVarying;
+  case Instruction::Trunc:
+  case Instruction::ZExt:
+  case Instruction::SExt:
+    return I->getType()->isIntegerTy(1) ? WIVarying : WIConsecutive;
+  case Instruction::BitCast:
+  case Instruction::AddrSpaceCast: {
+    auto SrcTy = dyn_cast<PointerType>(I->getOperand(0)->getType());
+    auto DstTy = dyn_cast<PointerType>(I->getType());
+    auto DL = M->getDataLayout();
+    if (SrcTy && DstTy && SrcTy->getElementType()->isSized() &&
+        DstTy->getElementType()->isSized() &&
+        DL->getTypeAllocSize(SrcTy->getElementType()) ==
+        DL->getTypeAllocSize(DstTy->getElementType()))
+      return WIConsecutive;
+    return WIVarying;
+  }
+  case Instruction::GetElementPtr: {
+    // Either the base is consecutive and is offset by whole elements, or the
+    // last index is consecutive.
+    auto GEP = cast<GetElementPtrInst>(I);
+    unsigned Last = GEP->getNumOperands() - 1;
+    for (unsigned Idx = 1; Idx < Last; ++Idx)
+      if (Ops[Idx] != WIUniform)
+        return WIVarying;
+    if (Ops[0] == WIConsecutive)
+      return GEP->getNumIndices() == 1 && Ops[Last] == WIUniform ?
+          WIConsecutive : WIVarying;
+    return WIConsecutive;
+  }
+  case Instruction::Select:
+    if (Ops[0] == WIUniform && Ops[1] == Ops[2])
+      return Ops[1];
+    return WIVarying;
+  default:
+    return WIVarying;
+  }
+}
+
+bool
+WorkItemVectorizer::isSupported() {
+  for (auto BB : RPO) {
+    auto T = BB->getTerminator();
+    if (!isa<BranchInst>(T) && !isa<SwitchInst>(T) && !isa<ReturnInst>(T) &&
+        !isa<UnreachableInst>(T)) {
+      DEBUG(dbgs() << "[oclvecwi] unsupported terminator " << *T << '\n');
+      return false;
+    }
+    for (auto &I : *BB) {
+      // Private memory would have to be replicated for each work-item.
+      if (isa<AllocaInst>(I) || isa<LandingPadInst>(I) || isa<VAArgInst>(I)) {
+        DEBUG(dbgs() << "[oclvecwi] unsupported instruction " << I << '\n');
+        return false;
+      }
+      auto Ty = I.getType();
+      if (getShape(&I) != WIUniform && !Ty->isVoidTy() &&
+          !VectorType::isValidElementType(Ty)) {
+        DEBUG(dbgs() << "[oclvecwi] cannot vectorize type of " << I << '\n');
+        return false;
+      }
+    }
+  }
+  if (!Divergent)
+    return true;
+
+  // Divergent control flow is linearized. Loops are kept, as long as all
+  // the work-items executing a loop take the same path through it.
+  for (auto BB : RPO) {
+    auto T = BB->getTerminator();
+    auto L = LI.getLoopFor(BB);
+    if ((L && isDivergent(T)) || (!L && isa<SwitchInst>(T))) {
+      DEBUG(dbgs() << "[oclvecwi] cannot linearize " << *T << '\n');
+      return false;
+    }
+    for (auto SI = succ_begin(BB), SE = succ_end(BB); SI != SE; ++SI)
+      if (RPONum[*SI] <= RPONum[BB] && !isBackEdge(BB, *SI)) {
+        DEBUG(dbgs() << "[oclvecwi] irreducible control flow\n");
+        return false;
+      }
+  }
+  for (auto L : LI)
+    if (!L->getExitingBlock() || !L->getExitBlock()) {
+      DEBUG(dbgs() << "[oclvecwi] loop with several exits\n");
+      return false;
+    }
+  return true;
+}
+
+Value *
+WorkItemVectorizer::getScalar(Value *V) {
+  if (isa<Constant>(V))
+    return V;
+  auto Loc = Scalars.find(V);
+  assert(Loc != Scalars.end() && "Value has no scalar form");
+  return Loc->second;
+}
+
+Value *
+WorkItemVectorizer::getVector(Value *V) {
+  if (auto C = dyn_cast<Constant>(V))
+    return ConstantVector::getSplat(Width, C);
+  auto Loc = Vectors.find(V);
+  if (Loc != Vectors.end())
+    return Loc->second;
+
+  // Build the vector right after the scalar, so that it is available
+  // wherever the scalar is.
+  auto S = getScalar(V);
+  IRBuilder<> B(F->getContext());
+  if (auto SI = dyn_cast<Instruction>(S)) {
+    auto BB = SI->getParent();
+    if (isa<PHINode>(SI))
+      B.SetInsertPoint(BB, BB->getFirstInsertionPt());
+    else
+      B.SetInsertPoint(BB, std::next(BasicBlock::iterator(SI)));
+  } else
+    B.SetInsertPoint(Prologue.GetInsertBlock());
+
+  Value *Vec = nullptr;
+  if (getShape(V) == WIUniform)
+    Vec = B.CreateVectorSplat(Width, S);
+  else if (S->getType()->isPointerTy()) {
+    Vec = UndefValue::get(VectorType::get(S->getType(), Width));
+    for (unsigned Lane = 0; Lane < Width; ++Lane)
+      Vec = B.CreateInsertElement(Vec,
+          Lane ? B.CreateGEP(S, B.getInt32(Lane)) : S, B.getInt32(Lane));
+  } else {
+    SmallVector<Constant *, 16> Lanes;
+    for (unsigned Lane = 0; Lane < Width; ++Lane)
+      Lanes.push_back(ConstantInt::get(S->getType(), Lane));
+    Vec = B.CreateAdd(B.CreateVectorSplat(Width, S),
+        ConstantVector::get(Lanes));
+  }
+  Vec->setName(V->getName() + ".vec");
+  Vectors[V] = Vec;
+  return Vec;
+}
+
+Value *
+WorkItemVectorizer::getLane(Value *V, unsigned Lane) {
+  switch (getShape(V)) {
+  case WIUniform:
+    return getScalar(V);
+  case WIConsecutive: {
+    auto S = getScalar(V);
+    if (Lane == 0)
+      return S;
+    if (S->getType()->isPointerTy())
+      return Builder.CreateGEP(S, Builder.getInt32(Lane));
+    return Builder.CreateAdd(S, ConstantInt::get(S->getType(), Lane));
+  }
+  case WIVarying:
+    break;
+  }
+  return Builder.CreateExtractElement(getVector(V), Builder.getInt32(Lane));
+}
+
+Value *
+WorkItemVectorizer::getPhiOperand(PHINode *Phi, Value *V) {
+  return getShape(Phi) == WIVarying ? getVector(V) : getScalar(V);
+}
+
+/// \returns whether all (\p All is true) or any of the lanes of \p Mask are
+/// true. The result is computed once, next to the mask.
+Value *
+WorkItemVectorizer::emitReduceMask(Value *Mask, bool All) {
+  auto &R = ReducedMasks[std::make_pair(Mask, All)];
+  if (R)
+    return R;
+  IRBuilder<> B(Builder.GetInsertBlock());
+  if (auto MI = dyn_cast<Instruction>(Mask)) {
+    auto BB = MI->getParent();
+    if (isa<PHINode>(MI))
+      B.SetInsertPoint(BB, BB->getFirstInsertionPt());
+    else
+      B.SetInsertPoint(BB, std::next(BasicBlock::iterator(MI)));
+  }
+  R = B.CreateExtractElement(Mask, B.getInt32(0));
+  for (unsigned Lane = 1; Lane < Width; ++Lane) {
+    auto Bit = B.CreateExtractElement(Mask, B.getInt32(Lane));
+    R = All ? B.CreateAnd(R, Bit) : B.CreateOr(R, Bit);
+  }
+  if (!isa<Constant>(R))
+    R->setName(All ? "all" : "any");
+  return R;
+}
+
+/// Emit a branch on \p Cond to the code generated by \p Then and \p Else.
+/// \returns the merged results of \p Then and \p Else, if any. A null \p Else
+/// produces an undefined value.
+Value *
+WorkItemVectorizer::emitIf(Value *Cond, std::function<Value *()> Then,
+    std::function<Value *()> Else, const Twine &Name) {
+  auto Ctx = &F->getContext();
+  auto From = Builder.GetInsertBlock();
+  auto Next = From->getNextNode();
+  auto ThenBB = BasicBlock::Create(*Ctx, Name + ".then", VF, Next);
+  auto ElseBB = Else ? BasicBlock::Create(*Ctx, Name + ".else", VF, Next) :
+      nullptr;
+  auto ContBB = BasicBlock::Create(*Ctx, Name + ".cont", VF, Next);
+  Builder.CreateCondBr(Cond, ThenBB, ElseBB ? ElseBB : ContBB);
+
+  Builder.SetInsertPoint(ThenBB);
+  auto ThenV = Then();
+  auto ThenEnd = Builder.GetInsertBlock();
+  Builder.CreateBr(ContBB);
+  Value *ElseV = nullptr;
+  auto ElseEnd = From;
+  if (ElseBB) {
+    Builder.SetInsertPoint(ElseBB);
+    ElseV = Else();
+    ElseEnd = Builder.GetInsertBlock();
+    Builder.CreateBr(ContBB);
+  }
+
+  Builder.SetInsertPoint(ContBB);
+  if (!ThenV || ThenV->getType()->isVoidTy())
+    return nullptr;
+  if (!ElseV)
+    ElseV = UndefValue::get(ThenV->getType());
+  auto Phi = Builder.CreatePHI(ThenV->getType(), 2, ThenV->getName());
+  Phi->addIncoming(ThenV, ThenEnd);
+  Phi->addIncoming(ElseV, ElseEnd);
+  return Phi;
+}
+
+bool
+WorkItemVectorizer::emitWorkItemIdQuery(CallInst *CI) {
+  auto Name = getCalledBuiltin(CI);
+  if (!isWorkItemIdQuery(Name))
+    return false;
+  unsigned Dim = cast<ConstantInt>(CI->getArgOperand(0))->getZExtValue();
+  Value *Id = getSizet(M, 0);
+  if (Dim < 3) {
+    Id = LocalIds[Dim];
+    if (Name == "get_global_id") {
+      if (!GlobalIds[Dim])
+        GlobalIds[Dim] = Prologue.CreateAdd(emitGlobalIdOffset(Prologue, M,
+            Dim), Id, "global_id");
+      Id = GlobalIds[Dim];
+    }
+  }
+  Scalars[CI] = Prologue.CreateZExtOrTrunc(Id, CI->getType());
+  return true;
+}
+
+void
+WorkItemVectorizer::emitInstruction(Instruction *I, Value *Mask) {
+  if (isa<DbgInfoIntrinsic>(I))
+    return;
+  if (auto CI = dyn_cast<CallInst>(I))
+    if (emitWorkItemIdQuery(CI))
+      return;
+  if (getShape(I) == WIVarying)
+    emitVarying(I, Mask);
+  else
+    emitScalar(I, Mask);
+}
+
+void
+WorkItemVectorizer::emitScalar(Instruction *I, Value *Mask) {
+  auto NewI = I->clone();
+  for (unsigned Idx = 0, E = I->getNumOperands(); Idx != E; ++Idx)
+    NewI->setOperand(Idx, getScalar(I->getOperand(Idx)));
+  auto Insert = [&]() -> Value * {
+    return Builder.Insert(NewI, I->getName());
+  };
+  // The instruction is executed once for all the active work-items, and must
+  // not be executed if none is active.
+  if (isAllTrue(Mask) || Mask == KnownAnyMask ||
+      isSafeToSpeculativelyExecute(I, M->getDataLayout()))
+    Scalars[I] = Insert();
+  else
+    Scalars[I] = emitIf(emitReduceMask(Mask, false), Insert, nullptr,
+        I->getName().empty() ? I->getOpcodeName() : I->getName());
+}
+
+void
+WorkItemVectorizer::emitVarying(Instruction *I, Value *Mask) {
+  auto Name = I->getName();
+  if (auto BO = dyn_cast<BinaryOperator>(I)) {
+    auto LHS = getVector(BO->getOperand(0));
+    auto RHS = getVector(BO->getOperand(1));
+    switch (BO->getOpcode()) {
+    case Instruction::UDiv:
+    case Instruction::SDiv:
+    case Instruction::URem:
+    case Instruction::SRem:
+      // Inactive work-items divide by one instead of a value they have not
+      // computed.
+      if (!isAllTrue(Mask))
+        RHS = Builder.CreateSelect(Mask, RHS, getVector(ConstantInt::get(
+            BO->getType(), 1)));
+      break;
+    default:
+      break;
+    }
+    auto V = Builder.CreateBinOp(BO->getOpcode(), LHS, RHS, Name);
+    if (auto NewBO = dyn_cast<BinaryOperator>(V))
+      NewBO->copyIRFlags(BO);
+    Vectors[I] = V;
+    return;
+  }
+  if (auto Cmp = dyn_cast<ICmpInst>(I)) {
+    Vectors[I] = Builder.CreateICmp(Cmp->getPredicate(),
+        getVector(Cmp->getOperand(0)), getVector(Cmp->getOperand(1)), Name);
+    return;
+  }
+  if (auto Cmp = dyn_cast<FCmpInst>(I)) {
+    Vectors[I] = Builder.CreateFCmp(Cmp->getPredicate(),
+        getVector(Cmp->getOperand(0)), getVector(Cmp->getOperand(1)), Name);
+    return;
+  }
+  if (auto Cast = dyn_cast<CastInst>(I)) {
+    Vectors[I] = Builder.CreateCast(Cast->getOpcode(),
+        getVector(Cast->getOperand(0)),
+        VectorType::get(Cast->getType(), Width), Name);
+    return;
+  }
+  if (auto Sel = dyn_cast<SelectInst>(I)) {
+    auto Cond = Sel->getCondition();
+    Vectors[I] = Builder.CreateSelect(getShape(Cond) == WIUniform ?
+        getScalar(Cond) : getVector(Cond), getVector(Sel->getTrueValue()),
+        getVector(Sel->getFalseValue()), Name);
+    return;
+  }
+
+  // Loads and stores of consecutive addresses access a vector, if all the
+  // work-items are active.
+  auto LD = dyn_cast<LoadInst>(I);
+  auto ST = dyn_cast<StoreInst>(I);
+  auto DL = M->getDataLayout();
+  Value *Ptr = LD ? LD->getPointerOperand() :
+      ST ? ST->getPointerOperand() : nullptr;
+  Type *EltTy = Ptr ? Ptr->getType()->getPointerElementType() : nullptr;
+  if (Ptr && (LD ? LD->isSimple() : ST->isSimple()) &&
+      getShape(Ptr) == WIConsecutive && VectorType::isValidElementType(EltTy) &&
+      DL->getTypeSizeInBits(EltTy) == DL->getTypeAllocSizeInBits(EltTy)) {
+    unsigned Align = LD ? LD->getAlignment() : ST->getAlignment();
+    if (!Align)
+      Align = DL->getABITypeAlignment(EltTy);
+    auto Vector = [&]() -> Value * {
+      auto VecPtr = Builder.CreateBitCast(getScalar(Ptr),
+          VectorType::get(EltTy, Width)->getPointerTo(
+              Ptr->getType()->getPointerAddressSpace()));
+      if (LD)
+        return Builder.CreateAlignedLoad(VecPtr, Align, Name);
+      Builder.CreateAlignedStore(getVector(ST->getValueOperand()), VecPtr,
+          Align);
+      return nullptr;
+    };
+    if (isAllTrue(Mask))
+      Vectors[I] = Vector();
+    else
+      Vectors[I] = emitIf(emitReduceMask(Mask, true), Vector,
+          [&]() { return emitPerLane(I, Mask); },
+          LD ? (Name.empty() ? "load" : Name) : "store");
+    if (!Vectors[I])
+      Vectors.erase(I);
+    return;
+  }
+
+  if (auto V = emitPerLane(I, Mask))
+    Vectors[I] = V;
+}
+
+/// Execute \p I for each active work-item.
+/// \returns the vector of the results, or nullptr if \p I has no result.
+Value *
+WorkItemVectorizer::emitPerLane(Instruction *I, Value *Mask) {
+  bool Guard = !isAllTrue(Mask) &&
+      !isSafeToSpeculativelyExecute(I, M->getDataLayout());
+  Type *Ty = I->getType();
+  Value *Vec = Ty->isVoidTy() ? nullptr :
+      UndefValue::get(VectorType::get(Ty, Width));
+  for (unsigned Lane = 0; Lane < Width; ++Lane) {
+    auto Scalar = [&]() -> Value * {
+      auto NewI = I->clone();
+      for (unsigned Idx = 0, E = I->getNumOperands(); Idx != E; ++Idx)
+        NewI->setOperand(Idx, getLane(I->getOperand(Idx), Lane));
+      return Builder.Insert(NewI, Ty->isVoidTy() ? "" : I->getName());
+    };
+    Value *V = Guard ? emitIf(Builder.CreateExtractElement(Mask,
+        Builder.getInt32(Lane)), Scalar, nullptr, "lane") : Scalar();
+    if (Vec)
+      Vec = Builder.CreateInsertElement(Vec, V, Builder.getInt32(Lane));
+  }
+  return Vec;
+}
+
+/// Clone \p Blocks, given in reverse post order, keeping their control flow.
+/// Edges leaving the region go to \p Exit and the values entering the region
+/// through the header phis come from \p Entries on the edge from \p Pre.
+void
+WorkItemVectorizer::emitRegion(ArrayRef<BasicBlock *> Blocks, Value *Mask,
+    BasicBlock *Exit, BasicBlock *Pre,
+    const DenseMap<PHINode *, Value *> &Entries) {
+  auto Ctx = &F->getContext();
+  DenseSet<BasicBlock *> InRegion;
+  for (auto BB : Blocks) {
+    InRegion.insert(BB);
+    NewBlocks[BB] = BasicBlock::Create(*Ctx, BB->getName(), VF, Exit);
+  }
+
+  for (auto BB : Blocks) {
+    Builder.SetInsertPoint(NewBlocks[BB]);
+    for (auto &I : *BB) {
+      if (auto Phi = dyn_cast<PHINode>(&I)) {
+        bool IsVec = getShape(Phi) == WIVarying;
+        auto NewPhi = Builder.CreatePHI(IsVec ?
+            VectorType::get(Phi->getType(), Width) : Phi->getType(),
+            Phi->getNumIncomingValues(), Phi->getName());
+        (IsVec ? Vectors : Scalars)[Phi] = NewPhi;
+        continue;
+      }
+      if (isa<TerminatorInst>(I))
+        break;
+      emitInstruction(&I, Mask);
+    }
+    EndBlocks[BB] = Builder.GetInsertBlock();
+
+    auto T = BB->getTerminator();
+    if (isa<ReturnInst>(T)) {
+      Builder.CreateRetVoid();
+      continue;
+    }
+    auto NewT = cast<TerminatorInst>(T->clone());
+    if (auto BI = dyn_cast<BranchInst>(NewT)) {
+      if (BI->isConditional())
+        BI->setCondition(getScalar(BI->getCondition()));
+    } else if (auto SI = dyn_cast<SwitchInst>(NewT))
+      SI->setCondition(getScalar(SI->getCondition()));
+    for (unsigned Idx = 0, E = T->getNumSuccessors(); Idx != E; ++Idx) {
+      auto S = T->getSuccessor(Idx);
+      NewT->setSuccessor(Idx, InRegion.count(S) ? NewBlocks[S] : Exit);
+    }
+    Builder.Insert(NewT);
+  }
+
+  for (auto BB : Blocks) {
+    for (auto &I : *BB) {
+      auto Phi = dyn_cast<PHINode>(&I);
+      if (!Phi)
+        break;
+      auto NewPhi = cast<PHINode>(getShape(Phi) == WIVarying ?
+          Vectors[Phi] : Scalars[Phi]);
+      bool HasEntry = false;
+      for (unsigned Idx = 0, E = Phi->getNumIncomingValues(); Idx != E;
+          ++Idx) {
+        auto P = Phi->getIncomingBlock(Idx);
+        if (!RPONum.count(P))
+          continue;
+        if (InRegion.count(P))
+          NewPhi->addIncoming(getPhiOperand(Phi, Phi->getIncomingValue(Idx)),
+              EndBlocks[P]);
+        else if (!HasEntry) {
+          NewPhi->addIncoming(Entries.lookup(Phi), Pre);
+          HasEntry = true;
+        }
+      }
+    }
+  }
+}
+
+void
+WorkItemVectorizer::addEdgeMask(BasicBlock *From, BasicBlock *To,
+    Value *Mask) {
+  auto &EM = EdgeMasks[std::make_pair(From, To)];
+  EM = EM ? Builder.CreateOr(EM, Mask) : Mask;
+}
+
+/// Emit the value of \p Phi as a chain of selects on the masks of its
+/// incoming edges. Only the edges from outside the loop headed by the block
+/// of \p Phi are used if \p FromOutside is true.
+Value *
+WorkItemVectorizer::emitLinearPhi(PHINode *Phi, bool FromOutside) {
+  auto BB = Phi->getParent();
+  bool IsVec = getShape(Phi) == WIVarying;
+  Value *R = nullptr;
+  for (unsigned Idx = 0, E = Phi->getNumIncomingValues(); Idx != E; ++Idx) {
+    auto P = Phi->getIncomingBlock(Idx);
+    if (!RPONum.count(P) || (FromOutside && isBackEdge(P, BB)))
+      continue;
+    auto V = getPhiOperand(Phi, Phi->getIncomingValue(Idx));
+    if (!R) {
+      R = V;
+      continue;
+    }
+    Value *EM = EdgeMasks.lookup(std::make_pair(P, BB));
+    if (!IsVec)
+      EM = Builder.CreateExtractElement(EM, Builder.getInt32(0));
+    R = Builder.CreateSelect(EM, V, R, Phi->getName());
+  }
+  return R;
+}
+
+void
+WorkItemVectorizer::emitLinearBlock(BasicBlock *BB) {
+  Value *Mask = nullptr;
+  if (BB == &F->getEntryBlock())
+    Mask = AllTrue;
+  else
+    for (auto PI = pred_begin(BB), PE = pred_end(BB); PI != PE; ++PI)
+      if (RPONum.count(*PI)) {
+        auto EM = EdgeMasks.lookup(std::make_pair(*PI, BB));
+        Mask = Mask ? Builder.CreateOr(Mask, EM) : EM;
+      }
+
+  for (auto &I : *BB) {
+    if (auto Phi = dyn_cast<PHINode>(&I)) {
+      (getShape(Phi) == WIVarying ? Vectors : Scalars)[Phi] =
+          emitLinearPhi(Phi, false);
+      continue;
+    }
+    if (isa<TerminatorInst>(I))
+      break;
+    emitInstruction(&I, Mask);
+  }
+
+  auto BI = dyn_cast<BranchInst>(BB->getTerminator());
+  if (!BI)
+    return;
+  if (BI->isUnconditional()) {
+    addEdgeMask(BB, BI->getSuccessor(0), Mask);
+    return;
+  }
+  auto Cond = getVector(BI->getCondition());
+  auto NotCond = Builder.CreateNot(Cond);
+  addEdgeMask(BB, BI->getSuccessor(0),
+      isAllTrue(Mask) ? Cond : Builder.CreateAnd(Mask, Cond));
+  addEdgeMask(BB, BI->getSuccessor(1),
+      isAllTrue(Mask) ? NotCond : Builder.CreateAnd(Mask, NotCond));
+}
+
+/// Emit a top level loop of a linearized kernel. All the active work-items
+/// execute the same iterations, so the loop is kept and entered if any
+/// work-item is active.
+void
+WorkItemVectorizer::emitLinearLoop(Loop *L) {
+  auto Header = L->getHeader();
+  Value *Mask = nullptr;
+  for (auto PI = pred_begin(Header), PE = pred_end(Header); PI != PE; ++PI)
+    if (RPONum.count(*PI) && !L->contains(*PI)) {
+      auto EM = EdgeMasks.lookup(std::make_pair(*PI, Header));
+      Mask = Mask ? Builder.CreateOr(Mask, EM) : EM;
+    }
+  DenseMap<PHINode *, Value *> Entries;
+  for (auto &I : *Header) {
+    auto Phi = dyn_cast<PHINode>(&I);
+    if (!Phi)
+      break;
+    Entries[Phi] = emitLinearPhi(Phi, true);
+  }
+  Value *Any = isAllTrue(Mask) ? nullptr : emitReduceMask(Mask, false);
+  auto Pre = Builder.GetInsertBlock();
+  auto End = BasicBlock::Create(F->getContext(),
+      L->getExitBlock()->getName() + ".loopend", VF);
+
+  std::vector<BasicBlock *> Blocks;
+  for (auto BB : RPO)
+    if (L->contains(BB))
+      Blocks.push_back(BB);
+  auto SavedAnyMask = KnownAnyMask;
+  KnownAnyMask = Mask;
+  emitRegion(Blocks, Mask, End, Pre, Entries);
+  KnownAnyMask = SavedAnyMask;
+  IRBuilder<> PreBuilder(Pre);
+  if (Any)
+    PreBuilder.CreateCondBr(Any, NewBlocks[Header], End);
+  else
+    PreBuilder.CreateBr(NewBlocks[Header]);
+
+  // Values used after a skipped loop are undefined, as no work-item uses
+  // them.
+  Builder.SetInsertPoint(End);
+  auto Exiting = L->getExitingBlock();
+  if (Any) {
+    auto ExitingEnd = EndBlocks[Exiting];
+    for (auto BB : Blocks)
+      for (auto &I : *BB) {
+        bool UsedOutside = false;
+        for (auto U : I.users())
+          if (!L->contains(cast<Instruction>(U)->getParent()))
+            UsedOutside = true;
+        if (!UsedOutside)
+          continue;
+        for (auto Map : {&Scalars, &Vectors}) {
+          auto Loc = Map->find(&I);
+          if (Loc == Map->end())
+            continue;
+          auto V = Loc->second;
+          auto Phi = Builder.CreatePHI(V->getType(), 2, I.getName());
+          Phi->addIncoming(V, ExitingEnd);
+          Phi->addIncoming(UndefValue::get(V->getType()), Pre);
+          Loc->second = Phi;
+        }
+      }
+  }
+  EdgeMasks[std::make_pair(Exiting, L->getExitBlock())] = Mask;
+}
+
+void
+WorkItemVectorizer::emitLinearized() {
+  DenseSet<Loop *> Done;
+  for (auto BB : RPO) {
+    auto L = LI.getLoopFor(BB);
+    if (!L) {
+      emitLinearBlock(BB);
+      continue;
+    }
+    while (L->getParentLoop())
+      L = L->getParentLoop();
+    if (Done.insert(L).second)
+      emitLinearLoop(L);
+  }
+  Builder.CreateRetVoid();
+}
+
+/// Erase the masks, and their reductions, which no predicated instruction
+/// or phi ended up using, e.g. the mask of a block with nothing to predicate.
+void
+WorkItemVectorizer::eraseDeadMasks() {
+  SmallVector<WeakVH, 16> Dead;
+  for (auto I = inst_begin(VF), E = inst_end(VF); I != E; ++I)
+    if (I->getType()->getScalarType()->isIntegerTy(1) &&
+        isInstructionTriviallyDead(&*I))
+      Dead.push_back(&*I);
+  for (auto &V : Dead)
+    if (auto I = cast_or_null<Instruction>(V))
+      RecursivelyDeleteTriviallyDeadInstructions(I);
+}
+
+Function *
+WorkItemVectorizer::run(FunctionType *FT, const Twine &Name) {
+  if (!analyze())
+    return nullptr;
+
+  auto Ctx = &F->getContext();
+  VF = Function::Create(FT, GlobalValue::InternalLinkage, Name, M);
+  auto NewArg = VF->arg_begin();
+  for (auto &Arg : F->args()) {
+    NewArg->setName(Arg.getName());
+    Scalars[&Arg] = NewArg++;
+  }
+  for (unsigned Dim = 0; Dim < 3; ++Dim) {
+    NewArg->setName(Twine("lid.") + DimNames[Dim]);
+    LocalIds[Dim] = NewArg++;
+    GlobalIds[Dim] = nullptr;
+  }
+  AllTrue = ConstantVector::getSplat(Width, ConstantInt::getTrue(*Ctx));
+  auto Entry = BasicBlock::Create(*Ctx, "entry", VF);
+  Prologue.SetInsertPoint(Entry);
+
+  BasicBlock *Body = nullptr;
+  if (Divergent) {
+    Body = BasicBlock::Create(*Ctx, F->getEntryBlock().getName(), VF);
+    Builder.SetInsertPoint(Body);
+    emitLinearized();
+    eraseDeadMasks();
+  } else {
+    emitRegion(RPO, AllTrue, nullptr, nullptr,
+        DenseMap<PHINode *, Value *>());
+    Body = NewBlocks[&F->getEntryBlock()];
+  }
+  Prologue.CreateBr(Body);
+  return VF;
+}
+
+class OCLVectorizeWorkItems: public ModulePass {
+public:
+  OCLVectorizeWorkItems(unsigned Width = 4):ModulePass(ID), M(nullptr),
+      Width(Width) {
+    initializeOCLVectorizeWorkItemsPass(*PassRegistry::getPassRegistry());
+  }
+  virtual bool runOnModule(Module &M);
+  static char ID;
+private:
+  Module *M;
+  unsigned Width;
+
+  FunctionType *getWorkItemFunctionType(Function *F);
+  Function *createScalarFunction(Function *F);
+  void createWorkGroupFunction(Function *F, Function *Scalar,
+      Function *Vector);
+};
+
+char OCLVectorizeWorkItems::ID = 0;
+
+bool
+OCLVectorizeWorkItems::runOnModule(Module &Module) {
+  M = &Module;
+  std::vector<Function *> Kernels;
+  for (auto &F : *M)
+    if (!F.isDeclaration() && F.getCallingConv() == CallingConv::SPIR_KERNEL)
+      Kernels.push_back(&F);
+
+  bool Changed = false;
+  for (auto F : Kernels) {
+    if (!canExecuteWorkItemsInSequence(F)) {
+      DEBUG(dbgs() << "[oclvecwi] skipping kernel " << F->getName() << '\n');
+      continue;
+    }
+    auto Scalar = createScalarFunction(F);
+    Function *Vector = nullptr;
+    if (Width > 1)
+      Vector = WorkItemVectorizer(F, Width).run(getWorkItemFunctionType(F),
+          F->getName() + ".wi.v" + Twine(Width));
+    DEBUG(dbgs() << "[oclvecwi] kernel " << F->getName() <<
+        (Vector ? " vectorized\n" : " not vectorized\n"));
+    createWorkGroupFunction(F, Scalar, Vector);
+    Changed = true;
+  }
+  return Changed;
+}
+
+/// The type of the kernel with three additional size_t arguments for the
+/// local id.
+FunctionType *
+OCLVectorizeWorkItems::getWorkItemFunctionType(Function *F) {
+  std::vector<Type *> ArgTys(F->getFunctionType()->param_begin(),
+      F->getFunctionType()->param_end());
+  ArgTys.insert(ArgTys.end(), 3, getSizetType(M));
+  return FunctionType::get(F->getReturnType(), ArgTys, false);
+}
+
+Function *
+OCLVectorizeWorkItems::createScalarFunction(Function *F) {
+  auto NewF = Function::Create(getWorkItemFunctionType(F),
+      GlobalValue::InternalLinkage, F->getName() + ".wi", M);
+  ValueToValueMapTy VMap;
+  auto NewArg = NewF->arg_begin();
+  for (auto &Arg : F->args()) {
+    NewArg->setName(Arg.getName());
+    VMap[&Arg] = NewArg++;
+  }
+  for (unsigned Dim = 0; Dim < 3; ++Dim)
+    (NewArg++)->setName(Twine("lid.") + DimNames[Dim]);
+  SmallVector<ReturnInst *, 4> Returns;
+  CloneFunctionInto(NewF, F, VMap, false, Returns);
+  NewF->setCallingConv(CallingConv::C);
+  replaceWorkItemIdQueries(NewF);
+  return NewF;
+}
+
+void
+OCLVectorizeWorkItems::createWorkGroupFunction(Function *F, Function *Scalar,
+    Function *Vector) {
+  auto Ctx = &M->getContext();
+  auto WG = Function::Create(F->getFunctionType(),
+      GlobalValue::ExternalLinkage, F->getName() + ".wg", M);
+  // The runtime calls K.wg in place of K, so it keeps the kernel's calling
+  // convention and parameter attributes.
+  WG->setCallingConv(F->getCallingConv());
+  WG->setAttributes(F->getAttributes());
+  std::vector<Value *> Args;
+  for (auto &Arg : WG->args())
+    Args.push_back(&Arg);
+  auto Arg = F->arg_begin();
+  for (auto &NewArg : WG->args())
+    NewArg.setName((Arg++)->getName());
+
+  IRBuilder<> Builder(BasicBlock::Create(*Ctx, "entry", WG));
+  Value *Sizes[3];
+  for (unsigned Dim = 0; Dim < 3; ++Dim) {
+    Sizes[Dim] = emitWorkItemBuiltinCall(Builder, M, "get_local_size", Dim);
+    Sizes[Dim]->setName(Twine("local_size.") + DimNames[Dim]);
+  }
+  auto Zero = getSizet(M, 0);
+  auto One = getSizet(M, 1);
+  Value *VectorEnd = nullptr;
+  if (Vector)
+    VectorEnd = Builder.CreateSub(Sizes[0],
+        Builder.CreateURem(Sizes[0], getSizet(M, Width)), "vector_end");
+
+  // Emit for (IV = Begin; IV < End; IV += Step) Body(IV).
+  // \returns the value of IV after the loop.
+  auto emitLoop = [&](Value *Begin, Value *End, Value *Step, const Twine &Name,
+      std::function<void(Value *)> Body) -> Value * {
+    auto Pre = Builder.GetInsertBlock();
+    auto CondBB = BasicBlock::Create(*Ctx, Name + ".cond", WG);
+    auto BodyBB = BasicBlock::Create(*Ctx, Name + ".body", WG);
+    auto EndBB = BasicBlock::Create(*Ctx, Name + ".end");
+    Builder.CreateBr(CondBB);
+    Builder.SetInsertPoint(CondBB);
+    auto IV = Builder.CreatePHI(Begin->getType(), 2, Name);
+    IV->addIncoming(Begin, Pre);
+    Builder.CreateCondBr(Builder.CreateICmpULT(IV, End), BodyBB, EndBB);
+    Builder.SetInsertPoint(BodyBB);
+    Body(IV);
+    IV->addIncoming(Builder.CreateAdd(IV, Step), Builder.GetInsertBlock());
+    Builder.CreateBr(CondBB);
+    WG->getBasicBlockList().push_back(EndBB);
+    Builder.SetInsertPoint(EndBB);
+    return IV;
+  };
+  auto emitCall = [&](Function *Callee, Value *X, Value *Y, Value *Z) {
+    auto CallArgs = Args;
+    CallArgs.push_back(X);
+    CallArgs.push_back(Y);
+    CallArgs.push_back(Z);
+    Builder.CreateCall(Callee, CallArgs);
+  };
+
+  emitLoop(Zero, Sizes[2], One, "lid.z", [&](Value *Z) {
+    emitLoop(Zero, Sizes[1], One, "lid.y", [&](Value *Y) {
+      Value *X = Zero;
+      if (Vector)
+        X = emitLoop(Zero, VectorEnd, getSizet(M, Width), "lid.x.vec",
+            [&](Value *VX) { emitCall(Vector, VX, Y, Z); });
+      emitLoop(X, Sizes[0], One, "lid.x",
+          [&](Value *SX) { emitCall(Scalar, SX, Y, Z); });
+    });
+  });
+  Builder.CreateRetVoid();
+}
+
+}
+
+INITIALIZE_PASS(OCLVectorizeWorkItems, "oclvecwi",
+    "Vectorize OpenCL kernels across work-items", false, false)
+
+ModulePass *llvm::createOCLVectorizeWorkItems(unsigned Width) {
+  return new OCLVectorizeWorkItems(Width);
+}
@@ -46,13 +46,17 @@
 #include "libSPIRV/SPIRVType.h"
 #include "NameMangleAPI.h"
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Attributes.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/Support/SPIRV.h"
 
 #include <utility>
 #include <functional>
+#include <map>
+#include <tuple>
 
 using namespace SPIRV;
 using namespace llvm;
@@ -471,6 +475,12 @@ public:
   virtual void init(const std::string &UniqUnmangledName){
     UnmangledName = UniqUnmangledName;
   }
+  /// Returns the value the mangling depends on besides the name and the
+  /// argument types, if any. Builtins mangled with equal keys share the
+  /// mangled name.
+  virtual Value *getCacheKey() const {
+    return nullptr;
+  }
 protected:
   std::string UnmangledName;
   std::set<int> UnsignedArgs; // unsigned arguments, or -1 if all are unsigned
@@ -636,13 +646,47 @@ bool hasFunctionPointerArg(Function *F, Function::arg_iterator& AI);
 /// \returns true if function \p F has array type argument.
 bool hasArrayArg(Function *F);
 
+/// Callees of mutated calls. Calls which are mutated to the same builtin with
+/// the same signature and mangling share the callee, which is then mangled
+/// and looked up only once.
+class BuiltinCalleeCache {
+public:
+  explicit BuiltinCalleeCache(Module *M = nullptr) : M(M) {}
+  void reset(Module *NewM) {
+    M = NewM;
+    Callees.clear();
+  }
+  Module *getModule() const { return M; }
+  /// Same as SPIRV::getOrCreateFunction for the module of the cache.
+  Function *getOrCreateFunction(Type *RetTy, ArrayRef<Type *> ArgTypes,
+      StringRef Name, BuiltinFuncMangleInfo *Mangle, AttributeSet *Attrs,
+      bool TakeName);
+
+private:
+  struct Entry {
+    Type *RetTy;
+    SmallVector<Type *, 4> ArgTypes;
+    bool Mangled;
+    WeakVH Key;         // The value the mangling depended on, if any.
+    bool HasKey;
+    WeakVH Callee;      // Null once the callee is erased.
+    std::string CalleeName;
+  };
+  Module *M;
+  // Callees by unmangled name. The handles keep an erased callee or key from
+  // matching a function later created at the same address.
+  StringMap<std::vector<Entry>> Callees;
+};
+
 /// Mutates function call instruction by changing the arguments.
+/// The new call instruction takes the name of \p CI.
+/// If \p Callees is not null, the callee is looked up there.
 /// \param ArgMutate mutates the function arguments.
 /// \return mutated call instruction.
 CallInst *mutateCallInst(Module *M, CallInst *CI,
     std::function<std::string (CallInst *, std::vector<Value *> &)>ArgMutate,
     BuiltinFuncMangleInfo *Mangle = nullptr, AttributeSet *Attrs = nullptr,
-    bool takeName = false);
+    bool takeName = false, BuiltinCalleeCache *Callees = nullptr);
 
 /// Mutates function call instruction by changing the arguments and return
 /// value.
@@ -654,7 +698,7 @@ Instruction *mutateCallInst(Module *M, CallInst *CI,
         Type *&RetTy)> ArgMutate,
     std::function<Instruction *(CallInst *)> RetMutate,
     BuiltinFuncMangleInfo *Mangle = nullptr, AttributeSet *Attrs = nullptr,
-    bool takeName = false);
+    bool takeName = false, BuiltinCalleeCache *Callees = nullptr);
 
 /// Mutate call instruction to call SPIR-V builtin function.
 CallInst *
@@ -670,7 +714,25 @@ mutateCallInstSPIRV(Module *M, CallInst *CI,
     std::function<Instruction *(CallInst *)> RetMutate,
     AttributeSet *Attrs = nullptr);
 
+/// Mutate call instruction to call SPIR-V builtin function, looking up the
+/// callee in \p Callees.
+CallInst *
+mutateCallInstSPIRV(BuiltinCalleeCache &Callees, CallInst *CI,
+    std::function<std::string (CallInst *, std::vector<Value *> &)>ArgMutate,
+    AttributeSet *Attrs = nullptr);
+
+/// Mutate call instruction to call SPIR-V builtin function, looking up the
+/// callee in \p Callees.
+Instruction *
+mutateCallInstSPIRV(BuiltinCalleeCache &Callees, CallInst *CI,
+    std::function<std::string (CallInst *, std::vector<Value *> &,
+        Type *&RetTy)> ArgMutate,
+    std::function<Instruction *(CallInst *)> RetMutate,
+    AttributeSet *Attrs = nullptr);
+
 /// Mutate function by change the arguments.
+/// All calls of \p F are mutated in one pass; calls mutated to the same
+/// function name and type share one callee, which is looked up once.
 /// \param ArgMutate mutates the function arguments.
 /// \param TakeName Take the original function's name if a new function with
 ///   different type needs to be created.
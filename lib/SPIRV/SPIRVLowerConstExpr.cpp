@@ -42,6 +42,7 @@
 #include "SPIRVMDBuilder.h"
 #include "SPIRVMDWalker.h"
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/InstVisitor.h"
@@ -110,12 +111,17 @@ SPIRVLowerConstExpr::runOnModule(Module& Module) {
 /// dominates all other BB's. Each constant expression only needs to be lowered
 /// once in each function and all uses of it by instructions in that function
 /// is replaced by one instruction.
+/// Uses are rewritten while walking the operands of the instructions of the
+/// function, so the users of a constant expression in other functions are
+/// never visited and the pass is linear in the size of the module.
 /// ToDo: remove redundant instructions for common subexpression
 
 void
 SPIRVLowerConstExpr::visit(Module *M) {
     for (auto I = M->begin(), E = M->end(); I != E; ++I) {
-      std::map<ConstantExpr*, Instruction *> CMap;
+      if (I->isDeclaration())
+        continue;
+      DenseMap<ConstantExpr*, Instruction *> CMap;
       std::list<Instruction *> WorkList;
       auto FBegin = I->begin();
       for (auto BI = FBegin, BE = I->end(); BI != BE; ++BI) {
@@ -127,29 +133,22 @@ SPIRVLowerConstExpr::visit(Module *M) {
         auto II = WorkList.front();
         WorkList.pop_front();
         for (unsigned OI = 0, OE = II->getNumOperands(); OI != OE; ++OI) {
-          auto Op = II->getOperand(OI);
-
-          if (auto CE = dyn_cast<ConstantExpr>(Op)) {
+          auto CE = dyn_cast<ConstantExpr>(II->getOperand(OI));
+          if (!CE)
+            continue;
+          auto &ReplInst = CMap[CE];
+          if (!ReplInst) {
+            // Instructions are visited in order starting from the entry
+            // block, so the first user is dominated by the insertion point
+            // and the insertion point dominates all later users.
             SPIRVDBG(dbgs() << "[lowerConstantExpressions] " << *CE;)
-            auto ReplInst = CE->getAsInstruction();
+            ReplInst = CE->getAsInstruction();
             auto InsPoint = II->getParent() == FBegin ? II : &FBegin->back();
             ReplInst->insertBefore(InsPoint);
             SPIRVDBG(dbgs() << " -> " << *ReplInst << '\n';)
             WorkList.push_front(ReplInst);
-            std::vector<Instruction *> Users;
-            // Do not replace use during iteration of use. Do it in another loop
-            for (auto U:CE->users()) {
-              SPIRVDBG(dbgs() << "[lowerConstantExpressions] Use: " <<
-                  *U << '\n';)
-              if (auto InstUser = dyn_cast<Instruction>(U)) {
-                // Only replace users in scope of current function
-                if (InstUser->getParent()->getParent() == I)
-                  Users.push_back(InstUser);
-              }
-            }
-            for (auto &User:Users)
-              User->replaceUsesOfWith(CE, ReplInst);
           }
+          II->setOperand(OI, ReplInst);
         }
       }
     }
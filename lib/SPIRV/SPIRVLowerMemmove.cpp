@@ -32,12 +32,15 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This file implements lowering llvm.memmove into several llvm.memcpys.
+// This file implements lowering llvm.memmove into llvm.memcpy if the source
+// and destination ranges cannot overlap, or into a copy loop otherwise.
 //
 //===----------------------------------------------------------------------===//
 #define DEBUG_TYPE "spvmemmove"
 
 #include "SPIRVInternal.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/IRBuilder.h"
@@ -64,51 +67,139 @@ public:
     initializeSPIRVLowerMemmovePass(*PassRegistry::getPassRegistry());
   }
   virtual void visitMemMoveInst(MemMoveInst &I) {
-    IRBuilder<> Builder(I.getParent());
-    Builder.SetInsertPoint(&I);
+    MemMoves.push_back(&I);
+  }
+
+  /// Check if the source and destination ranges of a memmove are known not
+  /// to overlap, either by alias analysis if it is available, or because
+  /// they are distinct identified objects or disjoint parts of one object.
+  bool isNoOverlap(MemMoveInst &I) {
     auto *Dest = I.getRawDest();
     auto *Src = I.getRawSource();
-    auto *SrcTy = Src->getType();
-    if (!isa<ConstantInt>(I.getLength())) 
-        // ToDo: for non-constant length, could use a loop to copy a 
-        // fixed length chunk at a time. For now simply fail
-        report_fatal_error("llvm.memmove of non-constant length not supported", 
-            false);
-    auto *Length = cast<ConstantInt>(I.getLength());
-    if (isa<BitCastInst>(Src)) 
-        // The source could be bit-cast from another type,
-        // need the original type for the allocation of the temporary variable
-        SrcTy = cast<BitCastInst>(Src)->getOperand(0)->getType();
-    auto Align = I.getAlignment();
-    auto Volatile = I.isVolatile();
-    Value *NumElements = nullptr;
-    uint64_t ElementsCount = 1;
-    if (SrcTy->isArrayTy()) {
-        NumElements = Builder.getInt32(SrcTy->getArrayNumElements());
-        ElementsCount = SrcTy->getArrayNumElements();
+    auto *Length = dyn_cast<ConstantInt>(I.getLength());
+    uint64_t Size = Length ? Length->getZExtValue() :
+        AliasAnalysis::UnknownSize;
+    if (auto *AA = getAnalysisIfAvailable<AliasAnalysis>())
+      if (AA->alias(Dest, Size, Src, Size) == AliasAnalysis::NoAlias)
+        return true;
+
+    auto *DL = Mod->getDataLayout();
+    int64_t DestOffset = 0;
+    int64_t SrcOffset = 0;
+    auto *DestBase = GetPointerBaseWithConstantOffset(Dest, DestOffset, DL);
+    auto *SrcBase = GetPointerBaseWithConstantOffset(Src, SrcOffset, DL);
+    if (DestBase == SrcBase) {
+      if (!Length)
+        return false;
+      uint64_t Distance = DestOffset > SrcOffset ? DestOffset - SrcOffset :
+          SrcOffset - DestOffset;
+      return Distance >= Size;
     }
-    if (Mod->getDataLayout()->getTypeSizeInBits(SrcTy->getPointerElementType()) 
-        * ElementsCount !=  Length->getZExtValue() * 8)
-        report_fatal_error("Size of the memcpy should match the allocated memory", 
-            false);
-
-    auto *Alloca = Builder.CreateAlloca(SrcTy->getPointerElementType(), 
-        NumElements);
-    auto *LifetimeStart = Builder.CreateLifetimeStart(Alloca);
-    auto *FirstCpy = Builder.CreateMemCpy(Alloca, Src, Length, Align, Volatile);
-    auto *SecondCpy = Builder.CreateMemCpy(Dest, Alloca, Length, Align, 
-        Volatile);
-    auto *LifetimeEnd = Builder.CreateLifetimeEnd(Alloca);
-
-    SecondCpy->takeName(&I);
-    I.replaceAllUsesWith(SecondCpy);
-    I.dropAllReferences();
+    auto *DestObj = GetUnderlyingObject(DestBase, DL);
+    auto *SrcObj = GetUnderlyingObject(SrcBase, DL);
+    return DestObj != SrcObj && isIdentifiedObject(DestObj) &&
+        isIdentifiedObject(SrcObj);
+  }
+
+  /// Lower a memmove whose ranges may overlap to a loop which copies forward
+  /// if the destination is below the source and backward otherwise:
+  ///
+  ///   entry:
+  ///     br (n == 0), exit, dir
+  ///   dir:
+  ///     br (dest <= src), fwd, bwd
+  ///   fwd:
+  ///     i = phi [0, dir], [i + 1, fwd]
+  ///     dest[i] = src[i]
+  ///     br (i + 1 == n), exit, fwd
+  ///   bwd:
+  ///     i = phi [n, dir], [i - 1, bwd]
+  ///     dest[i - 1] = src[i - 1]
+  ///     br (i - 1 == 0), exit, bwd
+  ///
+  /// Elements are as wide as the alignment and a constant length allow.
+  void lowerToCopyLoop(MemMoveInst &I) {
+    auto *Length = I.getLength();
+    auto *LengthTy = Length->getType();
+    auto Align = std::max(I.getAlignment(), 1u);
+    auto Volatile = I.isVolatile();
+    uint64_t Unit = 1;
+    if (auto *CLength = dyn_cast<ConstantInt>(Length))
+      while (Unit < 8 && Align % (Unit * 2) == 0 &&
+             CLength->getZExtValue() % (Unit * 2) == 0)
+        Unit *= 2;
+
+    auto *Entry = I.getParent();
+    auto *F = Entry->getParent();
+    auto *Exit = Entry->splitBasicBlock(&I, "memmove.exit");
+    auto *Dir = BasicBlock::Create(*Context, "memmove.dir", F, Exit);
+    auto *Fwd = BasicBlock::Create(*Context, "memmove.fwd", F, Exit);
+    auto *Bwd = BasicBlock::Create(*Context, "memmove.bwd", F, Exit);
+    Entry->getTerminator()->eraseFromParent();
+
+    IRBuilder<> Builder(Entry);
+    auto *UnitTy = Builder.getIntNTy(Unit * 8);
+    auto *Dest = Builder.CreateBitCast(I.getRawDest(), PointerType::get(UnitTy,
+        I.getDestAddressSpace()));
+    auto *Src = Builder.CreateBitCast(I.getRawSource(), PointerType::get(
+        UnitTy, I.getSourceAddressSpace()));
+    auto *Count = Unit == 1 ? Length : Builder.CreateUDiv(Length,
+        ConstantInt::get(LengthTy, Unit));
+    auto *Zero = ConstantInt::get(LengthTy, 0);
+    auto *One = ConstantInt::get(LengthTy, 1);
+    Builder.CreateCondBr(Builder.CreateICmpEQ(Count, Zero), Exit, Dir);
+
+    // The pointers may be in different address spaces, so they are compared
+    // as integers.
+    Builder.SetInsertPoint(Dir);
+    auto *IsFwd = Builder.CreateICmpULE(
+        Builder.CreatePtrToInt(Dest, Builder.getInt64Ty()),
+        Builder.CreatePtrToInt(Src, Builder.getInt64Ty()));
+    Builder.CreateCondBr(IsFwd, Fwd, Bwd);
+
+    auto CopyElement = [&](Value *Index) {
+      auto *Val = Builder.CreateLoad(Builder.CreateInBoundsGEP(Src, Index),
+          Volatile);
+      Val->setAlignment(Unit);
+      auto *Store = Builder.CreateStore(Val,
+          Builder.CreateInBoundsGEP(Dest, Index), Volatile);
+      Store->setAlignment(Unit);
+    };
+
+    Builder.SetInsertPoint(Fwd);
+    auto *FwdIndex = Builder.CreatePHI(LengthTy, 2);
+    CopyElement(FwdIndex);
+    auto *Next = Builder.CreateAdd(FwdIndex, One);
+    Builder.CreateCondBr(Builder.CreateICmpEQ(Next, Count), Exit, Fwd);
+    FwdIndex->addIncoming(Zero, Dir);
+    FwdIndex->addIncoming(Next, Fwd);
+
+    Builder.SetInsertPoint(Bwd);
+    auto *BwdIndex = Builder.CreatePHI(LengthTy, 2);
+    auto *Prev = Builder.CreateSub(BwdIndex, One);
+    CopyElement(Prev);
+    Builder.CreateCondBr(Builder.CreateICmpEQ(Prev, Zero), Exit, Bwd);
+    BwdIndex->addIncoming(Count, Dir);
+    BwdIndex->addIncoming(Prev, Bwd);
+  }
+
+  void lowerMemMove(MemMoveInst &I) {
+    if (isNoOverlap(I)) {
+      IRBuilder<> Builder(&I);
+      Builder.CreateMemCpy(I.getRawDest(), I.getRawSource(), I.getLength(),
+          I.getAlignment(), I.isVolatile());
+    } else
+      lowerToCopyLoop(I);
     I.eraseFromParent();
   }
+
   virtual bool runOnModule(Module &M) {
     Context = &M.getContext();
     Mod = &M;
     visit(M);
+    for (auto I : MemMoves)
+      lowerMemMove(*I);
+    MemMoves.clear();
 
     if (SPIRVLowerMemmoveValidate) {
       DEBUG(dbgs() << "After SPIRVLowerMemmove:\n" << M);
@@ -126,13 +217,14 @@ public:
 private:
   LLVMContext *Context;
   Module *Mod;
+  std::vector<MemMoveInst *> MemMoves;
 };
 
 char SPIRVLowerMemmove::ID = 0;
 }
 
 INITIALIZE_PASS(SPIRVLowerMemmove, "spvmemmove",
-    "Lower llvm.memmove into llvm.memcpy", false, false)
+    "Lower llvm.memmove into llvm.memcpy or a copy loop", false, false)
 
 ModulePass *llvm::createSPIRVLowerMemmove() {
   return new SPIRVLowerMemmove();
@@ -41,6 +41,7 @@
 #include "SPIRVValue.h"
 #include "SPIRVModule.h"
 #include "SPIRVFunction.h"
+#include "SPIRVIndex.h"
 #include "SPIRVBasicBlock.h"
 #include "SPIRVInstruction.h"
 #include "SPIRVExtInst.h"
@@ -58,6 +59,7 @@
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/NoFolder.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/Type.h"
 #include "llvm/PassManager.h"
@@ -99,6 +101,11 @@ cl::opt<bool> SPIRVGenImgTypeAccQualPostfix("spirv-gen-image-type-acc-postfix",
     cl::init(false), cl::desc("Enable generating access qualifier postfix"
         " in OpenCL image type names"));
 
+cl::opt<bool> SPIRVGenLLVMIntrinsics("spirv-gen-llvm-intrinsics",
+    cl::init(false), cl::desc("Translate OpenCL extended instructions which "
+        "have LLVM intrinsic equivalents to LLVM intrinsics instead of "
+        "OpenCL builtin function calls"));
+
 // Prefix for placeholder global variable name.
 const char* kPlaceholderPrefix = "placeholder.";
 
@@ -301,6 +308,10 @@ public:
   bool transDecoration(SPIRVValue *, Value *);
   bool transAlign(SPIRVValue *, Value *);
   Instruction *transOCLBuiltinFromExtInst(SPIRVExtInst *BC, BasicBlock *BB);
+  /// Translate an OpenCL extended instruction to an LLVM intrinsic call or
+  /// an equivalent instruction sequence if it has LLVM semantics.
+  /// \return nullptr if the instruction has no LLVM equivalent.
+  Instruction *transLLVMIntrinsicFromExtInst(SPIRVExtInst *BC, BasicBlock *BB);
   std::vector<Value *> transValue(const std::vector<SPIRVValue *>&, Function *F,
       BasicBlock *);
   Function *transFunction(SPIRVFunction *F);
@@ -1560,8 +1571,9 @@ SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
     auto BR = static_cast<SPIRVBranch *>(BV);
     auto BI = BranchInst::Create(
         dyn_cast<BasicBlock>(transValue(BR->getTargetLabel(), F, BB)), BB);
-    if (auto LM = static_cast<SPIRVLoopMerge *>(BR->getPrevious()))
-      setLLVMLoopMetadata(LM, BI);
+    if (BR->getPrevious() && BR->getPrevious()->getOpCode() == OpLoopMerge)
+      setLLVMLoopMetadata(static_cast<SPIRVLoopMerge *>(BR->getPrevious()),
+          BI);
     return mapValue(BV, BI);
   }
 
@@ -1571,8 +1583,9 @@ SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
         dyn_cast<BasicBlock>(transValue(BR->getTrueLabel(), F, BB)),
         dyn_cast<BasicBlock>(transValue(BR->getFalseLabel(), F, BB)),
         transValue(BR->getCondition(), F, BB), BB);
-    if (auto LM = static_cast<SPIRVLoopMerge *>(BR->getPrevious()))
-      setLLVMLoopMetadata(LM, BC);
+    if (BR->getPrevious() && BR->getPrevious()->getOpCode() == OpLoopMerge)
+      setLLVMLoopMetadata(static_cast<SPIRVLoopMerge *>(BR->getPrevious()),
+          BC);
     return mapValue(BV, BC);
   }
 
@@ -1707,9 +1720,8 @@ SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
     if (isFuncNoUnwind())
       Func->addFnAttr(Attribute::NoUnwind);
 
-    Value *Arg[] = { transValue(BC->getTarget(), Func, BB), Src,
-                     dyn_cast<llvm::ConstantInt>(transValue(BC->getSize(),
-                         Func, BB)),
+    Value *Arg[] = { transValue(BC->getTarget(), F, BB), Src,
+                     transValue(BC->getSize(), F, BB),
                      ConstantInt::get(Int32Ty,
                          BC->SPIRVMemoryAccess::getAlignment()),
                      ConstantInt::get(Int1Ty,
@@ -1801,6 +1813,20 @@ SPIRVToLLVM::transValueWithoutDecoration(SPIRVValue *BV, Function *F,
     for (const auto &I : Constituents) {
       CV.push_back(dyn_cast<Constant>(I));
     }
+    if (std::find(CV.begin(), CV.end(), nullptr) != CV.end()) {
+      // Some constituents are computed, so build the composite one element
+      // at a time.
+      Type *Ty = transType(CC->getType());
+      Value *V = UndefValue::get(Ty);
+      for (unsigned I = 0, E = Constituents.size(); I != E; ++I) {
+        if (Ty->isVectorTy())
+          V = InsertElementInst::Create(V, Constituents[I], getInt32(M, I), "",
+                                        BB);
+        else
+          V = InsertValueInst::Create(V, Constituents[I], I, "", BB);
+      }
+      return mapValue(BV, V);
+    }
     switch (BV->getType()->getOpCode()) {
     case OpTypeVector:
       return mapValue(BV, ConstantVector::get(CV));
@@ -2016,7 +2042,10 @@ SPIRVToLLVM::transFunction(SPIRVFunction *BF) {
     return Loc->second;
 
   auto IsKernel = BM->isEntryPoint(ExecutionModelKernel, BF->getId());
-  auto Linkage = IsKernel ? GlobalValue::ExternalLinkage : transLinkageType(BF);
+  // A function whose body is not decoded is translated to a declaration,
+  // which cannot have internal linkage.
+  auto Linkage = IsKernel || BF->getNumBasicBlock() == 0 ?
+      GlobalValue::ExternalLinkage : transLinkageType(BF);
   FunctionType *FT = dyn_cast<FunctionType>(transType(BF->getFunctionType()));
   Function *F = dyn_cast<Function>(mapValue(BF, Function::Create(FT, Linkage,
       BF->getName(), M)));
@@ -2042,6 +2071,10 @@ SPIRVToLLVM::transFunction(SPIRVFunction *BF) {
         return;
       F->addAttribute(I->getArgNo() + 1, SPIRSPIRVFuncParamAttrMap::rmap(Kind));
     });
+    // A Restrict pointer parameter is not aliased by the other pointers
+    // accessible to the function, which is what noalias means in LLVM.
+    if (BA->hasDecorate(DecorationRestrict) && BA->getType()->isTypePointer())
+      F->addAttribute(I->getArgNo() + 1, Attribute::NoAlias);
 
     SPIRVWord MaxOffset = 0;
     if (BA->hasDecorate(DecorationMaxByteOffset, 0, &MaxOffset)) {
@@ -2347,6 +2380,22 @@ bool
 SPIRVToLLVM::transDecoration(SPIRVValue *BV, Value *V) {
   if (!transAlign(BV, V))
     return false;
+  SPIRVWord Mask = 0;
+  if (isa<FPMathOperator>(V) && isa<Instruction>(V) && BV->isInst() &&
+      static_cast<SPIRVInstruction *>(BV)->hasFPFastMathMode(&Mask)) {
+    FastMathFlags FMF;
+    if (Mask & FPFastMathModeFastMask)
+      FMF.setUnsafeAlgebra();
+    if (Mask & FPFastMathModeNotNaNMask)
+      FMF.setNoNaNs();
+    if (Mask & FPFastMathModeNotInfMask)
+      FMF.setNoInfs();
+    if (Mask & FPFastMathModeNSZMask)
+      FMF.setNoSignedZeros();
+    if (Mask & FPFastMathModeAllowRecipMask)
+      FMF.setAllowReciprocal();
+    cast<Instruction>(V)->setFastMathFlags(FMF);
+  }
   DbgTran.transDbgInfo(BV, V);
   return true;
 }
@@ -2436,6 +2485,11 @@ SPIRVToLLVM::transKernelMetadata() {
       std::string Qual;
       if (Arg->hasDecorate(DecorationVolatile))
         Qual = kOCLTypeQualifierName::Volatile;
+      if (Arg->hasDecorate(DecorationRestrict) &&
+          !Arg->hasAttr(FunctionParameterAttributeNoAlias)) {
+        Qual += Qual.empty() ? "" : " ";
+        Qual += kOCLTypeQualifierName::Restrict;
+      }
       Arg->foreachAttr([&](SPIRVFuncParamAttrKind Kind){
         Qual += Qual.empty() ? "" : " ";
         switch(Kind){
@@ -2555,11 +2609,89 @@ SPIRVToLLVM::transOCLVectorLoadStore(std::string& UnmangledName,
    }
 }
 
+// Get the LLVM intrinsic having the same semantics as an OpenCL extended
+// instruction. sqrt is not mapped since llvm.sqrt is undefined for negative
+// arguments whereas OpenCL sqrt returns NaN.
+static Intrinsic::ID
+getLLVMIntrinsicForOCLExtOp(SPIRVWord ExtOp) {
+  switch (ExtOp) {
+  case OpenCLLIB::Ceil:
+    return Intrinsic::ceil;
+  case OpenCLLIB::Clz:
+    return Intrinsic::ctlz;
+  case OpenCLLIB::Copysign:
+    return Intrinsic::copysign;
+  case OpenCLLIB::Ctz:
+    return Intrinsic::cttz;
+  case OpenCLLIB::Fabs:
+    return Intrinsic::fabs;
+  case OpenCLLIB::Floor:
+    return Intrinsic::floor;
+  case OpenCLLIB::Fma:
+    return Intrinsic::fma;
+  case OpenCLLIB::Fmax:
+  case OpenCLLIB::FMax_common:
+    return Intrinsic::maxnum;
+  case OpenCLLIB::Fmin:
+  case OpenCLLIB::FMin_common:
+    return Intrinsic::minnum;
+  case OpenCLLIB::Popcount:
+    return Intrinsic::ctpop;
+  case OpenCLLIB::Rint:
+    return Intrinsic::rint;
+  case OpenCLLIB::Round:
+    return Intrinsic::round;
+  case OpenCLLIB::Trunc:
+    return Intrinsic::trunc;
+  default:
+    return Intrinsic::not_intrinsic;
+  }
+}
+
+Instruction *
+SPIRVToLLVM::transLLVMIntrinsicFromExtInst(SPIRVExtInst *BC, BasicBlock *BB) {
+  SPIRVWord ExtOp = BC->getExtOp();
+  Intrinsic::ID IID = getLLVMIntrinsicForOCLExtOp(ExtOp);
+  if (IID == Intrinsic::not_intrinsic && ExtOp != OpenCLLIB::Rotate)
+    return nullptr;
+
+  // Builtins taking scalar arguments together with vector ones, e.g.
+  // fmax(float4, float), have no intrinsic counterpart.
+  Type *RetTy = transType(BC->getType());
+  for (auto ArgTy : BC->getArgumentValueTypes())
+    if (transType(ArgTy) != RetTy)
+      return nullptr;
+
+  auto Args = transValue(BC->getArgumentValues(), BB->getParent(), BB);
+  // Constant arguments must not be folded since an instruction is expected.
+  IRBuilder<true, NoFolder> Builder(BB);
+  if (ExtOp == OpenCLLIB::Rotate) {
+    // rotate(v, i) = (v << (i % w)) | (v >> ((w - i % w) % w))
+    unsigned Width = RetTy->getScalarSizeInBits();
+    auto Mask = ConstantInt::get(RetTy, Width - 1);
+    auto Amt = Builder.CreateAnd(Args[1], Mask);
+    auto RevAmt = Builder.CreateAnd(
+        Builder.CreateSub(ConstantInt::get(RetTy, Width), Amt), Mask);
+    auto Shl = Builder.CreateShl(Args[0], Amt);
+    auto LShr = Builder.CreateLShr(Args[0], RevAmt);
+    return cast<Instruction>(Builder.CreateOr(Shl, LShr, BC->getName()));
+  }
+
+  // OpenCL clz/ctz are defined for zero.
+  if (IID == Intrinsic::ctlz || IID == Intrinsic::cttz)
+    Args.push_back(Builder.getFalse());
+  Function *F = Intrinsic::getDeclaration(M, IID, RetTy);
+  return Builder.CreateCall(F, Args, BC->getName());
+}
+
 // printf is not mangled. The function type should have just one argument.
 // read_image*: the second argument should be mangled as sampler.
 Instruction *
 SPIRVToLLVM::transOCLBuiltinFromExtInst(SPIRVExtInst *BC, BasicBlock *BB) {
   assert(BB && "Invalid BB");
+  if (SPIRVGenLLVMIntrinsics)
+    if (auto I = transLLVMIntrinsicFromExtInst(BC, BB))
+      return I;
   std::string MangledName;
   SPIRVWord EntryPoint = BC->getExtOp();
   SPIRVExtInstSetKind Set = BM->getBuiltinSet(BC->getExtSetId());
@@ -2935,15 +3067,12 @@ Instruction *SPIRVToLLVM::transOCLRelational(SPIRVInstruction *I, BasicBlock *BB
 }
 }
 
-bool
-llvm::ReadSPIRV(LLVMContext &C, std::istream &IS, Module *&M,
+// Translate the decoded SPIR-V module BM to a new LLVM module M.
+static bool
+translateSPIRV(LLVMContext &C, SPIRVModule *BM, Module *&M,
     std::string &ErrMsg) {
   M = new Module("", C);
-  std::unique_ptr<SPIRVModule> BM(SPIRVModule::createSPIRVModule());
-
-  IS >> *BM;
-
-  SPIRVToLLVM BTL(M, BM.get());
+  SPIRVToLLVM BTL(M, BM);
   bool Succeed = true;
   if (!BTL.translate()) {
     BM->getError(ErrMsg);
@@ -2962,3 +3091,35 @@ llvm::ReadSPIRV(LLVMContext &C, std::istream &IS, Module *&M,
   }
   return Succeed;
 }
+
+bool
+llvm::ReadSPIRV(LLVMContext &C, std::istream &IS, Module *&M,
+    std::string &ErrMsg) {
+  std::unique_ptr<SPIRVModule> BM(SPIRVModule::createSPIRVModule());
+
+  IS >> *BM;
+
+  return translateSPIRV(C, BM.get(), M, ErrMsg);
+}
+
+bool
+llvm::ReadSPIRV(LLVMContext &C, std::istream &IS, std::istream &IndexIS,
+    ArrayRef<std::string> FuncNames, Module *&M, std::string &ErrMsg) {
+  M = nullptr;
+  SPIRVModuleIndex Index;
+  if (!(IndexIS >> Index)) {
+    ErrMsg = "Invalid SPIR-V index";
+    return false;
+  }
+  std::set<std::string> Names(FuncNames.begin(), FuncNames.end());
+  std::unique_ptr<SPIRVModule> BM(SPIRVModule::createSPIRVModule());
+  if (!decodeSPIRVModule(IS, *BM, Index,
+      [&](const SPIRVModuleIndex::FunctionInfo &F) {
+        return Names.count(F.Name) != 0;
+      })) {
+    BM->getError(ErrMsg);
+    return false;
+  }
+
+  return translateSPIRV(C, BM.get(), M, ErrMsg);
+}
@@ -46,6 +46,7 @@
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Pass.h"
@@ -81,6 +82,10 @@ public:
   void lowerFuncPtr(Function *F, Op OC);
   void lowerFuncPtr(Module *M);
 
+  /// Expand llvm.*.with.overflow intrinsics, which may be formed by
+  /// instcombine, into arithmetic and comparison instructions.
+  void lowerArithWithOverflow(IntrinsicInst *II);
+
   static char ID;
 private:
   Module *M;
@@ -98,11 +103,6 @@ SPIRVRegularizeLLVM::runOnModule(Module& Module) {
   regularize();
 
   DEBUG(dbgs() << "After SPIRVRegularizeLLVM:\n" << *M);
-  std::string Err;
-  raw_string_ostream ErrorOS(Err);
-  if (verifyModule(*M, &ErrorOS)){
-    DEBUG(errs() << "Fails to verify module: " << ErrorOS.str());
-  }
   return true;
 }
 
@@ -117,6 +117,19 @@ SPIRVRegularizeLLVM::regularize() {
 
   for (auto I = M->begin(), E = M->end(); I != E;) {
     Function *F = I++;
+    switch (F->getIntrinsicID()) {
+    case Intrinsic::sadd_with_overflow:
+    case Intrinsic::uadd_with_overflow:
+    case Intrinsic::ssub_with_overflow:
+    case Intrinsic::usub_with_overflow:
+    case Intrinsic::smul_with_overflow:
+    case Intrinsic::umul_with_overflow:
+      while (!F->use_empty())
+        lowerArithWithOverflow(cast<IntrinsicInst>(*F->user_begin()));
+      break;
+    default:
+      break;
+    }
     if (F->isDeclaration() && F->use_empty()) {
       F->eraseFromParent();
       continue;
@@ -141,7 +154,10 @@ SPIRVRegularizeLLVM::regularize() {
           if (isa<PossiblyExactOperator>(BO) && BO->isExact())
             BO->setIsExact(false);
         }
-        // Remove metadata not supported by SPIRV
+        // Remove metadata not supported by SPIRV. SPIR-V can only express
+        // aliasing of function parameters and return values, which is
+        // translated from noalias attributes. Type based (tbaa) and scoped
+        // (alias.scope, noalias) alias metadata have no SPIR-V equivalent.
         static const char *MDs[] = {
             "fpmath",
             "tbaa",
@@ -158,7 +174,7 @@ SPIRVRegularizeLLVM::regularize() {
 
   std::string Err;
   raw_string_ostream ErrorOS(Err);
-  if (verifyModule(*M, &ErrorOS)){
+  if (verifyModuleParallel(*M, &ErrorOS)){
     SPIRVDBG(errs() << "Fails to verify module: " << ErrorOS.str();)
     return false;
   }
@@ -168,6 +184,72 @@ SPIRVRegularizeLLVM::regularize() {
   return true;
 }
 
+void
+SPIRVRegularizeLLVM::lowerArithWithOverflow(IntrinsicInst *II) {
+  DEBUG(dbgs() << "[lowerArithWithOverflow] " << *II << '\n');
+  IRBuilder<> Builder(II);
+  Value *LHS = II->getArgOperand(0);
+  Value *RHS = II->getArgOperand(1);
+  Type *Ty = LHS->getType();
+  Value *Res = nullptr;
+  Value *Overflow = nullptr;
+  switch (II->getIntrinsicID()) {
+  case Intrinsic::uadd_with_overflow:
+    Res = Builder.CreateAdd(LHS, RHS);
+    Overflow = Builder.CreateICmpULT(Res, LHS);
+    break;
+  case Intrinsic::usub_with_overflow:
+    Res = Builder.CreateSub(LHS, RHS);
+    Overflow = Builder.CreateICmpULT(LHS, RHS);
+    break;
+  case Intrinsic::sadd_with_overflow:
+  case Intrinsic::ssub_with_overflow: {
+    bool IsAdd = II->getIntrinsicID() == Intrinsic::sadd_with_overflow;
+    Res = IsAdd ? Builder.CreateAdd(LHS, RHS) : Builder.CreateSub(LHS, RHS);
+    // The result overflowed if its sign differs from the sign of LHS while
+    // the signs of the operands are equal (add) or differ (sub).
+    Value *L = Builder.CreateXor(LHS, Res);
+    Value *R = IsAdd ? Builder.CreateXor(RHS, Res) :
+        Builder.CreateXor(LHS, RHS);
+    Overflow = Builder.CreateICmpSLT(Builder.CreateAnd(L, R),
+        Constant::getNullValue(Ty));
+    break;
+  }
+  case Intrinsic::umul_with_overflow:
+  case Intrinsic::smul_with_overflow: {
+    bool IsSigned = II->getIntrinsicID() == Intrinsic::smul_with_overflow;
+    unsigned Width = Ty->getIntegerBitWidth();
+    Type *WideTy = IntegerType::get(*Ctx, Width * 2);
+    auto Ext = [&](Value *V) {
+      return IsSigned ? Builder.CreateSExt(V, WideTy) :
+          Builder.CreateZExt(V, WideTy);
+    };
+    Value *Prod = Builder.CreateMul(Ext(LHS), Ext(RHS));
+    Res = Builder.CreateTrunc(Prod, Ty);
+    Overflow = Builder.CreateICmpNE(Ext(Res), Prod);
+    break;
+  }
+  default:
+    llvm_unreachable("Not an arithmetic with overflow intrinsic");
+  }
+
+  // Extracted fields are replaced directly, other uses get the aggregate.
+  for (auto UI = II->user_begin(), UE = II->user_end(); UI != UE;) {
+    auto EV = dyn_cast<ExtractValueInst>(*UI++);
+    if (!EV || EV->getNumIndices() != 1)
+      continue;
+    EV->replaceAllUsesWith(EV->getIndices()[0] == 0 ? Res : Overflow);
+    EV->eraseFromParent();
+  }
+  if (!II->use_empty()) {
+    Value *Agg = UndefValue::get(II->getType());
+    Agg = Builder.CreateInsertValue(Agg, Res, 0);
+    Agg = Builder.CreateInsertValue(Agg, Overflow, 1);
+    II->replaceAllUsesWith(Agg);
+  }
+  II->eraseFromParent();
+}
+
 // Assume F is a SPIR-V builtin function with a function pointer argument which
 // is a bitcast instruction casting a function to a void(void) function pointer.
 void SPIRVRegularizeLLVM::lowerFuncPtr(Function* F, Op OC) {
@@ -0,0 +1,93 @@
+//===- SPIRVTargetTransformInfo.cpp - SPIR-V cost model hooks --*- C++ -*-===//
+//
+//                     The LLVM/SPIRV Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2014 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+//
+// This file implements a TargetTransformInfo for the optimizations run before
+// translation to SPIR-V. It keeps target independent transformations from
+// producing constructs SPIR-V cannot represent.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "spvtti"
+
+#include "SPIRVInternal.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/Pass.h"
+#include "llvm/PassSupport.h"
+
+using namespace llvm;
+using namespace SPIRV;
+
+namespace SPIRV {
+
+class SPIRVTTI final : public ImmutablePass, public TargetTransformInfo {
+public:
+  SPIRVTTI():ImmutablePass(ID) {
+    initializeSPIRVTTIPass(*PassRegistry::getPassRegistry());
+  }
+
+  void initializePass() override {
+    pushTTIStack(this);
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    TargetTransformInfo::getAnalysisUsage(AU);
+  }
+
+  void *getAdjustedAnalysisPointer(const void *ID) override {
+    if (ID == &TargetTransformInfo::ID)
+      return (TargetTransformInfo *)this;
+    return this;
+  }
+
+  /// Work items of a kernel may take different paths through the same branch.
+  bool hasBranchDivergence() const override {
+    return true;
+  }
+
+  /// Lookup tables would be emitted as private program scope variables, which
+  /// are not allowed in OpenCL, so switches are kept as they are.
+  bool shouldBuildLookupTables() const override {
+    return false;
+  }
+
+  static char ID;
+};
+
+char SPIRVTTI::ID = 0;
+}
+
+INITIALIZE_AG_PASS(SPIRVTTI, TargetTransformInfo, "spvtti",
+    "SPIR-V Target Transform Info", true, true, false)
+
+ImmutablePass *llvm::createSPIRVTargetTransformInfo() {
+  return new SPIRVTTI();
+}
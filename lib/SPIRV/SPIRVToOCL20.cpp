@@ -131,6 +131,7 @@ public:
 private:
   Module *M;
   LLVMContext *Ctx;
+  BuiltinCalleeCache Callees;
 };
 
 char SPIRVToOCL20::ID = 0;
@@ -138,6 +139,7 @@ char SPIRVToOCL20::ID = 0;
 bool
 SPIRVToOCL20::runOnModule(Module& Module) {
   M = &Module;
+  Callees.reset(M);
   Ctx = &M->getContext();
   visit(*M);
 
@@ -198,7 +200,7 @@ SPIRVToOCL20::visitCallInst(CallInst& CI) {
 
 void SPIRVToOCL20::visitCallSPIRVMemoryBarrier(CallInst* CI) {
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstOCL(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstOCL(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     auto getArg = [=](unsigned I){
       return cast<ConstantInt>(Args[I])->getZExtValue();
     };
@@ -336,7 +338,7 @@ void SPIRVToOCL20::visitCallSPIRVAtomicBuiltin(CallInst* CI, Op OC) {
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
   Instruction * pInsertBefore = CI;
 
-  mutateCallInstOCL(M, CI, [=](CallInst *, std::vector<Value *> &Args, Type *& RetTy){
+  mutateCallInstOCL(Callees, CI, [=](CallInst *, std::vector<Value *> &Args, Type *& RetTy){
     auto Ptr = findFirstPtr(Args);
     auto Name = OCLSPIRVBuiltinMap::rmap(OC);
     auto NumOrder = getAtomicBuiltinNumMemoryOrderArgs(Name);
@@ -398,7 +400,7 @@ void SPIRVToOCL20::visitCallSPIRVAtomicBuiltin(CallInst* CI, Op OC) {
 
 void SPIRVToOCL20::visitCallSPIRVBuiltin(CallInst* CI, Op OC) {
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstOCL(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstOCL(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     return OCLSPIRVBuiltinMap::rmap(OC);
   }, &Attrs);
 }
@@ -423,7 +425,7 @@ void SPIRVToOCL20::visitCallSPIRVGroupBuiltin(CallInst* CI, Op OC) {
         SPIRSPIRVGroupOperationMap::rmap(GO) + '_' + Op.str();
   }
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstOCL(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstOCL(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     Args.erase(Args.begin(), Args.begin() + (HasGroupOperation ? 2 : 1));
     if (OC == OpGroupBroadcast)
       expandVector(CI, Args, 1);
@@ -450,7 +452,7 @@ void SPIRVToOCL20::visitCallSPIRVPipeBuiltin(CallInst* CI, Op OC) {
     DemangledName = getGroupBuiltinPrefix(CI) + DemangledName;
 
   AttributeSet Attrs = CI->getCalledFunction()->getAttributes();
-  mutateCallInstOCL(M, CI, [=](CallInst *, std::vector<Value *> &Args){
+  mutateCallInstOCL(Callees, CI, [=](CallInst *, std::vector<Value *> &Args){
     if (HasScope)
       Args.erase(Args.begin(), Args.begin() + 1);
 
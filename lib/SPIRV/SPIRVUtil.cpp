@@ -55,6 +55,7 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include <functional>
+#include <map>
 #include <sstream>
 
 #define DEBUG_TYPE "spirv"
@@ -638,26 +639,78 @@ hasArrayArg(Function *F) {
   return false;
 }
 
+// Replace CI by a call of F with arguments Args. The new call takes the name
+// of CI, so that CI need not be renamed.
+static CallInst *
+replaceCallInst(CallInst *CI, Function *F, ArrayRef<Value *> Args) {
+  auto NewCI = CallInst::Create(F, Args, "", CI);
+  NewCI->setCallingConv(F->getCallingConv());
+  NewCI->takeName(CI);
+  DEBUG(dbgs() << " => " << *NewCI << '\n');
+  CI->replaceAllUsesWith(NewCI);
+  CI->dropAllReferences();
+  CI->removeFromParent();
+  return NewCI;
+}
+
+Function *
+BuiltinCalleeCache::getOrCreateFunction(Type *RetTy, ArrayRef<Type *> ArgTypes,
+    StringRef Name, BuiltinFuncMangleInfo *Mangle, AttributeSet *Attrs,
+    bool TakeName) {
+  Value *Key = Mangle ? Mangle->getCacheKey() : nullptr;
+  auto &Entries = Callees[Name];
+  Entry *Found = nullptr;
+  for (auto &E : Entries)
+    if (E.RetTy == RetTy && ArrayRef<Type *>(E.ArgTypes) == ArgTypes &&
+        E.Mangled == (Mangle != nullptr) && E.HasKey == (Key != nullptr) &&
+        E.Key == Key) {
+      Found = &E;
+      break;
+    }
+  // The cached callee is stale if it was erased, or renamed because another
+  // function took its name.
+  if (Found && Found->Callee &&
+      Found->Callee->getName() == Found->CalleeName)
+    return cast<Function>(Found->Callee);
+  auto F = SPIRV::getOrCreateFunction(M, RetTy, ArgTypes, Name, Mangle, Attrs,
+      TakeName);
+  if (!Found) {
+    Entries.push_back(Entry());
+    Found = &Entries.back();
+    Found->RetTy = RetTy;
+    Found->ArgTypes.append(ArgTypes.begin(), ArgTypes.end());
+    Found->Mangled = Mangle != nullptr;
+    Found->Key = Key;
+    Found->HasKey = Key != nullptr;
+  }
+  Found->Callee = F;
+  Found->CalleeName = F->getName();
+  return F;
+}
+
+static Function *
+getOrCreateCallee(Module *M, BuiltinCalleeCache *Callees, Type *RetTy,
+    ArrayRef<Type *> ArgTypes, StringRef Name, BuiltinFuncMangleInfo *Mangle,
+    AttributeSet *Attrs, bool TakeName) {
+  if (Callees)
+    return Callees->getOrCreateFunction(RetTy, ArgTypes, Name, Mangle, Attrs,
+        TakeName);
+  return getOrCreateFunction(M, RetTy, ArgTypes, Name, Mangle, Attrs,
+      TakeName);
+}
+
 CallInst *
 mutateCallInst(Module *M, CallInst *CI,
     std::function<std::string (CallInst *, std::vector<Value *> &)>ArgMutate,
-    BuiltinFuncMangleInfo *Mangle, AttributeSet *Attrs, bool TakeFuncName) {
+    BuiltinFuncMangleInfo *Mangle, AttributeSet *Attrs, bool TakeFuncName,
+    BuiltinCalleeCache *Callees) {
   DEBUG(dbgs() << "[mutateCallInst] " << *CI);
 
   auto Args = getArguments(CI);
   auto NewName = ArgMutate(CI, Args);
-  std::string InstName;
-  if (!CI->getType()->isVoidTy() && CI->hasName()) {
-    InstName = CI->getName();
-    CI->setName(InstName + ".old");
-  }
-  auto NewCI = addCallInst(M, NewName, CI->getType(), Args, Attrs, CI, Mangle,
-      InstName, TakeFuncName);
-  DEBUG(dbgs() << " => " << *NewCI << '\n');
-  CI->replaceAllUsesWith(NewCI);
-  CI->dropAllReferences();
-  CI->removeFromParent();
-  return NewCI;
+  auto F = getOrCreateCallee(M, Callees, CI->getType(), getTypes(Args),
+      NewName, Mangle, Attrs, TakeFuncName);
+  return replaceCallInst(CI, F, Args);
 }
 
 Instruction *
@@ -665,19 +718,19 @@ mutateCallInst(Module *M, CallInst *CI,
     std::function<std::string (CallInst *, std::vector<Value *> &,
         Type *&RetTy)>ArgMutate,
     std::function<Instruction *(CallInst *)> RetMutate,
-    BuiltinFuncMangleInfo *Mangle, AttributeSet *Attrs, bool TakeFuncName) {
+    BuiltinFuncMangleInfo *Mangle, AttributeSet *Attrs, bool TakeFuncName,
+    BuiltinCalleeCache *Callees) {
   DEBUG(dbgs() << "[mutateCallInst] " << *CI);
 
   auto Args = getArguments(CI);
   Type *RetTy = CI->getType();
   auto NewName = ArgMutate(CI, Args, RetTy);
-  std::string InstName;
-  if (CI->hasName()) {
-    InstName = CI->getName();
-    CI->setName(InstName + ".old");
-  }
-  auto NewCI = addCallInst(M, NewName, RetTy, Args, Attrs,
-      CI, Mangle, InstName + ".tmp", TakeFuncName);
+  auto F = getOrCreateCallee(M, Callees, RetTy, getTypes(Args), NewName,
+      Mangle, Attrs, TakeFuncName);
+  // The result of RetMutate takes the name of CI, so that CI need not be
+  // renamed.
+  auto NewCI = CallInst::Create(F, Args, "", CI);
+  NewCI->setCallingConv(F->getCallingConv());
   auto NewI = RetMutate(NewCI);
   NewI->takeName(CI);
   DEBUG(dbgs() << " => " << *NewI << '\n');
@@ -693,9 +746,22 @@ mutateFunction(Function *F,
     BuiltinFuncMangleInfo *Mangle, AttributeSet *Attrs,
     bool TakeFuncName) {
   auto M = F->getParent();
-  for (auto I = F->user_begin(), E = F->user_end(); I != E;) {
-    if (auto CI = dyn_cast<CallInst>(*I++))
-      mutateCallInst(M, CI, ArgMutate, Mangle, Attrs, TakeFuncName);
+  std::vector<CallInst *> Calls;
+  for (auto U:F->users())
+    if (auto CI = dyn_cast<CallInst>(U))
+      Calls.push_back(CI);
+
+  // All calls are mutated with the same mangling info, so calls mutated to
+  // the same name and signature share the callee, which is mangled and looked
+  // up once.
+  BuiltinCalleeCache Callees(M);
+  for (auto CI:Calls) {
+    DEBUG(dbgs() << "[mutateFunction] " << *CI);
+    auto Args = getArguments(CI);
+    auto NewName = ArgMutate(CI, Args);
+    auto NewF = Callees.getOrCreateFunction(CI->getType(), getTypes(Args),
+        NewName, Mangle, Attrs, TakeFuncName);
+    replaceCallInst(CI, NewF, Args);
   }
   if (F->use_empty())
     F->eraseFromParent();
@@ -719,6 +785,26 @@ mutateCallInstSPIRV(Module *M, CallInst *CI,
   return mutateCallInst(M, CI, ArgMutate, RetMutate, &BtnInfo, Attrs);
 }
 
+CallInst *
+mutateCallInstSPIRV(BuiltinCalleeCache &Callees, CallInst *CI,
+    std::function<std::string (CallInst *, std::vector<Value *> &)>ArgMutate,
+    AttributeSet *Attrs) {
+  BuiltinFuncMangleInfo BtnInfo;
+  return mutateCallInst(Callees.getModule(), CI, ArgMutate, &BtnInfo, Attrs,
+      false, &Callees);
+}
+
+Instruction *
+mutateCallInstSPIRV(BuiltinCalleeCache &Callees, CallInst *CI,
+    std::function<std::string (CallInst *, std::vector<Value *> &,
+        Type *&RetTy)> ArgMutate,
+    std::function<Instruction *(CallInst *)> RetMutate,
+    AttributeSet *Attrs) {
+  BuiltinFuncMangleInfo BtnInfo;
+  return mutateCallInst(Callees.getModule(), CI, ArgMutate, RetMutate,
+      &BtnInfo, Attrs, false, &Callees);
+}
+
 CallInst *
 addCallInst(Module *M, StringRef FuncName, Type *RetTy, ArrayRef<Value *> Args,
     AttributeSet *Attrs, Instruction *Pos, BuiltinFuncMangleInfo *Mangle,
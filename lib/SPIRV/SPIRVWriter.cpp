@@ -44,6 +44,7 @@
 #include "SPIRVType.h"
 #include "SPIRVValue.h"
 #include "SPIRVFunction.h"
+#include "SPIRVIndex.h"
 #include "SPIRVBasicBlock.h"
 #include "SPIRVInstruction.h"
 #include "SPIRVExtInst.h"
@@ -55,8 +56,10 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -76,7 +79,9 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/Scalar.h"
 
 #include <iostream>
 #include <list>
@@ -102,6 +107,10 @@ namespace SPIRV{
 cl::opt<bool> SPIRVMemToReg("spirv-mem2reg", cl::init(true),
     cl::desc("LLVM/SPIR-V translation enable mem2reg"));
 
+cl::opt<unsigned> SPIRVOptLevel("spirv-opt-level", cl::init(0),
+    cl::desc("LLVM/SPIR-V translation optimization level run before "
+        "lowering (0-2)"));
+
 
 static void
 foreachKernelArgMD(MDNode *MD, SPIRVFunction *BF,
@@ -163,7 +172,9 @@ public:
         ExtSetId(SPIRVID_INVALID),
         SrcLang(0),
         SrcLangVer(0),
+        FPFastMathMask(0),
         DbgTran(nullptr, SMod){
+    initializeLLVMToSPIRVPass(*PassRegistry::getPassRegistry());
   }
 
   virtual const char* getPassName() const {
@@ -181,12 +192,15 @@ public:
 
   void getAnalysisUsage(AnalysisUsage &AU) const {
     AU.addRequired<OCLTypeToSPIRV>();
+    AU.addRequired<LoopInfo>();
   }
 
   static char ID;
 
   SPIRVType *transType(Type *T);
   SPIRVType *transSPIRVOpaqueType(Type *T);
+  void computeStructSCCs(StructType *Root);
+  bool isRecursiveMember(StructType *ST, Type *ElemTy);
 
   SPIRVValue *getTranslatedValue(Value *) const;
 
@@ -202,9 +216,12 @@ public:
   SPIRVValue *transIntrinsicInst(IntrinsicInst *Intrinsic, SPIRVBasicBlock *BB);
   SPIRVValue *transCallInst(CallInst *Call, SPIRVBasicBlock *BB);
   bool transDecoration(Value *V, SPIRVValue *BV);
+  void transFPFastMathOptions();
+  SPIRVWord transFPFastMathMode(Instruction *I);
   SPIRVWord transFunctionControlMask(CallInst *);
   SPIRVWord transFunctionControlMask(Function *);
   SPIRVFunction *transFunctionDecl(Function *F);
+  void transArgAliasing(Function *F);
   bool transGlobalVariables();
 
   Op transBoolOpCode(SPIRVValue *Opn, Op OC);
@@ -220,16 +237,20 @@ public:
 
   typedef DenseMap<Type *, SPIRVType *> LLVMToSPIRVTypeMap;
   typedef DenseMap<Value *, SPIRVValue *> LLVMToSPIRVValueMap;
+  typedef DenseMap<StructType *, unsigned> StructSCCMapTy;
 private:
   Module *M;
   LLVMContext *Ctx;
   SPIRVModule *BM;
   LLVMToSPIRVTypeMap TypeMap;
   LLVMToSPIRVValueMap ValueMap;
+  StructSCCMapTy StructSCCMap;
   //ToDo: support multiple builtin sets. Currently assume one builtin set.
   SPIRVId ExtSetId;
   SPIRVWord SrcLang;
   SPIRVWord SrcLangVer;
+  // FPFastMathMode flags implied by the compiler options of the module.
+  SPIRVWord FPFastMathMask;
   LLVMToSPIRVDbgTran DbgTran;
 
   SPIRVType *mapType(Type *T, SPIRVType *BT) {
@@ -277,6 +298,10 @@ private:
   SPIRVInstruction* transCmpInst(CmpInst* Cmp, SPIRVBasicBlock* BB);
   SPIRVInstruction* transLifetimeIntrinsicInst(Op OC, IntrinsicInst *Intrinsic, SPIRVBasicBlock *BB);
 
+  /// Add OpLoopMerge to \param BB if the LLVM basic block is the header of a
+  /// loop carrying unroll hints in its llvm.loop metadata.
+  void transLoopMerge(BasicBlock *Header, LoopInfo &LI, SPIRVBasicBlock *BB);
+
   void dumpUsers(Value *V);
 
   template<class ExtInstKind>
@@ -408,36 +433,72 @@ static std::string
   return SubStrs[1].str();
 }
 
-static bool recursiveType(const StructType *ST, const Type *Ty) {
-  SmallPtrSet<const StructType *, 4> Seen;
-
-  std::function<bool(const Type *Ty)> Run = [&](const Type *Ty) {
-    if (!isa<CompositeType>(Ty))
-      return false;
-
-    if (auto *StructTy = dyn_cast<StructType>(Ty)) {
-      if (StructTy == ST)
-        return true;
-
-      if (Seen.count(StructTy))
-        return false;
-
-      Seen.insert(StructTy);
+// Get the struct type referred to by Ty through pointer and array types.
+// Returns nullptr if there is none.
+static StructType *getReferencedStruct(Type *Ty) {
+  while (true) {
+    if (auto PtrTy = dyn_cast<PointerType>(Ty))
+      Ty = PtrTy->getPointerElementType();
+    else if (auto ArrayTy = dyn_cast<ArrayType>(Ty))
+      Ty = ArrayTy->getArrayElementType();
+    else
+      break;
+  }
+  return dyn_cast<StructType>(Ty);
+}
 
-      return find_if(StructTy->subtype_begin(), StructTy->subtype_end(), Run) !=
-             StructTy->subtype_end();
+// Assign the struct types reachable from Root to the strongly connected
+// components of the graph of struct references by Tarjan's algorithm.
+// Structs assigned by previous calls are not visited again, so the total
+// cost over all calls is linear in the number of struct members.
+void
+LLVMToSPIRV::computeStructSCCs(StructType *Root) {
+  DenseMap<StructType *, unsigned> Index;
+  DenseMap<StructType *, unsigned> LowLink;
+  SmallVector<StructType *, 8> Stack;
+  SmallPtrSet<StructType *, 8> OnStack;
+
+  std::function<void(StructType *)> Visit = [&](StructType *ST) {
+    unsigned I = Index.size();
+    Index[ST] = I;
+    LowLink[ST] = I;
+    Stack.push_back(ST);
+    OnStack.insert(ST);
+    for (unsigned J = 0, E = ST->getNumElements(); J != E; ++J) {
+      auto Succ = getReferencedStruct(ST->getElementType(J));
+      if (!Succ || StructSCCMap.count(Succ))
+        continue;
+      if (!Index.count(Succ)) {
+        Visit(Succ);
+        LowLink[ST] = std::min(LowLink[ST], LowLink[Succ]);
+      } else if (OnStack.count(Succ))
+        LowLink[ST] = std::min(LowLink[ST], Index[Succ]);
     }
+    if (LowLink[ST] != Index[ST])
+      return;
+    // The map only grows, so its size is a fresh component number.
+    unsigned SCC = StructSCCMap.size();
+    StructType *Member = nullptr;
+    do {
+      Member = Stack.pop_back_val();
+      OnStack.erase(Member);
+      StructSCCMap[Member] = SCC;
+    } while (Member != ST);
+  };
 
-    if (auto *PtrTy = dyn_cast<PointerType>(Ty))
-      return Run(PtrTy->getPointerElementType());
-
-    if (auto *ArrayTy = dyn_cast<ArrayType>(Ty))
-      return Run(ArrayTy->getArrayElementType());
+  Visit(Root);
+}
 
+// A member of a struct refers back to the struct iff the struct it refers to
+// is in the same strongly connected component.
+bool
+LLVMToSPIRV::isRecursiveMember(StructType *ST, Type *ElemTy) {
+  auto Ref = getReferencedStruct(ElemTy);
+  if (!Ref)
     return false;
-  };
-
-  return Run(Ty);
+  if (!StructSCCMap.count(ST))
+    computeStructSCCs(ST);
+  return StructSCCMap[Ref] == StructSCCMap[ST];
 }
 
 SPIRVType *
@@ -556,7 +617,7 @@ LLVMToSPIRV::transType(Type *T) {
 
     for (unsigned I = 0, E = T->getStructNumElements(); I != E; ++I) {
       auto *ElemTy = ST->getElementType(I);
-      if (isa<CompositeType>(ElemTy) && recursiveType(ST, ElemTy))
+      if (isa<CompositeType>(ElemTy) && isRecursiveMember(ST, ElemTy))
         ForwardRefs.push_back(I);
       else
         Struct->setMemberType(I, transType(ST->getElementType(I)));
@@ -632,6 +693,25 @@ LLVMToSPIRV::transSPIRVOpaqueType(Type *T) {
       SPIRVOpaqueTypeOpCodeMap::map(TN)));
 }
 
+/// Decorates the pointer parameters of \p F with Restrict if they are not
+/// aliased by the other pointers accessible to the function, i.e. they are
+/// noalias or restrict qualified kernel arguments. The other parameters are
+/// left undecorated, since the source does not say that they alias.
+void
+LLVMToSPIRV::transArgAliasing(Function *F) {
+  auto BF = static_cast<SPIRVFunction *>(getTranslatedValue(F));
+  if (!BF)
+    return;
+  for (Function::arg_iterator I = F->arg_begin(), E = F->arg_end(); I != E;
+      ++I) {
+    if (!I->getType()->isPointerTy())
+      continue;
+    SPIRVFunctionParameter *BA = BF->getArgument(I->getArgNo());
+    if (BA->hasAttr(FunctionParameterAttributeNoAlias))
+      BA->addDecorate(DecorationRestrict);
+  }
+}
+
 SPIRVFunction *
 LLVMToSPIRV::transFunctionDecl(Function *F) {
   if (auto BF = getTranslatedValue(F))
@@ -684,6 +764,8 @@ LLVMToSPIRV::transFunctionDecl(Function *F) {
     BF->addDecorate(DecorationFuncParamAttr, FunctionParameterAttributeZext);
   if (Attrs.hasAttribute(AttributeSet::ReturnIndex, Attribute::SExt))
     BF->addDecorate(DecorationFuncParamAttr, FunctionParameterAttributeSext);
+  if (Attrs.hasAttribute(AttributeSet::ReturnIndex, Attribute::NoAlias))
+    BF->addDecorate(DecorationFuncParamAttr, FunctionParameterAttributeNoAlias);
   DbgTran.transDbgInfo(F, BF);
   SPIRVDBG(dbgs() << "[transFunction] " << *F << " => ";
     spvdbgs() << *BF << '\n';)
@@ -1172,10 +1254,63 @@ LLVMToSPIRV::transDecoration(Value *V, SPIRVValue *BV) {
       cast<AtomicCmpXchgInst>(V)->isVolatile()) ||
       (isa<AtomicRMWInst>(V) && cast<AtomicRMWInst>(V)->isVolatile()))
     BV->setVolatile(true);
+  if (isa<BinaryOperator>(V) && V->getType()->isFPOrFPVectorTy() &&
+      BV->isInst()) {
+    if (auto Mask = transFPFastMathMode(cast<Instruction>(V)))
+      static_cast<SPIRVInstruction *>(BV)->addFPFastMathMode(Mask);
+  }
   DbgTran.transDbgInfo(V, BV);
   return true;
 }
 
+void
+LLVMToSPIRV::transFPFastMathOptions() {
+  for (auto &Opts:getNamedMDAsStringSet(M, SPIR_MD_COMPILER_OPTIONS)) {
+    SmallVector<StringRef, 4> OptVec;
+    SplitString(Opts, OptVec);
+    for (auto &Opt:OptVec)
+      FPFastMathMask |= StringSwitch<SPIRVWord>(Opt)
+          .Case("-cl-fast-relaxed-math", FPFastMathModeNotNaNMask |
+              FPFastMathModeNotInfMask | FPFastMathModeNSZMask |
+              FPFastMathModeAllowRecipMask | FPFastMathModeFastMask)
+          .Case("-cl-finite-math-only", FPFastMathModeNotNaNMask |
+              FPFastMathModeNotInfMask)
+          .Case("-cl-unsafe-math-optimizations", FPFastMathModeNSZMask |
+              FPFastMathModeAllowRecipMask)
+          .Case("-cl-no-signed-zeros", FPFastMathModeNSZMask)
+          .Default(0);
+  }
+}
+
+SPIRVWord
+LLVMToSPIRV::transFPFastMathMode(Instruction *I) {
+  SPIRVWord Mask = FPFastMathMask;
+  auto FMF = I->getFastMathFlags();
+  if (FMF.unsafeAlgebra())
+    Mask |= FPFastMathModeFastMask;
+  if (FMF.noNaNs())
+    Mask |= FPFastMathModeNotNaNMask;
+  if (FMF.noInfs())
+    Mask |= FPFastMathModeNotInfMask;
+  if (FMF.noSignedZeros())
+    Mask |= FPFastMathModeNSZMask;
+  if (FMF.allowReciprocal())
+    Mask |= FPFastMathModeAllowRecipMask;
+
+  // Function attributes added by the front end for fast math options.
+  auto F = I->getParent()->getParent();
+  auto IsSet = [=](StringRef Kind) {
+    return F->getFnAttribute(Kind).getValueAsString() == "true";
+  };
+  if (IsSet("no-nans-fp-math"))
+    Mask |= FPFastMathModeNotNaNMask;
+  if (IsSet("no-infs-fp-math"))
+    Mask |= FPFastMathModeNotInfMask;
+  if (IsSet("unsafe-fp-math"))
+    Mask |= FPFastMathModeNSZMask | FPFastMathModeAllowRecipMask;
+  return Mask;
+}
+
 bool
 LLVMToSPIRV::transAlign(Value *V, SPIRVValue *BV) {
   if (auto AL = dyn_cast<AllocaInst>(V)) {
@@ -1250,6 +1385,63 @@ LLVMToSPIRV::transSpcvCast(CallInst* CI, SPIRVBasicBlock *BB) {
   return oclTransSpvcCastSampler(CI, BB);
 }
 
+// Get the OpenCL extended instruction having the same semantics as an LLVM
+// intrinsic. Returns SPIRVWORD_MAX if there is none.
+static SPIRVWord
+getOCLExtOpForLLVMIntrinsic(Intrinsic::ID IID) {
+  switch (IID) {
+  case Intrinsic::ceil:
+    return OpenCLLIB::Ceil;
+  case Intrinsic::copysign:
+    return OpenCLLIB::Copysign;
+  case Intrinsic::cos:
+    return OpenCLLIB::Cos;
+  case Intrinsic::ctlz:
+    return OpenCLLIB::Clz;
+  case Intrinsic::ctpop:
+    return OpenCLLIB::Popcount;
+  case Intrinsic::cttz:
+    return OpenCLLIB::Ctz;
+  case Intrinsic::exp:
+    return OpenCLLIB::Exp;
+  case Intrinsic::exp2:
+    return OpenCLLIB::Exp2;
+  case Intrinsic::fabs:
+    return OpenCLLIB::Fabs;
+  case Intrinsic::floor:
+    return OpenCLLIB::Floor;
+  case Intrinsic::fma:
+    return OpenCLLIB::Fma;
+  case Intrinsic::log:
+    return OpenCLLIB::Log;
+  case Intrinsic::log10:
+    return OpenCLLIB::Log10;
+  case Intrinsic::log2:
+    return OpenCLLIB::Log2;
+  case Intrinsic::maxnum:
+    return OpenCLLIB::Fmax;
+  case Intrinsic::minnum:
+    return OpenCLLIB::Fmin;
+  case Intrinsic::nearbyint:
+  case Intrinsic::rint:
+    return OpenCLLIB::Rint;
+  case Intrinsic::pow:
+    return OpenCLLIB::Pow;
+  case Intrinsic::powi:
+    return OpenCLLIB::Pown;
+  case Intrinsic::round:
+    return OpenCLLIB::Round;
+  case Intrinsic::sin:
+    return OpenCLLIB::Sin;
+  case Intrinsic::sqrt:
+    return OpenCLLIB::Sqrt;
+  case Intrinsic::trunc:
+    return OpenCLLIB::Trunc;
+  default:
+    return SPIRVWORD_MAX;
+  }
+}
+
 SPIRVValue *
 LLVMToSPIRV::transIntrinsicInst(IntrinsicInst *II, SPIRVBasicBlock *BB) {
   auto getMemoryAccess = [](MemIntrinsic *MI)->std::vector<SPIRVWord> {
@@ -1263,7 +1455,54 @@ LLVMToSPIRV::transIntrinsicInst(IntrinsicInst *II, SPIRVBasicBlock *BB) {
     return MemoryAccess;
   };
 
+  SPIRVWord ExtOp = getOCLExtOpForLLVMIntrinsic(II->getIntrinsicID());
+  if (ExtOp != SPIRVWORD_MAX) {
+    std::vector<SPIRVValue *> Args;
+    for (auto &Arg : II->arg_operands())
+      Args.push_back(transValue(Arg, BB));
+    // The is_zero_undef flag of llvm.ctlz/llvm.cttz has no OpenCL
+    // counterpart. OpenCL clz/ctz are defined for zero, which is a valid
+    // refinement of the intrinsics.
+    if (ExtOp == OpenCLLIB::Clz || ExtOp == OpenCLLIB::Ctz)
+      Args.pop_back();
+    // llvm.powi always takes a scalar i32 exponent, while a vector pown needs
+    // an exponent vector with as many components as the base.
+    if (ExtOp == OpenCLLIB::Pown && II->getType()->isVectorTy()) {
+      unsigned Size = II->getType()->getVectorNumElements();
+      Value *Exp = II->getArgOperand(1);
+      if (auto C = dyn_cast<Constant>(Exp))
+        Args[1] = transValue(ConstantVector::getSplat(Size, C), BB);
+      else
+        Args[1] = BM->addCompositeConstructInst(
+            transType(VectorType::get(Exp->getType(), Size)),
+            std::vector<SPIRVId>(Size, Args[1]->getId()), BB);
+    }
+    return BM->addExtInst(transType(II->getType()), ExtSetId, ExtOp, Args, BB);
+  }
+
   switch (II->getIntrinsicID()) {
+  case Intrinsic::bswap : {
+    // There is no byte swap instruction in SPIR-V, so the bytes are moved one
+    // by one: byte I goes to byte N - 1 - I.
+    Type *Ty = II->getType();
+    SPIRVType *BTy = transType(Ty);
+    SPIRVValue *Val = transValue(II->getArgOperand(0), BB);
+    int NumBytes = Ty->getScalarSizeInBits() / 8;
+    SPIRVValue *Res = nullptr;
+    for (int I = 0; I < NumBytes; ++I) {
+      SPIRVValue *Byte = BM->addBinaryInst(OpBitwiseAnd, BTy, Val,
+          transValue(ConstantInt::get(Ty, UINT64_C(0xFF) << (I * 8)), BB), BB);
+      int Shift = (NumBytes - 1 - 2 * I) * 8;
+      if (Shift > 0)
+        Byte = BM->addBinaryInst(OpShiftLeftLogical, BTy, Byte,
+            transValue(ConstantInt::get(Ty, Shift), BB), BB);
+      else
+        Byte = BM->addBinaryInst(OpShiftRightLogical, BTy, Byte,
+            transValue(ConstantInt::get(Ty, -Shift), BB), BB);
+      Res = Res ? BM->addBinaryInst(OpBitwiseOr, BTy, Res, Byte, BB) : Byte;
+    }
+    return Res;
+  }
   case Intrinsic::fmuladd : {
     // For llvm.fmuladd.* fusion is not guaranteed. If a fused multiply-add
     // is required the corresponding llvm.fma.* intrinsic function should be
@@ -1466,6 +1705,60 @@ LLVMToSPIRV::mutateFuncArgType(const std::map<unsigned, Type*>& ChangedType,
   }
 }
 
+// Get the loop control mask for the unroll hints of a loop ID. Returns
+// SPIRVWORD_MAX if there is no unroll hint.
+static SPIRVWord
+getLoopControl(MDNode *LoopID) {
+  SPIRVWord LoopControl = SPIRVWORD_MAX;
+  for (unsigned I = 1, E = LoopID->getNumOperands(); I < E; ++I) {
+    auto Node = dyn_cast<MDNode>(LoopID->getOperand(I));
+    if (!Node || Node->getNumOperands() == 0)
+      continue;
+    auto Name = dyn_cast<MDString>(Node->getOperand(0));
+    if (!Name)
+      continue;
+    if (Name->getString() == "llvm.loop.unroll.full")
+      LoopControl = LoopControlUnrollMask;
+    else if (Name->getString() == "llvm.loop.unroll.disable")
+      LoopControl = LoopControlDontUnrollMask;
+    else if (Name->getString() == "llvm.loop.unroll.count" &&
+             Node->getNumOperands() == 2) {
+      // A partial unroll count cannot be expressed, only count 1 which
+      // disables unrolling.
+      auto Count = mdconst::dyn_extract<ConstantInt>(Node->getOperand(1));
+      if (Count && Count->isOne())
+        LoopControl = LoopControlDontUnrollMask;
+    }
+  }
+  return LoopControl;
+}
+
+void
+LLVMToSPIRV::transLoopMerge(BasicBlock *Header, LoopInfo &LI,
+    SPIRVBasicBlock *BB) {
+  Loop *L = LI.getLoopFor(Header);
+  if (!L || L->getHeader() != Header || !isa<BranchInst>(
+      Header->getTerminator()))
+    return;
+  // The loop ID is normally attached to the latch. The SPIR-V reader attaches
+  // it to the branch of the loop header.
+  MDNode *LoopID = L->getLoopID();
+  if (!LoopID)
+    LoopID = Header->getTerminator()->getMetadata("llvm.loop");
+  if (!LoopID)
+    return;
+  SPIRVWord LoopControl = getLoopControl(LoopID);
+  if (LoopControl == SPIRVWORD_MAX)
+    return;
+  // OpLoopMerge requires a single merge block and a single continue target.
+  BasicBlock *Merge = L->getExitBlock();
+  BasicBlock *Continue = L->getLoopLatch();
+  if (!Merge || !Continue)
+    return;
+  BM->addLoopMergeInst(transValue(Merge, nullptr)->getId(),
+      transValue(Continue, nullptr)->getId(), LoopControl, BB);
+}
+
 void
 LLVMToSPIRV::transFunction(Function *I) {
   transFunctionDecl(I);
@@ -1473,10 +1766,13 @@ LLVMToSPIRV::transFunction(Function *I) {
   for (Function::iterator FI = I->begin(), FE = I->end(); FI != FE; ++FI) {
     transValue(FI, nullptr);
   }
+  LoopInfo &LI = getAnalysis<LoopInfo>(*I);
   for (Function::iterator FI = I->begin(), FE = I->end(); FI != FE; ++FI) {
     SPIRVBasicBlock* BB = static_cast<SPIRVBasicBlock*>(transValue(FI, nullptr));
     for (BasicBlock::iterator BI = FI->begin(), BE = FI->end(); BI != BE;
         ++BI) {
+      if (isa<TerminatorInst>(BI))
+        transLoopMerge(FI, LI, BB);
       transValue(BI, BB, false);
     }
   }
@@ -1494,6 +1790,7 @@ LLVMToSPIRV::translate() {
     return false;
   if (!transAddressingMode())
     return false;
+  transFPFastMathOptions();
   if (!transGlobalVariables())
     return false;
 
@@ -1525,6 +1822,12 @@ LLVMToSPIRV::translate() {
 
   if (!transOCLKernelMetadata())
     return false;
+  // Kernel arguments qualified restrict are known only after the kernel
+  // metadata is translated.
+  for (auto I:Decls)
+    transArgAliasing(I);
+  for (auto I:Defs)
+    transArgAliasing(I);
   if (!transExecutionMode())
     return false;
 
@@ -1821,6 +2124,7 @@ char LLVMToSPIRV::ID = 0;
 INITIALIZE_PASS_BEGIN(LLVMToSPIRV, "llvmtospv", "Translate LLVM to SPIR-V",
     false, false)
 INITIALIZE_PASS_DEPENDENCY(OCLTypeToSPIRV)
+INITIALIZE_PASS_DEPENDENCY(LoopInfo)
 INITIALIZE_PASS_END(LLVMToSPIRV, "llvmtospv", "Translate LLVM to SPIR-V",
     false, false)
 
@@ -1835,6 +2139,29 @@ addPassesForSPIRV(PassManager &PassMgr) {
   PassMgr.add(createTransOCLMD());
   PassMgr.add(createOCL21ToSPIRV());
   PassMgr.add(createSPIRVLowerOCLBlocks());
+  // Only transformations whose results are representable in SPIR-V are used.
+  // Lookup tables are disabled by the SPIR-V target transform info and
+  // intrinsics formed by instcombine are expanded by SPIRVRegularizeLLVM.
+  // OpenCL builtins such as printf or sqrt are not host library functions,
+  // so library call simplification is disabled.
+  if (SPIRVOptLevel > 0) {
+    TargetLibraryInfo *TLI = new TargetLibraryInfo();
+    TLI->disableAllFunctions();
+    PassMgr.add(TLI);
+    PassMgr.add(createSPIRVTargetTransformInfo());
+    PassMgr.add(createSROAPass());
+    PassMgr.add(createEarlyCSEPass());
+    PassMgr.add(createInstructionCombiningPass());
+    PassMgr.add(createCFGSimplificationPass());
+  }
+  if (SPIRVOptLevel > 1) {
+    PassMgr.add(createLoopRotatePass());
+    PassMgr.add(createLICMPass());
+    PassMgr.add(createLoopUnrollPass());
+    PassMgr.add(createGVNPass());
+    PassMgr.add(createInstructionCombiningPass());
+    PassMgr.add(createCFGSimplificationPass());
+  }
   PassMgr.add(createOCLTypeToSPIRV());
   PassMgr.add(createOCL20ToSPIRV());
   PassMgr.add(createSPIRVRegularizeLLVM());
@@ -1843,8 +2170,11 @@ addPassesForSPIRV(PassManager &PassMgr) {
   PassMgr.add(createSPIRVLowerMemmove());
 }
 
-bool
-llvm::WriteSPIRV(Module *M, llvm::raw_ostream &OS, std::string &ErrMsg) {
+// Translate M to SPIR-V and write it to OS. If IndexOS is not null, the
+// index of the binary recorded while encoding is written to it.
+static bool
+writeSPIRV(Module *M, llvm::raw_ostream &OS, llvm::raw_ostream *IndexOS,
+    std::string &ErrMsg) {
   std::unique_ptr<SPIRVModule> BM(SPIRVModule::createSPIRVModule());
   PassManager PassMgr;
   addPassesForSPIRV(PassMgr);
@@ -1853,10 +2183,27 @@ llvm::WriteSPIRV(Module *M, llvm::raw_ostream &OS, std::string &ErrMsg) {
 
   if (BM->getError(ErrMsg) != SPIRVEC_Success)
     return false;
-  OS << *BM;
+  if (!IndexOS) {
+    OS << *BM;
+    return true;
+  }
+  SPIRVModuleIndex Index;
+  encodeSPIRVModule(OS, *BM, &Index);
+  *IndexOS << Index;
   return true;
 }
 
+bool
+llvm::WriteSPIRV(Module *M, llvm::raw_ostream &OS, std::string &ErrMsg) {
+  return writeSPIRV(M, OS, nullptr, ErrMsg);
+}
+
+bool
+llvm::WriteSPIRV(Module *M, llvm::raw_ostream &OS, llvm::raw_ostream &IndexOS,
+    std::string &ErrMsg) {
+  return writeSPIRV(M, OS, &IndexOS, ErrMsg);
+}
+
 bool
 llvm::RegularizeLLVMForSPIRV(Module *M, std::string &ErrMsg) {
   std::unique_ptr<SPIRVModule> BM(SPIRVModule::createSPIRVModule());
@@ -69,6 +69,14 @@ SPIRVBasicBlock::addInstruction(SPIRVInstruction *I) {
   return I;
 }
 
+void
+SPIRVBasicBlock::takeInstructions(SPIRVBasicBlock *BB) {
+  for (auto I:BB->InstVec)
+    I->setBasicBlock(this);
+  InstVec.insert(InstVec.end(), BB->InstVec.begin(), BB->InstVec.end());
+  BB->InstVec.clear();
+}
+
 void
 SPIRVBasicBlock::encodeChildren(spv_ostream &O) const {
   O << SPIRVNL();
@@ -84,6 +84,8 @@ public:
     assert(Loc != InstVec.end());
     InstVec.erase(Loc);
   }
+  // Move all instructions of BB to the end of this basic block.
+  void takeInstructions(SPIRVBasicBlock *BB);
 
   void setAttr() { setHasNoType();}
   _SPIRV_DCL_ENCDEC
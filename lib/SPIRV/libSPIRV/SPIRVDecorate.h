@@ -43,6 +43,7 @@
 #include "SPIRVEntry.h"
 #include "SPIRVUtil.h"
 #include "SPIRVStream.h"
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <utility>
@@ -281,6 +282,11 @@ public:
     Targets.resize(WC - FixedWC);
   }
   virtual void decorateTargets() = 0;
+  void eraseTarget(SPIRVId Id) {
+    Targets.erase(std::remove(Targets.begin(), Targets.end(), Id),
+        Targets.end());
+    WordCount = FixedWC + Targets.size();
+  }
   _SPIRV_DCL_ENCDEC
 protected:
   SPIRVDecorationGroup *DecorationGroup;
@@ -118,6 +118,9 @@ SPIRVFunction::decode(std::istream &I) {
       break;
     }
     case OpLabel: {
+      // Declaration only, the rest of the body is not read.
+      if (Module->isSkippingFunctionBodies())
+        return;
       decodeBB(Decoder);
       break;
     }
@@ -129,6 +129,12 @@ public:
     return BB;
   }
 
+  void eraseBasicBlock(SPIRVBasicBlock *BB) {
+    auto Loc = std::find(BBVec.begin(), BBVec.end(), BB);
+    assert(Loc != BBVec.end());
+    BBVec.erase(Loc);
+  }
+
   void encodeChildren(spv_ostream &)const;
   void encodeExecutionModes(spv_ostream &)const;
   _SPIRV_DCL_ENCDEC
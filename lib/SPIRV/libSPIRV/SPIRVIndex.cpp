@@ -0,0 +1,163 @@
+//===- SPIRVIndex.cpp - Random-access index of SPIR-V binaries --*- C++ -*-===//
+//
+//                     The LLVM/SPIRV Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2014 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+/// \file
+///
+/// This file implements the serialization of the random-access index of a
+/// SPIR-V binary.
+///
+//===----------------------------------------------------------------------===//
+
+#include "SPIRVIndex.h"
+#include "SPIRVDebug.h"
+
+#include <algorithm>
+
+namespace SPIRV{
+
+// "SPVI" in little endian byte order.
+static const SPIRVWord IndexMagicNumber = 0x49565053;
+static const SPIRVWord IndexVersion = 1;
+
+SPIRVModuleIndex::SPIRVModuleIndex() {
+  clear();
+}
+
+void
+SPIRVModuleIndex::clear() {
+  ModuleWordCount = 0;
+  Bound = 0;
+  std::fill(SectionOffset, SectionOffset + SPIRVSEC_Count, 0);
+  Functions.clear();
+}
+
+const SPIRVModuleIndex::FunctionInfo *
+SPIRVModuleIndex::getFunction(const std::string &Name) const {
+  for (auto &F:Functions)
+    if (F.Name == Name)
+      return &F;
+  return nullptr;
+}
+
+static void
+writeWord(spv_ostream &O, SPIRVWord W) {
+  O.write(reinterpret_cast<const char *>(&W), sizeof(W));
+}
+
+static bool
+readWord(std::istream &I, SPIRVWord &W) {
+  I.read(reinterpret_cast<char *>(&W), sizeof(W));
+  return I.good();
+}
+
+// A name comes from a literal string, which fits in one instruction.
+static const SPIRVWord MaxNameSize = 0xFFFF * sizeof(SPIRVWord);
+
+// Check that Size bytes are left in I, if the stream can tell.
+static bool
+hasBytesLeft(std::istream &I, SPIRVWord Size) {
+  auto Pos = I.tellg();
+  if (Pos == std::istream::pos_type(-1))
+    return true;
+  I.seekg(0, std::ios::end);
+  auto End = I.tellg();
+  I.seekg(Pos);
+  return End != std::istream::pos_type(-1) &&
+      static_cast<std::streamoff>(End - Pos) >= Size;
+}
+
+spv_ostream &
+operator<<(spv_ostream &O, const SPIRVModuleIndex &Index) {
+  writeWord(O, IndexMagicNumber);
+  writeWord(O, IndexVersion);
+  writeWord(O, Index.ModuleWordCount);
+  writeWord(O, Index.Bound);
+  writeWord(O, SPIRVSEC_Count);
+  for (auto Offset:Index.SectionOffset)
+    writeWord(O, Offset);
+  writeWord(O, Index.Functions.size());
+  for (auto &F:Index.Functions) {
+    writeWord(O, F.Id);
+    writeWord(O, F.Offset);
+    writeWord(O, F.WordCount);
+    writeWord(O, F.Flags);
+    writeWord(O, F.Name.size());
+    O.write(F.Name.data(), F.Name.size());
+    static const char Padding[sizeof(SPIRVWord)] = {0};
+    O.write(Padding, (sizeof(SPIRVWord) - F.Name.size() % sizeof(SPIRVWord)) %
+        sizeof(SPIRVWord));
+  }
+  return O;
+}
+
+std::istream &
+operator>>(std::istream &I, SPIRVModuleIndex &Index) {
+  Index.clear();
+  SPIRVWord Magic = 0, Version = 0, NumSections = 0, NumFunctions = 0;
+  if (!readWord(I, Magic) || Magic != IndexMagicNumber ||
+      !readWord(I, Version) || Version != IndexVersion ||
+      !readWord(I, Index.ModuleWordCount) || !readWord(I, Index.Bound) ||
+      !readWord(I, NumSections) || NumSections != SPIRVSEC_Count) {
+    I.setstate(std::ios::failbit);
+    return I;
+  }
+  for (auto &Offset:Index.SectionOffset)
+    if (!readWord(I, Offset))
+      return I;
+  if (!readWord(I, NumFunctions))
+    return I;
+  for (SPIRVWord J = 0; J != NumFunctions; ++J) {
+    SPIRVModuleIndex::FunctionInfo F;
+    SPIRVWord NameSize = 0;
+    if (!readWord(I, F.Id) || !readWord(I, F.Offset) ||
+        !readWord(I, F.WordCount) || !readWord(I, F.Flags) ||
+        !readWord(I, NameSize))
+      return I;
+    // Do not trust a corrupt or truncated index with a large allocation.
+    if (NameSize > MaxNameSize || !hasBytesLeft(I, NameSize)) {
+      I.setstate(std::ios::failbit);
+      return I;
+    }
+    F.Name.resize(NameSize);
+    I.read(&F.Name[0], NameSize);
+    I.ignore((sizeof(SPIRVWord) - NameSize % sizeof(SPIRVWord)) %
+        sizeof(SPIRVWord));
+    if (!I.good())
+      return I;
+    SPIRVDBG(spvdbgs() << "[SPIRVModuleIndex] function " << F.Name << " id "
+        << F.Id << " offset " << F.Offset << '\n');
+    Index.Functions.push_back(F);
+  }
+  return I;
+}
+
+}
@@ -0,0 +1,145 @@
+//===- SPIRVIndex.h - Random-access index of SPIR-V binaries ----*- C++ -*-===//
+//
+//                     The LLVM/SPIRV Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2014 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+/// \file
+///
+/// This file defines the random-access index of a SPIR-V binary. The index
+/// records the word offsets of the module-scope sections and of every
+/// function, so that a reader can seek to the functions it needs and decode
+/// only those.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SPIRVINDEX_HPP_
+#define SPIRVINDEX_HPP_
+
+#include "SPIRVEnum.h"
+#include "SPIRVUtil.h"
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace SPIRV{
+
+class SPIRVModule;
+
+/// Logical sections of a SPIR-V module in encoding order.
+enum SPIRVModuleSectionKind {
+  SPIRVSEC_Capability,
+  SPIRVSEC_Extension,
+  SPIRVSEC_ExtInstImport,
+  SPIRVSEC_MemoryModel,
+  SPIRVSEC_EntryPoint,
+  SPIRVSEC_ExecutionMode,
+  SPIRVSEC_Debug,
+  SPIRVSEC_Annotation,
+  SPIRVSEC_Global,
+  SPIRVSEC_Function,
+  SPIRVSEC_Count
+};
+
+/// Index of a SPIR-V binary. All offsets are in words from the start of the
+/// module, i.e. the magic number is at offset 0.
+///
+/// The index is serialized as a sequence of words in the byte order of the
+/// host, like the SPIR-V binary:
+///   magic, version, module word count, id bound,
+///   number of sections, section offsets,
+///   number of functions, and for each function
+///     id, offset, word count, flags, name length in bytes, name bytes
+///     padded with zeros to a word boundary.
+class SPIRVModuleIndex {
+public:
+  enum FunctionFlag {
+    FuncEntryPoint = 0x1,
+    FuncExport = 0x2,
+  };
+
+  struct FunctionInfo {
+    FunctionInfo():Id(SPIRVID_INVALID), Offset(0), WordCount(0), Flags(0){}
+    SPIRVId Id;
+    SPIRVWord Offset;
+    SPIRVWord WordCount;
+    SPIRVWord Flags;
+    std::string Name;
+  };
+
+  SPIRVModuleIndex();
+
+  SPIRVWord getModuleWordCount() const { return ModuleWordCount;}
+  SPIRVWord getBound() const { return Bound;}
+  SPIRVWord getSectionOffset(SPIRVModuleSectionKind S) const {
+    return SectionOffset[S];
+  }
+  const std::vector<FunctionInfo> &getFunctions() const { return Functions;}
+  /// \returns the function with linkage or entry point name \p Name, or
+  /// nullptr if there is no such function.
+  const FunctionInfo *getFunction(const std::string &Name) const;
+
+  void setModuleWordCount(SPIRVWord Count) { ModuleWordCount = Count;}
+  void setBound(SPIRVWord TheBound) { Bound = TheBound;}
+  void setSectionOffset(SPIRVModuleSectionKind S, SPIRVWord Offset) {
+    SectionOffset[S] = Offset;
+  }
+  void addFunction(const FunctionInfo &Info) { Functions.push_back(Info);}
+  void clear();
+
+  friend spv_ostream &operator<<(spv_ostream &O, const SPIRVModuleIndex &Index);
+  friend std::istream &operator>>(std::istream &I, SPIRVModuleIndex &Index);
+
+private:
+  SPIRVWord ModuleWordCount;
+  SPIRVWord Bound;
+  SPIRVWord SectionOffset[SPIRVSEC_Count];
+  std::vector<FunctionInfo> Functions;
+};
+
+/// Encodes \p M to \p O like operator<<. If \p Index is not null and the
+/// binary format is used, records the offsets of the encoded sections and
+/// functions in \p Index while encoding.
+void encodeSPIRVModule(spv_ostream &O, SPIRVModule &M,
+    SPIRVModuleIndex *Index);
+
+/// Decodes the SPIR-V binary in \p I described by \p Index into \p M. The
+/// module-scope sections are always decoded. The body of a function is only
+/// decoded if \p DecodeBody returns true for it, otherwise the function is
+/// decoded as a declaration and its body is not read.
+/// \returns false if the index does not match the binary.
+bool decodeSPIRVModule(std::istream &I, SPIRVModule &M,
+    const SPIRVModuleIndex &Index,
+    std::function<bool(const SPIRVModuleIndex::FunctionInfo &)> DecodeBody);
+
+}
+
+#endif
@@ -129,6 +129,13 @@ public:
   std::vector<SPIRVType*> getOperandTypes();
   static std::vector<SPIRVType*> getOperandTypes(
       const std::vector<SPIRVValue *> &Ops);
+  /// Calls \p Func with a reference to each id operand of the instruction,
+  /// which may be used to replace the operand. The result type is not
+  /// included.
+  /// \returns false if the operands of the instruction are not known.
+  virtual bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    return false;
+  }
 
   void setParent(SPIRVBasicBlock *);
   void setScope(SPIRVEntry *);
@@ -151,6 +158,17 @@ public:
       *Kind = static_cast<SPIRVFPRoundingModeKind>(V);
     return Found;
   }
+  /// \param Mask a combination of FPFastMathModeMask flags.
+  void addFPFastMathMode(SPIRVWord Mask) {
+    addDecorate(DecorationFPFastMathMode, Mask);
+  }
+  bool hasFPFastMathMode(SPIRVWord *Mask = nullptr) {
+    SPIRVWord V;
+    auto Found = hasDecorate(DecorationFPFastMathMode, 0, &V);
+    if (Found && Mask)
+      *Mask = V;
+    return Found;
+  }
   bool isSaturatedConversion() {
     return hasDecorate(DecorationSaturatedConversion) ||
         OpCode == OpSatConvertSToU ||
@@ -336,6 +354,13 @@ public:
     return getOpValue(I + getOperandOffset());
   }
 
+  virtual bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    for (size_t I = 0, E = Ops.size(); I < E; ++I)
+      if (!isOperandLiteral(I))
+        Func(Ops[I]);
+    return true;
+  }
+
   bool hasExecScope() const {
     return SPIRV::hasExecScope(OpCode);
   }
@@ -490,6 +515,11 @@ public:
       return std::vector<SPIRVEntry*>(1, V);
     return std::vector<SPIRVEntry*>();
   }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    for (auto &I:Initializer)
+      Func(I);
+    return true;
+  }
 protected:
   void validate() const {
     SPIRVValue::validate();
@@ -531,6 +561,11 @@ public:
 
   SPIRVValue *getSrc() const { return getValue(ValId);}
   SPIRVValue *getDst() const { return getValue(PtrId);}
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(PtrId);
+    Func(ValId);
+    return true;
+  }
 protected:
   void setAttr() {
     setHasNoType();
@@ -581,6 +616,10 @@ public:
       PtrId(SPIRVID_INVALID){}
 
   SPIRVValue *getSrc() const { return Module->get<SPIRVValue>(PtrId);}
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(PtrId);
+    return true;
+  }
 
 protected:
   void setWordCount(SPIRVWord TheWordCount) {
@@ -697,6 +736,9 @@ public:
   SPIRVInstNoOperand():SPIRVInstruction(TheOpCode){
     setAttr();
   }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    return true;
+  }
 protected:
   void setAttr() {
     setHasNoId();
@@ -726,6 +768,10 @@ public:
   SPIRVValue *getReturnValue() const {
     return getValue(ReturnValueId);
   }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(ReturnValueId);
+    return true;
+  }
 protected:
   void setAttr() {
     setHasNoId();
@@ -755,6 +801,10 @@ public:
   SPIRVValue *getTargetLabel() const {
     return getValue(TargetLabelId);
   }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(TargetLabelId);
+    return true;
+  }
 protected:
   _SPIRV_DEF_ENCDEC1(TargetLabelId)
   void validate()const {
@@ -801,6 +851,12 @@ public:
   SPIRVLabel *getFalseLabel() const {
     return get<SPIRVLabel>(FalseLabelId);
   }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(ConditionId);
+    Func(TrueLabelId);
+    Func(FalseLabelId);
+    return true;
+  }
 protected:
   void setWordCount(SPIRVWord TheWordCount) {
     SPIRVEntry::setWordCount(TheWordCount);
@@ -849,6 +905,11 @@ public:
     WordCount = Pairs.size() + FixedWordCount;
     validate();
   }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    for (auto &I:Pairs)
+      Func(I);
+    return true;
+  }
   void foreachPair(std::function<void(SPIRVValue *, SPIRVBasicBlock *,
       size_t)> Func) {
     for (size_t I = 0, E = Pairs.size()/2; I != E; ++I) {
@@ -967,6 +1028,12 @@ public:
   SPIRVValue *getCondition() { return getValue(Condition);}
   SPIRVValue *getTrueValue() { return getValue(Op1);}
   SPIRVValue *getFalseValue() { return getValue(Op2);}
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Condition);
+    Func(Op1);
+    Func(Op2);
+    return true;
+  }
 protected:
   _SPIRV_DEF_ENCDEC5(Type, Id, Condition, Op1, Op2)
   void validate()const {
@@ -1009,6 +1076,10 @@ public:
 
   SPIRVId getMergeBlock() { return MergeBlock; }
   SPIRVWord getSelectionControl() { return SelectionControl; }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(MergeBlock);
+    return true;
+  }
 
   _SPIRV_DEF_ENCDEC2(MergeBlock, SelectionControl)
 
@@ -1039,6 +1110,11 @@ public:
   SPIRVId getMergeBlock() { return MergeBlock; }
   SPIRVId getContinueTarget() { return ContinueTarget; }
   SPIRVWord getLoopControl() { return LoopControl; }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(MergeBlock);
+    Func(ContinueTarget);
+    return true;
+  }
   _SPIRV_DEF_ENCDEC3(MergeBlock, ContinueTarget, LoopControl)
 
 protected:
@@ -1083,6 +1159,14 @@ public:
   size_t getLiteralsCount() const { return getSelect()->getType()->getBitWidth() / (sizeof(SPIRVWord) * 8);}
   size_t getPairSize() const { return getLiteralsCount() + 1; }
   size_t getNumPairs() const { return Pairs.size()/getPairSize();}
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Select);
+    Func(Default);
+    for (size_t I = getLiteralsCount(), E = Pairs.size(); I < E;
+        I += getPairSize())
+      Func(Pairs[I]);
+    return true;
+  }
   void foreachPair(std::function<void(LiteralTy, SPIRVBasicBlock *)> Func)
     const {
     unsigned PairSize = getPairSize();
@@ -1135,6 +1219,11 @@ public:
   }
   SPIRVValue *getDividend() const { return getValue(Dividend); }
   SPIRVValue *getDivisor() const { return getValue(Divisor); }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Dividend);
+    Func(Divisor);
+    return true;
+  }
 
   std::vector<SPIRVValue*> getOperands() {
     std::vector<SPIRVId> Operands;
@@ -1176,6 +1265,11 @@ public:
   }
   SPIRVValue *getVector() const { return getValue(Vector); }
   SPIRVValue *getScalar() const { return getValue(Scalar); }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Vector);
+    Func(Scalar);
+    return true;
+  }
 
   std::vector<SPIRVValue*> getOperands() {
     std::vector<SPIRVId> Operands;
@@ -1321,6 +1415,12 @@ public:
   std::vector<SPIRVValue *> getArgumentValues() {
     return getValues(Args);
   }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    for (size_t I = 0, E = Args.size(); I != E; ++I)
+      if (!this->isOperandLiteral(I))
+        Func(Args[I]);
+    return true;
+  }
   std::vector<SPIRVType *> getArgumentValueTypes()const {
     std::vector<SPIRVType *> ArgTypes;
     for (auto &I:Args)
@@ -1347,6 +1447,10 @@ public:
   SPIRVFunction *getFunction()const {
     return get<SPIRVFunction>(FunctionId);
   }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(FunctionId);
+    return SPIRVFunctionCallGeneric::foreachOperandId(Func);
+  }
   _SPIRV_DEF_ENCDEC4(Type, Id, FunctionId, Args)
   void validate()const;
   bool isOperandLiteral(unsigned Index) const { return false;}
@@ -1463,6 +1567,11 @@ public:
   const std::vector<SPIRVValue*> getConstituents() const {
     return getValues(Constituents);
   }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    for (auto &I:Constituents)
+      Func(I);
+    return true;
+  }
 protected:
   void setWordCount(SPIRVWord TheWordCount) {
     SPIRVEntry::setWordCount(TheWordCount);
@@ -1501,6 +1610,10 @@ public:
 
   SPIRVValue *getComposite() { return getValue(Composite);}
   const std::vector<SPIRVWord>& getIndices()const { return Indices;}
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Composite);
+    return true;
+  }
 protected:
   void setWordCount(SPIRVWord TheWordCount) {
     SPIRVEntry::setWordCount(TheWordCount);
@@ -1541,6 +1654,11 @@ public:
   SPIRVValue *getObject() { return getValue(Object);}
   SPIRVValue *getComposite() { return getValue(Composite);}
   const std::vector<SPIRVWord>& getIndices()const { return Indices;}
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Object);
+    Func(Composite);
+    return true;
+  }
 protected:
   void setWordCount(SPIRVWord TheWordCount) {
     SPIRVEntry::setWordCount(TheWordCount);
@@ -1579,6 +1697,10 @@ public:
   SPIRVCopyObject() :SPIRVInstruction(OC), Operand(SPIRVID_INVALID) {}
 
   SPIRVValue *getOperand() { return getValue(Operand); }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Operand);
+    return true;
+  }
 
 protected:
   _SPIRV_DEF_ENCDEC3(Type, Id, Operand)
@@ -1617,6 +1739,11 @@ public:
 
   SPIRVValue *getSource() { return getValue(Source); }
   SPIRVValue *getTarget() { return getValue(Target); }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Target);
+    Func(Source);
+    return true;
+  }
 
 protected:
   void setWordCount(SPIRVWord TheWordCount) {
@@ -1673,6 +1800,12 @@ public:
   SPIRVValue *getSource() { return getValue(Source); }
   SPIRVValue *getTarget() { return getValue(Target); }
   SPIRVValue *getSize() { return getValue(Size); }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Target);
+    Func(Source);
+    Func(Size);
+    return true;
+  }
 
 protected:
   void setWordCount(SPIRVWord TheWordCount) {
@@ -1717,6 +1850,11 @@ public:
 
   SPIRVValue *getVector() { return getValue(VectorId);}
   SPIRVValue *getIndex()const { return getValue(IndexId);}
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(VectorId);
+    Func(IndexId);
+    return true;
+  }
 protected:
   _SPIRV_DEF_ENCDEC4(Type, Id, VectorId, IndexId)
   void validate()const {
@@ -1748,6 +1886,12 @@ public:
   SPIRVValue *getVector() { return getValue(VectorId); }
   SPIRVValue *getIndex()const { return getValue(IndexId); }
   SPIRVValue *getComponent() { return getValue(ComponentId); }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(VectorId);
+    Func(ComponentId);
+    Func(IndexId);
+    return true;
+  }
 protected:
   _SPIRV_DEF_ENCDEC5(Type, Id, VectorId, ComponentId, IndexId)
     void validate()const {
@@ -1783,6 +1927,11 @@ public:
   SPIRVValue *getVector1() { return getValue(Vector1);}
   SPIRVValue *getVector2() { return getValue(Vector2);}
   const std::vector<SPIRVWord>& getComponents()const { return Components;}
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Vector1);
+    Func(Vector2);
+    return true;
+  }
 protected:
   void setWordCount(SPIRVWord TheWordCount) {
     SPIRVEntry::setWordCount(TheWordCount);
@@ -1832,6 +1981,12 @@ public:
   SPIRVValue *getExecScope() const { return getValue(ExecScope); }
   SPIRVValue *getMemScope() const { return getValue(MemScope); }
   SPIRVValue *getMemSemantic() const { return getValue(MemSema); }
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(ExecScope);
+    Func(MemScope);
+    Func(MemSema);
+    return true;
+  }
   std::vector<SPIRVValue *> getOperands() {
     std::vector<SPIRVId> Operands;
     Operands.push_back(ExecScope);
@@ -1872,6 +2027,10 @@ public:
   }
   SPIRVValue *getObject() { return getValue(Object); };
   SPIRVWord getSize() { return Size; };
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(Object);
+    return true;
+  }
 protected:
   void validate() const {
     auto Obj = static_cast<SPIRVVariable*>(getValue(Object));
@@ -1918,6 +2077,15 @@ public:
   SPIRVValue *getNumElements()const { return getValue(NumElements);}
   SPIRVValue *getStride()const { return getValue(Stride);}
   SPIRVValue *getEvent()const { return getValue(Event);}
+  bool foreachOperandId(std::function<void(SPIRVId &)> Func) {
+    Func(ExecScope);
+    Func(Destination);
+    Func(Source);
+    Func(NumElements);
+    Func(Stride);
+    Func(Event);
+    return true;
+  }
   std::vector<SPIRVValue *> getOperands() {
     std::vector<SPIRVId> Operands;
     Operands.push_back(Destination);
@@ -44,6 +44,7 @@
 #include "SPIRVValue.h"
 #include "SPIRVExtInst.h"
 #include "SPIRVFunction.h"
+#include "SPIRVIndex.h"
 #include "SPIRVInstruction.h"
 #include "SPIRVStream.h"
 
@@ -53,7 +54,8 @@
 
 namespace SPIRV{
 
-SPIRVModule::SPIRVModule():AutoAddCapability(true), ValidateCapability(false)
+SPIRVModule::SPIRVModule():AutoAddCapability(true), ValidateCapability(false),
+    SkipFunctionBodies(false)
 {}
 
 SPIRVModule::~SPIRVModule()
@@ -89,6 +91,8 @@ public:
   // Module query functions
   SPIRVAddressingModelKind getAddressingModel() { return AddrModel;}
   SPIRVExtInstSetKind getBuiltinSet(SPIRVId SetId) const;
+  SPIRVValue *getConstant(unsigned I) const { return ConstVec[I];}
+  SPIRVType *getType(unsigned I) const { return TypeVec[I];}
   const SPIRVCapMap &getCapability() const { return CapMap; }
   bool hasCapability(SPIRVCapabilityKind Cap) const {
     return CapMap.find(Cap) != CapMap.end();
@@ -119,6 +123,8 @@ public:
     return get<SPIRVFunction>(Loc->second[I]);
   }
   unsigned getNumFunctions() const { return FuncVec.size();}
+  unsigned getNumConstants() const { return ConstVec.size();}
+  unsigned getNumTypes() const { return TypeVec.size();}
   unsigned getNumVariables() const { return VariableVec.size();}
   SourceLanguage getSourceLanguage(SPIRVWord * Ver = nullptr) const {
     if (Ver)
@@ -185,6 +191,9 @@ public:
   virtual SPIRVFunction *addFunction(SPIRVTypeFunction *, SPIRVId);
   virtual SPIRVEntry *replaceForward(SPIRVForward *, SPIRVEntry *);
   virtual void eraseInstruction(SPIRVInstruction *, SPIRVBasicBlock *);
+  virtual void eraseBasicBlock(SPIRVBasicBlock *);
+  virtual void eraseFunction(SPIRVFunction *);
+  virtual void eraseValue(SPIRVValue *);
 
   // Type creation functions
   template<class T> T * addType(T *Ty);
@@ -315,6 +324,12 @@ public:
   // I/O functions
   friend spv_ostream & operator<<(spv_ostream &O, SPIRVModule& M);
   friend std::istream & operator>>(std::istream &I, SPIRVModule& M);
+  friend void encodeSPIRVModule(spv_ostream &O, SPIRVModule &M,
+      SPIRVModuleIndex *Index);
+  friend bool decodeSPIRVModule(std::istream &I, SPIRVModule &M,
+      const SPIRVModuleIndex &Index,
+      std::function<bool(const SPIRVModuleIndex::FunctionInfo &)> DecodeBody);
+  void decodeHeader(SPIRVDecoder &Decoder);
 
 private:
   SPIRVErrorLog ErrLog;
@@ -375,6 +390,7 @@ private:
   std::map<unsigned, SPIRVConstant*> LiteralMap;
 
   void layoutEntry(SPIRVEntry* Entry);
+  void forgetEntry(SPIRVEntry* Entry);
 };
 
 SPIRVModuleImpl::~SPIRVModuleImpl() {
@@ -798,6 +814,8 @@ SPIRVModuleImpl::addSampledImageType(SPIRVTypeImage *T) {
   return addType(new SPIRVTypeSampledImage(this, getId(), T));
 }
 
+// A pointer member refers to a type not emitted yet only on a cycle of
+// struct references. Each such pointer type is forward declared once.
 void SPIRVModuleImpl::createForwardPointers() {
   std::unordered_set<SPIRVId> Seen;
 
@@ -815,7 +833,7 @@ void SPIRVModuleImpl::createForwardPointers() {
       if (!MemberTy->isTypePointer()) continue;
       auto Ptr = static_cast<SPIRVTypePointer *>(MemberTy);
 
-      if (Seen.find(Ptr->getId()) == Seen.end()) {
+      if (Seen.insert(Ptr->getId()).second) {
         ForwardPointerVec.push_back(new SPIRVTypeForwardPointer(
             this, Ptr, Ptr->getPointerStorageClass()));
       }
@@ -893,12 +911,80 @@ SPIRVModuleImpl::replaceForward(SPIRVForward *Forward, SPIRVEntry *Entry) {
 
 void
 SPIRVModuleImpl::eraseInstruction(SPIRVInstruction *I, SPIRVBasicBlock *BB) {
-  SPIRVId Id = I->getId();
   BB->eraseInstruction(I);
-  auto Loc = IdEntryMap.find(Id);
-  assert(Loc != IdEntryMap.end());
-  IdEntryMap.erase(Loc);
-  delete I;
+  forgetEntry(I);
+}
+
+void
+SPIRVModuleImpl::eraseBasicBlock(SPIRVBasicBlock *BB) {
+  for (size_t I = 0, E = BB->getNumInst(); I != E; ++I)
+    forgetEntry(BB->getInst(I));
+  BB->getParent()->eraseBasicBlock(BB);
+  forgetEntry(BB);
+}
+
+void
+SPIRVModuleImpl::eraseFunction(SPIRVFunction *F) {
+  for (auto &I:EntryPointSet)
+    assert(!I.second.count(F->getId()) && "Cannot erase entry point");
+  for (size_t I = 0, E = F->getNumBasicBlock(); I != E; ++I) {
+    auto BB = F->getBasicBlock(I);
+    for (size_t J = 0, JE = BB->getNumInst(); J != JE; ++J)
+      forgetEntry(BB->getInst(J));
+    forgetEntry(BB);
+  }
+  for (size_t I = 0, E = F->getNumArguments(); I != E; ++I)
+    forgetEntry(F->getArgument(I));
+  forgetEntry(F);
+}
+
+void
+SPIRVModuleImpl::eraseValue(SPIRVValue *V) {
+  assert((isConstantOpCode(V->getOpCode()) ||
+      (V->getOpCode() == OpVariable &&
+       !static_cast<SPIRVVariable *>(V)->getParent())) &&
+      "Not a module scope value");
+  forgetEntry(V);
+}
+
+// Removes the entry from the id map, the logical layout of the module, its
+// name and decorations, then deletes it.
+void
+SPIRVModuleImpl::forgetEntry(SPIRVEntry *E) {
+  if (E->hasId()) {
+    SPIRVId Id = E->getId();
+    auto Loc = IdEntryMap.find(Id);
+    assert(Loc != IdEntryMap.end() && Loc->second == E);
+    IdEntryMap.erase(Loc);
+    NamedId.erase(Id);
+    for (auto I = DecorateSet.begin(); I != DecorateSet.end();) {
+      if ((*I)->getTargetId() == Id)
+        I = DecorateSet.erase(I);
+      else
+        ++I;
+    }
+    for (auto &I:GroupDecVec)
+      I->eraseTarget(Id);
+  } else
+    EntryNoId.erase(E);
+
+  auto OC = E->getOpCode();
+  if (OC == OpFunction)
+    FuncVec.erase(std::remove(FuncVec.begin(), FuncVec.end(), E),
+        FuncVec.end());
+  else if (OC == OpVariable)
+    VariableVec.erase(std::remove(VariableVec.begin(), VariableVec.end(), E),
+        VariableVec.end());
+  else if (isConstantOpCode(OC)) {
+    ConstVec.erase(std::remove(ConstVec.begin(), ConstVec.end(), E),
+        ConstVec.end());
+    for (auto I = LiteralMap.begin(), IE = LiteralMap.end(); I != IE; ++I)
+      if (I->second == E) {
+        LiteralMap.erase(I);
+        break;
+      }
+  }
+  delete E;
 }
 
 SPIRVValue *
@@ -1271,7 +1357,7 @@ class TopologicalSort {
   SPIRVConstantVector ConstIntVec;
   SPIRVTypeVec TypeVec;
   SPIRVConstAndVarVec ConstAndVarVec;
-  const SPIRVForwardPointerVec& ForwardPointerVec;
+  std::unordered_set<SPIRVEntry *> ForwardPointers;
   EntryStateMapTy EntryStateMap;
 
   friend spv_ostream & operator<<(spv_ostream &O, const TopologicalSort &S);
@@ -1287,13 +1373,8 @@ class TopologicalSort {
       return;
     State = Discovered;
     for (SPIRVEntry *Op : E->getNonLiteralOperands()) {
-      auto Comp = [&Op](SPIRVTypeForwardPointer *FwdPtr) {
-        return FwdPtr->getPointer() == Op;
-      };
       // Skip forward referenced pointers
-      if (Op->getOpCode() == OpTypePointer &&
-          find_if(ForwardPointerVec.begin(), ForwardPointerVec.end(), Comp) !=
-          ForwardPointerVec.end())
+      if (Op->getOpCode() == OpTypePointer && ForwardPointers.count(Op))
         continue;
       visit(Op);
     }
@@ -1317,11 +1398,12 @@ public:
                   const SPIRVConstantVector &_ConstVec,
                   const SPIRVVariableVec &_VariableVec,
                   const SPIRVForwardPointerVec &_ForwardPointerVec) :
-  ForwardPointerVec(_ForwardPointerVec),
   EntryStateMap([](SPIRVEntry* a, SPIRVEntry* b) -> bool {
                   return a->getId() < b->getId();
                 })
   {
+    for (auto *FwdPtr : _ForwardPointerVec)
+      ForwardPointers.insert(FwdPtr->getPointer());
     // Collect entries for sorting
     for (auto *T : _TypeVec)
       EntryStateMap[T] = DFSState::Unvisited;
@@ -1344,10 +1426,40 @@ operator<< (spv_ostream &O, const TopologicalSort &S) {
   return O;
 }
 
+// Returns the position of the output stream in words.
+static SPIRVWord
+getWordPos(spv_ostream &O) {
+#ifdef _SPIRV_LLVM_API
+  return O.tell() / sizeof(SPIRVWord);
+#else
+  return static_cast<SPIRVWord>(O.tellp()) / sizeof(SPIRVWord);
+#endif
+}
+
 spv_ostream &
 operator<< (spv_ostream &O, SPIRVModule &M) {
+  encodeSPIRVModule(O, M, nullptr);
+  return O;
+}
+
+void
+encodeSPIRVModule(spv_ostream &O, SPIRVModule &M, SPIRVModuleIndex *Index) {
   SPIRVModuleImpl &MI = *static_cast<SPIRVModuleImpl*>(&M);
 
+  // Offsets are only meaningful for the binary format.
+  if (SPIRVUseTextFormat)
+    Index = nullptr;
+  SPIRVWord Start = 0;
+  if (Index) {
+    Index->clear();
+    Index->setBound(MI.NextId);
+    Start = getWordPos(O);
+  }
+  auto MarkSection = [&](SPIRVModuleSectionKind S) {
+    if (Index)
+      Index->setSectionOffset(S, getWordPos(O) - Start);
+  };
+
   SPIRVEncoder Encoder(O);
   Encoder << MagicNumber
           << MI.SPIRVVersion
@@ -1356,28 +1468,35 @@ operator<< (spv_ostream &O, SPIRVModule &M) {
           << MI.InstSchema;
   O << SPIRVNL();
 
+  MarkSection(SPIRVSEC_Capability);
   for (auto &I:MI.CapMap)
     O << *I.second;
 
+  MarkSection(SPIRVSEC_Extension);
   for (auto &I:M.getExtension()) {
     assert(!I.empty() && "Invalid extension");
     O << SPIRVExtension(&M, I);
   }
 
+  MarkSection(SPIRVSEC_ExtInstImport);
   for (auto &I:MI.IdBuiltinMap)
     O <<  SPIRVExtInstImport(&M, I.first, SPIRVBuiltinSetNameMap::map(I.second));
 
+  MarkSection(SPIRVSEC_MemoryModel);
   O << SPIRVMemoryModel(&M);
 
+  MarkSection(SPIRVSEC_EntryPoint);
   for (auto &I:MI.EntryPointVec)
     for (auto &II:I.second)
       O << SPIRVEntryPoint(&M, I.first, II,
           M.get<SPIRVFunction>(II)->getName());
 
+  MarkSection(SPIRVSEC_ExecutionMode);
   for (auto &I:MI.EntryPointVec)
     for (auto &II:I.second)
       MI.get<SPIRVFunction>(II)->encodeExecutionModes(O);
 
+  MarkSection(SPIRVSEC_Debug);
   O << MI.StringVec;
 
   for (auto &I:M.getSourceExtension()) {
@@ -1399,16 +1518,37 @@ operator<< (spv_ostream &O, SPIRVModule &M) {
       M.getEntry(I)->encodeName(O);
   }
 
-  O << MI.MemberNameVec
-    << MI.DecGroupVec
+  O << MI.MemberNameVec;
+  MarkSection(SPIRVSEC_Annotation);
+  O << MI.DecGroupVec
     << MI.DecorateSet
-    << MI.GroupDecVec
-    << MI.ForwardPointerVec
+    << MI.GroupDecVec;
+  MarkSection(SPIRVSEC_Global);
+  O << MI.ForwardPointerVec
     << TopologicalSort(MI.TypeVec, MI.ConstVec, MI.VariableVec,
                        MI.ForwardPointerVec)
-    << SPIRVNL()
-    << MI.FuncVec;
-  return O;
+    << SPIRVNL();
+  MarkSection(SPIRVSEC_Function);
+  for (auto F:MI.FuncVec) {
+    SPIRVModuleIndex::FunctionInfo Info;
+    if (Index) {
+      Info.Id = F->getId();
+      Info.Offset = getWordPos(O) - Start;
+    }
+    O << *F;
+    if (!Index)
+      continue;
+    Info.WordCount = getWordPos(O) - Start - Info.Offset;
+    Info.Name = F->getName();
+    if (F->getLinkageType() == LinkageTypeExport)
+      Info.Flags |= SPIRVModuleIndex::FuncExport;
+    for (auto &EPS:MI.EntryPointSet)
+      if (EPS.second.count(F->getId()))
+        Info.Flags |= SPIRVModuleIndex::FuncEntryPoint;
+    Index->addFunction(Info);
+  }
+  if (Index)
+    Index->setModuleWordCount(getWordPos(O) - Start);
 }
 
 template<class T>
@@ -1479,30 +1619,35 @@ void SPIRVModuleImpl::addUnknownStructField(SPIRVTypeStruct *Struct, unsigned I,
   UnknownStructFieldMap[Struct].push_back(std::make_pair(I, ID));
 }
 
-std::istream &
-operator>> (std::istream &I, SPIRVModule &M) {
-  SPIRVDecoder Decoder(I, M);
-  SPIRVModuleImpl &MI = *static_cast<SPIRVModuleImpl*>(&M);
+void
+SPIRVModuleImpl::decodeHeader(SPIRVDecoder &Decoder) {
   // Disable automatic capability filling.
-  MI.setAutoAddCapability(false);
+  setAutoAddCapability(false);
 
   SPIRVWord Magic;
   Decoder >> Magic;
   assert(Magic == MagicNumber && "Invalid magic number");
 
-  Decoder >> MI.SPIRVVersion;
-  assert(MI.SPIRVVersion <= SPV_VERSION && "Unsupported SPIRV version number");
+  Decoder >> SPIRVVersion;
+  assert(SPIRVVersion <= SPV_VERSION && "Unsupported SPIRV version number");
 
   SPIRVWord Generator = 0;
   Decoder >> Generator;
-  MI.GeneratorId = Generator >> 16;
-  MI.GeneratorVer = Generator & 0xFFFF;
+  GeneratorId = Generator >> 16;
+  GeneratorVer = Generator & 0xFFFF;
 
   // Bound for Id
-  Decoder >> MI.NextId;
+  Decoder >> NextId;
 
-  Decoder >> MI.InstSchema;
-  assert(MI.InstSchema == SPIRVISCH_Default && "Unsupported instruction schema");
+  Decoder >> InstSchema;
+  assert(InstSchema == SPIRVISCH_Default && "Unsupported instruction schema");
+}
+
+std::istream &
+operator>> (std::istream &I, SPIRVModule &M) {
+  SPIRVDecoder Decoder(I, M);
+  SPIRVModuleImpl &MI = *static_cast<SPIRVModuleImpl*>(&M);
+  MI.decodeHeader(Decoder);
 
   while (Decoder.getWordCountAndOpCode()) {
     SPIRVEntry *Entry = Decoder.getEntry();
@@ -1516,6 +1661,66 @@ operator>> (std::istream &I, SPIRVModule &M) {
   return I;
 }
 
+bool
+decodeSPIRVModule(std::istream &I, SPIRVModule &M,
+    const SPIRVModuleIndex &Index,
+    std::function<bool(const SPIRVModuleIndex::FunctionInfo &)> DecodeBody) {
+  SPIRVModuleImpl &MI = *static_cast<SPIRVModuleImpl*>(&M);
+  auto &ErrLog = MI.getErrorLog();
+  if (!ErrLog.checkError(!SPIRVUseTextFormat, SPIRVEC_InvalidModuleIndex,
+      "Text format cannot be indexed"))
+    return false;
+
+  // Reject an index written for a different binary.
+  auto Start = I.tellg();
+  I.seekg(0, std::ios::end);
+  auto Size = static_cast<uint64_t>(I.tellg() - Start);
+  I.seekg(Start);
+  if (!ErrLog.checkError(Size == uint64_t(Index.getModuleWordCount()) *
+      sizeof(SPIRVWord), SPIRVEC_InvalidModuleIndex, "Module size mismatch"))
+    return false;
+
+  SPIRVDecoder Decoder(I, M);
+  MI.decodeHeader(Decoder);
+  if (!ErrLog.checkError(MI.NextId == Index.getBound(),
+      SPIRVEC_InvalidModuleIndex, "Id bound mismatch"))
+    return false;
+
+  auto getPos = [&](SPIRVWord Offset) {
+    return Start + std::streamoff(uint64_t(Offset) * sizeof(SPIRVWord));
+  };
+  auto FuncPos = getPos(Index.getSectionOffset(SPIRVSEC_Function));
+  while (I.tellg() < FuncPos && Decoder.getWordCountAndOpCode()) {
+    SPIRVEntry *Entry = Decoder.getEntry();
+    if (Entry != nullptr)
+      M.add(Entry);
+  }
+
+  for (auto &F:Index.getFunctions()) {
+    bool Body = DecodeBody(F);
+    SPIRVDBG(spvdbgs() << "[decodeSPIRVModule] " << (Body ? "decode " :
+        "declare ") << F.Name << '\n');
+    I.seekg(getPos(F.Offset));
+    MI.setSkipFunctionBodies(!Body);
+    if (!ErrLog.checkError(Decoder.getWordCountAndOpCode() &&
+        Decoder.OpCode == OpFunction, SPIRVEC_InvalidModuleIndex,
+        "No function at offset of " + F.Name)) {
+      MI.setSkipFunctionBodies(false);
+      return false;
+    }
+    SPIRVEntry *Entry = Decoder.getEntry();
+    if (Entry != nullptr)
+      M.add(Entry);
+  }
+  MI.setSkipFunctionBodies(false);
+  I.seekg(getPos(Index.getModuleWordCount()));
+
+  MI.optimizeDecorates();
+  MI.resolveUnknownStructFields();
+  MI.createForwardPointers();
+  return true;
+}
+
 SPIRVModule *
 SPIRVModule::createSPIRVModule() {
   return new SPIRVModuleImpl;
@@ -101,6 +101,7 @@ public:
     return static_cast<T*>(getEntry(Id));}
   virtual SPIRVEntry *getEntry(SPIRVId) const = 0;
   virtual bool hasDebugInfo() const = 0;
+  bool isSkippingFunctionBodies() const { return SkipFunctionBodies;}
 
   // Error handling functions
   virtual SPIRVErrorLog &getErrorLog() = 0;
@@ -111,6 +112,7 @@ public:
   virtual const SPIRVCapMap &getCapability() const = 0;
   virtual bool hasCapability(SPIRVCapabilityKind) const = 0;
   virtual SPIRVExtInstSetKind getBuiltinSet(SPIRVId) const = 0;
+  virtual SPIRVValue *getConstant(unsigned) const = 0;
   virtual SPIRVFunction *getEntryPoint(SPIRVExecutionModelKind, unsigned) const
     = 0;
   virtual std::set<std::string> &getExtension() = 0;
@@ -118,10 +120,13 @@ public:
   virtual SPIRVVariable *getVariable(unsigned) const = 0;
   virtual SPIRVMemoryModelKind getMemoryModel() const = 0;
   virtual unsigned getNumFunctions() const = 0;
+  virtual unsigned getNumConstants() const = 0;
   virtual unsigned getNumEntryPoints(SPIRVExecutionModelKind) const = 0;
+  virtual unsigned getNumTypes() const = 0;
   virtual unsigned getNumVariables() const = 0;
   virtual SourceLanguage getSourceLanguage(SPIRVWord *) const = 0;
   virtual std::set<std::string> &getSourceExtension() = 0;
+  virtual SPIRVType *getType(unsigned) const = 0;
   virtual SPIRVValue *getValue(SPIRVId TheId)const = 0;
   virtual std::vector<SPIRVValue *> getValues(const std::vector<SPIRVId>&)const
       = 0;
@@ -147,6 +152,8 @@ public:
   virtual void optimizeDecorates() = 0;
   virtual void setAutoAddCapability(bool E){ AutoAddCapability = E;}
   virtual void setValidateCapability(bool E){ ValidateCapability = E;}
+  /// Decode functions as declarations, i.e. without reading their bodies.
+  virtual void setSkipFunctionBodies(bool E){ SkipFunctionBodies = E;}
   virtual void setGeneratorId(unsigned short) = 0;
   virtual void setGeneratorVer(unsigned short) = 0;
   virtual void resolveUnknownStructFields() = 0;
@@ -189,6 +196,9 @@ public:
       SPIRVId Id = SPIRVID_INVALID) = 0;
   virtual SPIRVEntry *replaceForward(SPIRVForward *, SPIRVEntry *) = 0;
   virtual void eraseInstruction(SPIRVInstruction *, SPIRVBasicBlock *) = 0;
+  virtual void eraseBasicBlock(SPIRVBasicBlock *) = 0;
+  virtual void eraseFunction(SPIRVFunction *) = 0;
+  virtual void eraseValue(SPIRVValue *) = 0;
 
   // Type creation functions
   virtual SPIRVTypeArray *addArrayType(SPIRVType *, SPIRVConstant *) = 0;
@@ -327,6 +337,7 @@ public:
 protected:
   bool AutoAddCapability;
   bool ValidateCapability;
+  bool SkipFunctionBodies;
 };
 
 class SPIRVDbgInfo {
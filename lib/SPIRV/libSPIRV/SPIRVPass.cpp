@@ -0,0 +1,705 @@
+//===- SPIRVPass.cpp - SPIR-V Module Passes ---------------------*- C++ -*-===//
+//
+//                     The LLVM/SPIRV Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2014 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+/// \file
+///
+/// This file implements the SPIR-V pass manager and the cleanup passes run
+/// on translated modules.
+///
+//===----------------------------------------------------------------------===//
+
+#include "SPIRVPass.h"
+#include "SPIRVBasicBlock.h"
+#include "SPIRVDebug.h"
+#include "SPIRVFunction.h"
+#include "SPIRVInstruction.h"
+#include "SPIRVModule.h"
+#include "SPIRVStream.h"
+#include "SPIRVType.h"
+#include "SPIRVValue.h"
+
+#include <algorithm>
+
+namespace SPIRV{
+
+bool
+SPIRVPassManager::run(SPIRVModule *M) {
+  bool Changed = false;
+  for (unsigned Iter = 0; Iter < MaxIter; ++Iter) {
+    bool IterChanged = false;
+    for (auto &P:Passes) {
+      SPIRVDBG(spvdbgs() << "[SPIRVPassManager] run " << P->getName() << '\n');
+      IterChanged |= P->runOnModule(M);
+    }
+    if (!IterChanged)
+      break;
+    Changed = true;
+  }
+  return Changed;
+}
+
+SPIRVUseMap::SPIRVUseMap(SPIRVModule *M):Complete(true) {
+  for (unsigned I = 0, E = M->getNumTypes(); I != E; ++I)
+    addUses(M->getType(I));
+  for (unsigned I = 0, E = M->getNumConstants(); I != E; ++I)
+    addUses(M->getConstant(I));
+  for (unsigned I = 0, E = M->getNumVariables(); I != E; ++I)
+    addUses(M->getVariable(I));
+  for (unsigned I = 0, E = M->getNumFunctions(); I != E; ++I) {
+    auto F = M->getFunction(I);
+    for (size_t J = 0, JE = F->getNumBasicBlock(); J != JE; ++J) {
+      auto BB = F->getBasicBlock(J);
+      for (size_t K = 0, KE = BB->getNumInst(); K != KE; ++K)
+        addUses(BB->getInst(K));
+    }
+  }
+}
+
+bool
+SPIRVUseMap::foreachOperand(SPIRVEntry *E,
+    std::function<void(SPIRVId)> Func) {
+  if (E->isInst())
+    return static_cast<SPIRVInstruction *>(E)->foreachOperandId(
+        [&](SPIRVId &Id){ Func(Id);});
+  // Operands of specialization constant operations are not tracked.
+  if (E->getOpCode() == OpSpecConstantComposite ||
+      E->getOpCode() == OpSpecConstantOp)
+    return false;
+  for (auto Op:E->getNonLiteralOperands())
+    if (Op && Op->hasId())
+      Func(Op->getId());
+  return true;
+}
+
+size_t
+SPIRVUseMap::getNumUses(SPIRVId Id) const {
+  auto Loc = Users.find(Id);
+  if (Loc == Users.end())
+    return 0;
+  return Loc->second.size();
+}
+
+std::vector<SPIRVEntry *>
+SPIRVUseMap::getUsers(SPIRVId Id) const {
+  auto Loc = Users.find(Id);
+  if (Loc == Users.end())
+    return std::vector<SPIRVEntry *>();
+  return Loc->second;
+}
+
+void
+SPIRVUseMap::addUses(SPIRVEntry *User) {
+  if (!foreachOperand(User, [&](SPIRVId Id){
+    Users[Id].push_back(User);
+  }))
+    Complete = false;
+}
+
+void
+SPIRVUseMap::removeUses(SPIRVEntry *User) {
+  foreachOperand(User, [&](SPIRVId Id){
+    auto Loc = Users.find(Id);
+    if (Loc == Users.end())
+      return;
+    auto &V = Loc->second;
+    auto I = std::find(V.begin(), V.end(), User);
+    if (I != V.end())
+      V.erase(I);
+    if (V.empty())
+      Users.erase(Loc);
+  });
+}
+
+void
+SPIRVUseMap::replaceAllUsesWith(SPIRVId From, SPIRVId To) {
+  auto Loc = Users.find(From);
+  if (Loc == Users.end())
+    return;
+  auto FromUsers = std::move(Loc->second);
+  Users.erase(Loc);
+  for (auto U:FromUsers) {
+    assert(U->isInst() && "Only operands of instructions can be replaced");
+    static_cast<SPIRVInstruction *>(U)->foreachOperandId([&](SPIRVId &Id){
+      if (Id == From)
+        Id = To;
+    });
+  }
+  auto &ToUsers = Users[To];
+  ToUsers.insert(ToUsers.end(), FromUsers.begin(), FromUsers.end());
+}
+
+// Get the instructions of a function, so that they can be erased while
+// iterating over them.
+static std::vector<SPIRVInstruction *>
+getInstructions(SPIRVFunction *F) {
+  std::vector<SPIRVInstruction *> Insts;
+  for (size_t I = 0, E = F->getNumBasicBlock(); I != E; ++I) {
+    auto BB = F->getBasicBlock(I);
+    for (size_t J = 0, JE = BB->getNumInst(); J != JE; ++J)
+      Insts.push_back(BB->getInst(J));
+  }
+  return Insts;
+}
+
+static std::vector<SPIRVId>
+getOperandIds(SPIRVInstruction *I) {
+  std::vector<SPIRVId> Ids;
+  I->foreachOperandId([&](SPIRVId &Id){ Ids.push_back(Id);});
+  return Ids;
+}
+
+static bool
+isEntryPoint(SPIRVModule *M, SPIRVId Id) {
+  for (unsigned EM = ExecutionModelVertex; EM <= ExecutionModelKernel; ++EM)
+    if (M->isEntryPoint(static_cast<SPIRVExecutionModelKind>(EM), Id))
+      return true;
+  return false;
+}
+
+static bool
+isExported(SPIRVEntry *E) {
+  return E->hasLinkageType() && E->getLinkageType() == LinkageTypeExport;
+}
+
+static bool
+hasNoSideEffect(SPIRVInstruction *I) {
+  if (!I->hasId())
+    return false;
+  auto OC = I->getOpCode();
+  if (isBinaryShiftLogicalBitwiseOpCode(OC) ||
+      isCmpOpCode(OC) ||
+      isCvtOpCode(OC) ||
+      isGenericNegateOpCode(OC) ||
+      isAccessChainOpCode(OC))
+    return true;
+  switch (OC) {
+  case OpVariable:
+  case OpPtrAccessChain:
+  case OpInBoundsPtrAccessChain:
+  case OpPtrCastToGeneric:
+  case OpGenericCastToPtr:
+  case OpLogicalNot:
+  case OpIsNan:
+  case OpIsInf:
+  case OpIsFinite:
+  case OpIsNormal:
+  case OpSignBitSet:
+  case OpAny:
+  case OpAll:
+  case OpSelect:
+  case OpPhi:
+  case OpCompositeConstruct:
+  case OpCompositeExtract:
+  case OpCompositeInsert:
+  case OpCopyObject:
+  case OpVectorExtractDynamic:
+  case OpVectorInsertDynamic:
+  case OpVectorShuffle:
+  case OpVectorTimesScalar:
+    return true;
+  default:
+    return false;
+  }
+}
+
+class SPIRVCopyPropagation: public SPIRVPass {
+public:
+  const char *getName() const { return "copy-propagation";}
+  bool runOnModule(SPIRVModule *M);
+private:
+  // Get the id of the value copied by an instruction.
+  // Returns SPIRVID_INVALID if the instruction is not a copy.
+  static SPIRVId getCopiedId(SPIRVInstruction *I);
+};
+
+SPIRVId
+SPIRVCopyPropagation::getCopiedId(SPIRVInstruction *I) {
+  auto OC = I->getOpCode();
+  if (OC == OpCopyObject)
+    return static_cast<SPIRVCopyObject *>(I)->getOperand()->getId();
+  if (OC != OpBitcast)
+    return SPIRVID_INVALID;
+  auto Op = static_cast<SPIRVUnary *>(I)->getOperand(0);
+  if (Op->getType() == I->getType())
+    return Op->getId();
+  // A bitcast back to the original type.
+  if (Op->getOpCode() == OpBitcast) {
+    auto Src = static_cast<SPIRVUnary *>(Op)->getOperand(0);
+    if (Src->getType() == I->getType())
+      return Src->getId();
+  }
+  return SPIRVID_INVALID;
+}
+
+bool
+SPIRVCopyPropagation::runOnModule(SPIRVModule *M) {
+  SPIRVUseMap Uses(M);
+  if (!Uses.isComplete())
+    return false;
+  bool Changed = false;
+  for (unsigned I = 0, E = M->getNumFunctions(); I != E; ++I) {
+    for (auto Inst:getInstructions(M->getFunction(I))) {
+      auto Id = getCopiedId(Inst);
+      if (Id == SPIRVID_INVALID)
+        continue;
+      Uses.replaceAllUsesWith(Inst->getId(), Id);
+      Uses.removeUses(Inst);
+      M->eraseInstruction(Inst, Inst->getParent());
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+class SPIRVConstantFolding: public SPIRVPass {
+public:
+  const char *getName() const { return "constant-folding";}
+  bool runOnModule(SPIRVModule *M);
+};
+
+static unsigned
+getScalarBitWidth(SPIRVType *Ty) {
+  return Ty->isTypeBool() ? 1 : Ty->getBitWidth();
+}
+
+static uint64_t
+getMask(unsigned Width) {
+  return Width >= 64 ? ~0ULL : (1ULL << Width) - 1;
+}
+
+static int64_t
+signExtend(uint64_t V, unsigned Width) {
+  if (Width >= 64)
+    return static_cast<int64_t>(V);
+  return static_cast<int64_t>(V << (64 - Width)) >> (64 - Width);
+}
+
+// Get the value of a scalar integer or boolean constant zero extended from
+// its bit width.
+// Returns false if the value is not such a constant.
+static bool
+getConstantValue(SPIRVValue *V, uint64_t &Val) {
+  switch (V->getOpCode()) {
+  case OpConstantTrue:
+    Val = 1;
+    return true;
+  case OpConstantFalse:
+    Val = 0;
+    return true;
+  case OpConstant:
+    if (!V->getType()->isTypeInt())
+      return false;
+    Val = static_cast<SPIRVConstant *>(V)->getZExtIntValue() &
+        getMask(V->getType()->getBitWidth());
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Fold an instruction whose operands of bit width W have constant values.
+// Returns false if the instruction cannot be folded or the result is
+// undefined.
+static bool
+foldInst(Op OC, unsigned W, const std::vector<uint64_t> &Ops, uint64_t &R) {
+  uint64_t A = Ops[0];
+  uint64_t B = Ops.size() > 1 ? Ops[1] : 0;
+  int64_t SA = signExtend(A, W);
+  int64_t SB = signExtend(B, W);
+  switch (OC) {
+  case OpSNegate:
+    R = -A;
+    break;
+  case OpNot:
+    R = ~A;
+    break;
+  case OpLogicalNot:
+    R = !A;
+    break;
+  case OpIAdd:
+    R = A + B;
+    break;
+  case OpISub:
+    R = A - B;
+    break;
+  case OpIMul:
+    R = A * B;
+    break;
+  case OpUDiv:
+  case OpUMod:
+    if (!B)
+      return false;
+    R = OC == OpUDiv ? A / B : A % B;
+    break;
+  case OpSDiv:
+  case OpSRem:
+  case OpSMod: {
+    if (!B || (SB == -1 && SA == signExtend(1ULL << (W - 1), W)))
+      return false;
+    if (OC == OpSDiv) {
+      R = SA / SB;
+      break;
+    }
+    int64_t Rem = SA % SB;
+    // The result of OpSMod has the sign of the divisor.
+    if (OC == OpSMod && Rem != 0 && (Rem < 0) != (SB < 0))
+      Rem += SB;
+    R = Rem;
+    break;
+  }
+  case OpShiftLeftLogical:
+  case OpShiftRightLogical:
+  case OpShiftRightArithmetic:
+    if (B >= W)
+      return false;
+    if (OC == OpShiftLeftLogical)
+      R = A << B;
+    else if (OC == OpShiftRightLogical)
+      R = A >> B;
+    else
+      R = SA >> B;
+    break;
+  case OpBitwiseAnd:
+    R = A & B;
+    break;
+  case OpBitwiseOr:
+    R = A | B;
+    break;
+  case OpBitwiseXor:
+    R = A ^ B;
+    break;
+  case OpLogicalAnd:
+    R = A && B;
+    break;
+  case OpLogicalOr:
+    R = A || B;
+    break;
+  case OpIEqual:
+  case OpLogicalEqual:
+    R = A == B;
+    break;
+  case OpINotEqual:
+  case OpLogicalNotEqual:
+    R = A != B;
+    break;
+  case OpULessThan:
+    R = A < B;
+    break;
+  case OpULessThanEqual:
+    R = A <= B;
+    break;
+  case OpUGreaterThan:
+    R = A > B;
+    break;
+  case OpUGreaterThanEqual:
+    R = A >= B;
+    break;
+  case OpSLessThan:
+    R = SA < SB;
+    break;
+  case OpSLessThanEqual:
+    R = SA <= SB;
+    break;
+  case OpSGreaterThan:
+    R = SA > SB;
+    break;
+  case OpSGreaterThanEqual:
+    R = SA >= SB;
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
+bool
+SPIRVConstantFolding::runOnModule(SPIRVModule *M) {
+  bool Changed = false;
+  for (unsigned I = 0, E = M->getNumFunctions(); I != E; ++I) {
+    for (auto Inst:getInstructions(M->getFunction(I))) {
+      auto OC = Inst->getOpCode();
+      if (!isBinaryShiftLogicalBitwiseOpCode(OC) && !isCmpOpCode(OC) &&
+          OC != OpSNegate && OC != OpNot && OC != OpLogicalNot)
+        continue;
+      auto Ty = Inst->getType();
+      if (!Ty->isTypeInt() && !Ty->isTypeBool())
+        continue;
+      std::vector<uint64_t> Ops;
+      SPIRVType *OpTy = nullptr;
+      bool IsConst = true;
+      for (auto Id:getOperandIds(Inst)) {
+        auto Op = M->getValue(Id);
+        uint64_t V = 0;
+        if (!getConstantValue(Op, V)) {
+          IsConst = false;
+          break;
+        }
+        // The shift operand of a shift may be wider or narrower than its
+        // base, so the width is taken from the first operand.
+        if (Ops.empty())
+          OpTy = Op->getType();
+        Ops.push_back(V);
+      }
+      uint64_t R = 0;
+      if (!IsConst || Ops.empty() || Ops.size() > 2 ||
+          !foldInst(OC, getScalarBitWidth(OpTy), Ops, R))
+        continue;
+      R &= getMask(getScalarBitWidth(Ty));
+
+      // The constant takes over the id of the instruction, so that uses of
+      // the instruction need not be updated.
+      auto Id = Inst->getId();
+      M->eraseInstruction(Inst, Inst->getParent());
+      if (Ty->isTypeBool()) {
+        if (R)
+          M->addConstant(new SPIRVConstantTrue(M, Ty, Id));
+        else
+          M->addConstant(new SPIRVConstantFalse(M, Ty, Id));
+      } else
+        M->addConstant(new SPIRVConstant(M, Ty, Id, R));
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+class SPIRVDeadInstElim: public SPIRVPass {
+public:
+  const char *getName() const { return "dead-inst-elim";}
+  bool runOnModule(SPIRVModule *M);
+};
+
+bool
+SPIRVDeadInstElim::runOnModule(SPIRVModule *M) {
+  SPIRVUseMap Uses(M);
+  if (!Uses.isComplete())
+    return false;
+  std::vector<SPIRVInstruction *> WorkList;
+  for (unsigned I = 0, E = M->getNumFunctions(); I != E; ++I)
+    for (auto Inst:getInstructions(M->getFunction(I)))
+      if (hasNoSideEffect(Inst) && !Uses.getNumUses(Inst->getId()))
+        WorkList.push_back(Inst);
+
+  bool Changed = !WorkList.empty();
+  while (!WorkList.empty()) {
+    auto Inst = WorkList.back();
+    WorkList.pop_back();
+    auto Ops = getOperandIds(Inst);
+    std::sort(Ops.begin(), Ops.end());
+    Ops.erase(std::unique(Ops.begin(), Ops.end()), Ops.end());
+    Uses.removeUses(Inst);
+    M->eraseInstruction(Inst, Inst->getParent());
+    // Operands which lost their last use may be dead now.
+    for (auto Id:Ops) {
+      SPIRVEntry *Def = nullptr;
+      if (Uses.getNumUses(Id) || !M->exist(Id, &Def) || !Def->isInst())
+        continue;
+      auto DefInst = static_cast<SPIRVInstruction *>(Def);
+      if (DefInst->getParent() && hasNoSideEffect(DefInst))
+        WorkList.push_back(DefInst);
+    }
+  }
+  return Changed;
+}
+
+class SPIRVDeadGlobalElim: public SPIRVPass {
+public:
+  const char *getName() const { return "dead-global-elim";}
+  bool runOnModule(SPIRVModule *M);
+};
+
+bool
+SPIRVDeadGlobalElim::runOnModule(SPIRVModule *M) {
+  SPIRVUseMap Uses(M);
+  if (!Uses.isComplete())
+    return false;
+  bool Changed = false;
+  bool IterChanged = false;
+  do {
+    IterChanged = false;
+    for (unsigned I = M->getNumFunctions(); I > 0; --I) {
+      auto F = M->getFunction(I - 1);
+      if (Uses.getNumUses(F->getId()) || isEntryPoint(M, F->getId()) ||
+          isExported(F))
+        continue;
+      for (auto Inst:getInstructions(F))
+        Uses.removeUses(Inst);
+      M->eraseFunction(F);
+      IterChanged = true;
+    }
+    for (unsigned I = M->getNumVariables(); I > 0; --I) {
+      auto V = M->getVariable(I - 1);
+      if (Uses.getNumUses(V->getId()) || isExported(V))
+        continue;
+      Uses.removeUses(V);
+      M->eraseValue(V);
+      IterChanged = true;
+    }
+    for (unsigned I = M->getNumConstants(); I > 0; --I) {
+      auto C = M->getConstant(I - 1);
+      auto OC = C->getOpCode();
+      if (Uses.getNumUses(C->getId()) ||
+          (OC >= OpSpecConstantTrue && OC <= OpSpecConstantOp))
+        continue;
+      Uses.removeUses(C);
+      M->eraseValue(C);
+      IterChanged = true;
+    }
+    Changed |= IterChanged;
+  } while (IterChanged);
+  return Changed;
+}
+
+class SPIRVMergeBlocks: public SPIRVPass {
+public:
+  const char *getName() const { return "merge-blocks";}
+  bool runOnModule(SPIRVModule *M);
+private:
+  // Merge the successor of BB into BB if BB unconditionally branches to it
+  // and is its only predecessor.
+  // Returns true if the successor is merged.
+  static bool mergeSuccessor(SPIRVModule *M, SPIRVUseMap &Uses,
+      SPIRVBasicBlock *BB);
+};
+
+bool
+SPIRVMergeBlocks::mergeSuccessor(SPIRVModule *M, SPIRVUseMap &Uses,
+    SPIRVBasicBlock *BB) {
+  auto NumInst = BB->getNumInst();
+  if (!NumInst)
+    return false;
+  auto Term = BB->getInst(NumInst - 1);
+  if (Term->getOpCode() != OpBranch)
+    return false;
+  // Keep the block structure declared by a merge instruction.
+  if (NumInst > 1) {
+    auto MergeOC = BB->getInst(NumInst - 2)->getOpCode();
+    if (MergeOC == OpLoopMerge || MergeOC == OpSelectionMerge)
+      return false;
+  }
+  auto Target = static_cast<SPIRVBranch *>(Term)->getTargetLabel();
+  if (!Target->isLabel() || Target == BB)
+    return false;
+  auto Succ = static_cast<SPIRVBasicBlock *>(Target);
+  auto F = BB->getParent();
+  if (Succ->getParent() != F || F->getBasicBlock(0) == Succ)
+    return false;
+  // Other than the branch, the label may only be used as the incoming block
+  // of phis in the successors of Succ.
+  for (auto U:Uses.getUsers(Succ->getId()))
+    if (U != Term && U->getOpCode() != OpPhi)
+      return false;
+
+  // The phis of Succ have a single incoming value.
+  while (Succ->getNumInst() && Succ->getInst(0)->getOpCode() == OpPhi) {
+    auto Phi = Succ->getInst(0);
+    auto Ops = getOperandIds(Phi);
+    if (Ops.empty() || Ops[0] == Phi->getId())
+      return false;
+    Uses.replaceAllUsesWith(Phi->getId(), Ops[0]);
+    Uses.removeUses(Phi);
+    M->eraseInstruction(Phi, Succ);
+  }
+  Uses.replaceAllUsesWith(Succ->getId(), BB->getId());
+  Uses.removeUses(Term);
+  M->eraseInstruction(Term, BB);
+  BB->takeInstructions(Succ);
+  M->eraseBasicBlock(Succ);
+  return true;
+}
+
+bool
+SPIRVMergeBlocks::runOnModule(SPIRVModule *M) {
+  SPIRVUseMap Uses(M);
+  if (!Uses.isComplete())
+    return false;
+  bool Changed = false;
+  for (unsigned I = 0, E = M->getNumFunctions(); I != E; ++I) {
+    auto F = M->getFunction(I);
+    for (size_t J = 0; J < F->getNumBasicBlock();) {
+      if (mergeSuccessor(M, Uses, F->getBasicBlock(J)))
+        Changed = true;
+      else
+        ++J;
+    }
+  }
+  return Changed;
+}
+
+SPIRVPass *
+createSPIRVCopyPropagation() {
+  return new SPIRVCopyPropagation();
+}
+
+SPIRVPass *
+createSPIRVConstantFolding() {
+  return new SPIRVConstantFolding();
+}
+
+SPIRVPass *
+createSPIRVDeadInstElim() {
+  return new SPIRVDeadInstElim();
+}
+
+SPIRVPass *
+createSPIRVDeadGlobalElim() {
+  return new SPIRVDeadGlobalElim();
+}
+
+SPIRVPass *
+createSPIRVMergeBlocks() {
+  return new SPIRVMergeBlocks();
+}
+
+void
+addSPIRVCleanupPasses(SPIRVPassManager &PM) {
+  PM.add(createSPIRVCopyPropagation());
+  PM.add(createSPIRVConstantFolding());
+  PM.add(createSPIRVDeadInstElim());
+  PM.add(createSPIRVMergeBlocks());
+  PM.add(createSPIRVDeadGlobalElim());
+}
+
+bool
+OptimizeSPIRV(std::istream &IS, spv_ostream &OS, std::string &ErrMsg) {
+  std::unique_ptr<SPIRVModule> M(SPIRVModule::createSPIRVModule());
+  IS >> *M;
+  if (M->getError(ErrMsg) != SPIRVEC_Success)
+    return false;
+  SPIRVPassManager PM;
+  addSPIRVCleanupPasses(PM);
+  PM.run(M.get());
+  OS << *M;
+  return M->getError(ErrMsg) == SPIRVEC_Success;
+}
+
+}
@@ -0,0 +1,125 @@
+//===- SPIRVPass.h - SPIR-V Module Pass Infrastructure ----------*- C++ -*-===//
+//
+//                     The LLVM/SPIRV Translator
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+// Copyright (c) 2014 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal with the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimers.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimers in the documentation
+// and/or other materials provided with the distribution.
+// Neither the names of Advanced Micro Devices, Inc., nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// Software without specific prior written permission.
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS WITH
+// THE SOFTWARE.
+//
+/// \file
+///
+/// This file defines the infrastructure for passes which transform a SPIR-V
+/// module in place, and the cleanup passes run on translated modules.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef SPIRVPASS_HPP_
+#define SPIRVPASS_HPP_
+
+#include "SPIRVEntry.h"
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace SPIRV{
+
+class SPIRVModule;
+
+/// Base class of a pass transforming a SPIR-V module.
+class SPIRVPass {
+public:
+  virtual ~SPIRVPass(){}
+  virtual const char *getName() const = 0;
+  /// \returns true if the module is changed.
+  virtual bool runOnModule(SPIRVModule *M) = 0;
+};
+
+/// Owns a pipeline of passes and runs it on a module.
+class SPIRVPassManager {
+public:
+  SPIRVPassManager(unsigned TheMaxIter = 4):MaxIter(TheMaxIter){}
+  /// Takes ownership of the pass.
+  void add(SPIRVPass *P) { Passes.emplace_back(P);}
+  /// Runs the pipeline repeatedly until it does not change the module or the
+  /// maximum number of iterations is reached.
+  /// \returns true if the module is changed.
+  bool run(SPIRVModule *M);
+private:
+  std::vector<std::unique_ptr<SPIRVPass>> Passes;
+  unsigned MaxIter;
+};
+
+/// Maps the id of each entry to the entries using it as an operand. Names,
+/// decorations and entry points are not considered uses.
+class SPIRVUseMap {
+public:
+  explicit SPIRVUseMap(SPIRVModule *M);
+  /// \returns false if the operands of some instruction are unknown, in which
+  /// case an id without recorded uses may still be used.
+  bool isComplete() const { return Complete;}
+  size_t getNumUses(SPIRVId Id) const;
+  /// \returns users of the id. A user is listed once for each use.
+  std::vector<SPIRVEntry *> getUsers(SPIRVId Id) const;
+  /// Records the operands of an entry as used by it.
+  void addUses(SPIRVEntry *User);
+  /// Removes the uses by an entry, which must be done before erasing it.
+  void removeUses(SPIRVEntry *User);
+  /// Rewrites all operands referring to From to refer to To.
+  void replaceAllUsesWith(SPIRVId From, SPIRVId To);
+
+private:
+  bool foreachOperand(SPIRVEntry *E, std::function<void(SPIRVId)> Func);
+  std::unordered_map<SPIRVId, std::vector<SPIRVEntry *>> Users;
+  bool Complete;
+};
+
+/// Create a pass replacing OpCopyObject and no-op OpBitcast by their operands.
+SPIRVPass *createSPIRVCopyPropagation();
+
+/// Create a pass folding scalar integer and boolean instructions with
+/// constant operands.
+SPIRVPass *createSPIRVConstantFolding();
+
+/// Create a pass erasing unused instructions without side effects.
+SPIRVPass *createSPIRVDeadInstElim();
+
+/// Create a pass erasing unused functions, global variables and constants
+/// which are neither entry points nor exported.
+SPIRVPass *createSPIRVDeadGlobalElim();
+
+/// Create a pass merging a basic block into its single predecessor when the
+/// predecessor unconditionally branches to it.
+SPIRVPass *createSPIRVMergeBlocks();
+
+/// Adds the cleanup passes in the order they should run.
+void addSPIRVCleanupPasses(SPIRVPassManager &PM);
+
+}
+
+#endif
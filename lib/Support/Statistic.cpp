@@ -26,6 +26,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/raw_ostream.h"
@@ -44,6 +45,9 @@ Enabled(
     "stats",
     cl::desc("Enable statistics output from program (available with Asserts)"));
 
+static cl::opt<bool>
+StatsAsJSON("stats-json", cl::desc("Print -stats output as JSON"));
+
 
 namespace {
 /// StatisticInfo - This class is used in a ManagedStatic so that it is created
@@ -53,12 +57,16 @@ class StatisticInfo {
   std::vector<const Statistic*> Stats;
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
+  friend void llvm::PrintStatisticsJSON(raw_ostream &OS);
 public:
   ~StatisticInfo();
 
   void addStatistic(const Statistic *S) {
     Stats.push_back(S);
   }
+
+  /// sort - Sort the statistics by name, then by description.
+  void sort();
 };
 }
 
@@ -89,6 +97,17 @@ StatisticInfo::~StatisticInfo() {
   llvm::PrintStatistics();
 }
 
+void StatisticInfo::sort() {
+  std::stable_sort(Stats.begin(), Stats.end(),
+                   [](const Statistic *LHS, const Statistic *RHS) {
+    if (int Cmp = std::strcmp(LHS->getName(), RHS->getName()))
+      return Cmp < 0;
+
+    // Secondary key is the description.
+    return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
+  });
+}
+
 void llvm::EnableStatistics() {
   Enabled.setValue(true);
 }
@@ -110,14 +129,7 @@ void llvm::PrintStatistics(raw_ostream &OS) {
   }
 
   // Sort the fields by name.
-  std::stable_sort(Stats.Stats.begin(), Stats.Stats.end(),
-                   [](const Statistic *LHS, const Statistic *RHS) {
-    if (int Cmp = std::strcmp(LHS->getName(), RHS->getName()))
-      return Cmp < 0;
-
-    // Secondary key is the description.
-    return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
-  });
+  Stats.sort();
 
   // Print out the statistics header...
   OS << "===" << std::string(73, '-') << "===\n"
@@ -136,6 +148,25 @@ void llvm::PrintStatistics(raw_ostream &OS) {
 
 }
 
+void llvm::PrintStatisticsJSON(raw_ostream &OS) {
+  StatisticInfo &Stats = *StatInfo;
+
+  Stats.sort();
+
+  OS << "{\"statistics\": [";
+  for (size_t i = 0, e = Stats.Stats.size(); i != e; ++i) {
+    if (i)
+      OS << ", ";
+    OS << "{\"group\": ";
+    printJSONString(OS, Stats.Stats[i]->getName());
+    OS << ", \"desc\": ";
+    printJSONString(OS, Stats.Stats[i]->getDesc());
+    OS << ", \"value\": " << Stats.Stats[i]->getValue() << '}';
+  }
+  OS << "]}\n";
+  OS.flush();
+}
+
 void llvm::PrintStatistics() {
 #if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
   StatisticInfo &Stats = *StatInfo;
@@ -145,7 +176,10 @@ void llvm::PrintStatistics() {
 
   // Get the stream to write to.
   raw_ostream &OutStream = *CreateInfoOutputFile();
-  PrintStatistics(OutStream);
+  if (StatsAsJSON)
+    PrintStatisticsJSON(OutStream);
+  else
+    PrintStatistics(OutStream);
   delete &OutStream;   // Close the file.
 #else
   // Check if the -stats option is set instead of checking
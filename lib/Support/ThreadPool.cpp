@@ -0,0 +1,259 @@
+//==-- llvm/Support/ThreadPool.cpp - A ThreadPool implementation -*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a crude C++11 based thread pool and the work stealing
+// scheduler behind parallel_for.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/ManagedStatic.h"
+#include <cassert>
+
+#if LLVM_ENABLE_THREADS
+#include <atomic>
+#endif
+
+using namespace llvm;
+
+static ManagedStatic<ThreadPool> DefaultThreadPool;
+
+ThreadPool &llvm::getDefaultThreadPool() {
+  return *DefaultThreadPool;
+}
+
+unsigned llvm::getWorkerThreadCount(unsigned NumThreads) {
+#if LLVM_ENABLE_THREADS
+  if (NumThreads == 0)
+    NumThreads = std::thread::hardware_concurrency();
+  // The calling thread takes part in the parallel algorithms, so the pool
+  // needs one thread fewer than the job.
+  return NumThreads > 1 ? NumThreads - 1 : 0;
+#else
+  return 0;
+#endif
+}
+
+size_t llvm::detail::getDefaultGrainSize(const ThreadPool &Pool, size_t N) {
+  // A few chunks per thread keep the stealing rare without leaving threads
+  // idle at the end.
+  size_t NumThreads = Pool.getThreadCount() + 1;
+  return std::max<size_t>(1, N / (NumThreads * 8));
+}
+
+#if LLVM_ENABLE_THREADS
+
+ThreadPool::ThreadPool() : ThreadPool(0) {}
+
+ThreadPool::ThreadPool(unsigned ThreadCount)
+    : ActiveThreads(0), EnableFlag(true) {
+  if (ThreadCount == 0)
+    ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+  Threads.reserve(ThreadCount);
+  for (unsigned I = 0; I < ThreadCount; ++I)
+    Threads.emplace_back([this] { work(); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> LockGuard(QueueLock);
+    EnableFlag = false;
+  }
+  QueueCondition.notify_all();
+  for (auto &Worker : Threads)
+    Worker.join();
+}
+
+void ThreadPool::work() {
+  while (true) {
+    TaskTy Task;
+    {
+      std::unique_lock<std::mutex> LockGuard(QueueLock);
+      QueueCondition.wait(LockGuard,
+                          [&] { return !EnableFlag || !Tasks.empty(); });
+      // Exit only once the queue is drained.
+      if (Tasks.empty())
+        return;
+      ++ActiveThreads;
+      Task = std::move(Tasks.front());
+      Tasks.pop();
+    }
+    Task();
+    bool Idle;
+    {
+      std::unique_lock<std::mutex> LockGuard(QueueLock);
+      --ActiveThreads;
+      Idle = ActiveThreads == 0 && Tasks.empty();
+    }
+    if (Idle)
+      CompletionCondition.notify_all();
+  }
+}
+
+void ThreadPool::asyncImpl(TaskTy Task) {
+  {
+    std::unique_lock<std::mutex> LockGuard(QueueLock);
+    assert(EnableFlag && "Queuing a task during ThreadPool destruction");
+    Tasks.push(std::move(Task));
+  }
+  QueueCondition.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> LockGuard(QueueLock);
+  CompletionCondition.wait(
+      LockGuard, [&] { return ActiveThreads == 0 && Tasks.empty(); });
+}
+
+unsigned ThreadPool::getThreadCount() const {
+  return Threads.size();
+}
+
+namespace {
+/// The indices still to be processed by one thread of a parallel_for.
+struct WorkRange {
+  std::mutex Lock;
+  size_t Begin;
+  size_t End;
+};
+
+/// State of a parallel_for shared between the calling thread and the pool
+/// tasks helping it. Helpers may start after the loop has completed, so it
+/// is reference counted; they then find no work and never call Body.
+struct ParallelForState {
+  ParallelForState(unsigned NumSlots, size_t N, size_t Grain,
+                   std::function<void(size_t, size_t)> Body)
+      : Ranges(new WorkRange[NumSlots]), NumSlots(NumSlots), Remaining(N),
+        Grain(Grain), Body(std::move(Body)) {}
+
+  std::unique_ptr<WorkRange[]> Ranges;
+  unsigned NumSlots;
+  std::atomic<size_t> Remaining;
+  size_t Grain;
+  std::function<void(size_t, size_t)> Body;
+
+  std::mutex DoneLock;
+  std::condition_variable DoneCondition;
+
+  bool takeChunk(unsigned Slot, size_t &B, size_t &E);
+  void run(unsigned Slot);
+};
+} // end anonymous namespace
+
+/// Take the next chunk of the range of \p Slot. If it is empty, steal the
+/// upper half of the range of another slot first. At most one range lock is
+/// held at any time.
+bool ParallelForState::takeChunk(unsigned Slot, size_t &B, size_t &E) {
+  WorkRange &Own = Ranges[Slot];
+  {
+    std::unique_lock<std::mutex> LockGuard(Own.Lock);
+    if (Own.Begin != Own.End) {
+      B = Own.Begin;
+      E = std::min(Own.End, B + Grain);
+      Own.Begin = E;
+      return true;
+    }
+  }
+
+  for (unsigned I = 1; I < NumSlots; ++I) {
+    WorkRange &Victim = Ranges[(Slot + I) % NumSlots];
+    size_t StolenBegin, StolenEnd;
+    {
+      std::unique_lock<std::mutex> LockGuard(Victim.Lock);
+      size_t Size = Victim.End - Victim.Begin;
+      if (Size == 0)
+        continue;
+      if (Size <= Grain) {
+        B = Victim.Begin;
+        E = Victim.End;
+        Victim.Begin = E;
+        return true;
+      }
+      StolenBegin = Victim.Begin + Size / 2;
+      StolenEnd = Victim.End;
+      Victim.End = StolenBegin;
+    }
+    std::unique_lock<std::mutex> LockGuard(Own.Lock);
+    B = StolenBegin;
+    E = std::min(StolenEnd, B + Grain);
+    Own.Begin = E;
+    Own.End = StolenEnd;
+    return true;
+  }
+  return false;
+}
+
+void ParallelForState::run(unsigned Slot) {
+  size_t B, E;
+  while (takeChunk(Slot, B, E)) {
+    Body(B, E);
+    if ((Remaining -= E - B) == 0) {
+      std::unique_lock<std::mutex> LockGuard(DoneLock);
+      DoneCondition.notify_all();
+    }
+  }
+}
+
+void llvm::detail::parallelForImpl(ThreadPool &Pool, size_t Begin, size_t End,
+                                   size_t Grain,
+                                   std::function<void(size_t, size_t)> Body) {
+  if (Begin >= End)
+    return;
+  Grain = std::max<size_t>(Grain, 1);
+  size_t N = End - Begin;
+  size_t NumSlots = std::min<size_t>(Pool.getThreadCount() + 1,
+                                     (N + Grain - 1) / Grain);
+  if (NumSlots <= 1) {
+    for (size_t B = Begin; B < End; B += Grain)
+      Body(B, std::min(End, B + Grain));
+    return;
+  }
+
+  // Hand out equal shares up front; stealing balances uneven work.
+  auto State =
+      std::make_shared<ParallelForState>(NumSlots, N, Grain, std::move(Body));
+  for (size_t S = 0; S < NumSlots; ++S) {
+    State->Ranges[S].Begin = Begin + N * S / NumSlots;
+    State->Ranges[S].End = Begin + N * (S + 1) / NumSlots;
+  }
+  for (unsigned S = 1; S < NumSlots; ++S)
+    Pool.async([State, S] { State->run(S); });
+  State->run(0);
+
+  std::unique_lock<std::mutex> LockGuard(State->DoneLock);
+  State->DoneCondition.wait(LockGuard, [&] { return State->Remaining == 0; });
+}
+
+#else // LLVM_ENABLE_THREADS Disabled
+
+ThreadPool::ThreadPool() {}
+
+ThreadPool::ThreadPool(unsigned ThreadCount) {}
+
+ThreadPool::~ThreadPool() {}
+
+void ThreadPool::asyncImpl(TaskTy Task) {
+  Task();
+}
+
+void ThreadPool::wait() {}
+
+unsigned ThreadPool::getThreadCount() const {
+  return 0;
+}
+
+void llvm::detail::parallelForImpl(ThreadPool &Pool, size_t Begin, size_t End,
+                                   size_t Grain,
+                                   std::function<void(size_t, size_t)> Body) {
+  Grain = std::max<size_t>(Grain, 1);
+  for (size_t B = Begin; B < End; B += Grain)
+    Body(B, std::min(End, B + Grain));
+}
+
+#endif
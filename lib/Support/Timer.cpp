@@ -17,6 +17,7 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
@@ -52,6 +53,10 @@ namespace {
   InfoOutputFilename("info-output-file", cl::value_desc("filename"),
                      cl::desc("File to append -stats and -timer output to"),
                    cl::Hidden, cl::location(getLibSupportInfoOutputFilename()));
+
+  static cl::opt<bool>
+  TimersAsJSON("timers-json",
+               cl::desc("Print -time-passes and other timer reports as JSON"));
 }
 
 // CreateInfoOutputFile - Return a file stream to print our output on.
@@ -187,6 +192,13 @@ void TimeRecord::print(const TimeRecord &Total, raw_ostream &OS) const {
     OS << format("%9" PRId64 "  ", (int64_t)getMemUsed());
 }
 
+void TimeRecord::printJSONValues(raw_ostream &OS) const {
+  OS << format("\"wall\": %.6f, \"user\": %.6f, \"system\": %.6f, "
+               "\"mem\": %" PRId64,
+               getWallTime(), getUserTime(), getSystemTime(),
+               (int64_t)getMemUsed());
+}
+
 
 //===----------------------------------------------------------------------===//
 //   NamedRegionTimer Implementation
@@ -296,7 +308,10 @@ void TimerGroup::removeTimer(Timer &T) {
     return;
   
   raw_ostream *OutStream = CreateInfoOutputFile();
-  PrintQueuedTimers(*OutStream);
+  if (TimersAsJSON)
+    PrintQueuedTimersJSON(*OutStream);
+  else
+    PrintQueuedTimers(*OutStream);
   delete OutStream;   // Close the file.
 }
 
@@ -360,12 +375,41 @@ void TimerGroup::PrintQueuedTimers(raw_ostream &OS) {
   TimersToPrint.clear();
 }
 
-/// print - Print any started timers in this group and zero them.
-void TimerGroup::print(raw_ostream &OS) {
-  sys::SmartScopedLock<true> L(*TimerLock);
+/// PrintQueuedTimersJSON - Print the queued timers as a single line JSON
+/// object, in the same order as PrintQueuedTimers:
+///   {"group": ..., "timers": [{"name": ..., "wall": ..., ...}, ...],
+///    "total": {"wall": ..., ...}}
+void TimerGroup::PrintQueuedTimersJSON(raw_ostream &OS) {
+  std::sort(TimersToPrint.begin(), TimersToPrint.end());
 
-  // See if any of our timers were started, if so add them to TimersToPrint and
-  // reset them.
+  TimeRecord Total;
+  for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i)
+    Total += TimersToPrint[i].first;
+
+  OS << "{\"group\": ";
+  printJSONString(OS, Name);
+  OS << ", \"timers\": [";
+  for (unsigned i = 0, e = TimersToPrint.size(); i != e; ++i) {
+    const std::pair<TimeRecord, std::string> &Entry = TimersToPrint[e-i-1];
+    if (i)
+      OS << ", ";
+    OS << "{\"name\": ";
+    printJSONString(OS, Entry.second);
+    OS << ", ";
+    Entry.first.printJSONValues(OS);
+    OS << '}';
+  }
+  OS << "], \"total\": {";
+  Total.printJSONValues(OS);
+  OS << "}}\n";
+  OS.flush();
+
+  TimersToPrint.clear();
+}
+
+/// queueStartedTimers - Add the started timers of this group to TimersToPrint
+/// and reset them. Return true if there is anything to print.
+bool TimerGroup::queueStartedTimers() {
   for (Timer *T = FirstTimer; T; T = T->Next) {
     if (!T->Started) continue;
     TimersToPrint.push_back(std::make_pair(T->Time, T->Name));
@@ -374,12 +418,30 @@ void TimerGroup::print(raw_ostream &OS) {
     T->Started = 0;
     T->Time = TimeRecord();
   }
+  return !TimersToPrint.empty();
+}
+
+/// print - Print any started timers in this group and zero them.
+void TimerGroup::print(raw_ostream &OS) {
+  sys::SmartScopedLock<true> L(*TimerLock);
 
   // If any timers were started, print the group.
-  if (!TimersToPrint.empty())
+  if (!queueStartedTimers())
+    return;
+  if (TimersAsJSON)
+    PrintQueuedTimersJSON(OS);
+  else
     PrintQueuedTimers(OS);
 }
 
+/// printJSON - Print any started timers in this group as JSON and zero them.
+void TimerGroup::printJSON(raw_ostream &OS) {
+  sys::SmartScopedLock<true> L(*TimerLock);
+
+  if (queueStartedTimers())
+    PrintQueuedTimersJSON(OS);
+}
+
 /// printAll - This static method prints all timers and clears them all out.
 void TimerGroup::printAll(raw_ostream &OS) {
   sys::SmartScopedLock<true> L(*TimerLock);
@@ -387,3 +449,12 @@ void TimerGroup::printAll(raw_ostream &OS) {
   for (TimerGroup *TG = TimerGroupList; TG; TG = TG->Next)
     TG->print(OS);
 }
+
+/// printAllJSON - This static method prints all timers as JSON and clears them
+/// all out.
+void TimerGroup::printAllJSON(raw_ostream &OS) {
+  sys::SmartScopedLock<true> L(*TimerLock);
+
+  for (TimerGroup *TG = TimerGroupList; TG; TG = TG->Next)
+    TG->printJSON(OS);
+}
@@ -0,0 +1,56 @@
+; Function blocks written on other threads must encode forward references
+; exactly like the serial writer: relative value ids that point past the
+; instruction, phis over values defined later, block addresses and calls
+; into functions that come later in the module.
+; RUN: llvm-as < %s > %t.serial.bc
+; RUN: llvm-as -bitcode-write-threads=4 < %s > %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+; RUN: llvm-as -bitcode-write-threads=0 < %s > %t.hw.bc
+; RUN: cmp %t.serial.bc %t.hw.bc
+; RUN: llvm-dis < %t.parallel.bc | FileCheck %s
+
+; CHECK: define i32 @loop(i32 %n)
+; CHECK: %i = phi i32 [ 0, %entry ], [ %next, %body ]
+; CHECK: %next = add i32 %i, 1
+; CHECK: call i32 @later(i32 %next)
+; CHECK: define i8* @addr()
+; CHECK: ret i8* blockaddress(@target, %dest)
+; CHECK: define i32 @later(i32 %x)
+; CHECK: define void @target()
+
+define i32 @loop(i32 %n) {
+entry:
+  br label %head
+
+head:
+  %i = phi i32 [ 0, %entry ], [ %next, %body ]
+  %done = icmp eq i32 %i, %n
+  br i1 %done, label %exit, label %body
+
+body:
+  %next = add i32 %i, 1
+  %c = call i32 @later(i32 %next)
+  br label %head
+
+exit:
+  ret i32 %i
+}
+
+define i8* @addr() {
+entry:
+  ret i8* blockaddress(@target, %dest)
+}
+
+define i32 @later(i32 %x) {
+entry:
+  %a = add i32 %x, 42
+  ret i32 %a
+}
+
+define void @target() {
+entry:
+  br label %dest
+
+dest:
+  ret void
+}
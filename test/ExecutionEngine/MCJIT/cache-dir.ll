@@ -0,0 +1,31 @@
+; RUN: rm -rf %t.cachedir
+; RUN: %lli -cache-dir=%t.cachedir %s | FileCheck %s
+; RUN: ls %t.cachedir | count 1
+
+; A hit uses the stored object. A miss would store a new object, and renaming
+; it over the entry would change the entry's inode.
+; RUN: ls -i %t.cachedir > %t.before
+; RUN: %lli -cache-dir=%t.cachedir %s | FileCheck %s
+; RUN: ls -i %t.cachedir > %t.after
+; RUN: diff %t.before %t.after
+
+; The object is found again by contents, whatever the module is called.
+; RUN: cp %s %t.copy.ll
+; RUN: %lli -cache-dir=%t.cachedir %t.copy.ll | FileCheck %s
+; RUN: ls -i %t.cachedir > %t.after
+; RUN: diff %t.before %t.after
+
+; Other code generation settings need another object.
+; RUN: %lli -cache-dir=%t.cachedir -O0 %s | FileCheck %s
+; RUN: ls %t.cachedir | count 2
+
+; CHECK: Hello World
+
+@.LC0 = internal global [12 x i8] c"Hello World\00"
+
+declare i32 @puts(i8*)
+
+define i32 @main() {
+  %r = call i32 @puts(i8* getelementptr ([12 x i8]* @.LC0, i64 0, i64 0))
+  ret i32 0
+}
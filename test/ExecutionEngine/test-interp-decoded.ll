@@ -0,0 +1,133 @@
+; RUN: %lli -force-interpreter=true %s | FileCheck %s
+
+; CHECK: fib 610
+; CHECK: swap 3 4
+; CHECK: sum 45
+; CHECK: avg 2.500000
+; CHECK: min -7 max 9
+
+%pair = type { i32, [4 x i16] }
+
+@fmt.fib = internal constant [8 x i8] c"fib %d\0A\00"
+@fmt.swap = internal constant [12 x i8] c"swap %d %d\0A\00"
+@fmt.sum = internal constant [8 x i8] c"sum %d\0A\00"
+@fmt.avg = internal constant [8 x i8] c"avg %f\0A\00"
+@fmt.minmax = internal constant [18 x i8] c"min %d max %d\0A\00\00\00\00"
+@values = internal global [4 x i32] [i32 3, i32 -7, i32 9, i32 0]
+
+declare i32 @printf(i8*, ...)
+
+define i32 @fib(i32 %n) {
+entry:
+  %small = icmp slt i32 %n, 2
+  br i1 %small, label %done, label %recurse
+
+recurse:
+  %n1 = sub i32 %n, 1
+  %n2 = sub i32 %n, 2
+  %f1 = call i32 @fib(i32 %n1)
+  %f2 = call i32 @fib(i32 %n2)
+  %f = add i32 %f1, %f2
+  ret i32 %f
+
+done:
+  ret i32 %n
+}
+
+; The PHI nodes read each other on the back edge, so they have to be
+; updated together.
+define void @swap(i32 %count) {
+entry:
+  br label %loop
+
+loop:
+  %a = phi i32 [ 4, %entry ], [ %b, %loop ]
+  %b = phi i32 [ 3, %entry ], [ %a, %loop ]
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %i.next = add i32 %i, 1
+  %more = icmp ult i32 %i.next, %count
+  br i1 %more, label %loop, label %exit
+
+exit:
+  %f = getelementptr [12 x i8]* @fmt.swap, i64 0, i64 0
+  call i32 (i8*, ...)* @printf(i8* %f, i32 %a, i32 %b)
+  ret void
+}
+
+; Stores through struct and array indices, then sums them back up.
+define i32 @sum() {
+entry:
+  %p = alloca %pair, i32 2
+  br label %fill
+
+fill:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %fill ]
+  %s = trunc i64 %i to i16
+  %slot = getelementptr %pair* %p, i32 1, i32 1, i64 %i
+  store i16 %s, i16* %slot
+  %i.next = add i64 %i, 1
+  %filled = icmp eq i64 %i.next, 4
+  br i1 %filled, label %read, label %fill
+
+read:
+  %j = phi i32 [ 0, %fill ], [ %j.next, %read ]
+  %acc = phi i32 [ 39, %fill ], [ %acc.next, %read ]
+  %elt = getelementptr %pair* %p, i64 1, i32 1, i32 %j
+  %v = load i16* %elt
+  %v32 = sext i16 %v to i32
+  %acc.next = add i32 %acc, %v32
+  %j.next = add i32 %j, 1
+  %read.all = icmp sge i32 %j.next, 4
+  br i1 %read.all, label %exit, label %read
+
+exit:
+  ret i32 %acc.next
+}
+
+define double @avg() {
+entry:
+  %a = fadd float 1.5, 2.0
+  %b = fmul float %a, 2.0
+  %c = fsub float %b, 2.0
+  %d = fpext float %c to double
+  %e = fdiv double %d, 2.0
+  ret double %e
+}
+
+define i32 @main() {
+entry:
+  %fib = call i32 @fib(i32 15)
+  %f0 = getelementptr [8 x i8]* @fmt.fib, i64 0, i64 0
+  call i32 (i8*, ...)* @printf(i8* %f0, i32 %fib)
+
+  call void @swap(i32 8)
+
+  %sum = call i32 @sum()
+  %f1 = getelementptr [8 x i8]* @fmt.sum, i64 0, i64 0
+  call i32 (i8*, ...)* @printf(i8* %f1, i32 %sum)
+
+  %avg = call double @avg()
+  %f2 = getelementptr [8 x i8]* @fmt.avg, i64 0, i64 0
+  call i32 (i8*, ...)* @printf(i8* %f2, double %avg)
+
+  br label %scan
+
+scan:
+  %k = phi i64 [ 0, %entry ], [ %k.next, %scan ]
+  %min = phi i32 [ 2147483647, %entry ], [ %min.next, %scan ]
+  %max = phi i32 [ -2147483648, %entry ], [ %max.next, %scan ]
+  %p = getelementptr [4 x i32]* @values, i64 0, i64 %k
+  %x = load i32* %p
+  %lt = icmp slt i32 %x, %min
+  %min.next = select i1 %lt, i32 %x, i32 %min
+  %gt = icmp sgt i32 %x, %max
+  %max.next = select i1 %gt, i32 %x, i32 %max
+  %k.next = add i64 %k, 1
+  %done = icmp eq i64 %k.next, 4
+  br i1 %done, label %exit, label %scan
+
+exit:
+  %f3 = getelementptr [18 x i8]* @fmt.minmax, i64 0, i64 0
+  call i32 (i8*, ...)* @printf(i8* %f3, i32 %min.next, i32 %max.next)
+  ret i32 0
+}
@@ -0,0 +1,66 @@
+; RUN: %lli -force-interpreter=true %s | FileCheck %s
+
+; Intrinsics are lowered when they first run.  The call to llvm.fma.f64 never
+; runs, so it does not have to be supported, and the frames of @bits that are
+; suspended in the recursive call resume after the innermost one lowered
+; llvm.ctpop.i32 and llvm.bswap.i32.
+
+; CHECK: bits 9
+; CHECK: swapped 4030201
+; CHECK-NOT: fma
+
+@fmt.bits = internal constant [9 x i8] c"bits %d\0A\00"
+@fmt.swapped = internal constant [12 x i8] c"swapped %x\0A\00"
+@fmt.fma = internal constant [8 x i8] c"fma %f\0A\00"
+
+declare i32 @printf(i8*, ...)
+declare i32 @llvm.ctpop.i32(i32)
+declare i32 @llvm.bswap.i32(i32)
+declare double @llvm.fma.f64(double, double, double)
+
+; Sums the bits set in 1 .. %n.
+define i32 @bits(i32 %n) {
+entry:
+  %zero = icmp eq i32 %n, 0
+  br i1 %zero, label %done, label %recurse
+
+recurse:
+  %n1 = sub i32 %n, 1
+  %rest = call i32 @bits(i32 %n1)
+  %pop = call i32 @llvm.ctpop.i32(i32 %n)
+  %sum = add i32 %rest, %pop
+  ret i32 %sum
+
+done:
+  ret i32 0
+}
+
+define i32 @main() {
+entry:
+  %b = call i32 @bits(i32 6)
+  %fmt.b = getelementptr [9 x i8]* @fmt.bits, i32 0, i32 0
+  call i32 (i8*, ...)* @printf(i8* %fmt.b, i32 %b)
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %x = phi i32 [ 16909060, %entry ], [ %x.swapped, %loop ]
+  %x.swapped = call i32 @llvm.bswap.i32(i32 %x)
+  %i.next = add i32 %i, 1
+  %again = icmp ult i32 %i.next, 3
+  br i1 %again, label %loop, label %print
+
+print:
+  %fmt.s = getelementptr [12 x i8]* @fmt.swapped, i32 0, i32 0
+  call i32 (i8*, ...)* @printf(i8* %fmt.s, i32 %x.swapped)
+  br i1 false, label %dead, label %exit
+
+dead:
+  %f = call double @llvm.fma.f64(double 1.0, double 2.0, double 3.0)
+  %fmt.f = getelementptr [8 x i8]* @fmt.fma, i32 0, i32 0
+  call i32 (i8*, ...)* @printf(i8* %fmt.f, double %f)
+  br label %exit
+
+exit:
+  ret i32 0
+}
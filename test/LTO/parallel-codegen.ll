@@ -0,0 +1,45 @@
+; RUN: llvm-as -o %t.bc %s
+; RUN: llvm-lto -j2 -exported-symbol=foo -exported-symbol=bar -o %t.o %t.bc
+; RUN: llvm-nm %t.o | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-nm %t.o.1 | FileCheck --check-prefix=CHECK1 %s
+
+; The largest function goes to the first object, the rest fills the second.
+; The local symbols used by both objects become hidden global symbols.
+
+; CHECK0: T foo
+; CHECK0: U helper
+; CHECK0: U table
+
+; CHECK1: T bar
+; CHECK1: T helper
+; CHECK1: R table
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@table = internal constant [4 x i32] [i32 1, i32 2, i32 3, i32 5]
+
+define i32 @foo(i32 %x, i32 %y) {
+  %a = mul i32 %x, %y
+  %b = add i32 %a, %x
+  %c = xor i32 %b, %y
+  %d = shl i32 %c, 3
+  %e = call i32 @helper(i32 %d)
+  %i = and i32 %e, 3
+  %p = getelementptr [4 x i32]* @table, i32 0, i32 %i
+  %v = load i32* %p
+  %f = sub i32 %v, %a
+  ret i32 %f
+}
+
+define internal i32 @helper(i32 %x) noinline {
+  %p = getelementptr [4 x i32]* @table, i32 0, i32 1
+  %v = load i32* %p
+  %r = add i32 %x, %v
+  ret i32 %r
+}
+
+define i32 @bar(i32 %x) {
+  %r = call i32 @helper(i32 %x)
+  ret i32 %r
+}
@@ -0,0 +1,30 @@
+@table = global [2 x i32] [i32 1, i32 2]
+@unused_table = global [2 x i32] [i32 3, i32 4]
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @init, i8* null }]
+
+declare i32 @external(i32)
+
+define void @init() {
+  ret void
+}
+
+define i32 @needed(i32 %i) {
+  %c = call i32 @helper(i32 %i)
+  ret i32 %c
+}
+
+define i32 @helper(i32 %i) {
+  %p = getelementptr [2 x i32]* @table, i32 0, i32 %i
+  %v = load i32* %p
+  %e = call i32 @external(i32 %v)
+  ret i32 %e
+}
+
+define i32 @unused(i32 %i) {
+  %p = getelementptr [2 x i32]* @unused_table, i32 0, i32 %i
+  %v = load i32* %p
+  %c = call i32 @unused_external(i32 %v)
+  ret i32 %c
+}
+
+declare i32 @unused_external(i32)
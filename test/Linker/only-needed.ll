@@ -0,0 +1,23 @@
+; RUN: llvm-as %S/Inputs/only-needed.ll -o %t.bc
+; RUN: llvm-link -S -only-needed %s %t.bc | FileCheck %s
+; RUN: llvm-link -S %s %t.bc | FileCheck %s -check-prefix=ALL
+
+; CHECK-DAG: @table = global [2 x i32] [i32 1, i32 2]
+; CHECK-DAG: @llvm.global_ctors = appending global
+; CHECK-DAG: define i32 @kernel(i32 %i)
+; CHECK-DAG: define i32 @needed(i32 %i)
+; CHECK-DAG: define i32 @helper(i32 %i)
+; CHECK-DAG: declare i32 @external(i32)
+; CHECK-DAG: define void @init()
+; CHECK-NOT: unused
+
+; ALL-DAG: @unused_table = global [2 x i32] [i32 3, i32 4]
+; ALL-DAG: define i32 @unused(i32 %i)
+; ALL-DAG: declare i32 @unused_external(i32)
+
+define i32 @kernel(i32 %i) {
+  %c = call i32 @needed(i32 %i)
+  ret i32 %c
+}
+
+declare i32 @needed(i32)
@@ -0,0 +1,24 @@
+; RUN: llvm-as %S/Inputs/basiclink.b.ll -o %t.b.bc
+; RUN: llvm-link -S %s %S/Inputs/basiclink.a.ll %t.b.bc -o %t.serial.ll
+; RUN: llvm-link -S -threads=4 %s %S/Inputs/basiclink.a.ll %t.b.bc -o %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+; RUN: llvm-link -S -threads=0 %s %S/Inputs/basiclink.a.ll %t.b.bc -o %t.hw.ll
+; RUN: diff %t.serial.ll %t.hw.ll
+; RUN: FileCheck %s < %t.parallel.ll
+; RUN: not llvm-link -threads=4 %s %t.missing.bc 2>&1 | FileCheck %s -check-prefix=ERROR
+
+; CHECK: @baz = global i32 0
+; CHECK: define i32 @main()
+; CHECK: define i32* @foo(i32 %x)
+; CHECK: define i32* @bar()
+
+; ERROR: Could not open input file
+; ERROR: error loading file '{{.*}}.missing.bc'
+
+define i32 @main() {
+  %p = call i32* @bar()
+  %v = load i32* %p
+  ret i32 %v
+}
+
+declare i32* @bar()
@@ -0,0 +1,12 @@
+; RUN: opt -instcombine -stats -stats-json -disable-output %s 2>&1 | FileCheck %s
+; REQUIRES: asserts
+
+; CHECK: {"statistics": [{"group": "{{[^"]+}}", "desc": "{{[^"]+}}", "value": {{[0-9]+}}}
+; CHECK: {"group": "instcombine", "desc": "Number of dead inst eliminated", "value": 1}
+; CHECK: ]}{{$}}
+; CHECK-NOT: Statistics Collected
+
+define i32 @f(i32 %x) {
+  %dead = mul i32 %x, 3
+  ret i32 %x
+}
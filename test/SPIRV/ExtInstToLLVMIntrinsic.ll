@@ -0,0 +1,97 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-OCL
+; RUN: llvm-spirv -r -spirv-gen-llvm-intrinsics %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+
+; CHECK-OCL: call spir_func float @_Z3fmafff
+; CHECK-OCL: call spir_func i32 @_Z8popcounti
+
+; CHECK-LLVM-LABEL: define spir_func void @test_fp
+; CHECK-LLVM: call float @llvm.fma.f32(float %a, float %b, float %c)
+; CHECK-LLVM: call float @llvm.fabs.f32(float %a)
+; CHECK-LLVM: call float @llvm.floor.f32(float %a)
+; CHECK-LLVM: call float @llvm.ceil.f32(float %a)
+; CHECK-LLVM: call float @llvm.trunc.f32(float %a)
+; CHECK-LLVM: call float @llvm.rint.f32(float %a)
+; CHECK-LLVM: call float @llvm.copysign.f32(float %a, float %b)
+; CHECK-LLVM: call float @llvm.maxnum.f32(float %a, float %b)
+; CHECK-LLVM: call float @llvm.minnum.f32(float %a, float %b)
+; CHECK-LLVM: call <4 x float> @llvm.fma.v4f32(
+; sqrt keeps the OpenCL builtin since llvm.sqrt differs on negative inputs.
+; CHECK-LLVM: call spir_func float @_Z4sqrtf(float %a)
+; CHECK-LLVM: call <4 x float> @llvm.maxnum.v4f32(
+
+; CHECK-LLVM-LABEL: define spir_func void @test_int
+; CHECK-LLVM: call i32 @llvm.ctpop.i32(i32 %x)
+; CHECK-LLVM: call i32 @llvm.ctlz.i32(i32 %x, i1 false)
+; CHECK-LLVM: call i32 @llvm.cttz.i32(i32 %x, i1 false)
+; CHECK-LLVM: [[AMT:%[0-9a-z.]+]] = and i32 %y, 31
+; CHECK-LLVM: [[REV:%[0-9a-z.]+]] = sub i32 32, [[AMT]]
+; CHECK-LLVM: [[REVAMT:%[0-9a-z.]+]] = and i32 [[REV]], 31
+; CHECK-LLVM: [[SHL:%[0-9a-z.]+]] = shl i32 %x, [[AMT]]
+; CHECK-LLVM: [[SHR:%[0-9a-z.]+]] = lshr i32 %x, [[REVAMT]]
+; CHECK-LLVM: or i32 [[SHL]], [[SHR]]
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+; Function Attrs: nounwind
+define spir_func void @test_fp(float %a, float %b, float %c, <4 x float> %v) #0 {
+entry:
+  %call = call spir_func float @_Z3fmafff(float %a, float %b, float %c) #1
+  %call1 = call spir_func float @_Z4fabsf(float %a) #1
+  %call2 = call spir_func float @_Z5floorf(float %a) #1
+  %call3 = call spir_func float @_Z4ceilf(float %a) #1
+  %call4 = call spir_func float @_Z5truncf(float %a) #1
+  %call5 = call spir_func float @_Z4rintf(float %a) #1
+  %call6 = call spir_func float @_Z8copysignff(float %a, float %b) #1
+  %call7 = call spir_func float @_Z4fmaxff(float %a, float %b) #1
+  %call8 = call spir_func float @_Z4fminff(float %a, float %b) #1
+  %call9 = call spir_func <4 x float> @_Z3fmaDv4_fS_S_(<4 x float> %v, <4 x float> %v, <4 x float> %v) #1
+  %call10 = call spir_func float @_Z4sqrtf(float %a) #1
+  %call11 = call spir_func <4 x float> @_Z4fmaxDv4_ff(<4 x float> %v, float %a) #1
+  ret void
+}
+
+; Function Attrs: nounwind
+define spir_func void @test_int(i32 %x, i32 %y) #0 {
+entry:
+  %call = call spir_func i32 @_Z8popcounti(i32 %x) #1
+  %call1 = call spir_func i32 @_Z3clzi(i32 %x) #1
+  %call2 = call spir_func i32 @_Z3ctzi(i32 %x) #1
+  %call3 = call spir_func i32 @_Z6rotateii(i32 %x, i32 %y) #1
+  ret void
+}
+
+declare spir_func float @_Z3fmafff(float, float, float) #1
+declare spir_func float @_Z4fabsf(float) #1
+declare spir_func float @_Z5floorf(float) #1
+declare spir_func float @_Z4ceilf(float) #1
+declare spir_func float @_Z5truncf(float) #1
+declare spir_func float @_Z4rintf(float) #1
+declare spir_func float @_Z8copysignff(float, float) #1
+declare spir_func float @_Z4fmaxff(float, float) #1
+declare spir_func float @_Z4fminff(float, float) #1
+declare spir_func <4 x float> @_Z3fmaDv4_fS_S_(<4 x float>, <4 x float>, <4 x float>) #1
+declare spir_func float @_Z4sqrtf(float) #1
+declare spir_func <4 x float> @_Z4fmaxDv4_ff(<4 x float>, float) #1
+declare spir_func i32 @_Z8popcounti(i32) #1
+declare spir_func i32 @_Z3clzi(i32) #1
+declare spir_func i32 @_Z3ctzi(i32) #1
+declare spir_func i32 @_Z6rotateii(i32, i32) #1
+
+attributes #0 = { nounwind }
+attributes #1 = { nounwind readnone }
+
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!0}
+!opencl.ocl.version = !{!1}
+!opencl.used.extensions = !{!2}
+!opencl.used.optional.core.features = !{!2}
+!opencl.compiler.options = !{!2}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 2, i32 0}
+!2 = !{}
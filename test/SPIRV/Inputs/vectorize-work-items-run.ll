@@ -0,0 +1,57 @@
+; Runs the work-group functions of vectorize-work-items.ll for one work-group
+; of 6 work-items, so that 4 of them take the vector path and 2 the scalar one.
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+@a = addrspace(1) global [6 x float] [float 1.0, float -2.0, float 3.0, float 4.0, float -5.0, float 6.0]
+@b = addrspace(1) global [6 x float] zeroinitializer
+@c = addrspace(1) global [6 x i32] [i32 3, i32 -1, i32 0, i32 2, i32 5, i32 -4]
+@fmt.f = internal constant [11 x i8] c"ifelse %g\0A\00"
+@fmt.i = internal constant [10 x i8] c"sumto %d\0A\00"
+
+declare i32 @printf(i8*, ...)
+declare spir_kernel void @ifelse.wg(float addrspace(1)*, float addrspace(1)*)
+declare spir_kernel void @sumto.wg(i32 addrspace(1)*, i32)
+
+define spir_func i64 @_Z12get_group_idj(i32 %dim) {
+  ret i64 0
+}
+
+define spir_func i64 @_Z17get_global_offsetj(i32 %dim) {
+  ret i64 0
+}
+
+define spir_func i64 @_Z14get_local_sizej(i32 %dim) {
+  %x = icmp eq i32 %dim, 0
+  %size = select i1 %x, i64 6, i64 1
+  ret i64 %size
+}
+
+define i32 @main() {
+entry:
+  %a = getelementptr [6 x float] addrspace(1)* @a, i32 0, i32 0
+  %b = getelementptr [6 x float] addrspace(1)* @b, i32 0, i32 0
+  call spir_kernel void @ifelse.wg(float addrspace(1)* %a, float addrspace(1)* %b)
+  %c = getelementptr [6 x i32] addrspace(1)* @c, i32 0, i32 0
+  call spir_kernel void @sumto.wg(i32 addrspace(1)* %c, i32 3)
+  %fmt.f = getelementptr [11 x i8]* @fmt.f, i32 0, i32 0
+  %fmt.i = getelementptr [10 x i8]* @fmt.i, i32 0, i32 0
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %pb = getelementptr [6 x float] addrspace(1)* @b, i32 0, i32 %i
+  %vb = load float addrspace(1)* %pb
+  %db = fpext float %vb to double
+  call i32 (i8*, ...)* @printf(i8* %fmt.f, double %db)
+  %pc = getelementptr [6 x i32] addrspace(1)* @c, i32 0, i32 %i
+  %vc = load i32 addrspace(1)* %pc
+  call i32 (i8*, ...)* @printf(i8* %fmt.i, i32 %vc)
+  %i.next = add i32 %i, 1
+  %again = icmp ult i32 %i.next, 6
+  br i1 %again, label %loop, label %exit
+
+exit:
+  ret i32 0
+}
@@ -0,0 +1,64 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv -s %t.bc -o %t.serial.bc
+; RUN: llvm-spirv -s -bitcode-materialize-threads=4 %t.bc -o %t.parallel.bc
+; RUN: llvm-dis < %t.parallel.bc | FileCheck %s
+; RUN: llvm-dis < %t.serial.bc > %t.serial.ll
+; RUN: llvm-dis < %t.parallel.bc > %t.parallel.ll
+; RUN: diff %t.serial.ll %t.parallel.ll
+; RUN: llvm-spirv -s -bitcode-materialize-threads=0 %t.bc -o %t.hw.bc
+; RUN: llvm-dis < %t.hw.bc > %t.hw.ll
+; RUN: diff %t.serial.ll %t.hw.ll
+
+; CHECK: define spir_func i32 @select(i32 %x)
+; CHECK: switch i32 %x, label %default [
+; CHECK: phi i32 [ 7, %one ], [ 11, %two ], [ 13, %default ]
+; CHECK: define spir_func float @scale(float %f)
+; CHECK: fmul float %f, 2.500000e+00, !note ![[MD:[0-9]+]]
+; CHECK: define spir_func i32 @caller(i32 %x)
+; CHECK: call spir_func i32 @callee(i32 %x)
+; CHECK: define spir_func i32 @callee(i32 %x)
+; CHECK: ![[MD]] = !{float 2.500000e+00}
+
+target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir-unknown-unknown"
+
+define spir_func i32 @select(i32 %x) {
+entry:
+  switch i32 %x, label %default [
+    i32 1, label %one
+    i32 2, label %two
+  ]
+
+one:
+  br label %exit
+
+two:
+  br label %exit
+
+default:
+  br label %exit
+
+exit:
+  %r = phi i32 [ 7, %one ], [ 11, %two ], [ 13, %default ]
+  ret i32 %r
+}
+
+define spir_func float @scale(float %f) {
+entry:
+  %m = fmul float %f, 2.500000e+00, !note !0
+  ret float %m
+}
+
+define spir_func i32 @caller(i32 %x) {
+entry:
+  %c = call spir_func i32 @callee(i32 %x)
+  ret i32 %c
+}
+
+define spir_func i32 @callee(i32 %x) {
+entry:
+  %a = add i32 %x, 42
+  ret i32 %a
+}
+
+!0 = !{float 2.500000e+00}
@@ -0,0 +1,57 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-text -o %t.txt
+; RUN: FileCheck < %t.txt %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+
+; CHECK-SPIRV-DAG: 4 Decorate [[Fast:[0-9]+]] FPFastMathMode 31
+; CHECK-SPIRV-DAG: 4 Decorate [[Finite:[0-9]+]] FPFastMathMode 3
+; CHECK-SPIRV-DAG: 4 Decorate [[NSZ:[0-9]+]] FPFastMathMode 4
+; CHECK-SPIRV-DAG: 4 Decorate [[Recip:[0-9]+]] FPFastMathMode 8
+; CHECK-SPIRV-NOT: FPFastMathMode
+; CHECK-SPIRV: FAdd {{[0-9]+}} [[Fast]]
+; CHECK-SPIRV: FMul {{[0-9]+}} [[Finite]]
+; CHECK-SPIRV: FSub {{[0-9]+}} [[NSZ]]
+; CHECK-SPIRV: FDiv {{[0-9]+}} [[Recip]]
+; CHECK-SPIRV: FAdd {{[0-9]+}} {{[0-9]+}}
+
+; CHECK-LLVM: fadd fast float
+; CHECK-LLVM: fmul nnan ninf float
+; CHECK-LLVM: fsub nsz float
+; CHECK-LLVM: fdiv arcp float
+; CHECK-LLVM: fadd float
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+; Function Attrs: nounwind
+define spir_kernel void @test(float addrspace(1)* %out, float %a, float %b) #0 {
+entry:
+  %add = fadd fast float %a, %b
+  %mul = fmul nnan ninf float %add, %b
+  %sub = fsub nsz float %mul, %a
+  %div = fdiv arcp float %sub, %b
+  %add1 = fadd float %div, %a
+  store float %add1, float addrspace(1)* %out, align 4
+  ret void
+}
+
+attributes #0 = { nounwind }
+
+!opencl.kernels = !{!0}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!6}
+!opencl.ocl.version = !{!6}
+!opencl.used.extensions = !{!7}
+!opencl.used.optional.core.features = !{!7}
+!opencl.compiler.options = !{!7}
+
+!0 = !{void (float addrspace(1)*, float, float)* @test, !1, !2, !3, !4, !5}
+!1 = !{!"kernel_arg_addr_space", i32 1, i32 0, i32 0}
+!2 = !{!"kernel_arg_access_qual", !"none", !"none", !"none"}
+!3 = !{!"kernel_arg_type", !"float*", !"float", !"float"}
+!4 = !{!"kernel_arg_base_type", !"float*", !"float", !"float"}
+!5 = !{!"kernel_arg_type_qual", !"", !"", !""}
+!6 = !{i32 1, i32 2}
+!7 = !{}
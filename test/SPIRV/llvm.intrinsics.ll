@@ -0,0 +1,90 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-text -o - | FileCheck %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+
+; CHECK-SPIRV-NOT: llvm.
+; CHECK-SPIRV: TypeInt [[i32:[0-9]+]] 32
+; CHECK-SPIRV: TypeFloat [[f32:[0-9]+]] 32
+; CHECK-SPIRV: TypeVector [[v4f32:[0-9]+]] [[f32]] 4
+
+; CHECK-SPIRV: 6 ExtInst [[f32]] {{[0-9]+}} {{[0-9]+}} sqrt {{[0-9]+}}
+; CHECK-SPIRV: 6 ExtInst [[f32]] {{[0-9]+}} {{[0-9]+}} fabs {{[0-9]+}}
+; CHECK-SPIRV: 7 ExtInst [[f32]] {{[0-9]+}} {{[0-9]+}} fmin {{[0-9]+}} {{[0-9]+}}
+; CHECK-SPIRV: 7 ExtInst [[f32]] {{[0-9]+}} {{[0-9]+}} fmax {{[0-9]+}} {{[0-9]+}}
+; CHECK-SPIRV: 6 ExtInst [[v4f32]] {{[0-9]+}} {{[0-9]+}} floor {{[0-9]+}}
+; CHECK-SPIRV: 6 ExtInst [[i32]] {{[0-9]+}} {{[0-9]+}} popcount {{[0-9]+}}
+; CHECK-SPIRV: 6 ExtInst [[i32]] {{[0-9]+}} {{[0-9]+}} clz {{[0-9]+}}
+; CHECK-SPIRV: 6 ExtInst [[i32]] {{[0-9]+}} {{[0-9]+}} ctz {{[0-9]+}}
+; CHECK-SPIRV: 5 BitwiseAnd [[i32]] [[b0:[0-9]+]] [[x:[0-9]+]] {{[0-9]+}}
+; CHECK-SPIRV: 5 ShiftLeftLogical [[i32]] [[s0:[0-9]+]] [[b0]] {{[0-9]+}}
+; CHECK-SPIRV: 5 BitwiseAnd [[i32]] [[b1:[0-9]+]] [[x]] {{[0-9]+}}
+; CHECK-SPIRV: 5 ShiftLeftLogical [[i32]] [[s1:[0-9]+]] [[b1]] {{[0-9]+}}
+; CHECK-SPIRV: 5 BitwiseOr [[i32]] [[o1:[0-9]+]] [[s0]] [[s1]]
+; CHECK-SPIRV: 5 BitwiseAnd [[i32]] [[b2:[0-9]+]] [[x]] {{[0-9]+}}
+; CHECK-SPIRV: 5 ShiftRightLogical [[i32]] [[s2:[0-9]+]] [[b2]] {{[0-9]+}}
+; CHECK-SPIRV: 5 BitwiseOr [[i32]] [[o2:[0-9]+]] [[o1]] [[s2]]
+; CHECK-SPIRV: 5 BitwiseAnd [[i32]] [[b3:[0-9]+]] [[x]] {{[0-9]+}}
+; CHECK-SPIRV: 5 ShiftRightLogical [[i32]] [[s3:[0-9]+]] [[b3]] {{[0-9]+}}
+; CHECK-SPIRV: 5 BitwiseOr [[i32]] {{[0-9]+}} [[o2]] [[s3]]
+
+; CHECK-LLVM: call spir_func float @_Z4sqrtf(float
+; CHECK-LLVM: call spir_func float @_Z4fabsf(float
+; CHECK-LLVM: call spir_func float @_Z4fminff(float
+; CHECK-LLVM: call spir_func float @_Z4fmaxff(float
+; CHECK-LLVM: call spir_func <4 x float> @_Z5floorDv4_f(<4 x float>
+; CHECK-LLVM: call spir_func i32 @_Z8popcounti(i32
+; CHECK-LLVM: call spir_func i32 @_Z3clzi(i32
+; CHECK-LLVM: call spir_func i32 @_Z3ctzi(i32
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64"
+
+; Function Attrs: nounwind
+define spir_func void @foo(float %a, float %b, <4 x float> %v, i32 %x, float addrspace(1)* %fp, <4 x float> addrspace(1)* %vp, i32 addrspace(1)* %ip) #0 {
+entry:
+  %0 = call float @llvm.sqrt.f32(float %a)
+  store float %0, float addrspace(1)* %fp
+  %1 = call float @llvm.fabs.f32(float %a)
+  store float %1, float addrspace(1)* %fp
+  %2 = call float @llvm.minnum.f32(float %a, float %b)
+  store float %2, float addrspace(1)* %fp
+  %3 = call float @llvm.maxnum.f32(float %a, float %b)
+  store float %3, float addrspace(1)* %fp
+  %4 = call <4 x float> @llvm.floor.v4f32(<4 x float> %v)
+  store <4 x float> %4, <4 x float> addrspace(1)* %vp
+  %5 = call i32 @llvm.ctpop.i32(i32 %x)
+  store i32 %5, i32 addrspace(1)* %ip
+  %6 = call i32 @llvm.ctlz.i32(i32 %x, i1 false)
+  store i32 %6, i32 addrspace(1)* %ip
+  %7 = call i32 @llvm.cttz.i32(i32 %x, i1 true)
+  store i32 %7, i32 addrspace(1)* %ip
+  %8 = call i32 @llvm.bswap.i32(i32 %x)
+  store i32 %8, i32 addrspace(1)* %ip
+  ret void
+}
+
+declare float @llvm.sqrt.f32(float) #1
+declare float @llvm.fabs.f32(float) #1
+declare float @llvm.minnum.f32(float, float) #1
+declare float @llvm.maxnum.f32(float, float) #1
+declare <4 x float> @llvm.floor.v4f32(<4 x float>) #1
+declare i32 @llvm.ctpop.i32(i32) #1
+declare i32 @llvm.ctlz.i32(i32, i1) #1
+declare i32 @llvm.cttz.i32(i32, i1) #1
+declare i32 @llvm.bswap.i32(i32) #1
+
+attributes #0 = { nounwind }
+attributes #1 = { nounwind readnone }
+
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!0}
+!opencl.ocl.version = !{!1}
+!opencl.used.extensions = !{!2}
+!opencl.used.optional.core.features = !{!2}
+!opencl.compiler.options = !{!2}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 2, i32 0}
+!2 = !{}
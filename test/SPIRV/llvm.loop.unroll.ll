@@ -0,0 +1,142 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-text -o - | FileCheck %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+
+; CHECK-SPIRV: Function
+; CHECK-SPIRV: Branch [[header:[0-9]+]]
+; CHECK-SPIRV: Label [[header]]
+; CHECK-SPIRV: LoopMerge [[exit:[0-9]+]] [[latch:[0-9]+]] 1
+; CHECK-SPIRV-NEXT: BranchConditional {{[0-9]+}} [[latch]] [[exit]]
+; CHECK-SPIRV: Label [[latch]]
+; CHECK-SPIRV: Branch [[header]]
+
+; CHECK-SPIRV: Function
+; CHECK-SPIRV: LoopMerge {{[0-9]+}} {{[0-9]+}} 2
+; CHECK-SPIRV-NEXT: BranchConditional
+
+; CHECK-SPIRV: Function
+; CHECK-SPIRV: LoopMerge {{[0-9]+}} {{[0-9]+}} 2
+; CHECK-SPIRV-NEXT: BranchConditional
+
+; A loop without unroll hints gets no OpLoopMerge.
+; CHECK-SPIRV: Function
+; CHECK-SPIRV-NOT: LoopMerge
+; CHECK-SPIRV: FunctionEnd
+
+; CHECK-LLVM: define spir_func void @unroll_full
+; CHECK-LLVM: br i1 %{{[0-9a-z.]+}}, label %{{[0-9a-z.]+}}, label %{{[0-9a-z.]+}}, !llvm.loop ![[FULL:[0-9]+]]
+; CHECK-LLVM: define spir_func void @unroll_disable
+; CHECK-LLVM: br i1 %{{[0-9a-z.]+}}, label %{{[0-9a-z.]+}}, label %{{[0-9a-z.]+}}, !llvm.loop ![[DISABLE:[0-9]+]]
+; CHECK-LLVM: ![[FULL]] = distinct !{![[FULL]], ![[FULL_MD:[0-9]+]]}
+; CHECK-LLVM: ![[FULL_MD]] = !{!"llvm.loop.unroll.full"}
+; CHECK-LLVM: ![[DISABLE]] = distinct !{![[DISABLE]], ![[DISABLE_MD:[0-9]+]]}
+; CHECK-LLVM: ![[DISABLE_MD]] = !{!"llvm.loop.unroll.disable"}
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+; Function Attrs: nounwind
+define spir_func void @unroll_full(i32 addrspace(1)* %p, i32 %n) #0 {
+entry:
+  br label %for.cond
+
+for.cond:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %idx = sext i32 %i to i64
+  %arrayidx = getelementptr inbounds i32 addrspace(1)* %p, i64 %idx
+  store i32 %i, i32 addrspace(1)* %arrayidx, align 4
+  %inc = add nsw i32 %i, 1
+  br label %for.cond, !llvm.loop !0
+
+for.end:
+  ret void
+}
+
+; Function Attrs: nounwind
+define spir_func void @unroll_disable(i32 addrspace(1)* %p, i32 %n) #0 {
+entry:
+  br label %for.cond
+
+for.cond:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %idx = sext i32 %i to i64
+  %arrayidx = getelementptr inbounds i32 addrspace(1)* %p, i64 %idx
+  store i32 %i, i32 addrspace(1)* %arrayidx, align 4
+  %inc = add nsw i32 %i, 1
+  br label %for.cond, !llvm.loop !2
+
+for.end:
+  ret void
+}
+
+; Function Attrs: nounwind
+define spir_func void @unroll_count_1(i32 addrspace(1)* %p, i32 %n) #0 {
+entry:
+  br label %for.cond
+
+for.cond:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %idx = sext i32 %i to i64
+  %arrayidx = getelementptr inbounds i32 addrspace(1)* %p, i64 %idx
+  store i32 %i, i32 addrspace(1)* %arrayidx, align 4
+  %inc = add nsw i32 %i, 1
+  br label %for.cond, !llvm.loop !4
+
+for.end:
+  ret void
+}
+
+; Function Attrs: nounwind
+define spir_func void @no_hint(i32 addrspace(1)* %p, i32 %n) #0 {
+entry:
+  br label %for.cond
+
+for.cond:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %idx = sext i32 %i to i64
+  %arrayidx = getelementptr inbounds i32 addrspace(1)* %p, i64 %idx
+  store i32 %i, i32 addrspace(1)* %arrayidx, align 4
+  %inc = add nsw i32 %i, 1
+  br label %for.cond, !llvm.loop !6
+
+for.end:
+  ret void
+}
+
+attributes #0 = { nounwind }
+
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!8}
+!opencl.ocl.version = !{!8}
+!opencl.used.extensions = !{!9}
+!opencl.used.optional.core.features = !{!9}
+!opencl.compiler.options = !{!9}
+
+!0 = distinct !{!0, !1}
+!1 = !{!"llvm.loop.unroll.full"}
+!2 = distinct !{!2, !3}
+!3 = !{!"llvm.loop.unroll.disable"}
+!4 = distinct !{!4, !5}
+!5 = !{!"llvm.loop.unroll.count", i32 1}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.vectorize.width", i32 4}
+!8 = !{i32 1, i32 2}
+!9 = !{}
@@ -0,0 +1,59 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-text -o - | FileCheck %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+
+; The scalar exponent of llvm.powi is splatted for a vector pown. The reader
+; builds the splat back from the non-constant CompositeConstruct.
+
+; CHECK-SPIRV-NOT: llvm.
+; CHECK-SPIRV: TypeInt [[i32:[0-9]+]] 32
+; CHECK-SPIRV: Constant [[i32]] [[three:[0-9]+]] 3
+; CHECK-SPIRV: TypeFloat [[f32:[0-9]+]] 32
+; CHECK-SPIRV: TypeVector [[v4f32:[0-9]+]] [[f32]] 4
+; CHECK-SPIRV: TypeVector [[v4i32:[0-9]+]] [[i32]] 4
+; CHECK-SPIRV: ConstantComposite [[v4i32]] [[threes:[0-9]+]] [[three]] [[three]] [[three]] [[three]]
+; CHECK-SPIRV: FunctionParameter [[i32]] [[n:[0-9]+]]
+; CHECK-SPIRV: 7 ExtInst [[f32]] {{[0-9]+}} {{[0-9]+}} pown {{[0-9]+}} [[n]]
+; CHECK-SPIRV: 7 CompositeConstruct [[v4i32]] [[ns:[0-9]+]] [[n]] [[n]] [[n]] [[n]]
+; CHECK-SPIRV: 7 ExtInst [[v4f32]] {{[0-9]+}} {{[0-9]+}} pown {{[0-9]+}} [[ns]]
+; CHECK-SPIRV: 7 ExtInst [[v4f32]] {{[0-9]+}} {{[0-9]+}} pown {{[0-9]+}} [[threes]]
+
+; CHECK-LLVM: call spir_func float @_Z4pownfi(float
+; CHECK-LLVM: insertelement <4 x i32> undef, i32 %n, i32 0
+; CHECK-LLVM: insertelement <4 x i32> {{.*}}, i32 %n, i32 3
+; CHECK-LLVM: call spir_func <4 x float> @_Z4pownDv4_fDv4_i(<4 x float>
+; CHECK-LLVM: call spir_func <4 x float> @_Z4pownDv4_fDv4_i(<4 x float>
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64"
+
+; Function Attrs: nounwind
+define spir_func void @foo(float %a, <4 x float> %v, i32 %n, float addrspace(1)* %fp, <4 x float> addrspace(1)* %vp) #0 {
+entry:
+  %0 = call float @llvm.powi.f32(float %a, i32 %n)
+  store float %0, float addrspace(1)* %fp
+  %1 = call <4 x float> @llvm.powi.v4f32(<4 x float> %v, i32 %n)
+  store <4 x float> %1, <4 x float> addrspace(1)* %vp
+  %2 = call <4 x float> @llvm.powi.v4f32(<4 x float> %v, i32 3)
+  store <4 x float> %2, <4 x float> addrspace(1)* %vp
+  ret void
+}
+
+declare float @llvm.powi.f32(float, i32) #1
+declare <4 x float> @llvm.powi.v4f32(<4 x float>, i32) #1
+
+attributes #0 = { nounwind }
+attributes #1 = { nounwind readnone }
+
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!0}
+!opencl.ocl.version = !{!1}
+!opencl.used.extensions = !{!2}
+!opencl.used.optional.core.features = !{!2}
+!opencl.compiler.options = !{!2}
+
+!0 = !{i32 1, i32 2}
+!1 = !{i32 2, i32 0}
+!2 = !{}
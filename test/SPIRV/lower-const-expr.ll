@@ -0,0 +1,76 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-text -o - | FileCheck %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-LLVM
+
+; Each constant expression is lowered to one instruction per function and all
+; uses of it in that function refer to that instruction.
+
+; CHECK-SPIRV: Function
+; CHECK-SPIRV: InBoundsPtrAccessChain
+; CHECK-SPIRV-NOT: InBoundsPtrAccessChain
+; CHECK-SPIRV: FunctionEnd
+; CHECK-SPIRV: Function
+; CHECK-SPIRV: InBoundsPtrAccessChain
+; CHECK-SPIRV-NOT: InBoundsPtrAccessChain
+; CHECK-SPIRV: FunctionEnd
+
+; CHECK-LLVM-LABEL: define spir_kernel void @foo
+; CHECK-LLVM: [[GEP:%[0-9a-z.]+]] = getelementptr inbounds [4 x i32] addrspace(1)* @g, i32 0, i32 2
+; CHECK-LLVM: load i32 addrspace(1)* [[GEP]]
+; CHECK-LLVM: store i32 {{.*}}, i32 addrspace(1)* [[GEP]]
+; CHECK-LLVM: store i32 {{.*}}, i32 addrspace(1)* [[GEP]]
+; CHECK-LLVM-LABEL: define spir_kernel void @bar
+; CHECK-LLVM: [[GEP2:%[0-9a-z.]+]] = getelementptr inbounds [4 x i32] addrspace(1)* @g, i32 0, i32 2
+; CHECK-LLVM: store i32 {{.*}}, i32 addrspace(1)* [[GEP2]]
+; CHECK-LLVM: store i32 {{.*}}, i32 addrspace(1)* [[GEP2]]
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+@g = addrspace(1) global [4 x i32] zeroinitializer, align 4
+
+; Function Attrs: nounwind
+define spir_kernel void @foo(i32 %n) #0 {
+entry:
+  %0 = load i32 addrspace(1)* getelementptr inbounds ([4 x i32] addrspace(1)* @g, i32 0, i32 2), align 4
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %if.then, label %if.end
+
+if.then:
+  %add = add nsw i32 %0, %n
+  store i32 %add, i32 addrspace(1)* getelementptr inbounds ([4 x i32] addrspace(1)* @g, i32 0, i32 2), align 4
+  br label %if.end
+
+if.end:
+  store i32 %n, i32 addrspace(1)* getelementptr inbounds ([4 x i32] addrspace(1)* @g, i32 0, i32 2), align 4
+  ret void
+}
+
+; Function Attrs: nounwind
+define spir_kernel void @bar(i32 %n) #0 {
+entry:
+  store i32 %n, i32 addrspace(1)* getelementptr inbounds ([4 x i32] addrspace(1)* @g, i32 0, i32 2), align 4
+  store i32 0, i32 addrspace(1)* getelementptr inbounds ([4 x i32] addrspace(1)* @g, i32 0, i32 2), align 4
+  ret void
+}
+
+attributes #0 = { nounwind }
+
+!opencl.kernels = !{!0, !6}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!7}
+!opencl.ocl.version = !{!7}
+!opencl.used.extensions = !{!8}
+!opencl.used.optional.core.features = !{!8}
+!opencl.compiler.options = !{!8}
+
+!0 = !{void (i32)* @foo, !1, !2, !3, !4, !5}
+!1 = !{!"kernel_arg_addr_space", i32 0}
+!2 = !{!"kernel_arg_access_qual", !"none"}
+!3 = !{!"kernel_arg_type", !"int"}
+!4 = !{!"kernel_arg_base_type", !"int"}
+!5 = !{!"kernel_arg_type_qual", !""}
+!6 = !{void (i32)* @bar, !1, !2, !3, !4, !5}
+!7 = !{i32 1, i32 2}
+!8 = !{}
@@ -27,8 +27,8 @@
 ; CHECK-LLVM: load volatile i32 addrspace(4)** %ptr, align 8
 ; CHECK-LLVM: load volatile i32 addrspace(4)** %ptr
 ; CHECK-LLVM: load volatile i32 addrspace(4)** %ptr, align 8, !nontemporal ![[NTMetadata:[0-9]+]]
-; CHECK-LLVM: store i32 %call.old, i32 addrspace(4)* %arrayidx, align 4, !nontemporal ![[NTMetadata:[0-9]+]]
-; CHECK-LLVM: store i32 addrspace(4)* %5, i32 addrspace(4)** %ptr
+; CHECK-LLVM: store i32 %call, i32 addrspace(4)* %arrayidx, align 4, !nontemporal ![[NTMetadata:[0-9]+]]
+; CHECK-LLVM: store i32 addrspace(4)* %{{[0-9]+}}, i32 addrspace(4)** %ptr
 ; CHECK-LLVM: ![[NTMetadata:[0-9]+]] = !{i32 1}
 
 ; ModuleID = 'test.bc'
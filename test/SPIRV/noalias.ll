@@ -0,0 +1,63 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-text -o %t.txt
+; RUN: FileCheck < %t.txt %s --check-prefix=CHECK-SPIRV
+; RUN: not grep Aliased %t.txt
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+
+; CHECK-SPIRV: 4 Name [[Next:[0-9]+]] "next"
+; CHECK-SPIRV: 3 Name [[P:[0-9]+]] "p"
+; CHECK-SPIRV: 3 Name [[Q:[0-9]+]] "q"
+; CHECK-SPIRV: 3 Name [[A:[0-9]+]] "a"
+; CHECK-SPIRV: 3 Name [[B:[0-9]+]] "b"
+; CHECK-SPIRV: 3 Decorate [[Restrict:[0-9]+]] Restrict
+; CHECK-SPIRV: 2 DecorationGroup [[Restrict]]
+; CHECK-SPIRV: 4 Decorate [[NoAlias:[0-9]+]] FuncParamAttr 4
+; CHECK-SPIRV: 2 DecorationGroup [[NoAlias]]
+; CHECK-SPIRV: 4 GroupDecorate [[Restrict]] [[P]] [[A]]
+; CHECK-SPIRV: 5 GroupDecorate [[NoAlias]] [[P]] [[Next]] [[A]]
+; CHECK-SPIRV: 5 Function {{[0-9]+}} [[Next]]
+; CHECK-SPIRV-NEXT: 3 FunctionParameter {{[0-9]+}} [[P]]
+; CHECK-SPIRV-NEXT: 3 FunctionParameter {{[0-9]+}} [[Q]]
+
+; CHECK-LLVM: define spir_func noalias i32 addrspace(1)* @next(i32 addrspace(1)* noalias %p, i32 addrspace(1)* %q)
+; CHECK-LLVM: define spir_kernel void @k(i32 addrspace(1)* noalias %a, i32 addrspace(1)* %b)
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+; Function Attrs: nounwind
+define spir_func noalias i32 addrspace(1)* @next(i32 addrspace(1)* noalias %p, i32 addrspace(1)* %q) #0 {
+entry:
+  %add.ptr = getelementptr inbounds i32 addrspace(1)* %p, i32 1
+  ret i32 addrspace(1)* %add.ptr
+}
+
+; Function Attrs: nounwind
+define spir_kernel void @k(i32 addrspace(1)* %a, i32 addrspace(1)* %b) #0 {
+entry:
+  %0 = load i32 addrspace(1)* %b, align 4
+  store i32 %0, i32 addrspace(1)* %a, align 4
+  ret void
+}
+
+attributes #0 = { nounwind }
+
+!opencl.kernels = !{!2}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!0}
+!opencl.ocl.version = !{!0}
+!opencl.used.extensions = !{!1}
+!opencl.used.optional.core.features = !{!1}
+!opencl.compiler.options = !{!1}
+
+!0 = !{i32 1, i32 2}
+!1 = !{}
+!2 = !{void (i32 addrspace(1)*, i32 addrspace(1)*)* @k, !3, !4, !5, !6, !7, !8}
+!3 = !{!"kernel_arg_addr_space", i32 1, i32 1}
+!4 = !{!"kernel_arg_access_qual", !"none", !"none"}
+!5 = !{!"kernel_arg_type", !"int*", !"int*"}
+!6 = !{!"kernel_arg_type_qual", !"restrict", !""}
+!7 = !{!"kernel_arg_base_type", !"int*", !"int*"}
+!8 = !{!"kernel_arg_name", !"a", !"b"}
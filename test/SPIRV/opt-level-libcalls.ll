@@ -0,0 +1,47 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-opt-level=2 -spirv-text -o - | FileCheck %s
+
+; Calls to OpenCL builtins that share a name with a host library function
+; are kept as they are by the optimization pipeline.
+
+; CHECK-NOT: put
+; CHECK: ExtInst {{[0-9]+}} {{[0-9]+}} {{[0-9]+}} printf
+; CHECK-NOT: put
+; CHECK: ExtInst {{[0-9]+}} {{[0-9]+}} {{[0-9]+}} printf
+; CHECK-NOT: put
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
+target triple = "spir64"
+
+@.str = private unnamed_addr addrspace(2) constant [2 x i8] c"x\00", align 1
+@.str1 = private unnamed_addr addrspace(2) constant [7 x i8] c"hello\0A\00", align 1
+
+; Function Attrs: nounwind
+define spir_kernel void @test() #0 {
+entry:
+  %call = call i32 (i8 addrspace(2)*, ...)* @printf(i8 addrspace(2)* getelementptr inbounds ([2 x i8] addrspace(2)* @.str, i32 0, i32 0))
+  %call1 = call i32 (i8 addrspace(2)*, ...)* @printf(i8 addrspace(2)* getelementptr inbounds ([7 x i8] addrspace(2)* @.str1, i32 0, i32 0))
+  ret void
+}
+
+declare i32 @printf(i8 addrspace(2)*, ...)
+
+attributes #0 = { nounwind }
+
+!opencl.kernels = !{!0}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!6}
+!opencl.ocl.version = !{!7}
+!opencl.used.extensions = !{!8}
+!opencl.used.optional.core.features = !{!8}
+!opencl.compiler.options = !{!8}
+
+!0 = !{void ()* @test, !1, !2, !3, !4, !5}
+!1 = !{!"kernel_arg_addr_space"}
+!2 = !{!"kernel_arg_access_qual"}
+!3 = !{!"kernel_arg_type"}
+!4 = !{!"kernel_arg_base_type"}
+!5 = !{!"kernel_arg_type_qual"}
+!6 = !{i32 1, i32 2}
+!7 = !{i32 2, i32 0}
+!8 = !{}
@@ -0,0 +1,106 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-opt-level=2 -spirv-text -o - | FileCheck %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv %t.bc -spirv-opt-level=2 -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o - | llvm-dis | FileCheck %s --check-prefix=CHECK-LLVM
+
+; The optimization pipeline run before lowering must not produce constructs
+; SPIR-V cannot represent: switches are not turned into lookup tables and
+; arithmetic with overflow intrinsics are expanded.
+
+; CHECK-SPIRV-NOT: Variable
+; CHECK-SPIRV: Function
+; CHECK-SPIRV: Switch
+; CHECK-SPIRV: FunctionEnd
+; CHECK-SPIRV: Function
+; CHECK-SPIRV-NOT: FunctionCall
+; CHECK-SPIRV: IAdd
+; CHECK-SPIRV: ULessThan
+; CHECK-SPIRV: FunctionEnd
+
+; CHECK-LLVM-LABEL: define spir_kernel void @sel
+; CHECK-LLVM: switch i32
+; CHECK-LLVM-LABEL: define spir_kernel void @ovf
+; CHECK-LLVM-NOT: with.overflow
+; CHECK-LLVM: add i32
+; CHECK-LLVM: icmp ult i32
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+; Function Attrs: nounwind
+define spir_kernel void @sel(i32 %c, i32 addrspace(1)* %out) #0 {
+entry:
+  %v = alloca i32, align 4
+  switch i32 %c, label %def [
+    i32 0, label %c0
+    i32 1, label %c1
+    i32 2, label %c2
+    i32 3, label %c3
+  ]
+
+c0:
+  store i32 7, i32* %v, align 4
+  br label %exit
+
+c1:
+  store i32 11, i32* %v, align 4
+  br label %exit
+
+c2:
+  store i32 13, i32* %v, align 4
+  br label %exit
+
+c3:
+  store i32 17, i32* %v, align 4
+  br label %exit
+
+def:
+  store i32 0, i32* %v, align 4
+  br label %exit
+
+exit:
+  %0 = load i32* %v, align 4
+  store i32 %0, i32 addrspace(1)* %out, align 4
+  ret void
+}
+
+; Function Attrs: nounwind
+define spir_kernel void @ovf(i32 %a, i32 %b, i32 addrspace(1)* %out) #0 {
+entry:
+  %r = call { i32, i1 } @llvm.uadd.with.overflow.i32(i32 %a, i32 %b)
+  %s = extractvalue { i32, i1 } %r, 0
+  %o = extractvalue { i32, i1 } %r, 1
+  %z = zext i1 %o to i32
+  %t = add i32 %s, %z
+  store i32 %t, i32 addrspace(1)* %out, align 4
+  ret void
+}
+
+; Function Attrs: nounwind readnone
+declare { i32, i1 } @llvm.uadd.with.overflow.i32(i32, i32) #1
+
+attributes #0 = { nounwind }
+attributes #1 = { nounwind readnone }
+
+!opencl.kernels = !{!0, !6}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!12}
+!opencl.ocl.version = !{!12}
+!opencl.used.extensions = !{!13}
+!opencl.used.optional.core.features = !{!13}
+!opencl.compiler.options = !{!13}
+
+!0 = !{void (i32, i32 addrspace(1)*)* @sel, !1, !2, !3, !4, !5}
+!1 = !{!"kernel_arg_addr_space", i32 0, i32 1}
+!2 = !{!"kernel_arg_access_qual", !"none", !"none"}
+!3 = !{!"kernel_arg_type", !"int", !"int*"}
+!4 = !{!"kernel_arg_base_type", !"int", !"int*"}
+!5 = !{!"kernel_arg_type_qual", !"", !""}
+!6 = !{void (i32, i32, i32 addrspace(1)*)* @ovf, !7, !8, !9, !10, !11}
+!7 = !{!"kernel_arg_addr_space", i32 0, i32 0, i32 1}
+!8 = !{!"kernel_arg_access_qual", !"none", !"none", !"none"}
+!9 = !{!"kernel_arg_type", !"int", !"int", !"int*"}
+!10 = !{!"kernel_arg_base_type", !"int", !"int", !"int*"}
+!11 = !{!"kernel_arg_type_qual", !"", !"", !""}
+!12 = !{i32 1, i32 2}
+!13 = !{}
@@ -0,0 +1,74 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-index -o %t.spv
+; RUN: llvm-spirv -r %t.spv -spirv-index-funcs=bar,test -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+; RUN: llvm-spirv -r %t.spv -o %t.full.bc
+; RUN: llvm-dis < %t.full.bc | FileCheck %s --check-prefix=CHECK-FULL
+
+; An index whose first function name claims more bytes than the file holds is
+; rejected. The name size follows 16 header words and 4 function words.
+; RUN: cp %t.spv %t.bad.spv
+; RUN: head -c 80 %t.spv.idx > %t.bad.spv.idx
+; RUN: printf '\360\377\377\377' >> %t.bad.spv.idx
+; RUN: not llvm-spirv -r %t.bad.spv -spirv-index-funcs=bar -o %t.bad.bc 2>&1 | FileCheck %s --check-prefix=CHECK-BAD
+
+; Only the bodies of the functions named by -spirv-index-funcs are decoded,
+; the other functions are translated to declarations.
+
+; CHECK-LLVM-DAG: declare spir_func i32 @foo(i32
+; CHECK-LLVM-DAG: define spir_func i32 @bar(i32
+; CHECK-LLVM-DAG: define spir_kernel void @test(i32 addrspace(1)*
+; CHECK-LLVM-DAG: call spir_func i32 @foo(i32
+; CHECK-LLVM-DAG: call spir_func i32 @bar(i32
+
+; CHECK-FULL-DAG: define internal spir_func i32 @foo(i32
+; CHECK-FULL-DAG: define spir_func i32 @bar(i32
+; CHECK-FULL-DAG: define spir_kernel void @test(i32 addrspace(1)*
+
+; CHECK-BAD: Invalid SPIR-V index
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+; Function Attrs: nounwind
+define internal spir_func i32 @foo(i32 %x) #0 {
+entry:
+  %mul = mul nsw i32 %x, %x
+  ret i32 %mul
+}
+
+; Function Attrs: nounwind
+define spir_func i32 @bar(i32 %x) #0 {
+entry:
+  %add = add nsw i32 %x, 1
+  ret i32 %add
+}
+
+; Function Attrs: nounwind
+define spir_kernel void @test(i32 addrspace(1)* %out) #0 {
+entry:
+  %0 = load i32 addrspace(1)* %out, align 4
+  %call = call spir_func i32 @foo(i32 %0) #0
+  %call1 = call spir_func i32 @bar(i32 %call) #0
+  store i32 %call1, i32 addrspace(1)* %out, align 4
+  ret void
+}
+
+attributes #0 = { nounwind }
+
+!opencl.kernels = !{!0}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!6}
+!opencl.ocl.version = !{!6}
+!opencl.used.extensions = !{!7}
+!opencl.used.optional.core.features = !{!7}
+!opencl.compiler.options = !{!7}
+
+!0 = !{void (i32 addrspace(1)*)* @test, !1, !2, !3, !4, !5}
+!1 = !{!"kernel_arg_addr_space", i32 1}
+!2 = !{!"kernel_arg_access_qual", !"none"}
+!3 = !{!"kernel_arg_type", !"int*"}
+!4 = !{!"kernel_arg_base_type", !"int*"}
+!5 = !{!"kernel_arg_type_qual", !""}
+!6 = !{i32 2, i32 0}
+!7 = !{}
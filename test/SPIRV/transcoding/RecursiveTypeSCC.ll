@@ -0,0 +1,51 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-text -o %t.txt
+; RUN: FileCheck < %t.txt %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+
+; A pointer type used by several members on a cycle of struct references is
+; forward declared once.
+
+target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir-unknown-unknown"
+
+%struct.Tree = type { %struct.Tree addrspace(1)*, %struct.Tree addrspace(1)*, i32 }
+%struct.X = type { i32, %struct.Y addrspace(1)* }
+%struct.Y = type { [2 x %struct.X addrspace(1)*], %struct.Y addrspace(1)* }
+
+; CHECK-SPIRV: 3 TypeForwardPointer [[TreePtr:[0-9]+]]
+; CHECK-SPIRV-NOT: TypeForwardPointer [[TreePtr]]
+; CHECK-SPIRV: TypeStruct [[Tree:[0-9]+]] [[TreePtr]] [[TreePtr]]
+; CHECK-SPIRV: 4 TypePointer [[TreePtr]] {{[0-9]+}} [[Tree]]
+
+; CHECK-LLVM: %struct.Tree = type { %struct.Tree addrspace(1)*, %struct.Tree addrspace(1)*, i32 }
+; CHECK-LLVM: %struct.X = type { i32, %struct.Y addrspace(1)* }
+; CHECK-LLVM: %struct.Y = type { [2 x %struct.X addrspace(1)*], %struct.Y addrspace(1)* }
+
+; Function Attrs: nounwind
+define spir_kernel void @test(%struct.Tree addrspace(1)* %tree, %struct.X addrspace(1)* %x) #0 {
+  ret void
+}
+
+attributes #0 = { nounwind }
+
+!opencl.kernels = !{!0}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!7}
+!opencl.ocl.version = !{!8}
+!opencl.used.extensions = !{!9}
+!opencl.used.optional.core.features = !{!9}
+!opencl.compiler.options = !{!9}
+
+!0 = !{void (%struct.Tree addrspace(1)*, %struct.X addrspace(1)*)* @test, !1, !2, !3, !4, !5, !6}
+!1 = !{!"kernel_arg_addr_space", i32 1, i32 1}
+!2 = !{!"kernel_arg_access_qual", !"none", !"none"}
+!3 = !{!"kernel_arg_type", !"struct Tree*", !"struct X*"}
+!4 = !{!"kernel_arg_base_type", !"struct Tree*", !"struct X*"}
+!5 = !{!"kernel_arg_type_qual", !"", !""}
+!6 = !{!"kernel_arg_name", !"tree", !"x"}
+!7 = !{i32 1, i32 2}
+!8 = !{i32 2, i32 0}
+!9 = !{}
@@ -0,0 +1,76 @@
+; Check that calls mutated to the same builtin share one declaration while
+; calls with a different signature or mangling get their own.
+
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -spirv-text -o - | FileCheck %s --check-prefix=CHECK-SPIRV
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
+; RUN: llvm-dis < %t.rev.bc | grep "declare .*atomic_fetch_add_explicit" | count 2
+; RUN: llvm-dis < %t.rev.bc | grep "declare .*atomic_fetch_max_explicit" | count 2
+
+; CHECK-SPIRV: 7 AtomicIAdd
+; CHECK-SPIRV: 7 AtomicIAdd
+; CHECK-SPIRV: 7 AtomicSMax
+; CHECK-SPIRV: 7 AtomicUMax
+; CHECK-SPIRV: 7 AtomicIAdd
+; CHECK-SPIRV: 7 AtomicIAdd
+; CHECK-SPIRV: 7 AtomicIAdd
+
+; CHECK-LLVM-LABEL: @test_global
+; CHECK-LLVM: call spir_func i32 @_Z25atomic_fetch_add_explicitPVU3AS1U7_Atomiciiii(i32 addrspace(1)* %dst, i32 1
+; CHECK-LLVM: call spir_func i32 @_Z25atomic_fetch_add_explicitPVU3AS1U7_Atomiciiii(i32 addrspace(1)* %dst, i32 2
+; CHECK-LLVM: call spir_func i32 @_Z25atomic_fetch_max_explicitPVU3AS1U7_Atomiciiii(i32 addrspace(1)* %dst, i32 3
+; CHECK-LLVM: call spir_func i32 @_Z25atomic_fetch_max_explicitPVU3AS1U7_Atomicjjii(i32 addrspace(1)* %dst, i32 4
+; CHECK-LLVM: call spir_func i32 @_Z25atomic_fetch_add_explicitPVU3AS1U7_Atomiciiii(i32 addrspace(1)* %dst, i32 5
+; CHECK-LLVM-LABEL: @test_local
+; CHECK-LLVM: call spir_func i32 @_Z25atomic_fetch_add_explicitPVU3AS3U7_Atomiciiii(i32 addrspace(3)* %dst, i32 6
+; CHECK-LLVM: call spir_func i32 @_Z25atomic_fetch_add_explicitPVU3AS3U7_Atomiciiii(i32 addrspace(3)* %dst, i32 7
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+; Function Attrs: nounwind
+define spir_kernel void @test_global(i32 addrspace(1)* %dst) #0 {
+  %1 = tail call spir_func i32 @_Z10atomic_addPVU3AS1ii(i32 addrspace(1)* %dst, i32 1) #0
+  %2 = tail call spir_func i32 @_Z10atomic_addPVU3AS1jj(i32 addrspace(1)* %dst, i32 2) #0
+  %3 = tail call spir_func i32 @_Z10atomic_maxPVU3AS1ii(i32 addrspace(1)* %dst, i32 3) #0
+  %4 = tail call spir_func i32 @_Z10atomic_maxPVU3AS1jj(i32 addrspace(1)* %dst, i32 4) #0
+  %5 = tail call spir_func i32 @_Z10atomic_addPVU3AS1ii(i32 addrspace(1)* %dst, i32 5) #0
+  ret void
+}
+
+; Function Attrs: nounwind
+define spir_kernel void @test_local(i32 addrspace(3)* %dst) #0 {
+  %1 = tail call spir_func i32 @_Z10atomic_addPVU3AS3ii(i32 addrspace(3)* %dst, i32 6) #0
+  %2 = tail call spir_func i32 @_Z10atomic_addPVU3AS3ii(i32 addrspace(3)* %dst, i32 7) #0
+  ret void
+}
+
+declare spir_func i32 @_Z10atomic_addPVU3AS1ii(i32 addrspace(1)*, i32)
+declare spir_func i32 @_Z10atomic_addPVU3AS1jj(i32 addrspace(1)*, i32)
+declare spir_func i32 @_Z10atomic_maxPVU3AS1ii(i32 addrspace(1)*, i32)
+declare spir_func i32 @_Z10atomic_maxPVU3AS1jj(i32 addrspace(1)*, i32)
+declare spir_func i32 @_Z10atomic_addPVU3AS3ii(i32 addrspace(3)*, i32)
+
+attributes #0 = { nounwind }
+
+!opencl.kernels = !{!0, !7}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!8}
+!opencl.ocl.version = !{!8}
+!opencl.used.extensions = !{!9}
+!opencl.used.optional.core.features = !{!9}
+!opencl.compiler.options = !{!9}
+
+!0 = !{void (i32 addrspace(1)*)* @test_global, !1, !2, !3, !4, !5, !6}
+!1 = !{!"kernel_arg_addr_space", i32 1}
+!2 = !{!"kernel_arg_access_qual", !"none"}
+!3 = !{!"kernel_arg_type", !"int*"}
+!4 = !{!"kernel_arg_type_qual", !"volatile"}
+!5 = !{!"kernel_arg_base_type", !"int*"}
+!6 = !{!"kernel_arg_name", !"dst"}
+!7 = !{void (i32 addrspace(3)*)* @test_local, !10, !2, !3, !4, !5, !6}
+!8 = !{i32 1, i32 2}
+!9 = !{}
+!10 = !{!"kernel_arg_addr_space", i32 3}
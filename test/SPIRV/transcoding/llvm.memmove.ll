@@ -6,29 +6,59 @@
 ; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=CHECK-LLVM
 
 ; CHECK-SPIRV-NOT: llvm.memmove
+; CHECK-SPIRV-NOT: LifetimeStart
 
-; CHECK-SPIRV: Variable {{[0-9]+}} [[mem:[0-9]+]] 7
+; Possibly overlapping ranges are copied by a loop going forward or backward.
+; CHECK-SPIRV: Function
+; CHECK-SPIRV: ConvertPtrToU
+; CHECK-SPIRV: ConvertPtrToU
+; CHECK-SPIRV: ULessThanEqual
+; CHECK-SPIRV: BranchConditional {{[0-9]+}} [[fwd:[0-9]+]] [[bwd:[0-9]+]]
+; CHECK-SPIRV: Label [[fwd]]
+; CHECK-SPIRV: Phi
+; CHECK-SPIRV: Load [[i64Ty:[0-9]+]]
+; CHECK-SPIRV: Store
+; CHECK-SPIRV: IAdd
+; CHECK-SPIRV: Label [[bwd]]
+; CHECK-SPIRV: Phi
+; CHECK-SPIRV: ISub
+; CHECK-SPIRV: Load [[i64Ty]]
+; CHECK-SPIRV: Store
+; CHECK-SPIRV: FunctionEnd
 
-; CHECK-SPIRV: LifetimeStart [[mem]] [[size:[0-9]+]]
-; CHECK-SPIRV: Bitcast [[i8Ty:[0-9]+]] [[tmp1:[0-9]+]] [[mem]]
-; CHECK-SPIRV: CopyMemorySized [[tmp1]] {{[0-9]+}} {{[0-9]+}}
-; CHECK-SPIRV: Bitcast [[i8Ty]] [[tmp2:[0-9]+]] [[mem]]
-; CHECK-SPIRV: CopyMemorySized {{[0-9]+}} [[tmp2]] {{[0-9]+}}
-; CHECK-SPIRV: LifetimeStop [[mem]] [[size]]
+; CHECK-SPIRV: Function
+; CHECK-SPIRV-NOT: Phi
+; CHECK-SPIRV: CopyMemorySized
+; CHECK-SPIRV: FunctionEnd
+
+; CHECK-SPIRV: Function
+; CHECK-SPIRV-NOT: Phi
+; CHECK-SPIRV: CopyMemorySized
+; CHECK-SPIRV: FunctionEnd
+
+; CHECK-SPIRV: Function
+; CHECK-SPIRV: ULessThanEqual
+; CHECK-SPIRV: Phi
+; CHECK-SPIRV: Load [[i8Ty:[0-9]+]]
+; CHECK-SPIRV: Phi
+; CHECK-SPIRV: Load [[i8Ty]]
+; CHECK-SPIRV: FunctionEnd
 
 ; CHECK-LLVM-NOT: llvm.memmove
+; CHECK-LLVM-NOT: alloca
 
-; CHECK-LLVM: [[local:%[0-9]+]] = alloca %struct.SomeStruct
-; CHECK-LLVM: [[tmp1:%[0-9]+]] = bitcast %struct.SomeStruct* [[local]] to [[type:i[0-9]+\*]]
-; CHECK-LLVM: call void @llvm.lifetime.start({{i[0-9]+}} {{-?[0-9]+}}, [[type]] [[tmp1]])
-; CHECK-LLVM: [[tmp2:%[0-9]+]] = bitcast %struct.SomeStruct* [[local]] to [[type]]
+; CHECK-LLVM-LABEL: define spir_kernel void @test_struct
+; CHECK-LLVM: icmp ule i64
+; CHECK-LLVM: load i64 addrspace(1)*
+; CHECK-LLVM: store i64
+; CHECK-LLVM-LABEL: define spir_kernel void @test_noalias
 ; CHECK-LLVM: call void @llvm.memcpy
-; CHECK-LLVM:  ([[type]] [[tmp2]],
-; CHECK-LLVM:  {{i[0-9]+}} [[size:[0-9]+]]
-; CHECK-LLVM: [[tmp3:%[0-9]+]] = bitcast %struct.SomeStruct* [[local]] to [[type]]
+; CHECK-LLVM-LABEL: define spir_kernel void @test_disjoint
 ; CHECK-LLVM: call void @llvm.memcpy
-; CHECK-LLVM:  , [[type]] [[tmp3]], {{i[0-9]+}} [[size]]
-; CHECK-LLVM: call void @llvm.lifetime.end({{i[0-9]+}} {{-?[0-9]+}}, [[type]] [[tmp1]])
+; CHECK-LLVM-LABEL: define spir_kernel void @test_var_len
+; CHECK-LLVM: icmp ule i64
+; CHECK-LLVM: load i8 addrspace(1)*
+; CHECK-LLVM: store i8
 
 target datalayout = "e-p:32:32-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024-n8:16:32:64"
 target triple = "spir-unknown-unknown"
@@ -43,6 +73,26 @@ define spir_kernel void @test_struct(%struct.SomeStruct addrspace(1)* nocapture
   ret void
 }
 
+; Function Attrs: nounwind
+define spir_kernel void @test_noalias(i8 addrspace(1)* noalias %in, i8 addrspace(1)* noalias %out, i32 %n) #0 {
+  call void @llvm.memmove.p1i8.p1i8.i32(i8 addrspace(1)* %out, i8 addrspace(1)* %in, i32 %n, i32 1, i1 false)
+  ret void
+}
+
+; Function Attrs: nounwind
+define spir_kernel void @test_disjoint(i8 addrspace(1)* %p) #0 {
+  %1 = getelementptr inbounds i8 addrspace(1)* %p, i32 16
+  call void @llvm.memmove.p1i8.p1i8.i32(i8 addrspace(1)* %1, i8 addrspace(1)* %p, i32 16, i32 1, i1 false)
+  ret void
+}
+
+; Function Attrs: nounwind
+define spir_kernel void @test_var_len(i8 addrspace(1)* %p, i32 %n) #0 {
+  %1 = getelementptr inbounds i8 addrspace(1)* %p, i32 1
+  call void @llvm.memmove.p1i8.p1i8.i32(i8 addrspace(1)* %1, i8 addrspace(1)* %p, i32 %n, i32 1, i1 false)
+  ret void
+}
+
 ; Function Attrs: nounwind
 declare void @llvm.memmove.p1i8.p1i8.i32(i8 addrspace(1)* nocapture, i8 addrspace(1)* nocapture readonly, i32, i32, i1) #1
 
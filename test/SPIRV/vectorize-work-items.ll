@@ -0,0 +1,232 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-spirv %t.bc -o %t.spv
+; RUN: llvm-spirv -r -vectorize-work-items=4 %t.spv -o %t.rev.bc
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s
+; RUN: llvm-dis < %t.rev.bc | FileCheck %s --check-prefix=DEAD
+; RUN: llvm-as %S/Inputs/vectorize-work-items-run.ll -o %t.run.bc
+; RUN: llvm-link %t.rev.bc %t.run.bc -o %t.linked.bc
+; RUN: lli -force-interpreter %t.linked.bc | FileCheck %s --check-prefix=EXEC
+
+; CHECK: define spir_kernel void @vadd(
+; CHECK: define spir_kernel void @reduce(
+; CHECK: define spir_kernel void @private_copy(
+; CHECK: define spir_kernel void @ifelse(
+; CHECK: define spir_kernel void @sumto(
+
+; CHECK: define internal void @vadd.wi(float addrspace(1)* %a, float addrspace(1)* %b, float addrspace(1)* noalias %c, i32 %n, i64 %lid.x, i64 %lid.y, i64 %lid.z)
+; CHECK-NOT: get_global_id
+; CHECK: ret void
+
+; CHECK: define internal void @vadd.wi.v4(float addrspace(1)* %a, float addrspace(1)* %b, float addrspace(1)* %c, i32 %n, i64 %lid.x, i64 %lid.y, i64 %lid.z)
+; CHECK: load <4 x float> addrspace(1)*
+; CHECK: load <4 x float> addrspace(1)*
+; CHECK: fadd <4 x float>
+; CHECK: store <4 x float>
+; CHECK: ret void
+
+; The work-group function keeps the calling convention and the parameter
+; attributes of the kernel.
+; CHECK: define spir_kernel void @vadd.wg(float addrspace(1)* %a, float addrspace(1)* %b, float addrspace(1)* noalias %c, i32 %n)
+; CHECK: call void @vadd.wi.v4(
+; CHECK: call void @vadd.wi(
+; CHECK: ret void
+
+; A kernel that synchronizes the work-group cannot run its work-items one
+; after another.
+; CHECK-NOT: @reduce.wg
+
+; Private arrays are not vectorized, but the kernel still gets a wrapper.
+; CHECK: define internal void @private_copy.wi(
+; CHECK-NOT: @private_copy.wi.v4
+; CHECK: define spir_kernel void @private_copy.wg(
+; CHECK-NOT: @private_copy.wi.v4
+; CHECK: call void @private_copy.wi(
+
+; Both sides of a branch on a varying condition are executed, each with the
+; stores predicated on its mask.
+; CHECK: define internal void @ifelse.wi.v4(
+; CHECK: %cmp = fcmp ogt <4 x float>
+; CHECK: [[NOT:%[0-9]+]] = xor <4 x i1> %cmp, <i1 true, i1 true, i1 true, i1 true>
+; CHECK: fsub <4 x float>
+; CHECK: extractelement <4 x i1> [[NOT]], i32 0
+; CHECK: fmul <4 x float>
+; CHECK: extractelement <4 x i1> %cmp, i32 0
+; CHECK: ret void
+; CHECK: define spir_kernel void @ifelse.wg(
+; CHECK: %vector_end = sub i64 %local_size.x,
+; CHECK: call void @ifelse.wi.v4(
+; CHECK: %lid.x = phi i64 [ %lid.x.vec, %lid.x.vec.end ],
+; CHECK: call void @ifelse.wi(
+
+; The masks of the blocks nothing is predicated in are erased.
+; DEAD: define internal void @ifelse.wi.v4(
+; DEAD-NOT: = or <4 x i1>
+; DEAD: ret void
+
+; A loop with a uniform trip count is kept in the linearized kernel, and is
+; entered if any work-item reaches it.
+; CHECK: define internal void @sumto.wi.v4(
+; CHECK: %pos = icmp sgt <4 x i32>
+; CHECK: br i1 %any, label %for.body, label %if.end.loopend
+; CHECK: for.body:
+; CHECK: %s = phi <4 x i32>
+; CHECK: %more = icmp slt i32 %inc, %n
+; CHECK: br i1 %more, label %for.body, label %if.end.loopend
+; CHECK: if.end.loopend:
+; CHECK: %r = select <4 x i1> %pos,
+; CHECK: ret void
+; CHECK: define spir_kernel void @sumto.wg(
+
+; EXEC: ifelse 2
+; EXEC: sumto 6
+; EXEC: ifelse 2
+; EXEC: sumto -1
+; EXEC: ifelse 6
+; EXEC: sumto 0
+; EXEC: ifelse 8
+; EXEC: sumto 5
+; EXEC: ifelse 5
+; EXEC: sumto 8
+; EXEC: ifelse 12
+; EXEC: sumto -4
+
+target datalayout = "e-i64:64-v16:16-v24:32-v32:32-v48:64-v96:128-v192:256-v256:256-v512:512-v1024:1024"
+target triple = "spir64-unknown-unknown"
+
+define spir_kernel void @vadd(float addrspace(1)* %a, float addrspace(1)* %b, float addrspace(1)* noalias %c, i32 %n) {
+entry:
+  %call = call spir_func i64 @_Z13get_global_idj(i32 0)
+  %conv = trunc i64 %call to i32
+  %cmp = icmp slt i32 %conv, %n
+  br i1 %cmp, label %if.then, label %if.end
+
+if.then:
+  %idxprom = sext i32 %conv to i64
+  %pa = getelementptr inbounds float addrspace(1)* %a, i64 %idxprom
+  %0 = load float addrspace(1)* %pa, align 4
+  %pb = getelementptr inbounds float addrspace(1)* %b, i64 %idxprom
+  %1 = load float addrspace(1)* %pb, align 4
+  %add = fadd float %0, %1
+  %pc = getelementptr inbounds float addrspace(1)* %c, i64 %idxprom
+  store float %add, float addrspace(1)* %pc, align 4
+  br label %if.end
+
+if.end:
+  ret void
+}
+
+define spir_kernel void @reduce(float addrspace(1)* %a, float addrspace(3)* %tmp) {
+entry:
+  %call = call spir_func i64 @_Z13get_global_idj(i32 0)
+  %lid = call spir_func i64 @_Z12get_local_idj(i32 0)
+  %pa = getelementptr inbounds float addrspace(1)* %a, i64 %call
+  %0 = load float addrspace(1)* %pa, align 4
+  %pt = getelementptr inbounds float addrspace(3)* %tmp, i64 %lid
+  store float %0, float addrspace(3)* %pt, align 4
+  call spir_func void @_Z7barrierj(i32 1)
+  %pt0 = getelementptr inbounds float addrspace(3)* %tmp, i64 0
+  %1 = load float addrspace(3)* %pt0, align 4
+  store float %1, float addrspace(1)* %pa, align 4
+  ret void
+}
+
+define spir_kernel void @private_copy(i32 addrspace(1)* %a) {
+entry:
+  %buf = alloca [2 x i32], align 4
+  %call = call spir_func i64 @_Z13get_global_idj(i32 0)
+  %pa = getelementptr inbounds i32 addrspace(1)* %a, i64 %call
+  %0 = load i32 addrspace(1)* %pa, align 4
+  %pb = getelementptr inbounds [2 x i32]* %buf, i64 0, i64 1
+  store i32 %0, i32* %pb, align 4
+  %1 = load i32* %pb, align 4
+  %inc = add i32 %1, 1
+  store i32 %inc, i32 addrspace(1)* %pa, align 4
+  ret void
+}
+
+define spir_kernel void @ifelse(float addrspace(1)* %a, float addrspace(1)* %b) {
+entry:
+  %call = call spir_func i64 @_Z13get_global_idj(i32 0)
+  %pa = getelementptr inbounds float addrspace(1)* %a, i64 %call
+  %x = load float addrspace(1)* %pa, align 4
+  %pb = getelementptr inbounds float addrspace(1)* %b, i64 %call
+  %cmp = fcmp ogt float %x, 0.000000e+00
+  br i1 %cmp, label %if.then, label %if.else
+
+if.then:
+  %mul = fmul float %x, 2.000000e+00
+  store float %mul, float addrspace(1)* %pb, align 4
+  br label %if.end
+
+if.else:
+  %neg = fsub float 0.000000e+00, %x
+  store float %neg, float addrspace(1)* %pb, align 4
+  br label %if.end
+
+if.end:
+  ret void
+}
+
+define spir_kernel void @sumto(i32 addrspace(1)* %a, i32 %n) {
+entry:
+  %call = call spir_func i64 @_Z13get_global_idj(i32 0)
+  %pa = getelementptr inbounds i32 addrspace(1)* %a, i64 %call
+  %v = load i32 addrspace(1)* %pa, align 4
+  %pos = icmp sgt i32 %v, 0
+  br i1 %pos, label %for.body, label %if.end
+
+for.body:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  %s = phi i32 [ %v, %entry ], [ %add, %for.body ]
+  %add = add i32 %s, %i
+  %inc = add i32 %i, 1
+  %more = icmp slt i32 %inc, %n
+  br i1 %more, label %for.body, label %if.end
+
+if.end:
+  %r = phi i32 [ %v, %entry ], [ %add, %for.body ]
+  store i32 %r, i32 addrspace(1)* %pa, align 4
+  ret void
+}
+
+declare spir_func i64 @_Z13get_global_idj(i32)
+
+declare spir_func i64 @_Z12get_local_idj(i32)
+
+declare spir_func void @_Z7barrierj(i32)
+
+!opencl.kernels = !{!0, !6, !12, !20, !21}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!18}
+!opencl.ocl.version = !{!18}
+!opencl.used.extensions = !{!19}
+!opencl.used.optional.core.features = !{!19}
+!opencl.compiler.options = !{!19}
+
+!0 = !{void (float addrspace(1)*, float addrspace(1)*, float addrspace(1)*, i32)* @vadd, !1, !2, !3, !4, !5}
+!1 = !{!"kernel_arg_addr_space", i32 1, i32 1, i32 1, i32 0}
+!2 = !{!"kernel_arg_access_qual", !"none", !"none", !"none", !"none"}
+!3 = !{!"kernel_arg_type", !"float*", !"float*", !"float*", !"int"}
+!4 = !{!"kernel_arg_base_type", !"float*", !"float*", !"float*", !"int"}
+!5 = !{!"kernel_arg_type_qual", !"", !"", !"", !""}
+!6 = !{void (float addrspace(1)*, float addrspace(3)*)* @reduce, !7, !8, !9, !10, !11}
+!7 = !{!"kernel_arg_addr_space", i32 1, i32 3}
+!8 = !{!"kernel_arg_access_qual", !"none", !"none"}
+!9 = !{!"kernel_arg_type", !"float*", !"float*"}
+!10 = !{!"kernel_arg_base_type", !"float*", !"float*"}
+!11 = !{!"kernel_arg_type_qual", !"", !""}
+!12 = !{void (i32 addrspace(1)*)* @private_copy, !13, !14, !15, !16, !17}
+!13 = !{!"kernel_arg_addr_space", i32 1}
+!14 = !{!"kernel_arg_access_qual", !"none"}
+!15 = !{!"kernel_arg_type", !"int*"}
+!16 = !{!"kernel_arg_base_type", !"int*"}
+!17 = !{!"kernel_arg_type_qual", !""}
+!18 = !{i32 1, i32 2}
+!19 = !{}
+!20 = !{void (float addrspace(1)*, float addrspace(1)*)* @ifelse, !7, !8, !9, !10, !11}
+!21 = !{void (i32 addrspace(1)*, i32)* @sumto, !22, !23, !24, !25, !26}
+!22 = !{!"kernel_arg_addr_space", i32 1, i32 0}
+!23 = !{!"kernel_arg_access_qual", !"none", !"none"}
+!24 = !{!"kernel_arg_type", !"int*", !"int"}
+!25 = !{!"kernel_arg_base_type", !"int*", !"int"}
+!26 = !{!"kernel_arg_type_qual", !"", !""}
@@ -0,0 +1,54 @@
+; RUN: llvm-as %s -o %t.o
+; RUN: ld -plugin %llvmshlibdir/LLVMgold.so -m elf_x86_64 \
+; RUN:    --plugin-opt=jobs=2 \
+; RUN:    --plugin-opt=obj-path=%t2.o \
+; RUN:    -shared %t.o -o %t3.o
+; RUN: llvm-nm %t2.o | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-nm %t2.o.1 | FileCheck --check-prefix=CHECK1 %s
+; RUN: llvm-nm %t3.o | FileCheck --check-prefix=LINKED %s
+; RUN: not ld -plugin %llvmshlibdir/LLVMgold.so -m elf_x86_64 \
+; RUN:    --plugin-opt=jobs=0 \
+; RUN:    -shared %t.o -o %t4.o 2>&1 | FileCheck --check-prefix=ZERO %s
+
+; Each object is added to the link, so the references between them are
+; resolved and the hidden symbols they share become local to the output.
+
+; CHECK0: U helper
+; CHECK1: T helper
+
+; LINKED: T bar
+; LINKED: T foo
+; LINKED: t helper
+; LINKED: r table
+
+; ZERO: Invalid parallelism level: jobs=0
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@table = internal constant [4 x i32] [i32 1, i32 2, i32 3, i32 5]
+
+define i32 @foo(i32 %x, i32 %y) {
+  %a = mul i32 %x, %y
+  %b = add i32 %a, %x
+  %c = xor i32 %b, %y
+  %d = shl i32 %c, 3
+  %e = call i32 @helper(i32 %d)
+  %i = and i32 %e, 3
+  %p = getelementptr [4 x i32]* @table, i32 0, i32 %i
+  %v = load i32* %p
+  %f = sub i32 %v, %a
+  ret i32 %f
+}
+
+define internal i32 @helper(i32 %x) noinline {
+  %p = getelementptr [4 x i32]* @table, i32 0, i32 1
+  %v = load i32* %p
+  %r = add i32 %x, %v
+  ret i32 %r
+}
+
+define i32 @bar(i32 %x) {
+  %r = call i32 @helper(i32 %x)
+  ret i32 %r
+}
@@ -14,10 +14,12 @@
 
 #include "llvm/Config/config.h" // plugin-api.h requires HAVE_STDINT_H
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/Analysis.h"
 #include "llvm/CodeGen/CommandFlags.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
@@ -93,6 +95,8 @@ namespace options {
   static std::string extra_library_path;
   static std::string triple;
   static std::string mcpu;
+  // Number of object files, each generated on its own thread.
+  static unsigned Parallelism = 1;
   // Additional options to pass into the code generator.
   // Note: This array will contain all plugin options which are not claimed
   // as plugin exclusive to pass to the code generator.
@@ -116,6 +120,10 @@ namespace options {
       triple = opt.substr(strlen("mtriple="));
     } else if (opt.startswith("obj-path=")) {
       obj_path = opt.substr(strlen("obj-path="));
+    } else if (opt.startswith("jobs=")) {
+      if (opt.substr(strlen("jobs=")).getAsInteger(10, Parallelism) ||
+          !Parallelism)
+        message(LDPL_FATAL, "Invalid parallelism level: %s", opt_);
     } else if (opt == "emit-llvm") {
       TheOutputType = OT_BC_ONLY;
     } else if (opt == "save-temps") {
@@ -739,42 +747,50 @@ static void codegen(Module &M) {
   if (options::TheOutputType == options::OT_SAVE_TEMPS)
     saveBCFile(output_name + ".opt.bc", M);
 
-  PassManager CodeGenPasses;
-  CodeGenPasses.add(new DataLayoutPass());
-
-  SmallString<128> Filename;
-  int FD;
-  if (options::obj_path.empty()) {
-    std::error_code EC =
-        sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
-    if (EC)
-      message(LDPL_FATAL, "Could not create temporary file: %s",
-              EC.message().c_str());
-  } else {
-    Filename = options::obj_path;
-    std::error_code EC =
-        sys::fs::openFileForWrite(Filename.c_str(), FD, sys::fs::F_None);
-    if (EC)
-      message(LDPL_FATAL, "Could not open file: %s", EC.message().c_str());
+  // With obj-path and several jobs, the first object is written to obj-path
+  // and the others to obj-path.1, obj-path.2, ...
+  std::vector<std::string> Filenames;
+  std::vector<std::unique_ptr<raw_fd_ostream>> OSs;
+  for (unsigned I = 0; I != options::Parallelism; ++I) {
+    SmallString<128> Filename;
+    int FD;
+    if (options::obj_path.empty()) {
+      std::error_code EC =
+          sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
+      if (EC)
+        message(LDPL_FATAL, "Could not create temporary file: %s",
+                EC.message().c_str());
+    } else {
+      Filename = options::obj_path;
+      if (I)
+        Filename += "." + utostr(I);
+      std::error_code EC =
+          sys::fs::openFileForWrite(Filename.c_str(), FD, sys::fs::F_None);
+      if (EC)
+        message(LDPL_FATAL, "Could not open file: %s", EC.message().c_str());
+    }
+    Filenames.push_back(Filename.str());
+    OSs.emplace_back(new raw_fd_ostream(FD, true));
   }
 
   {
-    raw_fd_ostream OS(FD, true);
-    formatted_raw_ostream FOS(OS);
-
-    if (TM->addPassesToEmitFile(CodeGenPasses, FOS,
-                                TargetMachine::CGFT_ObjectFile))
-      message(LDPL_FATAL, "Failed to setup codegen");
-    CodeGenPasses.run(M);
+    std::vector<raw_ostream *> OSPtrs;
+    for (std::unique_ptr<raw_fd_ostream> &OS : OSs)
+      OSPtrs.push_back(OS.get());
+    if (splitCodeGen(M, OSPtrs, *TM, TargetMachine::CGFT_ObjectFile, ErrMsg))
+      message(LDPL_FATAL, "Failed to setup codegen: %s", ErrMsg.c_str());
+    OSs.clear();
   }
 
-  if (add_input_file(Filename.c_str()) != LDPS_OK)
-    message(LDPL_FATAL,
-            "Unable to add .o file to the link. File left behind in: %s",
-            Filename.c_str());
+  for (const std::string &Filename : Filenames) {
+    if (add_input_file(Filename.c_str()) != LDPS_OK)
+      message(LDPL_FATAL,
+              "Unable to add .o file to the link. File left behind in: %s",
+              Filename.c_str());
 
-  if (options::obj_path.empty())
-    Cleanup.push_back(Filename.c_str());
+    if (options::obj_path.empty())
+      Cleanup.push_back(Filename);
+  }
 }
 
 /// gold informs us that all symbols have been read. At this point, we use
@@ -20,6 +20,7 @@
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
+#include "llvm/ExecutionEngine/DiskObjectCache.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/Interpreter.h"
 #include "llvm/ExecutionEngine/JITEventListener.h"
@@ -153,6 +154,18 @@ namespace {
                            "(must be user writable)"),
                   cl::init(""));
 
+  cl::opt<std::string>
+  CacheDir("cache-dir",
+           cl::desc("Directory of a cache of compiled objects shared by all "
+                    "modules and runs"),
+           cl::value_desc("directory"));
+
+  cl::opt<unsigned>
+  CacheSizeLimit("cache-size-limit",
+                 cl::desc("Maximum size of -cache-dir in megabytes "
+                          "(default = unlimited)"),
+                 cl::init(0));
+
   cl::opt<std::string>
   FakeArgv0("fake-argv0",
             cl::desc("Override the 'argv[0]' value passed into the executing"
@@ -311,7 +324,7 @@ private:
 };
 
 static ExecutionEngine *EE = nullptr;
-static LLIObjectCache *CacheManager = nullptr;
+static ObjectCache *CacheManager = nullptr;
 
 static void do_shutdown() {
   // Cygwin-1.5 invokes DLL's dtors before atexit handler.
@@ -484,6 +497,14 @@ int main(int argc, char **argv, char * const *envp) {
   if (EnableCacheManager) {
     CacheManager = new LLIObjectCache(ObjectCacheDir);
     EE->setObjectCache(CacheManager);
+  } else if (!CacheDir.empty() && !ForceInterpreter) {
+    TargetMachine *TM = EE->getTargetMachine();
+    CacheManager = new DiskObjectCache(
+        CacheDir, TM->getTargetTriple(), TM->getTargetCPU(),
+        TM->getTargetFeatureString(), TM->getOptLevel(),
+        uint64_t(CacheSizeLimit) << 20, TM->getRelocationModel(),
+        TM->getCodeModel(), TM->Options);
+    EE->setObjectCache(CacheManager);
   }
 
   // Load any additional modules specified on the command line.
@@ -28,6 +28,7 @@
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SystemUtils.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include <memory>
 using namespace llvm;
@@ -40,6 +41,10 @@ static cl::opt<std::string>
 OutputFilename("o", cl::desc("Override output filename"), cl::init("-"),
                cl::value_desc("filename"));
 
+static cl::opt<bool>
+OnlyNeeded("only-needed",
+           cl::desc("Link only needed symbols from all but the first input"));
+
 static cl::opt<bool>
 Force("f", cl::desc("Enable binary output on terminals"));
 
@@ -57,6 +62,11 @@ static cl::opt<bool>
 SuppressWarnings("suppress-warnings", cl::desc("Suppress all linking warnings"),
                  cl::init(false));
 
+static cl::opt<unsigned>
+Threads("threads", cl::init(1),
+        cl::desc("Number of threads loading the input files "
+                 "(0 = one per hardware thread)"));
+
 // Read the specified bitcode file in and return it. This routine searches the
 // link path for the specified file to try to find it...
 //
@@ -71,6 +81,47 @@ loadFile(const char *argv0, const std::string &FN, LLVMContext &Context) {
   return Result;
 }
 
+namespace {
+/// An input file staged by a loader thread, ready to be lazily read into the
+/// shared context.
+struct StagedFile {
+  std::unique_ptr<MemoryBuffer> Buffer;
+  SMDiagnostic Err;
+};
+}
+
+// Read the specified file in. LLVM assembly is parsed into a private context
+// and handed over as bitcode, so that the expensive parsing can run on any
+// thread and only the cheap lazy bitcode reading needs the shared context.
+//
+static void stageFile(const std::string &FN, StagedFile &Staged) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> FileOrErr =
+      MemoryBuffer::getFileOrSTDIN(FN);
+  if (std::error_code EC = FileOrErr.getError()) {
+    Staged.Err = SMDiagnostic(FN, SourceMgr::DK_Error,
+                              "Could not open input file: " + EC.message());
+    return;
+  }
+  std::unique_ptr<MemoryBuffer> &Buffer = FileOrErr.get();
+  if (isBitcode((const unsigned char *)Buffer->getBufferStart(),
+                (const unsigned char *)Buffer->getBufferEnd())) {
+    Staged.Buffer = std::move(Buffer);
+    return;
+  }
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M = parseIR(Buffer->getMemBufferRef(), Staged.Err,
+                                      Context);
+  if (!M)
+    return;
+  SmallVector<char, 0> Bitcode;
+  raw_svector_ostream OS(Bitcode);
+  WriteBitcodeToFile(M.get(), OS);
+  OS.flush();
+  Staged.Buffer = MemoryBuffer::getMemBufferCopy(
+      StringRef(Bitcode.data(), Bitcode.size()), FN);
+}
+
 static void diagnosticHandler(const DiagnosticInfo &DI) {
   unsigned Severity = DI.getSeverity();
   switch (Severity) {
@@ -104,8 +155,30 @@ int main(int argc, char **argv) {
   auto Composite = make_unique<Module>("llvm-link", Context);
   Linker L(Composite.get(), diagnosticHandler);
 
+  // Load the inputs concurrently. Linking needs them all in one context, so
+  // it still happens in command line order below, which keeps the symbol
+  // resolution and the output independent of the number of threads.
+  std::vector<StagedFile> Staged;
+  if (unsigned NumWorkers = getWorkerThreadCount(Threads)) {
+    Staged.resize(InputFilenames.size());
+    ThreadPool Pool(NumWorkers);
+    parallel_for(Pool, size_t(0), InputFilenames.size(), [&](size_t i) {
+      stageFile(InputFilenames[i], Staged[i]);
+    });
+  }
+
   for (unsigned i = 0; i < InputFilenames.size(); ++i) {
-    std::unique_ptr<Module> M = loadFile(argv[0], InputFilenames[i], Context);
+    std::unique_ptr<Module> M;
+    if (Staged.empty()) {
+      M = loadFile(argv[0], InputFilenames[i], Context);
+    } else {
+      if (Verbose) errs() << "Loading '" << InputFilenames[i] << "'\n";
+      if (Staged[i].Buffer)
+        M = getLazyIRModule(std::move(Staged[i].Buffer), Staged[i].Err,
+                            Context);
+      if (!M)
+        Staged[i].Err.print(argv[0], errs());
+    }
     if (!M.get()) {
       errs() << argv[0] << ": error loading file '" <<InputFilenames[i]<< "'\n";
       return 1;
@@ -113,7 +186,12 @@ int main(int argc, char **argv) {
 
     if (Verbose) errs() << "Linking in '" << InputFilenames[i] << "'\n";
 
-    if (L.linkInModule(M.get()))
+    // The first input makes up the composite; the others only resolve it.
+    unsigned Flags = Linker::Flags::None;
+    if (OnlyNeeded && i != 0)
+      Flags |= Linker::Flags::LinkOnlyNeeded;
+
+    if (L.linkInModule(M.get(), Flags))
       return 1;
   }
 
@@ -12,6 +12,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/LTO/LTOCodeGenerator.h"
@@ -42,6 +43,10 @@ static cl::opt<bool>
 DisableLTOVectorization("disable-lto-vectorization", cl::init(false),
   cl::desc("Do not run loop or slp vectorization during LTO"));
 
+static cl::opt<unsigned>
+Parallelism("j", cl::Prefix, cl::init(1),
+  cl::desc("Number of object files to generate, each on its own thread"));
+
 static cl::opt<bool>
 UseDiagnosticHandler("use-diagnostic-handler", cl::init(false),
   cl::desc("Use a diagnostic handler to test the handler interface"));
@@ -227,7 +232,38 @@ int main(int argc, char **argv) {
   if (!attrs.empty())
     CodeGen.setAttr(attrs.c_str());
 
-  if (!OutputFilename.empty()) {
+  if (Parallelism > 1) {
+    // With -o, the first object file is written to the output file and the
+    // others to <output>.1, <output>.2, ...
+    CodeGen.setParallelism(Parallelism);
+    std::string ErrorInfo;
+    ArrayRef<const char *> OutputNames;
+    if (!CodeGen.compile_to_files(OutputNames, DisableOpt, DisableInline,
+                                  DisableGVNLoadPRE, DisableLTOVectorization,
+                                  ErrorInfo)) {
+      errs() << argv[0]
+             << ": error compiling the code: " << ErrorInfo
+             << "\n";
+      return 1;
+    }
+
+    for (unsigned I = 0, E = OutputNames.size(); I != E; ++I) {
+      if (OutputFilename.empty()) {
+        outs() << "Wrote native object file '" << OutputNames[I] << "'\n";
+        continue;
+      }
+      std::string PartFilename = OutputFilename;
+      if (I)
+        PartFilename += "." + utostr(I);
+      if (std::error_code EC = sys::fs::copy_file(OutputNames[I],
+                                                  PartFilename)) {
+        errs() << argv[0] << ": error writing the file '" << PartFilename
+               << "': " << EC.message() << "\n";
+        return 1;
+      }
+      sys::fs::remove(OutputNames[I]);
+    }
+  } else if (!OutputFilename.empty()) {
     size_t len = 0;
     std::string ErrorInfo;
     const void *Code =
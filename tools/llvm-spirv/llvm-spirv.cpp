@@ -49,10 +49,12 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/PassManager.h"
 #include "llvm/Support/CommandLine.h"
-#include "llvm/Support/DataStream.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Signals.h"
@@ -92,6 +94,26 @@ static cl::opt<bool>
 IsRegularization("s", cl::desc(
     "Regularize LLVM to be representable by SPIR-V"));
 
+static cl::opt<bool>
+IsOptimization("opt", cl::desc(
+    "Run cleanup passes on SPIR-V (SPIR-V to SPIR-V)"));
+
+static cl::opt<bool>
+GenIndex("spirv-index", cl::desc(
+    "Write a random-access index of the SPIR-V binary to <output>.idx"));
+
+static cl::list<std::string>
+IndexedFuncs("spirv-index-funcs", cl::CommaSeparated,
+    cl::desc("Use <input>.idx to translate only the bodies of the given "
+             "functions (SPIR-V to LLVM)"),
+    cl::value_desc("function names"));
+
+static cl::opt<unsigned>
+VectorizeWorkItems("vectorize-work-items", cl::init(0),
+    cl::desc("Add work-group functions to the translated kernels which run "
+             "<N> work-items at a time, for execution on a CPU"),
+    cl::value_desc("N"));
+
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
 namespace SPIRV {
 // Use textual format for SPIRV.
@@ -114,31 +136,43 @@ removeExt(const std::string& FileName) {
   return FileName;
 }
 
-static int
-convertLLVMToSPIRV() {
-  LLVMContext Context;
-
-  std::string Err;
-  DataStreamer *DS = getDataFileStreamer(InputFile, &Err);
-  if (!DS) {
-    errs() << "Fails to open input file: " << Err;
-    return -1;
+/// Load and materialize the input bitcode. The input is read into memory
+/// rather than streamed so that -bitcode-materialize-threads can decode the
+/// function bodies in parallel.
+static std::unique_ptr<Module>
+loadLLVMModule(LLVMContext &Context) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+      MemoryBuffer::getFileOrSTDIN(InputFile);
+  if (std::error_code EC = BufOrErr.getError()) {
+    errs() << "Fails to open input file: " << EC.message();
+    return nullptr;
   }
 
-  ErrorOr<std::unique_ptr<Module>> MOrErr =
-      getStreamedBitcodeModule(InputFile, DS, Context);
+  ErrorOr<Module *> MOrErr =
+      getLazyBitcodeModule(std::move(*BufOrErr), Context);
 
   if (std::error_code EC = MOrErr.getError()) {
     errs() << "Fails to load bitcode: " << EC.message();
-    return -1;
+    return nullptr;
   }
 
-  std::unique_ptr<Module> M = std::move(*MOrErr);
+  std::unique_ptr<Module> M(*MOrErr);
 
   if (std::error_code EC = M->materializeAllPermanently()){
     errs() << "Fails to materialize: " << EC.message();
-    return -1;
+    return nullptr;
   }
+  return M;
+}
+
+static int
+convertLLVMToSPIRV() {
+  LLVMContext Context;
+
+  std::string Err;
+  std::unique_ptr<Module> M = loadLLVMModule(Context);
+  if (!M)
+    return -1;
 
   if (OutputFile.empty()) {
     if (InputFile == "-")
@@ -151,6 +185,23 @@ convertLLVMToSPIRV() {
   llvm::StringRef outFile(OutputFile);
   std::error_code EC;
   llvm::raw_fd_ostream OFS(outFile, EC, llvm::sys::fs::F_None);
+  if (GenIndex) {
+    if (OutputFile == "-") {
+      errs() << "Cannot write SPIR-V index for standard output\n";
+      return -1;
+    }
+    llvm::raw_fd_ostream IndexOFS(llvm::StringRef(OutputFile + ".idx"), EC,
+        llvm::sys::fs::F_None);
+    if (EC) {
+      errs() << "Fails to open index file: " << EC.message();
+      return -1;
+    }
+    if (!WriteSPIRV(M.get(), OFS, IndexOFS, Err)) {
+      errs() << "Fails to save LLVM as SPIRV: " << Err << '\n';
+      return -1;
+    }
+    return 0;
+  }
   if (!WriteSPIRV(M.get(), OFS, Err)) {
     errs() << "Fails to save LLVM as SPIRV: " << Err << '\n';
     return -1;
@@ -165,16 +216,28 @@ convertSPIRVToLLVM() {
   Module *M;
   std::string Err;
 
-  if (!ReadSPIRV(Context, IFS, M, Err)) {
+  if (!IndexedFuncs.empty()) {
+    std::ifstream IndexIFS(InputFile + ".idx", std::ios::binary);
+    std::vector<std::string> Names(IndexedFuncs.begin(), IndexedFuncs.end());
+    if (!ReadSPIRV(Context, IFS, IndexIFS, Names, M, Err)) {
+      errs() << "Fails to load SPIRV as LLVM Module: " << Err << '\n';
+      return -1;
+    }
+  } else if (!ReadSPIRV(Context, IFS, M, Err)) {
     errs() << "Fails to load SPIRV as LLVM Module: " << Err << '\n';
     return -1;
   }
 
   DEBUG(dbgs() << "Converted LLVM module:\n" << *M);
 
+  if (VectorizeWorkItems) {
+    PassManager PassMgr;
+    PassMgr.add(createOCLVectorizeWorkItems(VectorizeWorkItems));
+    PassMgr.run(*M);
+  }
 
   raw_string_ostream ErrorOS(Err);
-  if (verifyModule(*M, &ErrorOS)){
+  if (verifyModuleParallel(*M, &ErrorOS)){
     errs() << "Fails to verify module: " << ErrorOS.str();
     return -1;
   }
@@ -235,30 +298,39 @@ convertSPIRV() {
 #endif
 
 static int
-regularizeLLVM() {
-  LLVMContext Context;
+optimizeSPIRV() {
+  std::ifstream IFS(InputFile, std::ios::binary);
 
-  std::string Err;
-  DataStreamer *DS = getDataFileStreamer(InputFile, &Err);
-  if (!DS) {
-    errs() << "Fails to open input file: " << Err;
-    return -1;
+  if (OutputFile.empty()) {
+    if (InputFile == "-")
+      OutputFile = "-";
+    else
+      OutputFile = removeExt(InputFile) + ".opt" +
+                   (SPIRV::SPIRVUseTextFormat ? kExt::SpirvText : kExt::SpirvBinary);
   }
 
-  ErrorOr<std::unique_ptr<Module>> MOrErr =
-      getStreamedBitcodeModule(InputFile, DS, Context);
-
-  if (std::error_code EC = MOrErr.getError()) {
-    errs() << "Fails to load bitcode: " << EC.message();
+  std::error_code EC;
+  llvm::raw_fd_ostream OFS(llvm::StringRef(OutputFile), EC, llvm::sys::fs::F_None);
+  if (EC) {
+    errs() << "Fails to open output file: " << EC.message();
     return -1;
   }
+  std::string Err;
+  if (!SPIRV::OptimizeSPIRV(IFS, OFS, Err)) {
+    errs() << "Fails to optimize SPIR-V : " << Err << '\n';
+    return -1;
+  }
+  return 0;
+}
 
-  std::unique_ptr<Module> M = std::move(*MOrErr);
+static int
+regularizeLLVM() {
+  LLVMContext Context;
 
-  if (std::error_code EC = M->materializeAllPermanently()){
-    errs() << "Fails to materialize: " << EC.message();
+  std::string Err;
+  std::unique_ptr<Module> M = loadLLVMModule(Context);
+  if (!M)
     return -1;
-  }
 
   if (OutputFile.empty()) {
     if (InputFile == "-")
@@ -290,17 +362,29 @@ main(int ac, char** av) {
   EnablePrettyStackTrace();
   sys::PrintStackTraceOnErrorSignal();
   PrettyStackTraceProgram X(ac, av);
+  llvm_shutdown_obj Y;  // Print -stats and -time-passes reports on exit.
 
   cl::ParseCommandLineOptions(ac, av, "LLVM/SPIR-V translator");
 
+  if (GenIndex && (IsReverse || IsRegularization || IsOptimization ||
+      SPIRV::SPIRVUseTextFormat)) {
+    errs() << "Cannot use -spirv-index with -r, -s, -opt, -spirv-text\n";
+    return -1;
+  }
+
+  if (!IndexedFuncs.empty() && !IsReverse) {
+    errs() << "Cannot use -spirv-index-funcs without -r\n";
+    return -1;
+  }
+
 #ifdef _SPIRV_SUPPORT_TEXT_FMT
-  if (ToText && (ToBinary || IsReverse || IsRegularization)) {
-    errs() << "Cannot use -to-text with -to-binary, -r, -s\n";
+  if (ToText && (ToBinary || IsReverse || IsRegularization || IsOptimization)) {
+    errs() << "Cannot use -to-text with -to-binary, -r, -s, -opt\n";
     return -1;
   }
 
-  if (ToBinary && (ToText || IsReverse || IsRegularization)) {
-    errs() << "Cannot use -to-binary with -to-text, -r, -s\n";
+  if (ToBinary && (ToText || IsReverse || IsRegularization || IsOptimization)) {
+    errs() << "Cannot use -to-binary with -to-text, -r, -s, -opt\n";
     return -1;
   }
 
@@ -308,6 +392,14 @@ main(int ac, char** av) {
     return convertSPIRV();
 #endif
 
+  if (IsOptimization) {
+    if (IsReverse || IsRegularization) {
+      errs() << "Cannot use -opt with -r, -s\n";
+      return -1;
+    }
+    return optimizeSPIRV();
+  }
+
   if (!IsReverse && !IsRegularization)
     return convertLLVMToSPIRV();
 
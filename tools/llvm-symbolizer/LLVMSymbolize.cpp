@@ -199,11 +199,49 @@ bool ModuleInfo::symbolizeData(uint64_t ModuleOffset, std::string &Name,
 
 const char LLVMSymbolizer::kBadString[] = "??";
 
+const std::string *ResultCache::lookup(const ModuleInfo *Info,
+                                       uint64_t ModuleOffset) {
+  auto It = EntryMap.find(std::make_pair(Info, ModuleOffset));
+  if (It == EntryMap.end())
+    return nullptr;
+  Entries.splice(Entries.begin(), Entries, It->second);
+  return &It->second->second;
+}
+
+void ResultCache::insert(const ModuleInfo *Info, uint64_t ModuleOffset,
+                         const std::string &Result) {
+  if (Capacity == 0)
+    return;
+  KeyTy Key = std::make_pair(Info, ModuleOffset);
+  if (EntryMap.count(Key))
+    return;
+  if (Entries.size() == Capacity) {
+    EntryMap.erase(Entries.back().first);
+    Entries.pop_back();
+  }
+  Entries.push_front(std::make_pair(Key, Result));
+  EntryMap[Key] = Entries.begin();
+}
+
+void ResultCache::clear() {
+  Entries.clear();
+  EntryMap.clear();
+}
+
 std::string LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
                                           uint64_t ModuleOffset) {
   ModuleInfo *Info = getOrCreateModuleInfo(ModuleName);
   if (!Info)
     return printDILineInfo(DILineInfo());
+  if (const std::string *Cached = CodeCache.lookup(Info, ModuleOffset))
+    return *Cached;
+  std::string Result = symbolizeCodeInModule(Info, ModuleOffset);
+  CodeCache.insert(Info, ModuleOffset, Result);
+  return Result;
+}
+
+std::string LLVMSymbolizer::symbolizeCodeInModule(ModuleInfo *Info,
+                                                  uint64_t ModuleOffset) const {
   if (Opts.PrintInlining) {
     DIInliningInfo InlinedContext =
         Info->symbolizeInlinedCode(ModuleOffset, Opts);
@@ -222,21 +260,34 @@ std::string LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
 
 std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
                                           uint64_t ModuleOffset) {
+  ModuleInfo *Info =
+      Opts.UseSymbolTable ? getOrCreateModuleInfo(ModuleName) : nullptr;
+  if (!Info)
+    return symbolizeDataInModule(nullptr, ModuleOffset);
+  if (const std::string *Cached = DataCache.lookup(Info, ModuleOffset))
+    return *Cached;
+  std::string Result = symbolizeDataInModule(Info, ModuleOffset);
+  DataCache.insert(Info, ModuleOffset, Result);
+  return Result;
+}
+
+std::string LLVMSymbolizer::symbolizeDataInModule(ModuleInfo *Info,
+                                                  uint64_t ModuleOffset) const {
   std::string Name = kBadString;
   uint64_t Start = 0;
   uint64_t Size = 0;
-  if (Opts.UseSymbolTable) {
-    if (ModuleInfo *Info = getOrCreateModuleInfo(ModuleName)) {
-      if (Info->symbolizeData(ModuleOffset, Name, Start, Size) && Opts.Demangle)
-        Name = DemangleName(Name);
-    }
-  }
+  if (Info && Info->symbolizeData(ModuleOffset, Name, Start, Size) &&
+      Opts.Demangle)
+    Name = DemangleName(Name);
   std::stringstream ss;
   ss << Name << "\n" << Start << " " << Size << "\n";
   return ss.str();
 }
 
 void LLVMSymbolizer::flush() {
+  // Cached results are keyed by the module infos deleted below.
+  CodeCache.clear();
+  DataCache.clear();
   DeleteContainerSeconds(Modules);
   ObjectPairForPathArch.clear();
   ObjectFileForArch.clear();
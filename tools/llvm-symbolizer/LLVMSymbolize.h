@@ -13,12 +13,14 @@
 #ifndef LLVM_TOOLS_LLVM_SYMBOLIZER_LLVMSYMBOLIZE_H
 #define LLVM_TOOLS_LLVM_SYMBOLIZER_LLVMSYMBOLIZE_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/Object/MachOUniversal.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <list>
 #include <map>
 #include <memory>
 #include <string>
@@ -32,6 +34,28 @@ namespace symbolize {
 
 class ModuleInfo;
 
+/// ResultCache - keeps the most recently used symbolization results, at most
+/// Capacity of them.
+class ResultCache {
+public:
+  explicit ResultCache(unsigned Capacity) : Capacity(Capacity) {}
+
+  /// Returns the cached result for ModuleOffset in Info, or null.
+  const std::string *lookup(const ModuleInfo *Info, uint64_t ModuleOffset);
+  void insert(const ModuleInfo *Info, uint64_t ModuleOffset,
+              const std::string &Result);
+  void clear();
+
+private:
+  typedef std::pair<const ModuleInfo *, uint64_t> KeyTy;
+  typedef std::list<std::pair<KeyTy, std::string>> EntryList;
+
+  // Most recently used entries come first.
+  EntryList Entries;
+  DenseMap<KeyTy, EntryList::iterator> EntryMap;
+  unsigned Capacity;
+};
+
 class LLVMSymbolizer {
 public:
   struct Options {
@@ -41,16 +65,19 @@ public:
     bool Demangle : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
+    // Number of symbolized addresses to remember (0 disables the cache).
+    unsigned CacheSize;
     Options(bool UseSymbolTable = true,
             FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool PrintInlining = true, bool Demangle = true,
-            std::string DefaultArch = "")
+            std::string DefaultArch = "", unsigned CacheSize = 0)
         : UseSymbolTable(UseSymbolTable),
           PrintFunctions(PrintFunctions), PrintInlining(PrintInlining),
-          Demangle(Demangle), DefaultArch(DefaultArch) {}
+          Demangle(Demangle), DefaultArch(DefaultArch), CacheSize(CacheSize) {}
   };
 
-  LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
+  LLVMSymbolizer(const Options &Opts = Options())
+      : Opts(Opts), CodeCache(Opts.CacheSize), DataCache(Opts.CacheSize) {}
   ~LLVMSymbolizer() {
     flush();
   }
@@ -77,6 +104,10 @@ private:
   /// universal binary (or the binary itself if it is an object file).
   ObjectFile *getObjectFileFromBinary(Binary *Bin, const std::string &ArchName);
 
+  std::string symbolizeCodeInModule(ModuleInfo *Info,
+                                    uint64_t ModuleOffset) const;
+  std::string symbolizeDataInModule(ModuleInfo *Info,
+                                    uint64_t ModuleOffset) const;
   std::string printDILineInfo(DILineInfo LineInfo) const;
 
   // Owns all the parsed binaries and object files.
@@ -98,6 +129,8 @@ private:
       ObjectPairForPathArch;
 
   Options Opts;
+  ResultCache CodeCache;
+  ResultCache DataCache;
   static const char kBadString[];
 };
 
@@ -24,9 +24,12 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <tuple>
+#include <vector>
 
 using namespace llvm;
 using namespace symbolize;
@@ -67,6 +70,17 @@ ClDsymHint("dsym-hint", cl::ZeroOrMore,
            cl::desc("Path to .dSYM bundles to search for debug info for the "
                     "object files"));
 
+static cl::opt<unsigned>
+ClCacheSize("cache-size", cl::init(16384),
+            cl::desc("Number of symbolized addresses to remember "
+                     "(0 disables the cache)"));
+
+static cl::opt<bool>
+ClBatch("batch", cl::init(false),
+        cl::desc("Read the whole input first, symbolize the addresses of each "
+                 "object file in ascending order and print the results in "
+                 "input order"));
+
 static bool parseCommand(bool &IsData, std::string &ModuleName,
                          uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
@@ -116,6 +130,56 @@ static bool parseCommand(bool &IsData, std::string &ModuleName,
   return true;
 }
 
+namespace {
+struct Command {
+  bool IsData;
+  std::string ModuleName;
+  uint64_t ModuleOffset;
+
+  bool operator<(const Command &RHS) const {
+    return std::tie(ModuleName, IsData, ModuleOffset) <
+           std::tie(RHS.ModuleName, RHS.IsData, RHS.ModuleOffset);
+  }
+  bool operator==(const Command &RHS) const {
+    return !(*this < RHS) && !(RHS < *this);
+  }
+};
+}
+
+static std::string runCommand(LLVMSymbolizer &Symbolizer, const Command &Cmd) {
+  if (Cmd.IsData)
+    return Symbolizer.symbolizeData(Cmd.ModuleName, Cmd.ModuleOffset);
+  return Symbolizer.symbolizeCode(Cmd.ModuleName, Cmd.ModuleOffset);
+}
+
+// Symbolizes the whole input at once. Addresses are resolved grouped by object
+// file and in ascending order, so that the debug info of every object is
+// walked front to back and every distinct address is symbolized only once.
+static void symbolizeBatch(LLVMSymbolizer &Symbolizer) {
+  std::vector<Command> Commands;
+  Command Cmd;
+  while (parseCommand(Cmd.IsData, Cmd.ModuleName, Cmd.ModuleOffset))
+    Commands.push_back(Cmd);
+
+  std::vector<unsigned> Order(Commands.size());
+  for (unsigned I = 0, E = Commands.size(); I != E; ++I)
+    Order[I] = I;
+  std::stable_sort(Order.begin(), Order.end(), [&](unsigned L, unsigned R) {
+    return Commands[L] < Commands[R];
+  });
+
+  std::vector<std::string> Results(Commands.size());
+  for (unsigned I = 0, E = Order.size(); I != E; ++I) {
+    if (I > 0 && Commands[Order[I]] == Commands[Order[I - 1]])
+      Results[Order[I]] = Results[Order[I - 1]];
+    else
+      Results[Order[I]] = runCommand(Symbolizer, Commands[Order[I]]);
+  }
+  for (const std::string &Result : Results)
+    outs() << Result << "\n";
+  outs().flush();
+}
+
 int main(int argc, char **argv) {
   // Print stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -124,7 +188,8 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm-symbolizer\n");
   LLVMSymbolizer::Options Opts(ClUseSymbolTable, ClPrintFunctions,
-                               ClPrintInlining, ClDemangle, ClDefaultArch);
+                               ClPrintInlining, ClDemangle, ClDefaultArch,
+                               ClCacheSize);
   for (const auto &hint : ClDsymHint) {
     if (sys::path::extension(hint) == ".dSYM") {
       Opts.DsymHints.push_back(hint);
@@ -135,14 +200,14 @@ int main(int argc, char **argv) {
   }
   LLVMSymbolizer Symbolizer(Opts);
 
-  bool IsData = false;
-  std::string ModuleName;
-  uint64_t ModuleOffset;
-  while (parseCommand(IsData, ModuleName, ModuleOffset)) {
-    std::string Result =
-        IsData ? Symbolizer.symbolizeData(ModuleName, ModuleOffset)
-               : Symbolizer.symbolizeCode(ModuleName, ModuleOffset);
-    outs() << Result << "\n";
+  if (ClBatch) {
+    symbolizeBatch(Symbolizer);
+    return 0;
+  }
+
+  Command Cmd;
+  while (parseCommand(Cmd.IsData, Cmd.ModuleName, Cmd.ModuleOffset)) {
+    outs() << runCommand(Symbolizer, Cmd) << "\n";
     outs().flush();
   }
   return 0;
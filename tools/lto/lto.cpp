@@ -300,6 +300,27 @@ bool lto_codegen_compile_to_file(lto_code_gen_t cg, const char **name) {
       DisableLTOVectorization, sLastErrorString);
 }
 
+void lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned parallelism) {
+  unwrap(cg)->setParallelism(parallelism);
+}
+
+bool lto_codegen_compile_to_files(lto_code_gen_t cg, const char *const **names,
+                                  unsigned *count) {
+  if (!parsedOptions) {
+    unwrap(cg)->parseCodeGenDebugOptions();
+    lto_add_attrs(cg);
+    parsedOptions = true;
+  }
+  ArrayRef<const char *> Names;
+  if (!unwrap(cg)->compile_to_files(Names, DisableOpt, DisableInline,
+                                    DisableGVNLoadPRE, DisableLTOVectorization,
+                                    sLastErrorString))
+    return true;
+  *names = Names.data();
+  *count = Names.size();
+  return false;
+}
+
 void lto_codegen_debug_options(lto_code_gen_t cg, const char *opt) {
   unwrap(cg)->setCodeGenDebugOptions(opt);
 }
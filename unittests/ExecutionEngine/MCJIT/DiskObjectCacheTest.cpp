@@ -0,0 +1,176 @@
+//===- DiskObjectCacheTest.cpp - Unit tests for DiskObjectCache -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ExecutionEngine/DiskObjectCache.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class DiskObjectCacheTest : public testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_FALSE(sys::fs::createUniqueDirectory("DiskObjectCacheTest", Dir));
+  }
+
+  void TearDown() override {
+    std::error_code EC;
+    for (sys::fs::directory_iterator I(Dir.str(), EC), E; I != E && !EC;
+         I.increment(EC))
+      sys::fs::remove(I->path());
+    sys::fs::remove(Dir.str());
+  }
+
+  std::unique_ptr<Module> createModule(StringRef ID, int Value) {
+    auto M = make_unique<Module>(ID, Context);
+    Type *Int32Ty = Type::getInt32Ty(Context);
+    new GlobalVariable(*M, Int32Ty, false, GlobalValue::ExternalLinkage,
+                       ConstantInt::get(Int32Ty, Value), "G");
+    return M;
+  }
+
+  /// Return the number of objects in the cache directory.
+  unsigned countObjects() {
+    unsigned Count = 0;
+    std::error_code EC;
+    for (sys::fs::directory_iterator I(Dir.str(), EC), E; I != E && !EC;
+         I.increment(EC))
+      if (sys::path::extension(I->path()) == ".o")
+        ++Count;
+    return Count;
+  }
+
+  void setLastUsed(DiskObjectCache &Cache, const Module *M,
+                   uint64_t SecondsAgo) {
+    SmallString<128> Path;
+    ASSERT_TRUE(Cache.getCacheFile(M, Path));
+    int FD;
+    ASSERT_FALSE(sys::fs::openFileForWrite(Path.str(), FD, sys::fs::F_Append));
+    sys::TimeValue Time =
+        sys::TimeValue::now() - sys::TimeValue(SecondsAgo, 0);
+    ASSERT_FALSE(sys::fs::setLastModificationAndAccessTime(FD, Time));
+    sys::Process::SafelyCloseFileDescriptor(FD);
+  }
+
+  LLVMContext Context;
+  SmallString<128> Dir;
+};
+
+TEST_F(DiskObjectCacheTest, Key) {
+  DiskObjectCache Cache(Dir, "", "cpu", "+feature", CodeGenOpt::Default);
+  DiskObjectCache OtherCPU(Dir, "", "other", "+feature", CodeGenOpt::Default);
+  DiskObjectCache OtherOpt(Dir, "", "cpu", "+feature", CodeGenOpt::None);
+  TargetOptions Options;
+  Options.UnsafeFPMath = true;
+  DiskObjectCache OtherOptions(Dir, "", "cpu", "+feature", CodeGenOpt::Default,
+                               0, Reloc::Default, CodeModel::Default, Options);
+  std::unique_ptr<Module> A = createModule("a.ll", 1);
+  std::unique_ptr<Module> B = createModule("b.ll", 1);
+  std::unique_ptr<Module> C = createModule("a.ll", 2);
+
+  SmallString<128> PathA, PathB, PathC, PathCPU, PathOpt, PathOptions;
+  ASSERT_TRUE(Cache.getCacheFile(A.get(), PathA));
+  ASSERT_TRUE(Cache.getCacheFile(B.get(), PathB));
+  ASSERT_TRUE(Cache.getCacheFile(C.get(), PathC));
+  ASSERT_TRUE(OtherCPU.getCacheFile(A.get(), PathCPU));
+  ASSERT_TRUE(OtherOpt.getCacheFile(A.get(), PathOpt));
+  ASSERT_TRUE(OtherOptions.getCacheFile(A.get(), PathOptions));
+
+  // The key depends on the contents and the target, not on the identifier.
+  EXPECT_EQ(PathA, PathB);
+  EXPECT_NE(PathA, PathC);
+  EXPECT_NE(PathA, PathCPU);
+  EXPECT_NE(PathA, PathOpt);
+  EXPECT_NE(PathA, PathOptions);
+  EXPECT_EQ(Dir.str(), sys::path::parent_path(PathA.str()));
+}
+
+TEST_F(DiskObjectCacheTest, RoundTrip) {
+  std::unique_ptr<Module> M = createModule("a.ll", 1);
+  {
+    DiskObjectCache Cache(Dir, "", "", "", CodeGenOpt::Default);
+    EXPECT_EQ(nullptr, Cache.getObject(M.get()));
+    Cache.notifyObjectCompiled(M.get(),
+                               MemoryBufferRef("object", "compiled"));
+  }
+
+  // A new cache, as in a later run, finds the object.
+  DiskObjectCache Cache(Dir, "", "", "", CodeGenOpt::Default);
+  std::unique_ptr<MemoryBuffer> Obj = Cache.getObject(M.get());
+  ASSERT_NE(nullptr, Obj);
+  EXPECT_EQ("object", Obj->getBuffer());
+  EXPECT_EQ(1u, countObjects());
+
+  std::unique_ptr<Module> Other = createModule("a.ll", 2);
+  EXPECT_EQ(nullptr, Cache.getObject(Other.get()));
+}
+
+TEST_F(DiskObjectCacheTest, ModuleChangedByCompilation) {
+  std::unique_ptr<Module> M = createModule("a.ll", 1);
+  {
+    DiskObjectCache Cache(Dir, "", "", "", CodeGenOpt::Default);
+    EXPECT_EQ(nullptr, Cache.getObject(M.get()));
+    // Code generation changes the module before the object is stored.
+    M->getGlobalVariable("G")->setLinkage(GlobalValue::InternalLinkage);
+    Cache.notifyObjectCompiled(M.get(),
+                               MemoryBufferRef("object", "compiled"));
+  }
+
+  // The object is stored under the contents the module had before it was
+  // compiled.
+  DiskObjectCache Cache(Dir, "", "", "", CodeGenOpt::Default);
+  std::unique_ptr<Module> Same = createModule("b.ll", 1);
+  std::unique_ptr<MemoryBuffer> Obj = Cache.getObject(Same.get());
+  ASSERT_NE(nullptr, Obj);
+  EXPECT_EQ("object", Obj->getBuffer());
+  EXPECT_EQ(1u, countObjects());
+}
+
+TEST_F(DiskObjectCacheTest, NotLookedUp) {
+  // Without getObject the contents before compilation are unknown.
+  DiskObjectCache Cache(Dir, "", "", "", CodeGenOpt::Default);
+  std::unique_ptr<Module> M = createModule("a.ll", 1);
+  Cache.notifyObjectCompiled(M.get(), MemoryBufferRef("object", "compiled"));
+  EXPECT_EQ(0u, countObjects());
+}
+
+TEST_F(DiskObjectCacheTest, Prune) {
+  DiskObjectCache Cache(Dir, "", "", "", CodeGenOpt::Default, 250);
+  std::string Object(100, 'x');
+  std::unique_ptr<Module> A = createModule("a.ll", 1);
+  std::unique_ptr<Module> B = createModule("b.ll", 2);
+  std::unique_ptr<Module> C = createModule("c.ll", 3);
+
+  EXPECT_EQ(nullptr, Cache.getObject(A.get()));
+  Cache.notifyObjectCompiled(A.get(), MemoryBufferRef(Object, "a"));
+  setLastUsed(Cache, A.get(), 200);
+  EXPECT_EQ(nullptr, Cache.getObject(B.get()));
+  Cache.notifyObjectCompiled(B.get(), MemoryBufferRef(Object, "b"));
+  setLastUsed(Cache, B.get(), 100);
+  EXPECT_EQ(2u, countObjects());
+
+  // Adding a third object evicts the least recently used one.
+  EXPECT_EQ(nullptr, Cache.getObject(C.get()));
+  Cache.notifyObjectCompiled(C.get(), MemoryBufferRef(Object, "c"));
+  EXPECT_EQ(2u, countObjects());
+  EXPECT_EQ(nullptr, Cache.getObject(A.get()));
+  EXPECT_NE(nullptr, Cache.getObject(B.get()));
+  EXPECT_NE(nullptr, Cache.getObject(C.get()));
+}
+
+} // end anonymous namespace
@@ -16,6 +16,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 namespace llvm {
@@ -60,5 +61,58 @@ TEST(VerifierTest, InvalidRetAttribute) {
       "Attribute 'uwtable' only applies to functions!"));
 }
 
+TEST(VerifierTest, ParallelParameterAttrs) {
+  // Use a new context, so the attribute sets checked by the verifier do not
+  // exist yet and the workers would create them concurrently.
+  LLVMContext C;
+  Module M("M", C);
+  Type *I32 = Type::getInt32Ty(C);
+  Type *I32Ptr = Type::getInt32PtrTy(C);
+  for (unsigned I = 0; I != 64; ++I) {
+    // Functions with a different number of i32 and i32* parameters, the last
+    // of which is zeroext. It is wrong for a pointer.
+    std::vector<Type *> Params(I % 16 + 1, (I & 16) ? I32Ptr : I32);
+    FunctionType *FTy = FunctionType::get(I32, Params, /*isVarArg=*/false);
+    Function *F = Function::Create(FTy, Function::ExternalLinkage,
+                                   "f" + Twine(I), &M);
+    F->addAttribute(Params.size(), Attribute::ZExt);
+    BasicBlock *Entry = BasicBlock::Create(C, "entry", F);
+    ReturnInst::Create(C, ConstantInt::get(I32, 0), Entry);
+  }
+
+  std::string Error;
+  raw_string_ostream ErrorOS(Error);
+  EXPECT_TRUE(verifyModuleParallel(M, &ErrorOS, 4));
+  std::string Expected;
+  raw_string_ostream ExpectedOS(Expected);
+  EXPECT_TRUE(verifyModule(M, &ExpectedOS));
+  EXPECT_EQ(ExpectedOS.str(), ErrorOS.str());
+  EXPECT_TRUE(StringRef(ErrorOS.str()).startswith(
+      "Wrong types for attribute: "));
+}
+
+TEST(VerifierTest, ParallelStructSizes) {
+  // Every function allocates the same new struct types, so the workers would
+  // all compute and cache whether they are sized.
+  LLVMContext C;
+  Module M("M", C);
+  Type *I32 = Type::getInt32Ty(C);
+  StructType *Inner = StructType::create("inner", I32, I32, nullptr);
+  StructType *Outer = StructType::create("outer", Inner, I32, nullptr);
+  StructType *Literal = StructType::get(Outer, I32, nullptr);
+  FunctionType *FTy = FunctionType::get(Type::getVoidTy(C), false);
+  for (unsigned I = 0; I != 64; ++I) {
+    Function *F = Function::Create(FTy, Function::ExternalLinkage,
+                                   "f" + Twine(I), &M);
+    BasicBlock *Entry = BasicBlock::Create(C, "entry", F);
+    new AllocaInst(Literal, "", Entry);
+    ReturnInst::Create(C, Entry);
+  }
+
+  EXPECT_FALSE(verifyModuleParallel(M, nullptr, 4));
+  EXPECT_TRUE(Inner->isSized());
+  EXPECT_TRUE(Literal->isSized());
+}
+
 }
 }
@@ -0,0 +1,37 @@
+//===- llvm/unittest/Support/JSONTest.cpp - JSON helper tests -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+std::string printToString(StringRef Str) {
+  std::string Result;
+  raw_string_ostream OS(Result);
+  printJSONString(OS, Str);
+  return OS.str();
+}
+
+TEST(JSONTest, PrintString) {
+  EXPECT_EQ("\"\"", printToString(""));
+  EXPECT_EQ("\"Pass execution timing report\"",
+            printToString("Pass execution timing report"));
+  EXPECT_EQ("\"a \\\"quoted\\\" name\"", printToString("a \"quoted\" name"));
+  EXPECT_EQ("\"C:\\\\dir\\\\file\"", printToString("C:\\dir\\file"));
+  EXPECT_EQ("\"tab\\u0009newline\\u000a\"", printToString("tab\tnewline\n"));
+  EXPECT_EQ("\"\\u0000\\u001f\"", printToString(StringRef("\0\x1f", 2)));
+  // Bytes from 0x7f up are printed as they are, so UTF-8 is kept.
+  EXPECT_EQ("\"\x7f\xc3\xa9\"", printToString("\x7f\xc3\xa9"));
+}
+
+}
@@ -0,0 +1,133 @@
+//===- llvm/unittest/Support/ThreadPoolTest.cpp - ThreadPool tests --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ThreadPool.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <numeric>
+
+using namespace llvm;
+
+namespace {
+
+TEST(ThreadPoolTest, AsyncBarrier) {
+  std::atomic<int> Count(0);
+  {
+    ThreadPool Pool(4);
+    for (int I = 0; I < 100; ++I)
+      Pool.async([&Count] { ++Count; });
+    Pool.wait();
+    EXPECT_EQ(100, Count);
+  }
+  // Destroying the pool waits for the queued tasks.
+  {
+    ThreadPool Pool(2);
+    for (int I = 0; I < 100; ++I)
+      Pool.async([&Count] { ++Count; });
+  }
+  EXPECT_EQ(200, Count);
+}
+
+TEST(ThreadPoolTest, AsyncFuture) {
+  ThreadPool Pool(2);
+  std::future<int> Sum = Pool.async([](int A, int B) { return A + B; }, 2, 3);
+  std::future<void> Done = Pool.async([] {});
+  EXPECT_EQ(5, Sum.get());
+  Done.get();
+}
+
+TEST(ThreadPoolTest, ParallelFor) {
+  ThreadPool Pool(4);
+  std::vector<int> Hits(10000, 0);
+  parallel_for(Pool, 0, 10000, [&](int I) { ++Hits[I]; });
+  for (int H : Hits)
+    EXPECT_EQ(1, H);
+
+  // Empty and reversed ranges are no-ops.
+  parallel_for(Pool, 5, 5, [&](int I) { ++Hits[I]; });
+  parallel_for(Pool, 5, 0, [&](int I) { ++Hits[I]; });
+  EXPECT_EQ(1, Hits[0]);
+}
+
+TEST(ThreadPoolTest, ParallelForUnbalanced) {
+  // All the work is in the first share, so the other threads have to steal
+  // it to help.
+  ThreadPool Pool(4);
+  std::atomic<unsigned> Sum(0);
+  parallel_for(Pool, 0u, 1000u, [&](unsigned I) {
+    unsigned Local = 0;
+    if (I < 250)
+      for (unsigned J = 0; J < 10000; ++J)
+        Local += J % 3;
+    Sum += Local + 1;
+  });
+  EXPECT_EQ(250u * 9999u + 1000u, Sum);
+}
+
+TEST(ThreadPoolTest, ParallelForNested) {
+  ThreadPool Pool(2);
+  std::atomic<int> Count(0);
+  parallel_for(Pool, 0, 8, [&](int) {
+    parallel_for(Pool, 0, 100, [&](int) { ++Count; });
+  });
+  EXPECT_EQ(800, Count);
+}
+
+TEST(ThreadPoolTest, ParallelForEach) {
+  std::vector<int> V(1000);
+  std::iota(V.begin(), V.end(), 0);
+  parallel_for_each(V.begin(), V.end(), [](int &X) { X *= 2; });
+  for (int I = 0; I < 1000; ++I)
+    EXPECT_EQ(2 * I, V[I]);
+}
+
+TEST(ThreadPoolTest, ParallelTransformReduce) {
+  std::vector<unsigned> V(5000);
+  std::iota(V.begin(), V.end(), 1u);
+  unsigned Sum = parallel_transform_reduce(
+      V.begin(), V.end(), 0u, [](unsigned A, unsigned B) { return A + B; },
+      [](unsigned X) { return X * 2; });
+  EXPECT_EQ(5000u * 5001u, Sum);
+
+  EXPECT_EQ(7u, parallel_transform_reduce(
+                    V.begin(), V.begin(), 7u,
+                    [](unsigned A, unsigned B) { return A + B; },
+                    [](unsigned X) { return X; }));
+}
+
+TEST(ThreadPoolTest, ParallelTransformReduceDeterministic) {
+  // Floating point addition is not associative, so the result is only
+  // reproducible if the reduction order does not depend on the threads.
+  std::vector<double> V(100000);
+  for (size_t I = 0; I < V.size(); ++I)
+    V[I] = 1.0 / (I + 1) * (I % 2 ? -1e8 : 1.0);
+  auto Add = [](double A, double B) { return A + B; };
+  auto Id = [](double X) { return X; };
+
+  ThreadPool Pool1(1), Pool8(8);
+  double R1 = parallel_transform_reduce(Pool1, V.begin(), V.end(), 0.0, Add,
+                                        Id);
+  for (int I = 0; I < 10; ++I)
+    EXPECT_EQ(R1, parallel_transform_reduce(Pool8, V.begin(), V.end(), 0.0,
+                                            Add, Id));
+}
+
+TEST(ThreadPoolTest, WorkerThreadCount) {
+#if LLVM_ENABLE_THREADS
+  EXPECT_EQ(0u, getWorkerThreadCount(1));
+  EXPECT_EQ(1u, getWorkerThreadCount(2));
+  EXPECT_EQ(7u, getWorkerThreadCount(8));
+  unsigned HW = std::thread::hardware_concurrency();
+  EXPECT_EQ(HW > 1 ? HW - 1 : 0, getWorkerThreadCount(0));
+#else
+  EXPECT_EQ(0u, getWorkerThreadCount(8));
+#endif
+}
+
+} // end anonymous namespace